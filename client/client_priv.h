@@ -134,7 +134,9 @@ enum options_client
   OPT_READ_FROM_BINLOG_SERVER,
   OPT_COMPRESSION_LIB,
   OPT_COMPRESS_DATA,
-  OPT_MINIMUM_HLC
+  OPT_MINIMUM_HLC,
+  OPT_PARALLEL_DECODERS,
+  OPT_PARALLEL_CHUNK_SIZE
 };
 
 /**
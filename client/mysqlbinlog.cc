@@ -40,6 +40,10 @@
 #include <my_dir.h>
 #include <map>
 #include <string>
+#include <vector>
+#ifndef __WIN__
+#include <sys/wait.h>
+#endif
 using std::map;
 using std::string;
 
@@ -169,6 +173,8 @@ static ulonglong start_position, stop_position;
 static char *start_datetime_str, *stop_datetime_str;
 static my_time_t start_datetime= 0, stop_datetime= MY_TIME_T_MAX;
 static ulonglong rec_count= 0;
+/* Position of the event at which process_event() stopped */
+static my_off_t stop_event_pos= 0;
 static MYSQL* mysql = NULL;
 static char* dirname_for_local_load= 0;
 static uint opt_server_id_bits = 0;
@@ -249,6 +255,8 @@ ReplSemiSyncSlave repl_semisync;
 
 static uint opt_receive_buffer_size = 0;
 static uint opt_flush_result_file = 0;
+static uint opt_parallel_decoders= 0;
+static ulonglong opt_parallel_chunk_size= 0;
 
 static Exit_status dump_local_log_entries(PRINT_EVENT_INFO *print_event_info,
                                           const char* logname);
@@ -1132,6 +1140,7 @@ Exit_status process_event(PRINT_EVENT_INFO *print_event_info, Log_event *ev,
         || (pos >= stop_position_mot) || shall_stop_gtids(ev))
     {
       /* end the program */
+      stop_event_pos= pos;
       retval= OK_STOP;
       goto end;
     }
@@ -2089,6 +2098,18 @@ static struct my_option my_long_options[] =
    0, GET_UINT, REQUIRED_ARG, 30, 0, 86400, 0, 0, 0},
   {"offset", 'o', "Skip the first N entries.", &offset, &offset,
    0, GET_ULL, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"parallel-decoders", OPT_PARALLEL_DECODERS,
+   "Number of processes decoding local binlogs in parallel. Each decodes a "
+   "binlog, or a part of one ending with a transaction, into a temporary "
+   "file, and the outputs are printed in order. 0 or 1 decodes the binlogs "
+   "sequentially.",
+   &opt_parallel_decoders, &opt_parallel_decoders, 0, GET_UINT, REQUIRED_ARG,
+   0, 0, 256, 0, 0, 0},
+  {"parallel-chunk-size", OPT_PARALLEL_CHUNK_SIZE,
+   "Size in bytes of the parts binlogs are split into at transaction "
+   "boundaries with --parallel-decoders. 0 does not split binlogs.",
+   &opt_parallel_chunk_size, &opt_parallel_chunk_size, 0, GET_ULL,
+   REQUIRED_ARG, 64 * 1024 * 1024, 0, ULONGLONG_MAX, 0, 0, 0},
   {"password", 'p', "Password to connect to remote server.",
    0, 0, 0, GET_PASSWORD, OPT_ARG, 0, 0, 0, 0, 0, 0},
   {"plugin_dir", OPT_PLUGIN_DIR, "Directory for client-side plugins.",
@@ -2677,6 +2698,371 @@ static Exit_status dump_single_log(PRINT_EVENT_INFO *print_event_info,
 }
 
 
+/**
+  Checks whether the binlogs can be decoded by parallel processes. Events
+  are decoded independently of the previous parts of the binlogs, unless
+  options depend on what was read before.
+
+  @return true if the binlogs can be decoded in parallel.
+*/
+static bool can_decode_in_parallel(int argc, char **argv)
+{
+  const char *reason= NULL;
+
+#ifdef __WIN__
+  reason= "this platform";
+#endif
+  if (opt_remote_proto != BINLOG_LOCAL)
+    reason= "remote binlogs";
+  else if (offset)
+    reason= "--offset";
+  else if (start_datetime_str)
+    reason= "--start-datetime";
+  else if (opt_print_gtids)
+    reason= "--print_gtids";
+  for (int i= 0; !reason && i < argc; i++)
+  {
+    if (!argv[i] || !strcmp(argv[i], "-"))
+      reason= "standard input";
+  }
+
+  if (reason)
+  {
+    warning("The option --parallel-decoders cannot be used with %s, the "
+            "binlogs are decoded sequentially.", reason);
+    return false;
+  }
+  return true;
+}
+
+
+#ifndef __WIN__
+/**
+  Exit codes of a parallel decoder: the Exit_status of its part of the
+  binlogs, and the state in which it left the output.
+*/
+#define DECODER_EXIT_STATUS_MASK        3
+#define DECODER_SKIPPED_EVENT_IN_TRX    4
+#define DECODER_GTID_NEXT_INVALID       8
+#define DECODER_UNFLUSHED_EVENTS        16
+#define DECODER_PARTIAL_STATEMENT       32
+
+/**
+  A part of the binlogs given on the command line, which one decoder
+  process prints with --parallel-decoders.
+*/
+struct Decoder_unit
+{
+  const char *logname;
+  my_off_t start;             ///< --start-position of the part
+  my_off_t stop;              ///< --stop-position of the part
+  bool split;                 ///< stop is where the binlog was split
+  FILE *output;               ///< temporary file the decoder prints to
+  pid_t pid;
+  int status;                 ///< exit code of the decoder, -1 if running
+};
+
+
+/**
+  Finds where to split a binlog, so that each part ends with a transaction
+  and is at least --parallel-chunk-size bytes long. Only the headers of the
+  events are read.
+
+  Nothing is reported if the binlog cannot be read: it is then not split,
+  and the decoder reading it reports the error.
+
+  @param[in]  logname Name of the binlog.
+  @param[in]  start   Position to start reading from.
+  @param[in]  stop    Position to stop reading at.
+  @param[out] splits  Positions of the first events of the parts but the
+                      first one.
+*/
+static void find_split_positions(const char *logname, my_off_t start,
+                                 my_off_t stop,
+                                 std::vector<my_off_t> *splits)
+{
+  File fd;
+  IO_CACHE cache;
+  uchar header[LOG_EVENT_MINIMAL_HEADER_LEN];
+  my_off_t pos= BIN_LOG_HEADER_SIZE, last_split= start;
+
+  if (!opt_parallel_chunk_size)
+    return;
+  if ((fd= my_open(logname, O_RDONLY | O_BINARY, MYF(0))) < 0)
+    return;
+  if (init_io_cache(&cache, fd, 0, READ_CACHE, 0, 0, MYF(MY_NABP)))
+  {
+    my_close(fd, MYF(0));
+    return;
+  }
+
+  if (!my_b_read(&cache, header, BIN_LOG_HEADER_SIZE) &&
+      !memcmp(header, BINLOG_MAGIC, BIN_LOG_HEADER_SIZE))
+  {
+    while (!my_b_read(&cache, header, sizeof(header)))
+    {
+      ulong event_len= uint4korr(header + EVENT_LEN_OFFSET);
+      if (event_len < sizeof(header))
+        break;
+      pos+= event_len;
+      if (pos >= stop || pos > cache.end_of_file)
+        break;
+      /* The event after an Xid event starts a transaction */
+      if (header[EVENT_TYPE_OFFSET] == XID_EVENT && pos > start &&
+          pos - last_split >= opt_parallel_chunk_size)
+      {
+        splits->push_back(pos);
+        last_split= pos;
+      }
+      my_b_seek(&cache, pos);
+    }
+  }
+
+  end_io_cache(&cache);
+  my_close(fd, MYF(0));
+}
+
+
+/**
+  Body of a decoder process: prints its part of the binlogs into its
+  temporary file as if it were given alone on the command line.
+
+  @return The exit code of the decoder.
+*/
+static int run_decoder(const Decoder_unit *unit)
+{
+  PRINT_EVENT_INFO print_event_info;
+  if (!print_event_info.init_ok())
+    return ERROR_STOP;
+  strmov(print_event_info.delimiter, "/*!*/;");
+  print_event_info.verbose= short_form ? 0 : verbose;
+
+  result_file= unit->output;
+  start_position= unit->start;
+  stop_position= unit->stop;
+
+  Exit_status rc= dump_single_log(&print_event_info, unit->logname);
+  /* Reaching the split position is not the end of the binlogs */
+  if (rc == OK_STOP && unit->split && stop_event_pos >= unit->stop)
+    rc= OK_CONTINUE;
+  if (fflush(result_file))
+  {
+    error("Could not write to a temporary file (errno: %d).", errno);
+    rc= ERROR_STOP;
+  }
+
+  int status= rc;
+  if (print_event_info.skipped_event_in_transaction)
+    status|= DECODER_SKIPPED_EVENT_IN_TRX;
+  if (!print_event_info.is_gtid_next_valid)
+    status|= DECODER_GTID_NEXT_INVALID;
+  if (print_event_info.have_unflushed_events)
+    status|= DECODER_UNFLUSHED_EVENTS;
+  if (buff_ev.elements > 0)
+    status|= DECODER_PARTIAL_STATEMENT;
+  return status;
+}
+
+
+/**
+  Forks the process decoding a part of the binlogs.
+
+  @retval ERROR_STOP An error occurred - the program should terminate.
+  @retval OK_CONTINUE No error, the program should continue.
+*/
+static Exit_status start_decoder(Decoder_unit *unit)
+{
+  if (!(unit->output= tmpfile()))
+  {
+    error("Could not create a temporary file (errno: %d).", errno);
+    return ERROR_STOP;
+  }
+
+  /* Nothing buffered may be written twice */
+  fflush(result_file);
+  fflush(stderr);
+  if ((unit->pid= fork()) < 0)
+  {
+    error("Could not start a decoder process (errno: %d).", errno);
+    fclose(unit->output);
+    unit->output= NULL;
+    return ERROR_STOP;
+  }
+  if (unit->pid == 0)
+    _exit(run_decoder(unit));
+
+  unit->status= -1;
+  return OK_CONTINUE;
+}
+
+
+/**
+  Copies the output of a decoder to the result file.
+
+  @retval false Success
+  @retval true  Error
+*/
+static bool copy_decoder_output(FILE *output)
+{
+  char buf[IO_SIZE * 16];
+  size_t length;
+
+  if (fseek(output, 0, SEEK_SET))
+    return true;
+  while ((length= fread(buf, 1, sizeof(buf), output)) > 0)
+  {
+    if (fwrite(buf, 1, length, result_file) != length)
+      return true;
+  }
+  return ferror(output) != 0;
+}
+#endif
+
+
+/**
+  Prints the binlogs with up to --parallel-decoders processes, each of
+  which decodes a binlog or a part of one into a temporary file. The
+  outputs are printed in the order of the binlogs, as they would have
+  been printed sequentially.
+
+  @param[in,out] print_event_info Gets the state in which the last part
+  printed left the output.
+  @param[out] partial_statement Whether the last part ends in the middle
+  of a statement.
+
+  @retval ERROR_STOP An error occurred - the program should terminate.
+  @retval OK_CONTINUE No error, the program should continue.
+  @retval OK_STOP No error, but the end of the specified range of
+  events to process has been reached and the program should terminate.
+*/
+static Exit_status dump_logs_in_parallel(int argc, char **argv,
+                                         PRINT_EVENT_INFO *print_event_info,
+                                         bool *partial_statement)
+{
+  DBUG_ENTER("dump_logs_in_parallel");
+  Exit_status rc= OK_CONTINUE;
+#ifndef __WIN__
+  std::vector<Decoder_unit> units;
+
+  for (int i= 0; i < argc; i++)
+  {
+    Decoder_unit unit;
+    std::vector<my_off_t> splits;
+
+    unit.logname= argv[i];
+    /* --start-position applies to the first log, --stop-position to the last */
+    unit.start= i == 0 ? start_position_mot : BIN_LOG_HEADER_SIZE;
+    my_off_t stop= i == argc - 1 ? stop_position_mot : ~(my_off_t)0;
+    unit.output= NULL;
+    unit.pid= 0;
+    unit.status= -1;
+
+    find_split_positions(unit.logname, unit.start, stop, &splits);
+    for (my_off_t split : splits)
+    {
+      unit.stop= split;
+      unit.split= true;
+      units.push_back(unit);
+      unit.start= split;
+    }
+    unit.stop= stop;
+    unit.split= false;
+    units.push_back(unit);
+  }
+
+  size_t next_start= 0, running= 0, next_print;
+  for (next_print= 0; next_print < units.size(); next_print++)
+  {
+    Decoder_unit *unit= &units[next_print];
+
+    while (running < opt_parallel_decoders && next_start < units.size())
+    {
+      if ((rc= start_decoder(&units[next_start])) != OK_CONTINUE)
+        break;
+      next_start++;
+      running++;
+    }
+    if (rc != OK_CONTINUE && next_start == next_print)
+      break;
+
+    while (unit->status < 0)
+    {
+      int status;
+      pid_t pid= waitpid(-1, &status, 0);
+      if (pid < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        error("Could not wait for the decoder processes (errno: %d).", errno);
+        unit->status= ERROR_STOP;
+        break;
+      }
+      for (size_t i= next_print; i < next_start; i++)
+      {
+        if (units[i].pid == pid)
+        {
+          running--;
+          if (WIFEXITED(status))
+            units[i].status= WEXITSTATUS(status);
+          else
+          {
+            error("The decoder process of '%s' was killed by signal %d.",
+                  units[i].logname, WTERMSIG(status));
+            units[i].status= ERROR_STOP;
+          }
+          units[i].pid= 0;
+        }
+      }
+    }
+
+    /* Each decoder starts outside of a transaction */
+    if (print_event_info->skipped_event_in_transaction && !opt_skip_empty_trans)
+      fprintf(result_file, "COMMIT /* added by mysqlbinlog */%s\n",
+              print_event_info->delimiter);
+
+    if (copy_decoder_output(unit->output))
+    {
+      error("Could not copy the output of a decoder process.");
+      unit->status= ERROR_STOP;
+    }
+    fclose(unit->output);
+    unit->output= NULL;
+
+    print_event_info->skipped_event_in_transaction=
+      unit->status & DECODER_SKIPPED_EVENT_IN_TRX;
+    print_event_info->is_gtid_next_valid=
+      !(unit->status & DECODER_GTID_NEXT_INVALID);
+    print_event_info->have_unflushed_events=
+      unit->status & DECODER_UNFLUSHED_EVENTS;
+    *partial_statement= unit->status & DECODER_PARTIAL_STATEMENT;
+
+    Exit_status unit_rc=
+      (Exit_status) (unit->status & DECODER_EXIT_STATUS_MASK);
+    if (unit_rc != OK_CONTINUE)
+    {
+      rc= unit_rc;
+      break;
+    }
+    if (rc != OK_CONTINUE)
+      break;
+  }
+
+  /* The decoders of the parts after an error or the stop are not needed */
+  for (size_t i= next_print; i < units.size(); i++)
+  {
+    if (units[i].pid > 0)
+    {
+      kill(units[i].pid, SIGKILL);
+      waitpid(units[i].pid, NULL, 0);
+    }
+    if (units[i].output)
+      fclose(units[i].output);
+  }
+#endif
+  DBUG_RETURN(rc);
+}
+
+
 static Exit_status dump_multiple_logs(int argc, char **argv)
 {
   DBUG_ENTER("dump_multiple_logs");
@@ -2697,21 +3083,29 @@ static Exit_status dump_multiple_logs(int argc, char **argv)
   
   print_event_info.verbose= short_form ? 0 : verbose;
 
-  // Dump all logs.
-  my_off_t save_stop_position= stop_position;
-  stop_position= ~(my_off_t)0;
-  for (int i= 0; i < argc; i++)
+  bool partial_statement= false;
+  if (opt_parallel_decoders > 1 && can_decode_in_parallel(argc, argv))
+    rc= dump_logs_in_parallel(argc, argv, &print_event_info,
+                              &partial_statement);
+  else
   {
-    if (i == argc - 1) // last log, --stop-position applies
-      stop_position= save_stop_position;
-    if ((rc= dump_single_log(&print_event_info, argv[i])) != OK_CONTINUE)
-      break;
+    // Dump all logs.
+    my_off_t save_stop_position= stop_position;
+    stop_position= ~(my_off_t)0;
+    for (int i= 0; i < argc; i++)
+    {
+      if (i == argc - 1) // last log, --stop-position applies
+        stop_position= save_stop_position;
+      if ((rc= dump_single_log(&print_event_info, argv[i])) != OK_CONTINUE)
+        break;
 
-    // For next log, --start-position does not apply
-    start_position= BIN_LOG_HEADER_SIZE;
+      // For next log, --start-position does not apply
+      start_position= BIN_LOG_HEADER_SIZE;
+    }
+    partial_statement= buff_ev.elements > 0;
   }
 
-  if (buff_ev.elements > 0)
+  if (partial_statement)
     warning("The range of printed events ends with an Intvar_event, "
             "Rand_event or User_var_event with no matching Query_log_event. "
             "This might be because the last statement was not fully written "
@@ -4456,5 +4850,6 @@ int main(int argc, char** argv)
 #include "rpl_gtid_misc.cc"
 #include "uuid.cc"
 #include "rpl_gtid_set.cc"
+#include "rpl_gtid_index.cc"
 #include "rpl_gtid_specification.cc"
 #include "rpl_tblmap.cc"
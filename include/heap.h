@@ -50,6 +50,7 @@ typedef struct st_heapinfo		/* Struct from heap_info */
   ulonglong index_length;
   uint reclength;			/* Length of one record */
   int errkey;
+  uchar *dupp_key_pos;                  /* Row that caused duplicate key */
   ulonglong auto_increment;
   time_t create_time;
 } HEAPINFO;
@@ -110,6 +111,18 @@ typedef struct st_heap_block
 
 struct st_heap_info;			/* For referense */
 
+/*
+  A BLOB column of the record. The record only holds the length and a
+  pointer; the value itself is copied to its own allocation on write, see
+  hp_blob.c.
+*/
+
+typedef struct st_hp_blob_desc
+{
+  uint offset;                          /* Offset of the column in record */
+  uint packlength;                      /* Bytes used to store the length */
+} HP_BLOB_DESC;
+
 typedef struct st_hp_keydef		/* Key definition with open */
 {
   uint flag;				/* HA_NOSAME | HA_NULL_PART_KEY */
@@ -156,6 +169,9 @@ typedef struct st_heap_share
   uint auto_key;
   uint auto_key_type;			/* real type of the auto key segment */
   ulonglong auto_increment;
+  HP_BLOB_DESC *blob_descs;             /* BLOB columns of the record */
+  uint blobs;
+  struct st_hp_blob_chunk *blob_chunks; /* Stored BLOB values */
 } HP_SHARE;
 
 struct st_hp_hash_info;
@@ -167,6 +183,7 @@ typedef struct st_heap_info
   struct st_hp_hash_info *current_hash_ptr;
   ulong current_record,next_block;
   int lastinx,errkey;
+  uchar *dupp_key_pos;                  /* Row that caused duplicate key */
   int  mode;				/* Mode of file (READONLY..) */
   uint opt_flag,update;
   uchar *lastkey;			/* Last used key with rkey */
@@ -184,6 +201,8 @@ typedef struct st_heap_info
 typedef struct st_heap_create_info
 {
   HP_KEYDEF *keydef;
+  HP_BLOB_DESC *blob_descs;
+  uint blobs;
   ulong max_records;
   ulong min_records;
   uint auto_key;                        /* keynr [1 - maxkey] for auto key */
@@ -22,6 +22,7 @@
 #endif
 #include "sql_class.h"
 #include "binlog.h"
+#include <algorithm>
 #include <fstream>
 
 #define TIME_THOUSAND 1000
@@ -34,12 +35,12 @@ unsigned long rpl_semi_sync_master_timeout;
 char rpl_semi_sync_master_crash_if_active_trxs;
 unsigned long rpl_semi_sync_master_trace_level;
 char rpl_semi_sync_master_status                    = 0;
-unsigned long rpl_semi_sync_master_yes_transactions = 0;
-unsigned long rpl_semi_sync_master_no_transactions  = 0;
+unsigned long long rpl_semi_sync_master_yes_transactions = 0;
+unsigned long long rpl_semi_sync_master_no_transactions  = 0;
 unsigned long rpl_semi_sync_master_off_times        = 0;
-unsigned long rpl_semi_sync_master_timefunc_fails   = 0;
-unsigned long rpl_semi_sync_master_wait_timeouts     = 0;
-unsigned long rpl_semi_sync_master_wait_sessions    = 0;
+unsigned long long rpl_semi_sync_master_timefunc_fails   = 0;
+unsigned long long rpl_semi_sync_master_wait_timeouts     = 0;
+unsigned long long rpl_semi_sync_master_wait_sessions    = 0;
 unsigned long rpl_semi_sync_master_wait_pos_backtraverse = 0;
 unsigned long rpl_semi_sync_master_avg_trx_wait_time = 0;
 unsigned long long rpl_semi_sync_master_trx_wait_num = 0;
@@ -48,6 +49,7 @@ unsigned long long rpl_semi_sync_master_net_wait_num = 0;
 unsigned long rpl_semi_sync_master_clients          = 0;
 unsigned long long rpl_semi_sync_master_net_wait_time = 0;
 unsigned long long rpl_semi_sync_master_trx_wait_time = 0;
+unsigned long long rpl_semi_sync_master_ack_receiver_replies = 0;
 char rpl_semi_sync_master_wait_no_slave = 1;
 char *histogram_trx_wait_step_size = 0;
 latency_histogram histogram_trx_wait;
@@ -73,56 +75,60 @@ static unsigned long long timespec_to_usec(const struct timespec *ts)
  *
  ******************************************************************************/
 
-ActiveTranx::ActiveTranx(mysql_mutex_t *lock,
-			 unsigned long trace_level)
-  : Trace(trace_level), allocator_(max_connections),
-    num_entries_(max_connections << 1), /* Transaction hash table size
-                                         * is set to double the size
-                                         * of max_connections */
-    lock_(lock)
+ActiveTranx::ActiveTranx(unsigned long trace_level)
+  : Trace(trace_level), insert_seq_(0), release_seq_(0), free_waiter_(false)
 {
-  /* No transactions are in the list initially. */
-  trx_front_ = NULL;
-  trx_rear_  = NULL;
+  /* A slot is used per group of transactions flushed together, so there
+   * are fewer slots in use than sessions waiting.
+   */
+  ulonglong wanted= std::max<ulonglong>(max_connections << 1, 1024);
+  for (num_slots_= 1; num_slots_ < wanted; num_slots_<<= 1)
+  {}
 
-  /* Create the hash table to find a transaction's ending event. */
-  trx_htb_ = new TranxNode *[num_entries_];
-  for (int idx = 0; idx < num_entries_; ++idx)
-    trx_htb_[idx] = NULL;
+  slots_ = new TranxSlot[num_slots_];
+  for (ulonglong idx = 0; idx < num_slots_; ++idx)
+  {
+    slots_[idx].key_ = 0;
+    slots_[idx].n_waiters = 0;
+    mysql_mutex_init(key_ss_mutex_LOCK_tranx_slot_, &slots_[idx].lock,
+                     MY_MUTEX_INIT_FAST);
+    mysql_cond_init(key_ss_cond_COND_binlog_send_, &slots_[idx].cond, NULL);
+  }
+  mysql_mutex_init(key_ss_mutex_LOCK_free_slot_, &free_lock_,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_ss_cond_COND_free_slot_, &free_cond_, NULL);
 
   sql_print_information("Semi-sync replication initialized for transactions.");
 }
 
 ActiveTranx::~ActiveTranx()
 {
-  delete [] trx_htb_;
-  trx_htb_          = NULL;
-  num_entries_      = 0;
-}
-
-unsigned int ActiveTranx::calc_hash(const unsigned char *key,
-                                    unsigned int length)
-{
-  unsigned int nr = 1, nr2 = 4;
-
-  /* The hash implementation comes from calc_hashnr() in mysys/hash.c. */
-  while (length--)
+  for (ulonglong idx = 0; idx < num_slots_; ++idx)
   {
-    nr  ^= (((nr & 63)+nr2)*((unsigned int) (unsigned char) *key++))+ (nr << 8);
-    nr2 += 3;
+    mysql_mutex_destroy(&slots_[idx].lock);
+    mysql_cond_destroy(&slots_[idx].cond);
   }
-  return((unsigned int) nr);
+  mysql_mutex_destroy(&free_lock_);
+  mysql_cond_destroy(&free_cond_);
+  delete [] slots_;
+  slots_            = NULL;
+  num_slots_        = 0;
 }
 
-unsigned int ActiveTranx::get_hash_value(const char *log_file_name,
-				 my_off_t    log_file_pos)
+ulonglong ActiveTranx::pos_key(const char *log_file_name,
+                               my_off_t log_file_pos)
 {
-  unsigned int hash1 = calc_hash((const unsigned char *)log_file_name,
-                                 strlen(log_file_name));
-  unsigned int hash2 = calc_hash((const unsigned char *)(&log_file_pos),
-                                 sizeof(log_file_pos));
+  static const ulonglong kMaxFileNum = (1ULL << 24) - 1;
+  static const ulonglong kMaxPos = (1ULL << 40) - 1;
+
+  /* The index of the file, parsed as MYSQL_BIN_LOG::extract_file_index()
+   * does.
+   */
+  const char *ext = strrchr(log_file_name, '.');
+  ulonglong file_num = ext ? strtoull(ext + 1, NULL, 10) : 0;
 
-  return (hash1 + hash2) % num_entries_;
+  return (min(file_num, kMaxFileNum) << 40) |
+         min((ulonglong) log_file_pos, kMaxPos);
 }
 
 int ActiveTranx::compare(const char *log_file_name1, my_off_t log_file_pos1,
@@ -144,231 +150,223 @@ int ActiveTranx::compare(const char *log_file_name1, my_off_t log_file_pos1,
   return 0;
 }
 
+/* Wait until the slot of sequence number seq is released, or for wait_ms
+ * milliseconds.  A slot is released when a slave replies up to its
+ * position, or when semi-sync switches off, so the wait is as long as the
+ * one of a committing session.
+ */
+bool ActiveTranx::wait_for_free_slot(ulonglong seq, unsigned long wait_ms)
+{
+  const char *kWho = "ActiveTranx::wait_for_free_slot";
+  struct timespec abstime;
+  int wait_result = 0;
+
+  function_enter(kWho);
+
+  set_timespec_nsec(abstime, (ulonglong) wait_ms * TIME_MILLION);
+
+  mysql_mutex_lock(&free_lock_);
+  /* Releasing threads check for a waiter after moving release_seq_. */
+  free_waiter_ = true;
+  while (seq - release_seq_.load() >= num_slots_ && wait_result == 0)
+    wait_result = mysql_cond_timedwait(&free_cond_, &free_lock_, &abstime);
+  free_waiter_ = false;
+  const bool free = seq - release_seq_.load() < num_slots_;
+  mysql_mutex_unlock(&free_lock_);
+
+  function_exit(kWho, free);
+  return free;
+}
+
 int ActiveTranx::insert_tranx_node(const char *log_file_name,
-				   my_off_t log_file_pos)
+				   my_off_t log_file_pos,
+				   unsigned long wait_ms)
 {
   const char *kWho = "ActiveTranx:insert_tranx_node";
-  TranxNode  *ins_node;
+  const ulonglong key = pos_key(log_file_name, log_file_pos);
   int         result = 0;
-  unsigned int        hash_val;
 
   function_enter(kWho);
 
-  ins_node = allocator_.allocate_node();
-  if (!ins_node)
-  {
-    sql_print_error("%s: transaction node allocation failed for: (%s, %lu)",
-                    kWho, log_file_name, (unsigned long)log_file_pos);
-    result = -1;
-    goto l_end;
-  }
-
-  /* insert the binlog position in the active transaction list. */
-  strncpy(ins_node->log_name_, log_file_name, FN_REFLEN-1);
-  ins_node->log_name_[FN_REFLEN-1] = 0; /* make sure it ends properly */
-  ins_node->log_pos_ = log_file_pos;
+  /* Only the session flushing the binlog inserts, under LOCK_log. */
+  ulonglong seq = insert_seq_.load(std::memory_order_relaxed);
+  ulonglong release_seq = release_seq_.load();
 
-  if (!trx_front_)
-  {
-    /* The list is empty. */
-    trx_front_ = trx_rear_ = ins_node;
-  }
-  else
+  if (seq - release_seq >= num_slots_)
   {
-    int cmp = compare(ins_node, trx_rear_);
-    if (cmp > 0)
+    if (trace_level_ & kTraceDetail)
+      sql_print_information("%s: wait for a free transaction slot for: "
+                            "(%s, %lu)", kWho, log_file_name,
+                            (unsigned long)log_file_pos);
+    if (!wait_for_free_slot(seq, wait_ms))
     {
-      /* Compare with the tail first.  If the transaction happens later in
-       * binlog, then make it the new tail.
-       */
-      trx_rear_->next_ = ins_node;
-      trx_rear_        = ins_node;
+      sql_print_error("%s: no free transaction slot for: (%s, %lu)",
+                      kWho, log_file_name, (unsigned long)log_file_pos);
+      result = -1;
+      goto l_end;
     }
-    else
+    release_seq = release_seq_.load();
+  }
+
+  if (seq > release_seq)
+  {
+    /* The rear slot can not be reused before it is released. */
+    ulonglong rear_key = slot(seq - 1)->key_.load();
+    if (key <= rear_key)
     {
-      /* Otherwise, it is an error because the transaction should hold the
+      /* It is an error because the transaction should hold the
        * mysql_bin_log.LOCK_log when appending events.
        */
-      sql_print_error("%s: binlog write out-of-order, tail (%s, %lu), "
-                      "new node (%s, %lu)", kWho,
-                      trx_rear_->log_name_, (unsigned long)trx_rear_->log_pos_,
-                      ins_node->log_name_, (unsigned long)ins_node->log_pos_);
+      sql_print_error("%s: binlog write out-of-order, tail key %llu, "
+                      "new node (%s, %lu)", kWho, rear_key,
+                      log_file_name, (unsigned long)log_file_pos);
       result = -1;
       goto l_end;
     }
   }
 
-  hash_val = get_hash_value(ins_node->log_name_, ins_node->log_pos_);
-  ins_node->hash_next_ = trx_htb_[hash_val];
-  trx_htb_[hash_val]   = ins_node;
+  slot(seq)->key_.store(key);
+  insert_seq_.store(seq + 1);
 
   if (trace_level_ & kTraceDetail)
-    sql_print_information("%s: insert (%s, %lu) in entry(%u)", kWho,
-                          ins_node->log_name_, (unsigned long)ins_node->log_pos_,
-                          hash_val);
+    sql_print_information("%s: insert (%s, %lu) in slot(%llu)", kWho,
+                          log_file_name, (unsigned long)log_file_pos,
+                          seq & (num_slots_ - 1));
 
  l_end:
   return function_exit(kWho, result);
 }
 
-bool ActiveTranx::is_tranx_end_pos(const char *log_file_name,
-				   my_off_t    log_file_pos)
+/* Find the sequence number of the first slot with a position at or after
+ * key.  The slots read may be released and reused by later positions while
+ * they are searched, in which case the search is repeated.
+ */
+bool ActiveTranx::find_slot_seq(ulonglong key, ulonglong *seq)
 {
-  const char *kWho = "ActiveTranx::is_tranx_end_pos";
-  function_enter(kWho);
-
-  unsigned int hash_val = get_hash_value(log_file_name, log_file_pos);
-  TranxNode *entry = trx_htb_[hash_val];
-
-  while (entry != NULL)
+  for (;;)
   {
-    if (compare(entry, log_file_name, log_file_pos) == 0)
-      break;
-
-    entry = entry->hash_next_;
-  }
+    ulonglong lo = release_seq_.load();
+    ulonglong hi = insert_seq_.load();
+    const ulonglong first = lo, end = hi;
 
-  if (trace_level_ & kTraceDetail)
-    sql_print_information("%s: probe (%s, %lu) in entry(%u)", kWho,
-                          log_file_name, (unsigned long)log_file_pos, hash_val);
-
-  function_exit(kWho, (entry != NULL));
-  return (entry != NULL);
-}
-
-int ActiveTranx::signal_waiting_sessions_all()
-{
-  const char *kWho = "ActiveTranx::signal_waiting_sessions_all";
-  function_enter(kWho);
-  for (TranxNode* entry= trx_front_; entry; entry=entry->next_)
-    mysql_cond_broadcast(&entry->cond);
+    while (lo < hi)
+    {
+      ulonglong mid = lo + (hi - lo) / 2;
+      if (slot(mid)->key_.load() < key)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if (lo == end)
+      return false;
 
-  return function_exit(kWho, 0);
+    /* The keys read before the first slot which is not released is read
+     * again are those of the slots searched, unless they were released.
+     */
+    ulonglong lo_key = slot(lo)->key_.load();
+    ulonglong prev_key = lo > first ? slot(lo - 1)->key_.load() : 0;
+    ulonglong release_seq = release_seq_.load();
+    if (release_seq <= lo && lo_key >= key &&
+        (release_seq == lo || prev_key < key))
+    {
+      *seq = lo;
+      return true;
+    }
+    if (release_seq >= end)
+      return false;
+  }
 }
 
-int ActiveTranx::signal_waiting_sessions_up_to(const char *log_file_name,
-                                               my_off_t log_file_pos)
+TranxSlot * ActiveTranx::find_active_tranx_slot(ulonglong key)
 {
-  const char *kWho = "ActiveTranx::signal_waiting_sessions_up_to";
+  const char *kWho = "ActiveTranx::find_active_tranx_slot";
   function_enter(kWho);
 
-  TranxNode* entry= trx_front_;
-  int cmp= ActiveTranx::compare(entry->log_name_, entry->log_pos_, log_file_name, log_file_pos) ;
-  while (entry && cmp <= 0)
-  {
-    mysql_cond_broadcast(&entry->cond);
-    entry= entry->next_;
-    if (entry)
-      cmp= ActiveTranx::compare(entry->log_name_, entry->log_pos_, log_file_name, log_file_pos) ;
-  }
+  ulonglong seq;
+  TranxSlot *entry = find_slot_seq(key, &seq) ? slot(seq) : NULL;
 
-  return function_exit(kWho, (entry != NULL));
+  function_exit(kWho, 0);
+  return entry;
 }
 
-TranxNode * ActiveTranx::find_active_tranx_node(const char *log_file_name,
-                                                my_off_t log_file_pos)
+bool ActiveTranx::is_tranx_end_pos(ulonglong key)
 {
-  const char *kWho = "ActiveTranx::find_active_tranx_node";
+  const char *kWho = "ActiveTranx::is_tranx_end_pos";
   function_enter(kWho);
 
-  TranxNode* entry= trx_front_;
+  ulonglong seq;
+  bool found = find_slot_seq(key, &seq) && slot(seq)->key_.load() == key;
 
-  while (entry)
-  {
-    if (ActiveTranx::compare(log_file_name, log_file_pos, entry->log_name_,
-                             entry->log_pos_) <= 0)
-      break;
-    entry= entry->next_;
-  }
-  function_exit(kWho, 0);
-  return entry;
+  if (trace_level_ & kTraceDetail)
+    sql_print_information("%s: probe key %llu, found(%d)", kWho, key,
+                          (int) found);
+
+  function_exit(kWho, found);
+  return found;
 }
 
-int ActiveTranx::clear_active_tranx_nodes(const char *log_file_name,
-					  my_off_t log_file_pos)
+/* Release the slots up to key in order, waking up the sessions waiting on
+ * them.  Several threads may release at once: each slot is released by the
+ * one which moves release_seq_ past it.
+ */
+void ActiveTranx::release_slots_up_to(ulonglong key)
 {
-  const char *kWho = "ActiveTranx::::clear_active_tranx_nodes";
-  TranxNode *new_front;
-
-  function_enter(kWho);
+  ulonglong seq = release_seq_.load();
 
-  if (log_file_name != NULL)
+  while (seq < insert_seq_.load())
   {
-    new_front = trx_front_;
-
-    while (new_front)
+    TranxSlot *entry = slot(seq);
+    if (entry->key_.load() > key)
     {
-      if (compare(new_front, log_file_name, log_file_pos) > 0 ||
-          new_front->n_waiters > 0)
+      /* Unless the slot was released meanwhile, its key was read. */
+      ulonglong release_seq = release_seq_.load();
+      if (release_seq == seq)
         break;
-      new_front = new_front->next_;
+      seq = release_seq;
+      continue;
     }
-  }
-  else
-  {
-    /* If log_file_name is NULL, clear everything. */
-    new_front = NULL;
-  }
-
-  if (new_front == NULL)
-  {
-    /* No active transaction nodes after the call. */
 
-    /* Clear the hash table. */
-    memset(trx_htb_, 0, num_entries_ * sizeof(TranxNode *));
-    allocator_.free_all_nodes();
-
-    /* Clear the active transaction list. */
-    if (trx_front_ != NULL)
+    /* The sessions check the reply position after counting themselves. */
+    if (entry->n_waiters.load() > 0)
     {
-      trx_front_ = NULL;
-      trx_rear_  = NULL;
+      mysql_mutex_lock(&entry->lock);
+      mysql_cond_broadcast(&entry->cond);
+      mysql_mutex_unlock(&entry->lock);
     }
-
-    if (trace_level_ & kTraceDetail)
-      sql_print_information("%s: cleared all nodes", kWho);
+    if (release_seq_.compare_exchange_strong(seq, seq + 1))
+      seq++;
   }
-  else if (new_front != trx_front_)
+
+  if (free_waiter_.load())
   {
-    TranxNode *curr_node, *next_node;
+    mysql_mutex_lock(&free_lock_);
+    mysql_cond_broadcast(&free_cond_);
+    mysql_mutex_unlock(&free_lock_);
+  }
+}
 
-    /* Delete all transaction nodes before the confirmation point. */
-    int n_frees = 0;
-    curr_node = trx_front_;
-    while (curr_node != new_front)
-    {
-      next_node = curr_node->next_;
-      n_frees++;
+int ActiveTranx::signal_waiting_sessions_all()
+{
+  const char *kWho = "ActiveTranx::signal_waiting_sessions_all";
+  function_enter(kWho);
 
-      /* Remove the node from the hash table. */
-      unsigned int hash_val = get_hash_value(curr_node->log_name_, curr_node->log_pos_);
-      TranxNode **hash_ptr = &(trx_htb_[hash_val]);
-      while ((*hash_ptr) != NULL)
-      {
-        if ((*hash_ptr) == curr_node)
-	{
-          (*hash_ptr) = curr_node->hash_next_;
-          break;
-        }
-        hash_ptr = &((*hash_ptr)->hash_next_);
-      }
+  release_slots_up_to(ULONGLONG_MAX);
 
-      curr_node = next_node;
-    }
+  return function_exit(kWho, 0);
+}
 
-    trx_front_ = new_front;
-    allocator_.free_nodes_before(trx_front_);
+int ActiveTranx::signal_waiting_sessions_up_to(ulonglong key)
+{
+  const char *kWho = "ActiveTranx::signal_waiting_sessions_up_to";
+  function_enter(kWho);
 
-    if (trace_level_ & kTraceDetail)
-      sql_print_information("%s: cleared %d nodes back until pos (%s, %lu)",
-                            kWho, n_frees,
-                            trx_front_->log_name_, (unsigned long)trx_front_->log_pos_);
-  }
+  release_slots_up_to(key);
 
-  return function_exit(kWho, 0);
+  return function_exit(kWho, !is_empty());
 }
 
 
+
 /*******************************************************************************
  *
  * <ReplSemiSyncMaster> class: the basic code layer for sync-replication master.
@@ -395,16 +393,14 @@ int ActiveTranx::clear_active_tranx_nodes(const char *log_file_name,
 ReplSemiSyncMaster::ReplSemiSyncMaster()
   : active_tranxs_(NULL),
     init_done_(false),
-    reply_file_name_inited_(false),
-    reply_file_pos_(0L),
-    wait_file_name_inited_(false),
-    wait_file_pos_(0),
+    reply_key_(0),
+    commit_key_(0),
+    ack_receiver_(this),
     master_enabled_(false),
     wait_timeout_(0L),
-    state_(0)
+    state_(false)
 {
   strcpy(reply_file_name_, "");
-  strcpy(wait_file_name_, "");
 }
 
 int ReplSemiSyncMaster::initObject()
@@ -427,6 +423,11 @@ int ReplSemiSyncMaster::initObject()
   mysql_mutex_init(key_ss_mutex_LOCK_binlog_,
                    &LOCK_binlog_, MY_MUTEX_INIT_FAST);
 
+  /* Committing sessions use the list without the lock, so it is only
+   * freed at cleanup.
+   */
+  active_tranxs_ = new ActiveTranx(trace_level_);
+
   if (rpl_semi_sync_master_enabled)
     result = enableMaster();
   else
@@ -437,6 +438,11 @@ int ReplSemiSyncMaster::initObject()
     result = init_whitelist();
   }
 
+  if (result == 0)
+  {
+    result = ack_receiver_.start();
+  }
+
   latency_histogram_init(&histogram_trx_wait, histogram_trx_wait_step_size);
   return result;
 }
@@ -450,24 +456,12 @@ int ReplSemiSyncMaster::enableMaster()
 
   if (!getMasterEnabled())
   {
-    if (active_tranxs_ == NULL)
-      active_tranxs_ = new ActiveTranx(&LOCK_binlog_, trace_level_);
-
-    if (active_tranxs_ != NULL)
-    {
-      commit_file_name_inited_ = false;
-      reply_file_name_inited_  = false;
-      wait_file_name_inited_   = false;
+    commit_key_ = 0;
+    reply_key_  = 0;
 
-      set_master_enabled(true);
-      state_ = true;
-      sql_print_information("Semi-sync replication enabled on the master.");
-    }
-    else
-    {
-      sql_print_error("Cannot allocate memory to enable semi-sync on the master.");
-      result = -1;
-    }
+    set_master_enabled(true);
+    state_ = true;
+    sql_print_information("Semi-sync replication enabled on the master.");
   }
 
   unlock();
@@ -487,15 +481,8 @@ int ReplSemiSyncMaster::disableMaster()
      */
     switch_off();
 
-    if ( active_tranxs_ && active_tranxs_->is_empty())
-    {
-      delete active_tranxs_;
-      active_tranxs_ = NULL;
-    }
-
-    reply_file_name_inited_ = false;
-    wait_file_name_inited_  = false;
-    commit_file_name_inited_ = false;
+    reply_key_  = 0;
+    commit_key_ = 0;
 
     set_master_enabled(false);
     sql_print_information("Semi-sync replication disabled on the master.");
@@ -582,6 +569,7 @@ int ReplSemiSyncMaster::init_whitelist()
 
 void ReplSemiSyncMaster::cleanup()
 {
+  ack_receiver_.stop();
   free_latency_histogram_sysvars(latency_histogram_trx_wait);
   if (init_done_)
   {
@@ -590,6 +578,7 @@ void ReplSemiSyncMaster::cleanup()
   }
 
   delete active_tranxs_;
+  active_tranxs_ = NULL;
 }
 
 void ReplSemiSyncMaster::lock()
@@ -602,24 +591,31 @@ void ReplSemiSyncMaster::unlock()
   mysql_mutex_unlock(&LOCK_binlog_);
 }
 
-void ReplSemiSyncMaster::add_slave()
+void ReplSemiSyncMaster::add_slave(uint32 server_id)
 {
+  THD *thd= current_thd;
   lock();
   rpl_semi_sync_master_clients++;
-  DBUG_ASSERT(current_thd->semisync_whitelist_ver == 0);
+  DBUG_ASSERT(thd->semisync_whitelist_ver == 0);
   // case: if whitelist is ANY was init the version with 1 to avoid the initial
   // check in @verify_againt_whitelist()
   rpl_semi_sync_master_whitelist_set_lock.lock();
   if (strcmp(rpl_semi_sync_master_whitelist, "ANY") == 0)
   {
-    current_thd->semisync_whitelist_ver= 1;
+    thd->semisync_whitelist_ver= 1;
   }
   rpl_semi_sync_master_whitelist_set_lock.unlock();
   unlock();
+
+  /* The replies of the slave are read by the ack receiver if it can. */
+  ack_receiver_.add_slave(thd, server_id, get_slave_uuid(),
+                          thd->semisync_whitelist_ver);
 }
 
 void ReplSemiSyncMaster::remove_slave()
 {
+  ack_receiver_.remove_slave(current_thd);
+
   lock();
   rpl_semi_sync_master_clients--;
 
@@ -749,15 +745,29 @@ bool ReplSemiSyncMaster::update_whitelist(std::string& wlist)
 }
 
 bool ReplSemiSyncMaster::verify_against_whitelist()
+{
+  THD *thd= current_thd;
+
+  // case: the current threads version is up-to-date, no need to get the UUID
+  if (thd->semisync_whitelist_ver >= rpl_semi_sync_master_whitelist_ver.load())
+  {
+    DBUG_ASSERT(thd->semisync_whitelist_ver ==
+                rpl_semi_sync_master_whitelist_ver.load());
+    return true;
+  }
+  return verify_against_whitelist(get_slave_uuid(),
+                                  &thd->semisync_whitelist_ver);
+}
+
+bool ReplSemiSyncMaster::verify_against_whitelist(const std::string &slave_uuid,
+                                                  ulonglong *whitelist_ver)
 {
   auto local_whitelist_ver= rpl_semi_sync_master_whitelist_ver.load();
 
-  // case: the current threads version is out-dated, so we have to check the
+  // case: the slave's version is out-dated, so we have to check the
   // whitelist
-  if (current_thd->semisync_whitelist_ver < local_whitelist_ver)
+  if (*whitelist_ver < local_whitelist_ver)
   {
-    const auto& slave_uuid = get_slave_uuid();
-
     std::lock_guard<std::mutex> guard(rpl_semi_sync_master_whitelist_set_lock);
 
     // case: whitelist is enabled and this slave is not in whitelist
@@ -770,16 +780,16 @@ bool ReplSemiSyncMaster::verify_against_whitelist()
                       slave_uuid.c_str());
       return false;
     }
-    // case: update the threads whitelist version
+    // case: update the slave's whitelist version
     else
     {
-      current_thd->semisync_whitelist_ver = local_whitelist_ver;
+      *whitelist_ver = local_whitelist_ver;
     }
   }
 #ifndef DBUG_OFF
   else
   {
-    DBUG_ASSERT(current_thd->semisync_whitelist_ver == local_whitelist_ver);
+    DBUG_ASSERT(*whitelist_ver == local_whitelist_ver);
   }
 #endif
   return true;
@@ -788,12 +798,12 @@ bool ReplSemiSyncMaster::verify_against_whitelist()
 int ReplSemiSyncMaster::reportReplyBinlog(uint32 server_id,
                                           const char *log_file_name,
                                           my_off_t log_file_pos,
-                                          bool skipped_event)
+                                          bool skipped_event,
+                                          const std::string *slave_uuid,
+                                          ulonglong *whitelist_ver)
 {
   const char *kWho = "ReplSemiSyncMaster::reportReplyBinlog";
-  int   cmp;
   bool  can_release_threads = false;
-  bool  need_copy_send_pos = true;
   int   result = 0;
 
   if (!(getMasterEnabled()))
@@ -801,69 +811,111 @@ int ReplSemiSyncMaster::reportReplyBinlog(uint32 server_id,
 
   function_enter(kWho);
 
-  lock();
-
-  /* This is the real check inside the mutex. */
-  if (!getMasterEnabled())
-    goto l_end;
-
-  if (!is_on())
-    /* We check to see whether we can switch semi-sync ON. */
-    try_switch_on(server_id, log_file_name, log_file_pos);
+  const ulonglong key = ActiveTranx::pos_key(log_file_name, log_file_pos);
 
   /* Check if this reply came from a slave in the whitelist */
-  if (!verify_against_whitelist())
+  if (slave_uuid ? !verify_against_whitelist(*slave_uuid, whitelist_ver)
+                 : !verify_against_whitelist())
   {
-    result = 2;
-    goto l_end;
+    /* A reply may still switch semi-sync on, see below. */
+    lock();
+    if (getMasterEnabled() && !is_on())
+      try_switch_on(server_id, log_file_name, log_file_pos);
+    unlock();
+    return function_exit(kWho, 2);
   }
 
-  /* The position should increase monotonically, if there is only one
-   * thread sending the binlog to the slave.
-   * In reality, to improve the transaction availability, we allow multiple
-   * sync replication slaves.  So, if any one of them get the transaction,
-   * the transaction session in the primary can move forward.
+  /* While semi-sync is on, a reply in the binlog file of the current reply
+   * position only moves reply_key_ forward, which committing sessions read
+   * without the lock.  Switching semi-sync off resets reply_key_ to 0, so
+   * the move fails if it happened meanwhile.  rpl_wait_for_semi_sync_ack
+   * needs the replies signaled in order, under the lock.
    */
-  if (reply_file_name_inited_)
+#ifndef MYSQL_CLIENT
+  const bool signal_ack = rpl_wait_for_semi_sync_ack;
+#else
+  const bool signal_ack = false;
+#endif
+  bool handled = false;
+  if (is_on() && !signal_ack)
   {
-    cmp = ActiveTranx::compare(log_file_name, log_file_pos,
-                               reply_file_name_, reply_file_pos_);
-
-    /* If the requested position is behind the sending binlog position,
-     * would not adjust sending binlog position.
-     * We based on the assumption that there are multiple semi-sync slave,
-     * and at least one of them shou/ld be up to date.
-     * If all semi-sync slaves are behind, at least initially, the primary
-     * can find the situation after the waiting timeout.  After that, some
-     * slaves should catch up quickly.
-     */
-    if (cmp < 0)
+    ulonglong reply_key = reply_key_.load();
+    while (reply_key != 0 && ActiveTranx::same_file(key, reply_key) &&
+           key > reply_key)
     {
-      /* If the position is behind, do not copy it. */
-      need_copy_send_pos = false;
+      if (reply_key_.compare_exchange_weak(reply_key, key))
+      {
+        can_release_threads = true;
+        break;
+      }
     }
+    /* Otherwise the reply is not after the reply position. */
+    handled = reply_key != 0 && ActiveTranx::same_file(key, reply_key);
   }
 
-  if (need_copy_send_pos)
+  if (!handled)
   {
-    strncpy(reply_file_name_, log_file_name, sizeof(reply_file_name_) - 1);
-    reply_file_name_[sizeof(reply_file_name_) - 1]= '\0';
-    reply_file_pos_ = log_file_pos;
-    reply_file_name_inited_ = true;
+    lock();
 
-#ifndef MYSQL_CLIENT
-    if (rpl_wait_for_semi_sync_ack)
+    /* This is the real check inside the mutex. */
+    if (getMasterEnabled())
     {
-      const LOG_POS_COORD coord { (char*) reply_file_name_, reply_file_pos_ };
-      signal_semi_sync_ack(&coord);
-      if (trace_level_ & kTraceDetail)
+      if (!is_on())
+        /* We check to see whether we can switch semi-sync ON. */
+        try_switch_on(server_id, log_file_name, log_file_pos);
+
+      /* The position should increase monotonically, if there is only one
+       * thread sending the binlog to the slave.
+       * In reality, to improve the transaction availability, we allow multiple
+       * sync replication slaves.  So, if any one of them get the transaction,
+       * the transaction session in the primary can move forward.
+       *
+       * If the requested position is behind the sending binlog position,
+       * would not adjust sending binlog position.
+       * We based on the assumption that there are multiple semi-sync slave,
+       * and at least one of them shou/ld be up to date.
+       * If all semi-sync slaves are behind, at least initially, the primary
+       * can find the situation after the waiting timeout.  After that, some
+       * slaves should catch up quickly.
+       */
+      ulonglong reply_key = reply_key_.load();
+      if (key >= reply_key)
       {
-        sql_print_information("[rpl_wait_for_semi_sync_ack] Signaled till: "
-                              "%s:%llu", coord.file_name, coord.pos);
+        strncpy(reply_file_name_, log_file_name, sizeof(reply_file_name_) - 1);
+        reply_file_name_[sizeof(reply_file_name_) - 1]= '\0';
+        /* Replies in the same file may move the key without the lock. */
+        while (key >= reply_key &&
+               !reply_key_.compare_exchange_weak(reply_key, key))
+        {}
+
+#ifndef MYSQL_CLIENT
+        if (signal_ack)
+        {
+          const LOG_POS_COORD coord { (char*) log_file_name, log_file_pos };
+          signal_semi_sync_ack(&coord);
+          if (trace_level_ & kTraceDetail)
+          {
+            sql_print_information("[rpl_wait_for_semi_sync_ack] Signaled till: "
+                                  "%s:%llu", coord.file_name, coord.pos);
+          }
+        }
+#endif
+
+        /* Let us check if some of the waiting threads doing a trx
+         * commit can now proceed.
+         */
+        can_release_threads = true;
       }
     }
-#endif
 
+    unlock();
+  }
+
+  /* The slots are released without the lock, the sessions waiting on them
+   * do not take it either.
+   */
+  if (can_release_threads)
+  {
     if (trace_level_ & kTraceDetail)
     {
       if(!skipped_event)
@@ -872,35 +924,11 @@ int ReplSemiSyncMaster::reportReplyBinlog(uint32 server_id,
       else
         sql_print_information("%s: Transaction skipped at (%s, %lu)", kWho,
                             log_file_name, (unsigned long)log_file_pos);
+      sql_print_information("%s: signal threads waiting up to (%s, %lu).",
+                            kWho, log_file_name, (unsigned long)log_file_pos);
     }
+    active_tranxs_->signal_waiting_sessions_up_to(key);
   }
-
-  if (rpl_semi_sync_master_wait_sessions > 0)
-  {
-    /* Let us check if some of the waiting threads doing a trx
-     * commit can now proceed.
-     */
-    cmp = ActiveTranx::compare(reply_file_name_, reply_file_pos_,
-                               wait_file_name_, wait_file_pos_);
-    if (cmp >= 0)
-    {
-      /* Yes, at least one waiting thread can now proceed:
-       * let us release all waiting threads with a broadcast
-       */
-      can_release_threads = true;
-      wait_file_name_inited_ = false;
-    }
-  }
-
- l_end:
-
-  if (can_release_threads)
-  {
-    if (trace_level_ & kTraceDetail)
-      sql_print_information("%s: signal all waiting threads.", kWho);
-    active_tranxs_->signal_waiting_sessions_up_to(reply_file_name_, reply_file_pos_);
-  }
-  unlock();
   return function_exit(kWho, result);
 }
 
@@ -917,43 +945,60 @@ int ReplSemiSyncMaster::commitTrx(const char* trx_wait_binlog_name,
   if (current_thd->debug_sync_control)
     DEBUG_SYNC(current_thd, "rpl_semisync_master_commit_trx_before_lock");
 #endif
-  /* Acquire the mutex. */
-  lock();
 
-  TranxNode* entry= NULL;
-  mysql_cond_t* thd_cond= NULL;
+  if (!getMasterEnabled() || !trx_wait_binlog_name)
+    return function_exit(kWho, 0);
+
+  const ulonglong key = ActiveTranx::pos_key(trx_wait_binlog_name,
+                                             trx_wait_binlog_pos);
   bool is_semi_sync_trans= true;
-  if (active_tranxs_ != NULL && trx_wait_binlog_name)
+  bool timed_out= false;
+
+  if (!is_on())
+    goto l_end;
+
+  if (trace_level_ & kTraceDetail)
   {
-    entry=
-      active_tranxs_->find_active_tranx_node(trx_wait_binlog_name,
-                                             trx_wait_binlog_pos);
-    if (entry)
-      thd_cond= &entry->cond;
+    sql_print_information("%s: wait pos (%s, %lu), repl(%d)\n", kWho,
+                          trx_wait_binlog_name, (unsigned long)trx_wait_binlog_pos,
+                          (int)is_on());
   }
-  /* This must be called after acquired the lock */
-  THD_ENTER_COND(NULL, thd_cond, &LOCK_binlog_,
-                 & stage_waiting_for_semi_sync_ack_from_slave,
-                 & old_stage);
 
-  if (getMasterEnabled() && trx_wait_binlog_name)
+  if (reply_key_.load() < key)
   {
     struct timespec start_ts;
     struct timespec abstime;
-    int wait_result;
-
-    set_timespec(start_ts, 0);
-    /* This is the real check inside the mutex. */
-    if (!getMasterEnabled() || !is_on())
-      goto l_end;
-
-    if (trace_level_ & kTraceDetail)
+    int wait_result = 0;
+
+    /*
+      The slot of the group the transaction was flushed in, which is released
+      once a slave replied up to the end of the group.
+
+      When code reaches here a slot may not be present in the following
+      scenarios.
+
+      The slot was released since the reply position was read. Then the
+      slave replied for the transaction, or semi-sync was switched off.
+
+      Semi sync was not enabled when transaction entered into ordered_commit
+      process. During flush stage, semi sync was not enabled and there was no
+      slot used for the transaction being committed and at a later stage it
+      was enabled. In this case trx_wait_binlog_name and trx_wait_binlog_pos
+      are set but no slot is present. Hence dump thread will not wait for
+      reply from slave and it will not update reply_file_name. In such case
+      the committing transaction should not wait for an ack from slave and
+      it should be considered as an async transaction.
+    */
+    TranxSlot *entry = active_tranxs_->find_active_tranx_slot(key);
+    if (!entry)
     {
-      sql_print_information("%s: wait pos (%s, %lu), repl(%d)\n", kWho,
-                            trx_wait_binlog_name, (unsigned long)trx_wait_binlog_pos,
-                            (int)is_on());
+      if (is_on() && reply_key_.load() < key)
+        is_semi_sync_trans= false;
+      goto l_end;
     }
 
+    set_timespec(start_ts, 0);
+
     /* Calcuate the waiting period. */
 #ifndef HAVE_STRUCT_TIMESPEC
       abstime.tv.i64 = start_ts.tv.i64 + (__int64)wait_timeout_ * TIME_THOUSAND * 10;
@@ -969,154 +1014,101 @@ int ReplSemiSyncMaster::commitTrx(const char* trx_wait_binlog_name,
       }
 #endif /* __WIN__ */
 
-    while (is_on() && entry)
-    {
-      if (reply_file_name_inited_)
-      {
-        int cmp = ActiveTranx::compare(reply_file_name_, reply_file_pos_,
-                                       trx_wait_binlog_name, trx_wait_binlog_pos);
-        if (cmp >= 0)
-        {
-          /* We have already sent the relevant binlog to the slave: no need to
-           * wait here.
-           */
-          if (trace_level_ & kTraceDetail)
-            sql_print_information("%s: Binlog reply is ahead (%s, %lu),",
-                                  kWho, reply_file_name_, (unsigned long)reply_file_pos_);
-          break;
-        }
-      }
-      /*
-        When code reaches here an Entry object may not be present in the
-        following scenario.
-
-        Semi sync was not enabled when transaction entered into ordered_commit
-        process. During flush stage, semi sync was not enabled and there was no
-        'Entry' object created for the transaction being committed and at a
-        later stage it was enabled. In this case trx_wait_binlog_name and
-        trx_wait_binlog_pos are set but the 'Entry' object is not present. Hence
-        dump thread will not wait for reply from slave and it will not update
-        reply_file_name. In such case the committing transaction should not wait
-        for an ack from slave and it should be considered as an async
-        transaction.
-      */
-      if (!entry)
-      {
-        is_semi_sync_trans= false;
-        goto l_end;
-      }
+    /* In semi-synchronous replication, we wait until the binlog-dump
+     * thread has received the reply on the relevant binlog segment from the
+     * replication slave.
+     *
+     * Let us suspend this thread to wait on the condition of the slot;
+     * when replication has progressed far enough, the slot is released
+     * and the sessions waiting on it are woken up.  The session counts
+     * itself before checking the reply position, so that the thread
+     * releasing the slot after moving the reply position signals it.
+     */
+    mysql_mutex_lock(&entry->lock);
+    THD_ENTER_COND(NULL, &entry->cond, &entry->lock,
+                   & stage_waiting_for_semi_sync_ack_from_slave,
+                   & old_stage);
+    entry->n_waiters++;
+    my_atomic_add64((int64 *) &rpl_semi_sync_master_wait_sessions, 1);
 
-      /* Let us update the info about the minimum binlog position of waiting
-       * threads.
-       */
-      if (wait_file_name_inited_)
-      {
-        int cmp = ActiveTranx::compare(trx_wait_binlog_name, trx_wait_binlog_pos,
-                                       wait_file_name_, wait_file_pos_);
-        if (cmp <= 0)
-	{
-          /* This thd has a lower position, let's update the minimum info. */
-          strncpy(wait_file_name_, trx_wait_binlog_name, sizeof(wait_file_name_) - 1);
-          wait_file_name_[sizeof(wait_file_name_) - 1]= '\0';
-          wait_file_pos_ = trx_wait_binlog_pos;
-
-          rpl_semi_sync_master_wait_pos_backtraverse++;
-          if (trace_level_ & kTraceDetail)
-            sql_print_information("%s: move back wait position (%s, %lu),",
-                                  kWho, wait_file_name_, (unsigned long)wait_file_pos_);
-        }
-      }
-      else
-      {
-        strncpy(wait_file_name_, trx_wait_binlog_name, sizeof(wait_file_name_) - 1);
-        wait_file_name_[sizeof(wait_file_name_) - 1]= '\0';
-        wait_file_pos_ = trx_wait_binlog_pos;
-        wait_file_name_inited_ = true;
-
-        if (trace_level_ & kTraceDetail)
-          sql_print_information("%s: init wait position (%s, %lu),",
-                                kWho, wait_file_name_, (unsigned long)wait_file_pos_);
-      }
+    if (trace_level_ & kTraceDetail)
+      sql_print_information("%s: wait %lu ms for binlog sent (%s, %lu)",
+                            kWho, wait_timeout_,
+                            trx_wait_binlog_name,
+                            (unsigned long)trx_wait_binlog_pos);
 
-      /* In semi-synchronous replication, we wait until the binlog-dump
-       * thread has received the reply on the relevant binlog segment from the
-       * replication slave.
-       *
-       * Let us suspend this thread to wait on the condition;
-       * when replication has progressed far enough, we will release
-       * these waiting threads.
-       */
-      rpl_semi_sync_master_wait_sessions++;
-      
-      if (trace_level_ & kTraceDetail)
-        sql_print_information("%s: wait %lu ms for binlog sent (%s, %lu)",
-                              kWho, wait_timeout_,
-                              wait_file_name_, (unsigned long)wait_file_pos_);
-      
-      /* wait for the position to be ACK'ed back */
-      assert(entry);
-      entry->n_waiters++;
-      wait_result= mysql_cond_timedwait(&entry->cond, &LOCK_binlog_, &abstime);
-      entry->n_waiters--;
-      rpl_semi_sync_master_wait_sessions--;
-      
-      if (wait_result != 0)
+    /* wait for the position to be ACK'ed back */
+    while (is_on() && reply_key_.load() < key && wait_result == 0)
+      wait_result= mysql_cond_timedwait(&entry->cond, &entry->lock, &abstime);
+
+    entry->n_waiters--;
+    my_atomic_add64((int64 *) &rpl_semi_sync_master_wait_sessions, -1);
+    /* The lock held will be released by thd_exit_cond */
+    THD_EXIT_COND(NULL, & old_stage);
+
+    if (wait_result != 0 && reply_key_.load() < key)
+    {
+      timed_out= true;
+      lock();
+      if (is_on() && reply_key_.load() < key)
       {
         /* This is a real wait timeout. */
         sql_print_warning("Timeout waiting for reply of binlog (file: %s, pos: %lu), "
                           "semi-sync up to file %s, position %lu.",
                           trx_wait_binlog_name, (unsigned long)trx_wait_binlog_pos,
-                          reply_file_name_, (unsigned long)reply_file_pos_);
-        rpl_semi_sync_master_wait_timeouts++;
-        
+                          reply_file_name_,
+                          (unsigned long)ActiveTranx::key_pos(reply_key_.load()));
+        my_atomic_add64((int64 *) &rpl_semi_sync_master_wait_timeouts, 1);
+
         /* switch semi-sync off */
         switch_off();
       }
-      else
+      unlock();
+    }
+    else if (reply_key_.load() >= key)
+    {
+      int wait_time;
+
+      wait_time = getWaitTime(start_ts);
+      if (wait_time < 0)
       {
-        int wait_time;
-        
-        wait_time = getWaitTime(start_ts);
-        if (wait_time < 0)
-        {
-          if (trace_level_ & kTraceGeneral)
-          {
-            sql_print_information("Assessment of waiting time for commitTrx "
-                                  "failed at wait position (%s, %lu)",
-                                  trx_wait_binlog_name,
-                                  (unsigned long)trx_wait_binlog_pos);
-          }
-          rpl_semi_sync_master_timefunc_fails++;
-        }
-        else
+        if (trace_level_ & kTraceGeneral)
         {
-          rpl_semi_sync_master_trx_wait_num++;
-          rpl_semi_sync_master_trx_wait_time += wait_time;
-          if (histogram_trx_wait_step_size)
-            latency_histogram_increment(&histogram_trx_wait,
-              microseconds_to_my_timer((double)wait_time), 1);
+          sql_print_information("Assessment of waiting time for commitTrx "
+                                "failed at wait position (%s, %lu)",
+                                trx_wait_binlog_name,
+                                (unsigned long)trx_wait_binlog_pos);
         }
+        my_atomic_add64((int64 *) &rpl_semi_sync_master_timefunc_fails, 1);
+      }
+      else
+      {
+        my_atomic_add64((int64 *) &rpl_semi_sync_master_trx_wait_num, 1);
+        my_atomic_add64((int64 *) &rpl_semi_sync_master_trx_wait_time,
+                        wait_time);
+        if (histogram_trx_wait_step_size)
+          latency_histogram_increment(&histogram_trx_wait,
+            microseconds_to_my_timer((double)wait_time), 1);
       }
     }
-
-l_end:
-    /* Update the status counter. */
-    if (is_on() && is_semi_sync_trans)
-      rpl_semi_sync_master_yes_transactions++;
-    else
-      rpl_semi_sync_master_no_transactions++;
-
+  }
+  else if (trace_level_ & kTraceDetail)
+  {
+    /* We have already sent the relevant binlog to the slave: no need to
+     * wait here.
+     */
+    sql_print_information("%s: Binlog reply is ahead of (%s, %lu),",
+                          kWho, trx_wait_binlog_name,
+                          (unsigned long)trx_wait_binlog_pos);
   }
 
-  /* Last waiter removes the TranxNode */
-  if (trx_wait_binlog_name && active_tranxs_
-      && entry && entry->n_waiters == 0)
-    active_tranxs_->clear_active_tranx_nodes(trx_wait_binlog_name,
-                                             trx_wait_binlog_pos);
+l_end:
+  /* Update the status counter. */
+  if (!timed_out && is_on() && is_semi_sync_trans)
+    my_atomic_add64((int64 *) &rpl_semi_sync_master_yes_transactions, 1);
+  else
+    my_atomic_add64((int64 *) &rpl_semi_sync_master_no_transactions, 1);
 
-  /* The lock held will be released by thd_exit_cond, so no need to
-    call unlock() here */
-  THD_EXIT_COND(NULL, & old_stage);
   return function_exit(kWho, 0);
 }
 
@@ -1154,8 +1146,7 @@ int ReplSemiSyncMaster::switch_off()
   state_ = false;
 
   rpl_semi_sync_master_off_times++;
-  wait_file_name_inited_   = false;
-  reply_file_name_inited_  = false;
+  reply_key_ = 0;
   sql_print_information("Semi-sync replication switched OFF.");
 
   /* signal waiting sessions */
@@ -1176,19 +1167,13 @@ int ReplSemiSyncMaster::try_switch_on(int server_id,
   /* If the current sending event's position is larger than or equal to the
    * 'largest' commit transaction binlog position, the slave is already
    * catching up now and we can switch semi-sync on here.
-   * If commit_file_name_inited_ indicates there are no recent transactions,
-   * we can enable semi-sync immediately.
+   * If commit_key_ indicates there are no recent transactions, we can
+   * enable semi-sync immediately.
    */
-  if (commit_file_name_inited_)
-  {
-    int cmp = ActiveTranx::compare(log_file_name, log_file_pos,
-                                   commit_file_name_, commit_file_pos_);
-    semi_sync_on = (cmp >= 0);
-  }
-  else
-  {
-    semi_sync_on = true;
-  }
+  const ulonglong commit_key = commit_key_.load();
+  semi_sync_on = (commit_key == 0 ||
+                  ActiveTranx::pos_key(log_file_name, log_file_pos) >=
+                  commit_key);
 
   if (semi_sync_on)
   {
@@ -1236,7 +1221,6 @@ int ReplSemiSyncMaster::updateSyncHeader(unsigned char *packet,
 					 uint32 server_id)
 {
   const char *kWho = "ReplSemiSyncMaster::updateSyncHeader";
-  int  cmp = 0;
   bool sync = false;
 
   /* If the semi-sync master is not enabled, or the slave is not a semi-sync
@@ -1248,65 +1232,36 @@ int ReplSemiSyncMaster::updateSyncHeader(unsigned char *packet,
 
   function_enter(kWho);
 
-  lock();
-
-  /* This is the real check inside the mutex. */
-  if (!getMasterEnabled())
-    goto l_end; // sync= false at this point in time
+  /* The positions are read without the lock: a reply requested after
+   * semi-sync was switched off, or one missed for a position released
+   * meanwhile, is harmless.
+   */
+  const ulonglong key = ActiveTranx::pos_key(log_file_name, log_file_pos);
 
   if (is_on())
   {
     /* semi-sync is ON */
     /* sync= false; No sync unless a transaction is involved. */
 
-    if (reply_file_name_inited_)
+    if (key <= reply_key_.load())
     {
-      cmp = ActiveTranx::compare(log_file_name, log_file_pos,
-                                 reply_file_name_, reply_file_pos_);
-      if (cmp <= 0)
-      {
-        /* If we have already got the reply for the event, then we do
-         * not need to sync the transaction again.
-         */
-        goto l_end;
-      }
+      /* If we have already got the reply for the event, then we do
+       * not need to sync the transaction again.
+       */
+      goto l_end;
     }
 
-    if (wait_file_name_inited_)
-    {
-      cmp = ActiveTranx::compare(log_file_name, log_file_pos,
-                                 wait_file_name_, wait_file_pos_);
-    }
-    else
-    {
-      cmp = 1;
-    }
-    
-    /* If we are already waiting for some transaction replies which
-     * are later in binlog, do not wait for this one event.
+    /*
+     * We only wait if the event is the ending event of the last
+     * transaction of a group, for which the sessions wait.
      */
-    if (cmp >= 0)
-    {
-      /* 
-       * We only wait if the event is a transaction's ending event.
-       */
-      assert(active_tranxs_ != NULL);
-      sync = active_tranxs_->is_tranx_end_pos(log_file_name,
-                                               log_file_pos);
-    }
+    assert(active_tranxs_ != NULL);
+    sync = active_tranxs_->is_tranx_end_pos(key);
   }
   else
   {
-    if (commit_file_name_inited_)
-    {
-      int cmp = ActiveTranx::compare(log_file_name, log_file_pos,
-                                     commit_file_name_, commit_file_pos_);
-      sync = (cmp >= 0);
-    }
-    else
-    {
-      sync = true;
-    }
+    const ulonglong commit_key = commit_key_.load();
+    sync = (commit_key == 0 || key >= commit_key);
   }
 
   if (trace_level_ & kTraceDetail)
@@ -1315,8 +1270,6 @@ int ReplSemiSyncMaster::updateSyncHeader(unsigned char *packet,
                           (unsigned long)log_file_pos, sync, (int)is_on());
 
  l_end:
-  unlock();
-
   /* We do not need to clear sync flag because we set it to 0 when we
    * reserve the packet header.
    */
@@ -1336,57 +1289,46 @@ int ReplSemiSyncMaster::writeTranxInBinlog(const char* log_file_name,
 
   function_enter(kWho);
 
-  lock();
-
-  /* This is the real check inside the mutex. */
   if (!getMasterEnabled())
     goto l_end;
 
-  /* Update the 'largest' transaction commit position seen so far even
-   * though semi-sync is switched off.
-   * It is much better that we update commit_file_* here, instead of
-   * inside commitTrx().  This is mostly because updateSyncHeader()
-   * will watch for commit_file_* to decide whether to switch semi-sync
-   * on. The detailed reason is explained in function updateSyncHeader().
-   */
-  if (commit_file_name_inited_)
-  {
-    int cmp = ActiveTranx::compare(log_file_name, log_file_pos,
-                                   commit_file_name_, commit_file_pos_);
-    if (cmp > 0)
-    {
-      /* This is a larger position, let's update the maximum info. */
-      strncpy(commit_file_name_, log_file_name, FN_REFLEN-1);
-      commit_file_name_[FN_REFLEN-1] = 0; /* make sure it ends properly */
-      commit_file_pos_ = log_file_pos;
-    }
-  }
-  else
   {
-    strncpy(commit_file_name_, log_file_name, FN_REFLEN-1);
-    commit_file_name_[FN_REFLEN-1] = 0; /* make sure it ends properly */
-    commit_file_pos_ = log_file_pos;
-    commit_file_name_inited_ = true;
-  }
+    /* Only the session flushing the binlog calls this, under LOCK_log, so
+     * the positions are written by a single thread.
+     */
+    const ulonglong key = ActiveTranx::pos_key(log_file_name, log_file_pos);
+
+    /* Update the 'largest' transaction commit position seen so far even
+     * though semi-sync is switched off.
+     * It is much better that we update commit_key_ here, instead of
+     * inside commitTrx().  This is mostly because updateSyncHeader()
+     * will watch for commit_key_ to decide whether to switch semi-sync
+     * on. The detailed reason is explained in function updateSyncHeader().
+     */
+    if (key > commit_key_.load())
+      commit_key_.store(key);
 
-  if (is_on())
-  {
-    assert(active_tranxs_ != NULL);
-    if(active_tranxs_->insert_tranx_node(log_file_name, log_file_pos))
+    if (is_on())
     {
-      /*
-        if insert tranx_node failed, print a warning message
-        and turn off semi-sync
-      */
-      sql_print_warning("Semi-sync failed to insert tranx_node for binlog file: %s, position: %lu",
-                        log_file_name, (ulong)log_file_pos);
-      switch_off();
+      assert(active_tranxs_ != NULL);
+      if(active_tranxs_->insert_tranx_node(log_file_name, log_file_pos,
+                                           wait_timeout_))
+      {
+        /*
+          if insert tranx_node failed, print a warning message
+          and turn off semi-sync
+        */
+        sql_print_warning("Semi-sync failed to insert tranx_node for binlog file: %s, position: %lu",
+                          log_file_name, (ulong)log_file_pos);
+        lock();
+        if (is_on())
+          switch_off();
+        unlock();
+      }
     }
   }
 
  l_end:
-  unlock();
-
   return function_exit(kWho, result);
 }
 
@@ -1417,10 +1359,6 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
                                        const char *event_buf)
 {
   const char *kWho = "ReplSemiSyncMaster::readSlaveReply";
-  const unsigned char *packet;
-  char     log_file_name[FN_REFLEN];
-  my_off_t log_file_pos;
-  ulong    log_file_len = 0;
   ulong    packet_len;
   int      result = -1;
 
@@ -1450,6 +1388,11 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
     goto l_end;
   }
 
+  /* The ack receiver reads the reply, if it listens to the slave. */
+  result = ack_receiver_.expect_reply(current_thd, net);
+  if (result >= 0)
+    goto l_end;
+
   net_clear(net, 0);
   if (trc_level & kTraceDetail)
     sql_print_information("%s: Wait for replica's reply", kWho);
@@ -1468,7 +1411,7 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
     {
       sql_print_information("Assessment of waiting time for "
                             "readSlaveReply failed.");
-      rpl_semi_sync_master_timefunc_fails++;
+      my_atomic_add64((int64 *) &rpl_semi_sync_master_timefunc_fails, 1);
     }
     else
     {
@@ -1477,18 +1420,41 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
     }
   }
 
-  if (packet_len == packet_error || packet_len < REPLY_BINLOG_NAME_OFFSET)
+  if (packet_len == packet_error)
   {
-    if (packet_len == packet_error)
-      sql_print_error("Read semi-sync reply network error: %s (errno: %d)",
-                      net->last_error, net->last_errno);
-    else
-      sql_print_error("Read semi-sync reply length error: %s (errno: %d)",
-                      net->last_error, net->last_errno);
+    sql_print_error("Read semi-sync reply network error: %s (errno: %d)",
+                    net->last_error, net->last_errno);
+    result = -1;
+    goto l_end;
+  }
+
+  result = reportReplyPacket(server_id, net->read_pos, packet_len);
+
+ l_end:
+  return function_exit(kWho, result);
+}
+
+int ReplSemiSyncMaster::reportReplyPacket(uint32 server_id,
+                                          const uchar *packet,
+                                          ulong packet_len,
+                                          const std::string *slave_uuid,
+                                          ulonglong *whitelist_ver)
+{
+  const char *kWho = "ReplSemiSyncMaster::reportReplyPacket";
+  char     log_file_name[FN_REFLEN];
+  my_off_t log_file_pos;
+  ulong    log_file_len = 0;
+  int      result = -1;
+
+  function_enter(kWho);
+
+  if (packet_len < REPLY_BINLOG_NAME_OFFSET)
+  {
+    sql_print_error("Read semi-sync reply length error: packet length %lu",
+                    packet_len);
     goto l_end;
   }
 
-  packet = net->read_pos;
   if (packet[REPLY_MAGIC_NUM_OFFSET] != ReplSemiSyncMaster::kPacketMagicNum)
   {
     sql_print_error("Read semi-sync reply magic number error");
@@ -1505,11 +1471,12 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
   strncpy(log_file_name, (const char*)packet + REPLY_BINLOG_NAME_OFFSET, log_file_len);
   log_file_name[log_file_len] = 0;
 
-  if (trc_level & kTraceDetail)
+  if (trace_level_ & kTraceDetail)
     sql_print_information("%s: Got reply (%s, %lu)",
                           kWho, log_file_name, (ulong)log_file_pos);
 
-  result = reportReplyBinlog(server_id, log_file_name, log_file_pos);
+  result = reportReplyBinlog(server_id, log_file_name, log_file_pos, false,
+                             slave_uuid, whitelist_ver);
 
  l_end:
   return function_exit(kWho, result);
@@ -1528,15 +1495,13 @@ int ReplSemiSyncMaster::resetMaster()
 
   state_ = getMasterEnabled()? 1 : 0;
 
-  wait_file_name_inited_   = false;
-  reply_file_name_inited_  = false;
-  commit_file_name_inited_ = false;
+  reply_key_ = 0;
+  commit_key_ = 0;
 
   rpl_semi_sync_master_yes_transactions = 0;
   rpl_semi_sync_master_no_transactions = 0;
   rpl_semi_sync_master_off_times = 0;
   rpl_semi_sync_master_timefunc_fails = 0;
-  rpl_semi_sync_master_wait_sessions = 0;
   rpl_semi_sync_master_wait_pos_backtraverse = 0;
   rpl_semi_sync_master_trx_wait_num = 0;
   rpl_semi_sync_master_trx_wait_time = 0;
@@ -19,357 +19,127 @@
 #define SEMISYNC_MASTER_H
 
 #include "semisync.h"
+#include "semisync_master_ack_receiver.h"
+#include <atomic>
 
 #ifdef HAVE_PSI_INTERFACE
 extern PSI_mutex_key key_ss_mutex_LOCK_binlog_;
+extern PSI_mutex_key key_ss_mutex_LOCK_tranx_slot_;
+extern PSI_mutex_key key_ss_mutex_LOCK_free_slot_;
 extern PSI_cond_key key_ss_cond_COND_binlog_send_;
+extern PSI_cond_key key_ss_cond_COND_free_slot_;
+extern PSI_thread_key key_ss_thread_ack_receiver;
 #endif
 
 extern PSI_stage_info stage_waiting_for_semi_sync_ack_from_slave;
 
-struct TranxNode {
-  char             log_name_[FN_REFLEN];
-  my_off_t         log_pos_;
-  mysql_cond_t     cond;
-  int              n_waiters;
-  struct TranxNode *next_;            /* the next node in the sorted list */
-  struct TranxNode *hash_next_;    /* the next node during hash collision */
+/**
+   A slot of the active transaction list, holding the binlog position up
+   to which a group of transactions was flushed. The sessions waiting for
+   the slave to acknowledge one of them sleep on the slot's condition.
+*/
+struct TranxSlot {
+  std::atomic<ulonglong> key_;           /* ActiveTranx::pos_key() of the end */
+  std::atomic<int>       n_waiters;
+  mysql_mutex_t          lock;
+  mysql_cond_t           cond;
 };
 
 /**
-  @class TranxNodeAllocator
-
-  This class provides memory allocating and freeing methods for
-  TranxNode. The main target is performance.
-
-  @section ALLOCATE How to allocate a node
-    The pointer of the first node after 'last_node' in current_block is
-    returned. current_block will move to the next free Block when all nodes of
-    it are in use. A new Block is allocated and is put into the rear of the
-    Block link table if no Block is free.
-
-    The list starts up empty (ie, there is no allocated Block).
-
-    After some nodes are freed, there probably are some free nodes before
-    the sequence of the allocated nodes, but we do not reuse it. It is better
-    to keep the allocated nodes are in the sequence, for it is more efficient
-    for allocating and freeing TranxNode.
-
-  @section FREENODE How to free nodes
-    There are two methods for freeing nodes. They are free_all_nodes and
-    free_nodes_before.
-
-    'A Block is free' means all of its nodes are free.
-    @subsection free_nodes_before
-    As all allocated nodes are in the sequence, 'Before one node' means all
-    nodes before given node in the same Block and all Blocks before the Block
-    which containing the given node. As such, all Blocks before the given one
-    ('node') are free Block and moved into the rear of the Block link table.
-    The Block containing the given 'node', however, is not. For at least the
-    given 'node' is still in use. This will waste at most one Block, but it is
-    more efficient.
- */
-#define BLOCK_TRANX_NODES 16
-class TranxNodeAllocator
-{
-public:
-  /**
-    @param reserved_nodes
-      The number of reserved TranxNodes. It is used to set 'reserved_blocks'
-      which can contain at least 'reserved_nodes' number of TranxNodes.  When
-      freeing memory, we will reserve at least reserved_blocks of Blocks not
-      freed.
-   */
-  TranxNodeAllocator(uint reserved_nodes) :
-    reserved_blocks(reserved_nodes/BLOCK_TRANX_NODES +
-                  (reserved_nodes%BLOCK_TRANX_NODES > 1 ? 2 : 1)),
-    first_block(NULL), last_block(NULL),
-    current_block(NULL), last_node(-1), block_num(0) {}
-
-  ~TranxNodeAllocator()
-  {
-    Block *block= first_block;
-    while (block != NULL)
-    {
-      Block *next= block->next;
-      free_block(block);
-      block= next;
-    }
-  }
-
-  /**
-    The pointer of the first node after 'last_node' in current_block is
-    returned. current_block will move to the next free Block when all nodes of
-    it are in use. A new Block is allocated and is put into the rear of the
-    Block link table if no Block is free.
-
-    @return Return a TranxNode *, or NULL if an error occured.
-   */
-  TranxNode *allocate_node()
-  {
-    TranxNode *trx_node;
-    Block *block= current_block;
-
-    if (last_node == BLOCK_TRANX_NODES-1)
-    {
-      current_block= current_block->next;
-      last_node= -1;
-    }
-
-    if (current_block == NULL && allocate_block())
-    {
-      current_block= block;
-      if (current_block)
-        last_node= BLOCK_TRANX_NODES-1;
-      return NULL;
-    }
-
-    trx_node= &(current_block->nodes[++last_node]);
-    trx_node->log_name_[0] = '\0';
-    trx_node->log_pos_= 0;
-    trx_node->next_= 0;
-    trx_node->hash_next_= 0;
-    trx_node->n_waiters= 0;
-    return trx_node;
-  }
-
-  /**
-    All nodes are freed.
-
-    @return Return 0, or 1 if an error occured.
-   */
-  int free_all_nodes()
-  {
-    current_block= first_block;
-    last_node= -1;
-    free_blocks();
-    return 0;
-  }
-
-  /**
-    All Blocks before the given 'node' are free Block and moved into the rear
-    of the Block link table.
-
-    @param node All nodes before 'node' will be freed
-
-    @return Return 0, or 1 if an error occured.
-   */
-  int free_nodes_before(TranxNode* node)
-  {
-    Block *block;
-    Block *prev_block= NULL;
-
-    block= first_block;
-    while (block != current_block->next)
-    {
-      /* Find the Block containing the given node */
-      if (&(block->nodes[0]) <= node && &(block->nodes[BLOCK_TRANX_NODES]) >= node)
-      {
-        /* All Blocks before the given node are put into the rear */
-        if (first_block != block)
-        {
-          last_block->next= first_block;
-          first_block= block;
-          last_block= prev_block;
-          last_block->next= NULL;
-          free_blocks();
-        }
-        return 0;
-      }
-      prev_block= block;
-      block= block->next;
-    }
-
-    /* Node does not find should never happen */
-    DBUG_ASSERT(0);
-    return 1;
-  }
-
+   This class manages the active transaction list.
+
+   The list is a ring of slots ordered by binlog position. The session
+   flushing the binlog, which holds mysql_bin_log.LOCK_log, appends the end
+   position of each group it writes, and the slots are released in order
+   when a slave acknowledges a position at or after theirs, or when
+   semi-sync switches off. Both ends are sequence numbers which only grow,
+   so committing sessions find their slot, and acknowledgements release
+   slots, without a lock in common: a session only takes the mutex of its
+   slot to sleep, and a slot is only locked on release if sessions wait on
+   it.
+
+   A slot may be reused for a later position once it has been released,
+   so readers check the slot they read was not released meanwhile. When
+   all slots are in use, the session flushing the binlog waits for one to
+   be released.
+*/
+class ActiveTranx
+  :public Trace {
 private:
-  uint reserved_blocks;
 
- /**
-   A sequence memory which contains BLOCK_TRANX_NODES TranxNodes.
+  TranxSlot       *slots_;
+  ulonglong        num_slots_;               /* a power of two */
 
-   BLOCK_TRANX_NODES The number of TranxNodes which are in a Block.
+  /* Sequence number of the next slot to fill. */
+  std::atomic<ulonglong> insert_seq_;
+  /* Sequence number of the first slot which has not been released. */
+  std::atomic<ulonglong> release_seq_;
 
-   next Every Block has a 'next' pointer which points to the next Block.
-        These linking Blocks constitute a Block link table.
-  */
-  struct Block {
-    Block *next;
-    TranxNode nodes[BLOCK_TRANX_NODES];
-  };
+  TranxSlot *slot(ulonglong seq) {
+    return &slots_[seq & (num_slots_ - 1)];
+  }
 
-  /**
-    The 'first_block' is the head of the Block link table;
+  /* Signaled when a slot is released while the session flushing the
+   * binlog waits for one.
    */
-  Block *first_block;
-  /**
-    The 'last_block' is the rear of the Block link table;
-   */
-  Block *last_block;
+  mysql_mutex_t          free_lock_;
+  mysql_cond_t           free_cond_;
+  std::atomic<bool>      free_waiter_;
 
-  /**
-    current_block always points the Block in the Block link table in
-    which the last allocated node is. The Blocks before it are all in use
-    and the Blocks after it are all free.
-   */
-  Block *current_block;
+  bool find_slot_seq(ulonglong key, ulonglong *seq);
+  void release_slots_up_to(ulonglong key);
+  bool wait_for_free_slot(ulonglong seq, unsigned long wait_ms);
 
-  /**
-    It always points to the last node which has been allocated in the
-    current_block.
-   */
-  int last_node;
+public:
+  ActiveTranx(unsigned long trace_level);
+  ~ActiveTranx();
 
-  /**
-    How many Blocks are in the Block link table.
+  /* Pack a binlog position into an integer ordered as compare() orders
+   * positions: the index of the binlog file in the high 24 bits, and the
+   * offset in the low 40 bits. Larger values are capped.
    */
-  uint block_num;
+  static ulonglong pos_key(const char *log_file_name, my_off_t log_file_pos);
 
-  /**
-    Allocate a block and then assign it to current_block.
-  */
-  int allocate_block()
-  {
-    Block *block= (Block *)my_malloc(sizeof(Block), MYF(0));
-    if (block)
-    {
-      block->next= NULL;
-
-      if (first_block == NULL)
-        first_block= block;
-      else
-        last_block->next= block;
-
-      /* New Block is always put into the rear */
-      last_block= block;
-      /* New Block is always the current_block */
-      current_block= block;
-      ++block_num;
-
-      for (int i=0; i< BLOCK_TRANX_NODES; i++)
-        mysql_cond_init(key_ss_cond_COND_binlog_send_,
-                        &current_block->nodes[i].cond,
-                        NULL);
-
-      return 0;
-    }
-    return 1;
+  /* The binlog offset of a key made by pos_key(). */
+  static my_off_t key_pos(ulonglong key) {
+    return key & ((1ULL << 40) - 1);
   }
 
-  /**
-    Free a given Block.
-    @param block The Block will be freed.
-   */
-  void free_block(Block *block)
-  {
-    for (int i=0; i< BLOCK_TRANX_NODES; i++)
-      mysql_cond_destroy(&block->nodes[i].cond);
-    my_free(block);
-    --block_num;
+  /* Whether two keys made by pos_key() are in the same binlog file. */
+  static bool same_file(ulonglong key1, ulonglong key2) {
+    return (key1 >> 40) == (key2 >> 40);
   }
 
+  /* Wake up the sessions waiting on all slots, and release them. */
+  int signal_waiting_sessions_all();
 
-  /**
-    If there are some free Blocks and the total number of the Blocks in the
-    Block link table is larger than the 'reserved_blocks', Some free Blocks
-    will be freed until the total number of the Blocks is equal to the
-    'reserved_blocks' or there is only one free Block behind the
-    'current_block'.
+  /* Wake up the sessions waiting on the slots up to the specified position,
+   * and release them.
    */
-  void free_blocks()
-  {
-    if (current_block == NULL || current_block->next == NULL)
-      return;
-
-    /* One free Block is always kept behind the current block */
-    Block *block= current_block->next->next;
-    while (block_num > reserved_blocks && block != NULL)
-    {
-      Block *next= block->next;
-      free_block(block);
-      block= next;
-    }
-    current_block->next->next= block;
-    if (block == NULL)
-      last_block= current_block->next;
-  }
-};
-
-/**
-   This class manages memory for active transaction list.
-
-   We record each active transaction with a TranxNode, each session
-   can have only one open transaction. Because of EVENT, the total
-   active transaction nodes can exceed the maximum allowed
-   connections.
-*/
-class ActiveTranx
-  :public Trace {
-private:
-
-  TranxNodeAllocator allocator_;
-  /* These two record the active transaction list in sort order. */
-  TranxNode       *trx_front_, *trx_rear_;
-
-  TranxNode      **trx_htb_;        /* A hash table on active transactions. */
-
-  int              num_entries_;              /* maximum hash table entries */
-  mysql_mutex_t *lock_;                                     /* mutex lock */
-
-  inline void assert_lock_owner();
-
-  inline unsigned int calc_hash(const unsigned char *key,unsigned int length);
-  unsigned int get_hash_value(const char *log_file_name, my_off_t log_file_pos);
-
-  int compare(const char *log_file_name1, my_off_t log_file_pos1,
-              const TranxNode *node2) {
-    return compare(log_file_name1, log_file_pos1,
-                   node2->log_name_, node2->log_pos_);
-  }
-  int compare(const TranxNode *node1,
-              const char *log_file_name2, my_off_t log_file_pos2) {
-    return compare(node1->log_name_, node1->log_pos_,
-                   log_file_name2, log_file_pos2);
-  }
-  int compare(const TranxNode *node1, const TranxNode *node2) {
-    return compare(node1->log_name_, node1->log_pos_,
-                   node2->log_name_, node2->log_pos_);
-  }
-
-public:
-  int signal_waiting_sessions_all();
-  int signal_waiting_sessions_up_to(const char *log_file_name,
-                                    my_off_t log_file_pos);
-  TranxNode* find_active_tranx_node(const char *log_file_name,
-                                    my_off_t log_file_pos);
-  ActiveTranx(mysql_mutex_t *lock, unsigned long trace_level);
-  ~ActiveTranx();
+  int signal_waiting_sessions_up_to(ulonglong key);
 
-  /* Insert an active transaction node with the specified position.
+  /* Find the first slot at or after a position, which the transactions
+   * ending at the position wait on.
    *
    * Return:
-   *  0: success;  non-zero: error
+   *  the slot, or NULL if no position at or after it is in the list
    */
-  int insert_tranx_node(const char *log_file_name, my_off_t log_file_pos);
+  TranxSlot* find_active_tranx_slot(ulonglong key);
 
-  /* Clear the active transaction nodes until(inclusive) the specified
-   * position.
-   * If log_file_name is NULL, everything will be cleared: the sorted
-   * list and the hash table will be reset to empty.
-   * 
+  /* Append an active transaction slot with the specified position, which
+   * must be after the positions in the list.  If all slots are in use,
+   * wait up to wait_ms milliseconds for one to be released.
+   *
    * Return:
    *  0: success;  non-zero: error
    */
-  int clear_active_tranx_nodes(const char *log_file_name,
-                               my_off_t    log_file_pos);
+  int insert_tranx_node(const char *log_file_name, my_off_t log_file_pos,
+                        unsigned long wait_ms);
 
   /* Given a position, check to see whether the position is an active
-   * transaction's ending position by probing the hash table.
+   * transaction's ending position.
    */
-  bool is_tranx_end_pos(const char *log_file_name, my_off_t log_file_pos);
+  bool is_tranx_end_pos(ulonglong key);
 
   /* Given two binlog positions, compare which one is bigger based on
    * (file_name, file_position).
@@ -377,19 +147,20 @@ public:
   static int compare(const char *log_file_name1, my_off_t log_file_pos1,
                      const char *log_file_name2, my_off_t log_file_pos2);
 
-  /* Find out if active tranx node list is empty or not
+  /* Find out if active tranx slot list is empty or not
    *
    * Return:
-   *   True :  If there are no nodes
+   *   True :  If there are no slots
    *   False:  othewise
   */
   bool is_empty()
   {
-    return (trx_front_ == NULL);
+    return (release_seq_.load() >= insert_seq_.load());
   }
 
 };
 
+
 /**
    The extension class for the master of semi-synchronous replication
 */
@@ -397,61 +168,48 @@ class ReplSemiSyncMaster
   :public ReplSemiSyncBase {
  private:
   ActiveTranx    *active_tranxs_;  /* active transaction list: the list will
-                                      be cleared when semi-sync switches off. */
+                                      be released when semi-sync switches
+                                      off. */
 
   /* True when initObject has been called */
   bool init_done_;
 
-  /* Mutex that protects the following state variables and the active
-   * transaction list.
+  /* Mutex that serializes the changes of the state variables below and the
+   * switching of semi-sync on and off. Committing sessions do not take it
+   * unless they switch semi-sync off.
    * Under no cirumstances we can acquire mysql_bin_log.LOCK_log if we are
    * already holding LOCK_binlog_ because it can cause deadlocks.
    */
   mysql_mutex_t LOCK_binlog_;
 
-  /* This is set to true when reply_file_name_ contains meaningful data. */
-  bool            reply_file_name_inited_;
-
-  /* The binlog name up to which we have received replies from any slaves. */
-  char            reply_file_name_[FN_REFLEN];
-
-  /* The position in that file up to which we have the reply from any slaves. */
-  my_off_t        reply_file_pos_;
-
-  /* This is set to true when we know the 'smallest' wait position. */
-  bool            wait_file_name_inited_;
-
-  /* NULL, or the 'smallest' filename that a transaction is waiting for
-   * slave replies.
+  /* The ActiveTranx::pos_key() of the position up to which we have received
+   * replies from any slaves, or 0 if we have not.
    */
-  char            wait_file_name_[FN_REFLEN];
+  std::atomic<ulonglong> reply_key_;
 
-  /* The smallest position in that file that a trx is waiting for: the trx
-   * can proceed and send an 'ok' to the client when the master has got the
-   * reply from the slave indicating that it already got the binlog events.
+  /* The binlog name up to which we have received replies from any slaves.
+   * It only changes under LOCK_binlog_, when a reply is in a later file
+   * than reply_key_; replies in the same file only move reply_key_.
    */
-  my_off_t        wait_file_pos_;
+  char            reply_file_name_[FN_REFLEN];
 
-  /* This is set to true when we know the 'largest' transaction commit
-   * position in the binlog file.
+  /* The ActiveTranx::pos_key() of the 'largest' transaction commit position
+   * in the binlog, or 0 if we do not know it.
    * We always maintain the position no matter whether semi-sync is switched
    * on switched off.  When a transaction wait timeout occurs, semi-sync will
-   * switch off.  Binlog-dump thread can use the three fields to detect when
+   * switch off.  Binlog-dump thread can use the position to detect when
    * slaves catch up on replication so that semi-sync can switch on again.
    */
-  bool            commit_file_name_inited_;
+  std::atomic<ulonglong> commit_key_;
 
-  /* The 'largest' binlog filename that a commit transaction is seeing.       */
-  char            commit_file_name_[FN_REFLEN];
-
-  /* The 'largest' position in that file that a commit transaction is seeing. */
-  my_off_t        commit_file_pos_;
+  /* Reads the replies of the slaves for the binlog dump threads. */
+  AckReceiver     ack_receiver_;
 
   /* All global variables which can be set by parameters. */
   volatile bool            master_enabled_;      /* semi-sync is enabled on the master */
   unsigned long           wait_timeout_;      /* timeout period(ms) during tranx wait */
 
-  bool            state_;                    /* whether semi-sync is switched */
+  std::atomic<bool> state_;                  /* whether semi-sync is switched */
 
   /* Whitelist related members */
   std::mutex rpl_semi_sync_master_whitelist_set_lock;
@@ -489,6 +247,8 @@ class ReplSemiSyncMaster
 
   /* Checks if the reply is from a slave on the whitelist */
   bool verify_against_whitelist();
+  bool verify_against_whitelist(const std::string &slave_uuid,
+                                ulonglong *whitelist_ver);
 
  public:
   ReplSemiSyncMaster();
@@ -522,7 +282,7 @@ class ReplSemiSyncMaster
   int disableMaster();
 
   /* Add a semi-sync replication slave */
-  void add_slave();
+  void add_slave(uint32 server_id);
     
   /* Remove a semi-sync replication slave */
   void remove_slave();
@@ -543,14 +303,37 @@ class ReplSemiSyncMaster
    *  end_offset    - (IN)  the offset in the binlog file up to which we have
    *                        the replies from the slave or that was skipped
    *  skipped_event - (IN)  if the event was skipped
+   *  slave_uuid    - (IN)  the UUID of the slave, or NULL if the current
+   *                        thread is the binlog dump thread of the slave
+   *  whitelist_ver - (IN/OUT) the whitelist version the slave was checked
+   *                        against, if slave_uuid is not NULL
    *
    * Return:
-   *  0: success;  non-zero: error
+   *  0: success;  2: the slave is not on the whitelist; other: error
    */
   int reportReplyBinlog(uint32 server_id,
                         const char* log_file_name,
                         my_off_t end_offset,
-                        bool skipped_event= false);
+                        bool skipped_event= false,
+                        const std::string *slave_uuid= NULL,
+                        ulonglong *whitelist_ver= NULL);
+
+  /* Parse a reply packet of a slave and report its position with
+   * reportReplyBinlog().
+   *
+   * Input:
+   *  server_id     - (IN)  master server id number
+   *  packet        - (IN)  the payload of the packet
+   *  packet_len    - (IN)  the length of the payload
+   *  slave_uuid, whitelist_ver - as for reportReplyBinlog()
+   *
+   * Return:
+   *  0: success;  non-zero: error
+   */
+  int reportReplyPacket(uint32 server_id, const uchar *packet,
+                        ulong packet_len,
+                        const std::string *slave_uuid= NULL,
+                        ulonglong *whitelist_ver= NULL);
 
   /* Commit a transaction in the final step.  This function is called from
    * InnoDB before returning from the low commit.  If semi-sync is switch on,
@@ -616,7 +399,9 @@ class ReplSemiSyncMaster
   int writeTranxInBinlog(const char* log_file_name, my_off_t log_file_pos);
 
   /* Read the slave's reply so that we know how much progress the slave makes
-   * on receive replication events.
+   * on receive replication events.  The reply is read by the ack receiver
+   * thread if it listens to the slave, and otherwise by the calling binlog
+   * dump thread, which then waits for it.
    * 
    * Input:
    *  net          - (IN)  the connection to master
@@ -668,13 +453,13 @@ extern unsigned long rpl_semi_sync_master_clients;
 extern unsigned long rpl_semi_sync_master_timeout;
 extern char rpl_semi_sync_master_crash_if_active_trxs;
 extern unsigned long rpl_semi_sync_master_trace_level;
-extern unsigned long rpl_semi_sync_master_yes_transactions;
-extern unsigned long rpl_semi_sync_master_no_transactions;
+extern unsigned long long rpl_semi_sync_master_yes_transactions;
+extern unsigned long long rpl_semi_sync_master_no_transactions;
 extern unsigned long rpl_semi_sync_master_off_times;
-extern unsigned long rpl_semi_sync_master_wait_timeouts;
-extern unsigned long rpl_semi_sync_master_timefunc_fails;
+extern unsigned long long rpl_semi_sync_master_wait_timeouts;
+extern unsigned long long rpl_semi_sync_master_timefunc_fails;
 extern unsigned long rpl_semi_sync_master_num_timeouts;
-extern unsigned long rpl_semi_sync_master_wait_sessions;
+extern unsigned long long rpl_semi_sync_master_wait_sessions;
 extern unsigned long rpl_semi_sync_master_wait_pos_backtraverse;
 extern unsigned long rpl_semi_sync_master_avg_trx_wait_time;
 extern unsigned long rpl_semi_sync_master_avg_net_wait_time;
@@ -682,6 +467,7 @@ extern unsigned long long rpl_semi_sync_master_net_wait_num;
 extern unsigned long long rpl_semi_sync_master_trx_wait_num;
 extern unsigned long long rpl_semi_sync_master_net_wait_time;
 extern unsigned long long rpl_semi_sync_master_trx_wait_time;
+extern unsigned long long rpl_semi_sync_master_ack_receiver_replies;
 
 extern char* histogram_trx_wait_step_size;
 extern latency_histogram histogram_trx_wait;
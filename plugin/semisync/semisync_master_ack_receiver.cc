@@ -0,0 +1,307 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+
+#include "semisync_master.h"
+#include "sql_class.h"                          // THD
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+/* How long epoll_wait() waits before the thread checks whether to stop. */
+static const int kPollTimeoutMs= 100;
+
+/* How long the rest of a reply is waited for once its first bytes came. */
+static const uint kReadTimeoutMs= 1000;
+
+static const int kMaxEvents= 64;
+
+AckReceiver::Slave::~Slave()
+{
+  if (net_inited)
+    net_end(&net);
+}
+
+AckReceiver::AckReceiver(ReplSemiSyncMaster *master)
+  : master_(master), epoll_fd_(-1), stop_(false), last_slave_id_(0)
+{
+}
+
+AckReceiver::~AckReceiver()
+{
+  stop();
+}
+
+extern "C" {
+static void *handle_ack_receiver(void *arg)
+{
+  THD *thd;
+
+  my_thread_init();
+  /* The bytes read through a NET are accounted to the session */
+  thd= new THD;
+  thd->thread_stack= (char *)&thd;
+  thd->store_globals();
+  thd->security_ctx->skip_grants();
+
+  static_cast<AckReceiver*>(arg)->run();
+
+  thd->release_resources();
+  delete thd;
+  my_thread_end();
+  pthread_exit(0);
+  return 0;
+}
+}
+
+int AckReceiver::start()
+{
+#ifdef HAVE_EPOLL
+  if (epoll_fd_ >= 0)
+    return 0;
+
+  if ((epoll_fd_= epoll_create(kMaxEvents)) < 0)
+  {
+    sql_print_error("Semi-sync master failed to create the epoll instance "
+                    "of the ack receiver (errno: %d)", errno);
+    return 1;
+  }
+
+  stop_= false;
+  if (mysql_thread_create(key_ss_thread_ack_receiver, &thread_, NULL,
+                          handle_ack_receiver, this))
+  {
+    sql_print_error("Semi-sync master failed to create the ack receiver "
+                    "thread");
+    close(epoll_fd_);
+    epoll_fd_= -1;
+    return 1;
+  }
+  sql_print_information("Semi-sync master started the ack receiver thread.");
+#endif
+  return 0;
+}
+
+void AckReceiver::stop()
+{
+#ifdef HAVE_EPOLL
+  if (epoll_fd_ < 0)
+    return;
+
+  stop_= true;
+  pthread_join(thread_, NULL);
+  close(epoll_fd_);
+  epoll_fd_= -1;
+
+  std::lock_guard<std::mutex> guard(slaves_lock_);
+  slaves_.clear();
+  slaves_by_thd_.clear();
+#endif
+}
+
+bool AckReceiver::add_slave(THD *thd, uint32 server_id,
+                            const std::string &slave_uuid,
+                            ulonglong whitelist_ver)
+{
+#ifdef HAVE_EPOLL
+  NET *net= thd->get_net();
+  Vio *vio= net->vio;
+
+  if (epoll_fd_ < 0 || !vio || net->compress ||
+      (vio->type != VIO_TYPE_TCPIP && vio->type != VIO_TYPE_SOCKET))
+    return false;
+
+  std::shared_ptr<Slave> slave= std::make_shared<Slave>();
+  slave->thd= thd;
+  slave->server_id= server_id;
+  slave->uuid= slave_uuid;
+  slave->whitelist_ver= whitelist_ver;
+  /*
+    The dump thread only writes to the socket from now on. The copy is not
+    instrumented, and does not wait long for the rest of a reply.
+  */
+  slave->vio= *vio;
+  slave->vio.mysql_socket.m_psi= NULL;
+  slave->vio.read_timeout= timeout_from_millis(kReadTimeoutMs);
+  if (my_net_init(&slave->net, &slave->vio))
+    return false;
+  slave->net_inited= true;
+
+  std::lock_guard<std::mutex> guard(slaves_lock_);
+  slave->id= ++last_slave_id_;
+
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events= EPOLLIN | EPOLLRDHUP;
+  event.data.u64= slave->id;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD,
+                mysql_socket_getfd(vio->mysql_socket), &event))
+  {
+    sql_print_warning("Semi-sync master failed to listen to the replies of "
+                      "slave (server_id: %d) in the ack receiver "
+                      "(errno: %d)", server_id, errno);
+    return false;
+  }
+  slaves_[slave->id]= slave;
+  slaves_by_thd_[thd]= slave;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AckReceiver::remove_slave(THD *thd)
+{
+#ifdef HAVE_EPOLL
+  std::shared_ptr<Slave> slave;
+  {
+    std::lock_guard<std::mutex> guard(slaves_lock_);
+    auto it= slaves_by_thd_.find(thd);
+    if (it == slaves_by_thd_.end())
+      return;
+    slave= it->second;
+    slaves_by_thd_.erase(it);
+    slaves_.erase(slave->id);
+  }
+
+  /* Wait for a read in progress, the dump thread closes the socket next */
+  std::lock_guard<std::mutex> guard(slave->lock);
+  if (!slave->fatal_error.load())
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL,
+              mysql_socket_getfd(slave->vio.mysql_socket), NULL);
+  slave->removed= true;
+#endif
+}
+
+int AckReceiver::expect_reply(THD *thd, NET *net)
+{
+  std::shared_ptr<Slave> slave;
+  {
+    std::lock_guard<std::mutex> guard(slaves_lock_);
+    auto it= slaves_by_thd_.find(thd);
+    if (it == slaves_by_thd_.end())
+      return -1;
+    slave= it->second;
+  }
+
+  /*
+    The slave numbers its reply as the first packet of a new command, and
+    the next event as the packet following it.
+  */
+  net_clear(net, 0);
+  net->pkt_nr++;
+  net->compress_pkt_nr++;
+
+  if (master_->trace_level_ & Trace::kTraceNetWait)
+    slave->flush_time= my_micro_time();
+
+  int error= slave->fatal_error.load();
+  if (!error)
+    error= slave->reply_error.exchange(0);
+  return error;
+}
+
+/**
+  Stop listening to a slave whose replies can no longer be read. Called
+  with the lock of the slave held.
+*/
+void AckReceiver::forget(Slave *slave, int error)
+{
+#ifdef HAVE_EPOLL
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL,
+            mysql_socket_getfd(slave->vio.mysql_socket), NULL);
+  slave->fatal_error= error;
+#endif
+}
+
+void AckReceiver::read_reply(Slave *slave, uint32 events)
+{
+#ifdef HAVE_EPOLL
+  std::lock_guard<std::mutex> guard(slave->lock);
+  if (slave->removed || slave->fatal_error.load())
+    return;
+
+  const bool hangup= events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+  if (events & EPOLLIN)
+  {
+    net_clear(&slave->net, 0);
+    ulong packet_len= my_net_read(&slave->net);
+    if (packet_len != packet_error)
+    {
+      const ulonglong flush_time= slave->flush_time.load();
+      if ((master_->trace_level_ & Trace::kTraceNetWait) && flush_time)
+      {
+        const ulonglong now= my_micro_time();
+        if (now >= flush_time)
+        {
+          rpl_semi_sync_master_net_wait_num++;
+          rpl_semi_sync_master_net_wait_time+= now - flush_time;
+        }
+      }
+
+      int result= master_->reportReplyPacket(slave->server_id,
+                                             slave->net.read_pos, packet_len,
+                                             &slave->uuid,
+                                             &slave->whitelist_ver);
+      if (result == 2)
+        forget(slave, result);
+      else if (result)
+        slave->reply_error= 1;
+      else
+        rpl_semi_sync_master_ack_receiver_replies++;
+      if (!hangup)
+        return;
+    }
+    else if (!hangup)
+      sql_print_error("Read semi-sync reply network error: %s (errno: %d)",
+                      slave->net.last_error, slave->net.last_errno);
+  }
+
+  /* The slave went away, or its connection is out of sync */
+  if (!slave->fatal_error.load())
+    forget(slave, 1);
+#endif
+}
+
+void AckReceiver::run()
+{
+#ifdef HAVE_EPOLL
+  struct epoll_event events[kMaxEvents];
+
+  while (!stop_.load())
+  {
+    int n_events= epoll_wait(epoll_fd_, events, kMaxEvents, kPollTimeoutMs);
+    if (n_events < 0 && errno != EINTR)
+    {
+      sql_print_error("Semi-sync master ack receiver failed in epoll_wait() "
+                      "(errno: %d)", errno);
+      my_sleep(kPollTimeoutMs * 1000);
+    }
+
+    for (int i= 0; i < n_events; i++)
+    {
+      std::shared_ptr<Slave> slave;
+      {
+        std::lock_guard<std::mutex> guard(slaves_lock_);
+        auto it= slaves_.find(events[i].data.u64);
+        if (it == slaves_.end())
+          continue;
+        slave= it->second;
+      }
+      read_reply(slave.get(), events[i].events);
+    }
+  }
+#endif
+}
@@ -0,0 +1,131 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+
+#ifndef SEMISYNC_MASTER_ACK_RECEIVER_H
+#define SEMISYNC_MASTER_ACK_RECEIVER_H
+
+#include "semisync.h"
+#include "violite.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class ReplSemiSyncMaster;
+class THD;
+
+/**
+   A thread which reads the replies of all semi-sync slaves, so that the
+   binlog dump threads go on sending events instead of waiting for them.
+
+   It listens to the sockets of the slaves with epoll, reads the replies
+   through its own NET on a copy of the Vio of each binlog dump thread,
+   and reports them to the master.  The connections using SSL or
+   compression, which cannot be read from another thread, are read by
+   their binlog dump threads as before, and so are all of them where
+   epoll is not available.
+*/
+class AckReceiver {
+public:
+  AckReceiver(ReplSemiSyncMaster *master);
+  ~AckReceiver();
+
+  /* Start the thread.
+   *
+   * Return:
+   *  0: success or epoll is not available;  non-zero: error
+   */
+  int start();
+
+  /* Stop the thread and forget all slaves. */
+  void stop();
+
+  /* Listen to the replies of the slave served by a binlog dump thread.
+   *
+   * Input:
+   *  thd           - (IN)  the binlog dump thread
+   *  server_id     - (IN)  the server id of the slave
+   *  slave_uuid    - (IN)  the UUID of the slave
+   *  whitelist_ver - (IN)  the whitelist version the slave was checked
+   *                        against
+   *
+   * Return:
+   *  true: the thread reads the replies;  false: the dump thread must
+   */
+  bool add_slave(THD *thd, uint32 server_id, const std::string &slave_uuid,
+                 ulonglong whitelist_ver);
+
+  /* Stop listening to a slave.  The thread does not read its socket after
+   * this returns.
+   */
+  void remove_slave(THD *thd);
+
+  /* Called by a binlog dump thread when it has flushed an event the slave
+   * replies to.  The NET of the dump thread is set as if it had read the
+   * reply.
+   *
+   * Return:
+   *  -1: the thread does not listen to the slave;  0: success;
+   *   2: the slave is not on the whitelist;  other: error
+   */
+  int expect_reply(THD *thd, NET *net);
+
+  /* Body of the thread. */
+  void run();
+
+private:
+  struct Slave
+  {
+    ulonglong id;
+    THD *thd;
+    uint32 server_id;
+    std::string uuid;
+    ulonglong whitelist_ver;
+    Vio vio;                     /* copy of the Vio of the dump thread */
+    NET net;
+    bool net_inited;
+    std::atomic<ulonglong> flush_time;    /* of the last event, in usecs */
+    /* Whether the socket is closed or the slave was rejected, for good */
+    std::atomic<int> fatal_error;
+    /* An error in the last reply, reported once to the dump thread */
+    std::atomic<int> reply_error;
+
+    /* Held while reading the socket, which is not read once removed */
+    std::mutex lock;
+    bool removed;
+
+    Slave() : net_inited(false), flush_time(0), fatal_error(0),
+              reply_error(0), removed(false) {}
+    ~Slave();
+  };
+
+  void read_reply(Slave *slave, uint32 events);
+  void forget(Slave *slave, int error);
+
+  ReplSemiSyncMaster *master_;
+  int epoll_fd_;
+  pthread_t thread_;
+  std::atomic<bool> stop_;
+
+  /* Protects the maps of the slaves, not their state */
+  std::mutex slaves_lock_;
+  ulonglong last_slave_id_;
+  std::unordered_map<ulonglong, std::shared_ptr<Slave>> slaves_;
+  std::unordered_map<const THD*, std::shared_ptr<Slave>> slaves_by_thd_;
+};
+
+#endif /* SEMISYNC_MASTER_ACK_RECEIVER_H */
@@ -98,7 +98,7 @@ int repl_semi_binlog_dump_start(Binlog_transmit_param *param,
   int ret = 0;
 
   /* One more semi-sync slave */
-  repl_semisync.add_slave();
+  repl_semisync.add_slave(param->server_id);
   /* Tell server it will observe the transmission.*/
   param->set_observe_flag();
 
@@ -461,7 +461,7 @@ Binlog_transmit_observer transmit_observer = {
 
 DEF_SHOW_FUNC(status, SHOW_BOOL)
 DEF_SHOW_FUNC(clients, SHOW_LONG)
-DEF_SHOW_FUNC(wait_sessions, SHOW_LONG)
+DEF_SHOW_FUNC(wait_sessions, SHOW_LONGLONG)
 DEF_SHOW_FUNC(trx_wait_time, SHOW_LONGLONG)
 DEF_SHOW_FUNC(trx_wait_num, SHOW_LONGLONG)
 DEF_SHOW_FUNC(net_wait_time, SHOW_LONGLONG)
@@ -499,10 +499,10 @@ static SHOW_VAR semi_sync_master_status_vars[]= {
    SHOW_FUNC},
   {"Rpl_semi_sync_master_yes_tx",
    (char*) &rpl_semi_sync_master_yes_transactions,
-   SHOW_LONG},
+   SHOW_LONGLONG},
   {"Rpl_semi_sync_master_no_tx",
    (char*) &rpl_semi_sync_master_no_transactions,
-   SHOW_LONG},
+   SHOW_LONGLONG},
   {"Rpl_semi_sync_master_wait_sessions",
    (char*) &SHOW_FNAME(wait_sessions),
    SHOW_FUNC},
@@ -511,7 +511,7 @@ static SHOW_VAR semi_sync_master_status_vars[]= {
    SHOW_LONG},
   {"Rpl_semi_sync_master_timefunc_failures",
    (char*) &rpl_semi_sync_master_timefunc_fails,
-   SHOW_LONG},
+   SHOW_LONGLONG},
   {"Rpl_semi_sync_master_wait_pos_backtraverse",
    (char*) &rpl_semi_sync_master_wait_pos_backtraverse,
    SHOW_LONG},
@@ -533,6 +533,9 @@ static SHOW_VAR semi_sync_master_status_vars[]= {
   {"Rpl_semi_sync_master_net_avg_wait_time",
    (char*) &SHOW_FNAME(avg_net_wait_time),
    SHOW_FUNC},
+  {"Rpl_semi_sync_master_ack_receiver_replies",
+   (char*) &rpl_semi_sync_master_ack_receiver_replies,
+   SHOW_LONGLONG},
   {"Rpl_semi_sync_master",
    (char*) &rpl_semi_sync_master_trx_wait_histogram,
    SHOW_FUNC},
@@ -541,17 +544,30 @@ static SHOW_VAR semi_sync_master_status_vars[]= {
 
 #ifdef HAVE_PSI_INTERFACE
 PSI_mutex_key key_ss_mutex_LOCK_binlog_;
+PSI_mutex_key key_ss_mutex_LOCK_tranx_slot_;
+PSI_mutex_key key_ss_mutex_LOCK_free_slot_;
 
 static PSI_mutex_info all_semisync_mutexes[]=
 {
-  { &key_ss_mutex_LOCK_binlog_, "LOCK_binlog_", 0}
+  { &key_ss_mutex_LOCK_binlog_, "LOCK_binlog_", 0},
+  { &key_ss_mutex_LOCK_tranx_slot_, "LOCK_tranx_slot_", 0},
+  { &key_ss_mutex_LOCK_free_slot_, "LOCK_free_slot_", 0}
 };
 
 PSI_cond_key key_ss_cond_COND_binlog_send_;
+PSI_cond_key key_ss_cond_COND_free_slot_;
 
 static PSI_cond_info all_semisync_conds[]=
 {
-  { &key_ss_cond_COND_binlog_send_, "COND_binlog_send_", 0}
+  { &key_ss_cond_COND_binlog_send_, "COND_binlog_send_", 0},
+  { &key_ss_cond_COND_free_slot_, "COND_free_slot_", 0}
+};
+
+PSI_thread_key key_ss_thread_ack_receiver;
+
+static PSI_thread_info all_semisync_threads[]=
+{
+  { &key_ss_thread_ack_receiver, "ack_receiver", 0}
 };
 #endif /* HAVE_PSI_INTERFACE */
 
@@ -575,6 +591,9 @@ static void init_semisync_psi_keys(void)
   count= array_elements(all_semisync_conds);
   mysql_cond_register(category, all_semisync_conds, count);
 
+  count= array_elements(all_semisync_threads);
+  mysql_thread_register(category, all_semisync_threads, count);
+
   count= array_elements(all_semisync_stages);
   mysql_stage_register(category, all_semisync_stages, count);
 }
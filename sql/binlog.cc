@@ -90,6 +90,8 @@ static int limit_unsafe_warning_count= 0;
 
 static handlerton *binlog_hton;
 bool opt_binlog_order_commits= true;
+ulong opt_binlog_gtid_index_interval= 0;
+ulonglong opt_binlog_tail_cache_size= 0;
 bool opt_gtid_precommit= false;
 
 const char *log_bin_index= 0;
@@ -3890,6 +3892,7 @@ void MYSQL_BIN_LOG::cleanup()
     mysql_cond_destroy(&m_prep_xids_cond);
     mysql_cond_destroy(&non_xid_trxs_cond);
     stage_manager.deinit();
+    tail_cache.cleanup();
   }
   DBUG_VOID_RETURN;
 }
@@ -3911,6 +3914,7 @@ void MYSQL_BIN_LOG::init_pthread_objects()
   my_atomic_rwlock_init(&m_prep_xids_lock);
   mysql_cond_init(m_key_prep_xids_cond, &m_prep_xids_cond, NULL);
   mysql_cond_init(m_key_non_xid_trxs_cond, &non_xid_trxs_cond, NULL);
+  tail_cache.init();
   stage_manager.init(
 #ifdef HAVE_PSI_INTERFACE
                    m_key_LOCK_flush_queue,
@@ -5170,6 +5174,9 @@ bool MYSQL_BIN_LOG::open_binlog(const char *log_name,
 #endif
   }
 
+  if (!is_relay_log && write_file_name_to_index_file)
+    gtid_index.open(log_file_name, opt_binlog_gtid_index_interval);
+
   log_state= LOG_OPENED;
 
 #ifdef HAVE_REPLICATION
@@ -5267,6 +5274,9 @@ bool MYSQL_BIN_LOG::open_existing_binlog(
   max_size= max_size_arg;
   open_count++;
 
+  /* Transactions appended from now on would be missing from the index */
+  Gtid_index::remove(log_file_name);
+
   update_binlog_end_pos(need_end_log_pos_lock);
 
   log_state= LOG_OPENED;
@@ -5965,6 +5975,7 @@ bool MYSQL_BIN_LOG::reset_logs(THD* thd)
 
   for (;;)
   {
+    Gtid_index::remove(linfo.log_file_name);
     if ((error= my_delete_allow_opened(linfo.log_file_name, MYF(0))) != 0)
     {
       if (my_errno == ENOENT)
@@ -6795,6 +6806,7 @@ int MYSQL_BIN_LOG::purge_logs_in_list(std::list<std::string>& delete_list,
     else
     {
       DBUG_PRINT("info",("purging %s",log_file_name.c_str()));
+      Gtid_index::remove(log_file_name.c_str());
       if (!mysql_file_delete(key_file_binlog, log_file_name.c_str(), MYF(0)))
       {
         DBUG_EXECUTE_IF("wait_in_purge_index_entry",
@@ -7601,7 +7613,18 @@ bool MYSQL_BIN_LOG::append_event(Log_event* ev, Master_info *mi)
 }
 
 
-bool MYSQL_BIN_LOG::append_buffer(const char* buf, uint len, Master_info *mi)
+/**
+  Append an event received from the master to the relay log.
+
+  @param buf  The event
+  @param len  Its length
+  @param mi   Master_info of the I/O thread
+  @param qev  If not NULL, the event parsed, to queue for the SQL thread
+              once written
+*/
+
+bool MYSQL_BIN_LOG::append_buffer(const char* buf, uint len, Master_info *mi,
+                                  Queued_event *qev)
 {
   DBUG_ENTER("MYSQL_BIN_LOG::append_buffer");
   // Release data_lock while writing to relay log. If slave IO thread
@@ -7626,8 +7649,17 @@ bool MYSQL_BIN_LOG::append_buffer(const char* buf, uint len, Master_info *mi)
 
   // write data
   bool error= false;
+  const my_off_t start_pos= my_b_append_tell(&log_file);
   if (my_b_append(&log_file,(uchar*) buf,len) == 0)
   {
+    if (qev)
+    {
+      /* Queued before the SQL thread can see the event in the relay log */
+      qev->open_count= open_count;
+      qev->start_pos= start_pos;
+      qev->end_pos= start_pos + len;
+      mi->rli->event_queue.push(qev);
+    }
     bytes_written += len;
     relay_log_bytes_written += len;
     if (us)
@@ -8956,6 +8988,7 @@ bool MYSQL_BIN_LOG::write_cache(THD *thd, binlog_cache_data *cache_data,
      */
     if (my_b_tell(cache) > 0)
     {
+      const my_off_t trx_pos= my_b_tell(&log_file);
       DBUG_EXECUTE_IF("crash_before_writing_xid",
                       {
                         if ((write_error= do_write_cache(cache)))
@@ -9006,6 +9039,8 @@ bool MYSQL_BIN_LOG::write_cache(THD *thd, binlog_cache_data *cache_data,
         }
         global_sid_lock->unlock();
       }
+      if (thd->owned_gtid.sidno > 0)
+        gtid_index.add_transaction(thd->owned_gtid, trx_pos);
       if (thd->rli_slave)
       {
         /*
@@ -9191,6 +9226,8 @@ void MYSQL_BIN_LOG::close(uint exiting)
 
     /* this will cleanup IO_CACHE, sync and close the file */
     MYSQL_LOG::close(exiting);
+    gtid_index.close();
+    tail_cache.clear();
   }
 
   /*
@@ -9269,8 +9306,12 @@ void MYSQL_BIN_LOG::update_binlog_end_pos(bool need_lock)
     lock_binlog_end_pos();
   mysql_mutex_assert_owner(&LOCK_binlog_end_pos);
   strmake(binlog_file_name, log_file_name, sizeof(binlog_file_name)-1);
-  binlog_end_pos=
+  const my_off_t end_pos=
     is_relay_log ? my_b_append_tell(&log_file) : my_b_tell(&log_file);
+  /* Cache the new bytes before dump threads can look for them */
+  if (!is_relay_log)
+    tail_cache.publish(log_file_name, log_file.file, end_pos);
+  binlog_end_pos= end_pos;
   signal_update();
   if (need_lock)
     unlock_binlog_end_pos();
@@ -9460,6 +9501,8 @@ int MYSQL_BIN_LOG::open_binlog(const char *opt_name)
         }
         else
         {
+          /* The index may refer to the removed transactions */
+          Gtid_index::remove(log_name);
           sql_print_information("Crashed binlog file %s size is %llu, "
                                 "but recovered up to %llu. Binlog trimmed to %llu bytes.",
                                 log_name, binlog_size, valid_pos, valid_pos);
@@ -9828,9 +9871,14 @@ MYSQL_BIN_LOG::process_flush_stage_queue(my_off_t *total_bytes_var,
   DBUG_EXECUTE_IF("crash_after_flush_engine_log", DBUG_SUICIDE(););
 
   ulonglong thd_count = 0;
+  ulonglong slave_thd_count = 0;
   /* Flush thread caches to binary log. */
   for (THD *head= first_seen ; head ; head = head->next_to_commit)
   {
+#ifdef HAVE_REPLICATION
+    if (has_commit_order_manager(head))
+      ++slave_thd_count;
+#endif
     std::pair<int,my_off_t> result= flush_thread_caches(head, async);
     total_bytes+= result.second;
     if (flush_error == 1)
@@ -9859,6 +9907,11 @@ MYSQL_BIN_LOG::process_flush_stage_queue(my_off_t *total_bytes_var,
   DBUG_ASSERT(thd_count > 0);
   DBUG_PRINT("info", ("Number of threads in group commit %llu", thd_count));
   counter_histogram_increment(&histogram_binlog_group_commit, thd_count);
+  if (slave_thd_count)
+  {
+    ++slave_commit_groups;
+    slave_commit_group_trxs+= slave_thd_count;
+  }
 
   *out_queue_var= first_seen;
   *total_bytes_var= total_bytes;
@@ -10857,6 +10910,14 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit,
 
     if (change_stage(thd, Stage_manager::FLUSH_STAGE, thd, NULL, &LOCK_log))
       DBUG_RETURN(finish_commit(thd, async));
+
+    /*
+      The workers committing next in order enroll one after the other as
+      each unregisters. Let those already prepared join this group, instead
+      of each leading a group with its own sync.
+    */
+    if (opt_slave_commit_group_wait_usec)
+      mngr->wait_for_group(worker, opt_slave_commit_group_wait_usec);
   }
   else
 #endif
@@ -11281,6 +11342,8 @@ int MYSQL_BIN_LOG::recover_raft_log()
       + std::string(log_name);
     error= 1;
   }
+  else
+    Gtid_index::remove(log_name);
 
   mysql_file_close(file, MYF(MY_WME));
 
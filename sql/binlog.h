@@ -20,6 +20,8 @@
 #include "log_event.h"
 #include "log.h"
 #include "rpl_gtid.h"
+#include "rpl_gtid_index.h"
+#include "rpl_binlog_tail_cache.h"
 #include <atomic>
 #include <list>
 #include <unordered_map>
@@ -39,6 +41,7 @@ class Master_info;
 
 class Format_description_log_event;
 struct RaftRotateInfo;
+struct Queued_event;
 
 /* The enum defining the server's action when a trx fails inside ordered commit
  * due to an error related to consensus (raft plugin) */
@@ -528,6 +531,10 @@ public:
      and this is totally rebuilt in init_gtid_sets() function.
   */
   Gtid_set_map previous_gtid_set_map;
+  /// Index of the GTIDs of the binlog being written, protected by LOCK_log
+  Gtid_index gtid_index;
+  /// Last bytes of the binlog being written, for the dump threads
+  Binlog_tail_cache tail_cache;
   /*
     crash_safe_index_file is temp file used for guaranteeing
     index file crash safe when master server restarts.
@@ -1129,7 +1136,8 @@ public:
   bool is_query_in_union(THD *thd, query_id_t query_id_param);
 
 #ifdef HAVE_REPLICATION
-  bool append_buffer(const char* buf, uint len, Master_info *mi);
+  bool append_buffer(const char* buf, uint len, Master_info *mi,
+                     Queued_event *qev= NULL);
   bool append_event(Log_event* ev, Master_info *mi);
 private:
   bool after_append_to_relay_log(Master_info *mi);
@@ -1281,6 +1289,7 @@ public:
     return binlog_end_pos;
   }
   mysql_mutex_t* get_binlog_end_pos_lock() { return &LOCK_binlog_end_pos; }
+  Binlog_tail_cache *get_tail_cache() { return &tail_cache; }
   void lock_binlog_end_pos() { mysql_mutex_lock(&LOCK_binlog_end_pos); }
   void unlock_binlog_end_pos() { mysql_mutex_unlock(&LOCK_binlog_end_pos); }
   inline void update_binlog_group_commit_step() {
@@ -1489,6 +1498,8 @@ int gtid_empty_group_log_and_cleanup(THD *thd);
 extern const char *log_bin_index;
 extern const char *log_bin_basename;
 extern bool opt_binlog_order_commits;
+extern ulong opt_binlog_gtid_index_interval;
+extern ulonglong opt_binlog_tail_cache_size;
 extern bool opt_gtid_precommit;
 
 /**
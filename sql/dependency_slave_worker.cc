@@ -2,6 +2,7 @@
 #include "debug_sync.h"
 #include "dependency_slave_worker.h"
 #include "log_event_wrapper.h"
+#include "mysqld.h"                  // opt_slave_prefetch_window
 #include "rpl_slave_commit_order_manager.h"
 #include <../include/mysql/service_thd_engine_lock.h>
 
@@ -85,6 +86,7 @@ bool Dependency_slave_worker::execute_group()
 
   while (ev)
   {
+    prefetch_ahead(ev);
     if (unlikely(err= execute_event(ev)))
     {
       c_rli->dependency_worker_error= true;
@@ -119,6 +121,7 @@ bool Dependency_slave_worker::execute_group()
           c_rli->dep_fake_gap_lock.unlock();
         }
       };);
+      end_prefetch();
       ev= begin_event;
       continue;
     }
@@ -134,6 +137,8 @@ bool Dependency_slave_worker::execute_group()
     }
   };);
 
+  end_prefetch();
+
   // case: in case of error rollback if commit ordering is enabled
   if (unlikely(err && commit_order_mngr))
   {
@@ -232,6 +237,106 @@ Dependency_slave_worker::finalize_event(std::shared_ptr<Log_event_wrapper> &ev)
   mysql_mutex_unlock(&c_rli->dep_key_lookup_mutex);
 }
 
+/* Looks up the rows of the next row events of a large group in the threads of
+ * @Slave_prefetcher before we execute an event of it.
+ *
+ * The lookahead starts once slave_prefetch_large_trx_size bytes of the group
+ * have been executed, and covers the events the coordinator has scheduled so
+ * far, up to slave_prefetch_window bytes of row events. The rows are only read,
+ * so all the changes of the group are still made by us in our trx.
+ */
+void Dependency_slave_worker::prefetch_ahead(
+    const std::shared_ptr<Log_event_wrapper> &ev)
+{
+  const auto prefetcher= c_rli->prefetcher;
+  const auto window= opt_slave_prefetch_window;
+
+  if (likely(!prefetcher))
+    return;
+
+  if (!prefetch_tail)
+  {
+    // case: the group is small so far, just track its tables
+    const auto raw_ev= ev->raw_event();
+    track_prefetch_table(raw_ev);
+    if (raw_ev)
+      prefetch_group_bytes+= raw_ev->data_written;
+    if (prefetch_group_bytes < opt_slave_prefetch_large_trx_size)
+      return;
+    prefetch_tail= ev;
+  }
+  else if (!prefetch_jobs.empty() && prefetch_jobs.front()->ev == ev.get())
+  {
+    // case: take the job of this event back before executing it
+    const auto job= prefetch_jobs.front();
+    if (prefetcher->claim(job.get()))
+      my_atomic_add64((int64*) &slave_prefetch_useful, 1);
+    else
+      my_atomic_add64((int64*) &slave_prefetch_wasted, 1);
+    prefetch_bytes-= job->rows->data_written;
+    prefetch_jobs.pop_front();
+  }
+
+  std::shared_ptr<Log_event_wrapper> next;
+  while (prefetch_bytes < window && (next= prefetch_tail->peek_next()))
+  {
+    prefetch_tail= next;
+    const auto raw_ev= next->raw_event();
+    // NOTE: the event we're about to execute is next when we've caught up
+    // with the coordinator, it's too late to look up its rows
+    if (next != ev && raw_ev && raw_ev->is_row_log_event())
+    {
+      const auto rows= static_cast<Rows_log_event*>(raw_ev);
+      const auto it= prefetch_tables.find(rows->get_table_id());
+      if (it != prefetch_tables.end())
+      {
+        auto job= std::make_shared<Slave_prefetcher::Group_job>(
+            it->second, rows, next.get());
+        prefetch_jobs.push_back(job);
+        prefetch_bytes+= rows->data_written;
+        prefetcher->queue(job);
+      }
+    }
+    track_prefetch_table(raw_ev);
+  }
+}
+
+void Dependency_slave_worker::track_prefetch_table(Log_event *raw_ev)
+{
+  if (!raw_ev)
+    return;
+
+  if (raw_ev->get_type_code() == TABLE_MAP_EVENT)
+  {
+    const auto table_map= static_cast<Table_map_log_event*>(raw_ev);
+    prefetch_tables[table_map->get_table_id()]=
+      std::make_shared<Prefetch_table>(table_map);
+  }
+  // case: table ids are only valid within a statement
+  else if (raw_ev->is_row_log_event() &&
+           static_cast<Rows_log_event*>(raw_ev)->get_flags(
+             Rows_log_event::STMT_END_F))
+  {
+    prefetch_tables.clear();
+  }
+}
+
+// Takes all our jobs back from the prefetch threads, before the events of the
+// group are freed or executed again
+void Dependency_slave_worker::end_prefetch()
+{
+  for (const auto& job : prefetch_jobs)
+  {
+    c_rli->prefetcher->claim(job.get());
+    my_atomic_add64((int64*) &slave_prefetch_wasted, 1);
+  }
+  prefetch_jobs.clear();
+  prefetch_bytes= 0;
+  prefetch_tables.clear();
+  prefetch_tail.reset();
+  prefetch_group_bytes= 0;
+}
+
 Dependency_slave_worker::Dependency_slave_worker(Relay_log_info *rli
 #ifdef HAVE_PSI_INTERFACE
                                    ,PSI_mutex_key *param_key_info_run_lock,
@@ -4,6 +4,7 @@
 #ifdef HAVE_REPLICATION
 
 #include "rpl_rli_pdb.h"
+#include "rpl_slave_prefetch.h"
 
 class Commit_order_manager;
 
@@ -15,6 +16,22 @@ class Dependency_slave_worker : public Slave_worker
   int execute_event(std::shared_ptr<Log_event_wrapper> &ev);
   void finalize_event(std::shared_ptr<Log_event_wrapper> &ev);
 
+  // rows of a large group looked up ahead of us, see @Slave_prefetcher
+  std::deque<std::shared_ptr<Slave_prefetcher::Group_job>> prefetch_jobs;
+  // bytes of the row events of @prefetch_jobs
+  ulonglong prefetch_bytes= 0;
+  // tables of the table map events up to @prefetch_tail, by table id
+  std::unordered_map<ulonglong, std::shared_ptr<Prefetch_table>>
+    prefetch_tables;
+  // last event of the group looked at for prefetching
+  std::shared_ptr<Log_event_wrapper> prefetch_tail;
+  // bytes of the group executed before the lookahead starts
+  ulonglong prefetch_group_bytes= 0;
+
+  void prefetch_ahead(const std::shared_ptr<Log_event_wrapper> &ev);
+  void track_prefetch_table(Log_event *raw_ev);
+  void end_prefetch();
+
 public:
   Dependency_slave_worker(Relay_log_info *rli
 #ifdef HAVE_PSI_INTERFACE
@@ -41,9 +41,12 @@
 #include "sql_base.h"
 
 #include "blind_fwrite.h"
+#include "mysys_err.h"                  // EE_WRITE
 
 #include <algorithm>
+#include <atomic>
 #include <utility>
+#include <vector>
 using std::max;
 using std::min;
 
@@ -56,9 +59,11 @@ static ha_rows find_all_keys(Sort_param *param,SQL_SELECT *select,
                              IO_CACHE *buffer_file,
                              IO_CACHE *tempfile,
                              Bounded_queue<uchar, uchar> *pq,
+                             bool background_sort,
                              ha_rows *found_rows);
 static int write_keys(Sort_param *param, Filesort_info *fs_info,
-                      uint count, IO_CACHE *buffer_file, IO_CACHE *tempfile);
+                      uint first, uint count, bool sorted,
+                      IO_CACHE *buffer_file, IO_CACHE *tempfile);
 static void register_used_fields(Sort_param *param);
 static int merge_index(Sort_param *param,uchar *sort_buffer,
                        BUFFPEK *buffpek,
@@ -66,12 +71,22 @@ static int merge_index(Sort_param *param,uchar *sort_buffer,
                        IO_CACHE *outfile);
 static bool save_index(Sort_param *param, uint count,
                        Filesort_info *table_sort);
+static int do_merge_buffers(Sort_param *param, IO_CACHE *from_file,
+                            IO_CACHE *to_file, uchar *sort_buffer,
+                            BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
+                            int flag,
+                            std::atomic<THD::killed_state> *killed,
+                            ulonglong *bytes_written);
 static uint suffix_length(ulong string_length);
 static SORT_ADDON_FIELD *get_addon_fields(ulong max_length_for_sort_data,
                                           Field **ptabfield,
                                           uint sortlength, uint *plength);
 static void unpack_addon_fields(struct st_sort_addon_field *addon_field,
                                 uchar *buff);
+static bool init_packed_records(Sort_param *param, SORT_FIELD *sortorder,
+                                uint s_length);
+static void unpack_sort_result(Sort_param *param, const uchar *record,
+                               uchar *to);
 static bool check_if_pq_applicable(Opt_trace_context *trace,
                                    Sort_param *param, Filesort_info *info,
                                    TABLE *table,
@@ -110,6 +125,125 @@ void Sort_param::init_for_filesort(uint sortlen, TABLE *table,
 }
 
 
+/**
+  Whether addon fields of this field are stored at their actual length
+  when records are packed, rather than at SORT_ADDON_FIELD::length.
+*/
+
+static inline bool is_packed_addon(const Field *field)
+{
+  return field->real_type() == MYSQL_TYPE_VARCHAR ||
+         field->real_type() == MYSQL_TYPE_STRING;
+}
+
+
+/**
+  Set up sorting of packed records, see Sort_param::using_packed_records,
+  if any string in the sort key or in the addon fields can be packed.
+
+  String key parts are packed against the sort key of an empty string,
+  which is what their padding looks like. Packed keys compare the same as
+  fixed size ones whatever the pad is, it only decides how much is saved.
+
+  @param param      Sort parameters, set up by init_for_filesort()
+  @param sortorder  The sort key
+  @param s_length   Number of parts of the sort key
+
+  @retval
+    false OK, whether or not the records are packed
+  @retval
+    true  Out of memory
+*/
+
+static bool init_packed_records(Sort_param *param, SORT_FIELD *sortorder,
+                                uint s_length)
+{
+  SORT_KEY_PART *key_parts;
+  uchar *pad;
+  uint packed_parts= 0;
+  bool packed_addons= false;
+  DBUG_ENTER("init_packed_records");
+
+  /*
+    packed_buffer holds a sort key being packed, with the 4 bytes after
+    it which Item::str_result() may write to, or a result being unpacked.
+  */
+  if (!my_multi_malloc(MYF(MY_WME),
+                       &key_parts, s_length * sizeof(SORT_KEY_PART),
+                       &pad, param->sort_length,
+                       &param->packed_buffer, param->rec_length + 4,
+                       NullS))
+    DBUG_RETURN(true);
+
+  for (SORT_KEY_PART *part= key_parts; part != key_parts + s_length;
+       part++, sortorder++)
+  {
+    const CHARSET_INFO *cs;
+    uint nweights;
+    bool maybe_null, is_string;
+    if (sortorder->field)
+    {
+      Field *field= sortorder->field;
+      cs= field->sort_charset();
+      nweights= field->char_length();
+      maybe_null= field->maybe_null();
+      is_string= field->result_type() == STRING_RESULT &&
+                 !field->is_temporal() &&
+                 sortorder->as_type == MYSQL_TYPE_DOCUMENT_UNKNOWN;
+    }
+    else
+    {
+      Item *item= sortorder->item;
+      cs= item->collation.collation;
+      nweights= item->max_char_length();
+      maybe_null= item->maybe_null;
+      is_string= sortorder->result_type == STRING_RESULT &&
+                 !sortorder->suffix_length;
+    }
+    part->length= sortorder->length + (maybe_null ? 1 : 0);
+    part->pad= NULL;
+    // Binary strings store their length last, so their keys do not end in pad
+    if (!is_string || cs == &my_charset_bin)
+      continue;
+
+    uchar *to= pad;
+    if (maybe_null)
+      *to++= 1;
+    cs->coll->strnxfrm(cs, to, sortorder->length, nweights,
+                       (const uchar*) "", 0,
+                       MY_STRXFRM_PAD_WITH_SPACE | MY_STRXFRM_PAD_TO_MAXLEN);
+    if (sortorder->reverse)
+    {
+      for (uint i= 0; i < part->length; i++)
+        pad[i]= (uchar) ~pad[i];
+    }
+    part->pad= pad;
+    pad+= part->length;
+    packed_parts++;
+  }
+
+  for (SORT_ADDON_FIELD *addonf= param->addon_field;
+       addonf && addonf->field; addonf++)
+  {
+    if (is_packed_addon(addonf->field))
+      packed_addons= true;
+  }
+
+  if (!packed_parts && !packed_addons)
+  {
+    my_free(key_parts);
+    param->packed_buffer= NULL;
+    DBUG_RETURN(false);
+  }
+  param->using_packed_records= true;
+  param->key_parts= key_parts;
+  param->key_part_count= s_length;
+  // The record length, and the lengths of the packed key parts
+  param->rec_length+= 4 + 2 * packed_parts;
+  DBUG_RETURN(false);
+}
+
+
 static void trace_filesort_information(Opt_trace_context *trace,
                                        const SORT_FIELD *sortorder,
                                        uint s_length)
@@ -245,6 +379,7 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
   SQL_SELECT *const select= filesort->select;
   ha_rows max_rows= filesort->limit;
   uint s_length= 0;
+  bool background_sort= false;
 
   DBUG_ENTER("filesort");
 
@@ -294,6 +429,7 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
                           table,
                           thd->variables.max_length_for_sort_data,
                           max_rows, sort_positions);
+  param.max_threads= thd->variables.filesort_max_threads;
 
   table_sort.addon_buf= 0;
   table_sort.addon_length= param.addon_length;
@@ -345,6 +481,10 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
   {
     DBUG_PRINT("info", ("filesort PQ is not applicable"));
 
+    if (thd->variables.filesort_packed_records &&
+        init_packed_records(&param, filesort->sortorder, s_length))
+      goto err;
+
     /*
       We need space for at least one record from each merge chunk, i.e.
         param->max_keys_per_buffer >= MERGEBUFF2
@@ -383,6 +523,15 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
       my_error(ER_OUT_OF_SORTMEMORY,MYF(ME_ERROR + ME_FATALERROR));
       goto err;
     }
+    /*
+      If the rows are not expected to fit in the buffer anyway, let
+      find_all_keys() sort one half of it on a helper thread while
+      filling the other half. Packed records are not stored in halves.
+    */
+    background_sort= param.max_threads > 1 &&
+                     !param.using_packed_records &&
+                     num_rows > param.max_keys_per_buffer &&
+                     param.max_keys_per_buffer / 2 >= MERGEBUFF2;
   }
 
   if (filesort_open_cached_file(&buffpek_pointers,mysql_tmpdir,TEMP_PREFIX,
@@ -399,6 +548,7 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
                             &buffpek_pointers,
                             &tempfile, 
                             pq.is_initialized() ? &pq : NULL,
+                            background_sort,
                             found_rows);
     if (num_rows == HA_POS_ERROR)
       goto err;
@@ -474,6 +624,7 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
 
  err:
   my_free(param.tmp_buffer);
+  my_free(param.key_parts);
   if (!subselect || !subselect->is_uncacheable())
   {
     table_sort.free_sort_buffer();
@@ -706,6 +857,80 @@ static void dbug_print_record(TABLE *table, bool print_rowid)
 }
 #endif 
 
+/**
+  Sorts a range of the sort buffer on a helper thread.
+
+  find_all_keys() uses this to split the sort buffer in two halves: while
+  one filled half is being sorted here, rows are read into the other one.
+  If no thread can be started, the range is sorted by start() instead.
+*/
+
+class Background_sort
+{
+public:
+  Background_sort(Sort_param *param, Filesort_info *fs_info)
+    : m_param(param), m_fs_info(fs_info), m_first(0), m_count(0),
+      m_pending(false), m_running(false)
+  {}
+
+  ~Background_sort() { wait(); }
+
+  /**
+    Start sorting count keys starting at key number first.
+
+    @retval true   The keys are being sorted on a helper thread.
+    @retval false  The keys have been sorted by the calling thread.
+  */
+  bool start(uint first, uint count)
+  {
+    DBUG_ASSERT(!m_pending);
+    m_first= first;
+    m_count= count;
+    m_pending= true;
+    m_running= !mysql_thread_create(key_thread_filesort_worker, &m_thread,
+                                    NULL, run, this);
+    if (!m_running)
+      sort();
+    return m_running;
+  }
+
+  /// Wait for the sort started by start(), if any, to finish.
+  void wait()
+  {
+    if (m_running)
+    {
+      pthread_join(m_thread, NULL);
+      m_running= false;
+    }
+  }
+
+  /// Whether a range has been passed to start() but not to done() yet.
+  bool pending() const { return m_pending; }
+  uint first() const { return m_first; }
+  uint count() const { return m_count; }
+  void done() { m_pending= false; }
+
+private:
+  void sort() { m_fs_info->sort_buffer(m_param, m_count, m_first); }
+
+  static void *run(void *arg)
+  {
+    my_thread_init();
+    static_cast<Background_sort*>(arg)->sort();
+    my_thread_end();
+    return NULL;
+  }
+
+  Sort_param *m_param;
+  Filesort_info *m_fs_info;
+  uint m_first;
+  uint m_count;
+  bool m_pending;
+  bool m_running;
+  pthread_t m_thread;
+};
+
+
 /**
   Search after sort_keys, and write them into tempfile
   (if we run out of space in the sort_keys buffer).
@@ -718,6 +943,9 @@ static void dbug_print_record(TABLE *table, bool print_rowid)
                            in tempfile.
   @param tempfile          File to write sorted sequences of sortkeys to.
   @param pq                If !NULL, use it for keeping top N elements
+  @param background_sort   Use the sort_keys buffer as two halves, and sort
+                           a filled half on a helper thread while the other
+                           half is being filled.
   @param [out] found_rows  The number of FOUND_ROWS().
                            For a query with LIMIT, this value will typically
                            be larger than the function return value.
@@ -757,10 +985,13 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
                              IO_CACHE *buffpek_pointers,
                              IO_CACHE *tempfile,
                              Bounded_queue<uchar, uchar> *pq,
+                             bool background_sort,
                              ha_rows *found_rows)
 {
   int error,flag,quick_select;
   uint idx,indexpos,ref_length;
+  uint first,keys_per_run;
+  ha_rows packed_rows_written;
   uchar *ref_pos,*next_pos,ref_buff[MAX_REFLENGTH];
   my_off_t record;
   TABLE *sort_form;
@@ -775,6 +1006,15 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
                      (select ? select->quick ? "ranges" : "where":
                       "every row")));
 
+  Background_sort bg_sort(param, fs_info);
+  /* idx counts the keys of the run being filled, which starts at first */
+  first= 0;
+  keys_per_run= background_sort ? param->max_keys_per_buffer / 2 :
+                                  param->max_keys_per_buffer;
+  /* Packed records fill the buffer until it is full, see make_sortkey() */
+  packed_rows_written= 0;
+  if (param->using_packed_records)
+    fs_info->init_packed_records();
   idx=indexpos=0;
   error=quick_select=0;
   sort_form=param->sort_form;
@@ -878,16 +1118,55 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
         pq->push(ref_pos);
         idx= pq->num_elements();
       }
+      else if (param->using_packed_records)
+      {
+        uchar *record= fs_info->get_packed_record_buffer(param->rec_length);
+        if (!record)
+        {
+          if (write_keys(param, fs_info, 0, idx, false,
+                         buffpek_pointers, tempfile))
+            DBUG_RETURN(HA_POS_ERROR);
+          packed_rows_written+= min<ha_rows>(idx, param->max_rows);
+          fs_info->init_packed_records();
+          record= fs_info->get_packed_record_buffer(param->rec_length);
+          idx= 0;
+          indexpos++;
+        }
+        make_sortkey(param, record, ref_pos);
+        fs_info->commit_packed_record(record,
+                                      param->get_record_length(record));
+        idx++;
+      }
       else
       {
-        if (idx == param->max_keys_per_buffer)
+        if (idx == keys_per_run)
         {
-          if (write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
-             DBUG_RETURN(HA_POS_ERROR);
+          if (!background_sort)
+          {
+            if (write_keys(param, fs_info, first, idx, false,
+                           buffpek_pointers, tempfile))
+              DBUG_RETURN(HA_POS_ERROR);
+          }
+          else
+          {
+            /* Write the previous run, then sort this one behind our back */
+            bg_sort.wait();
+            if (bg_sort.pending())
+            {
+              if (write_keys(param, fs_info, bg_sort.first(), bg_sort.count(),
+                             true, buffpek_pointers, tempfile))
+                DBUG_RETURN(HA_POS_ERROR);
+              bg_sort.done();
+            }
+            if (bg_sort.start(first, idx))
+              status_var_increment(thd->status_var.filesort_parallel_runs);
+            first= first ? 0 : keys_per_run;
+          }
           idx= 0;
           indexpos++;
         }
-        make_sortkey(param, fs_info->get_record_buffer(idx++), ref_pos);
+        make_sortkey(param, fs_info->get_record_buffer(first + idx++),
+                     ref_pos);
       }
     }
     /*
@@ -919,12 +1198,24 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
     file->print_error(error,MYF(ME_ERROR | ME_WAITTANG)); // purecov: inspected
     DBUG_RETURN(HA_POS_ERROR);			/* purecov: inspected */
   }
+  bg_sort.wait();
+  if (bg_sort.pending())
+  {
+    if (write_keys(param, fs_info, bg_sort.first(), bg_sort.count(), true,
+                   buffpek_pointers, tempfile))
+      DBUG_RETURN(HA_POS_ERROR);                /* purecov: inspected */
+    bg_sort.done();
+  }
   if (indexpos && idx &&
-      write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
+      write_keys(param, fs_info, first, idx, false,
+                 buffpek_pointers, tempfile))
     DBUG_RETURN(HA_POS_ERROR);			/* purecov: inspected */
+  if (indexpos && idx)
+    packed_rows_written+= min<ha_rows>(idx, param->max_rows);
   const ha_rows retval= 
-    my_b_inited(tempfile) ?
-    (ha_rows) (my_b_tell(tempfile)/param->rec_length) : idx;
+    !my_b_inited(tempfile) ? idx :
+    param->using_packed_records ? packed_rows_written :
+    (ha_rows) (my_b_tell(tempfile)/param->rec_length);
   DBUG_PRINT("info", ("find_all_keys return %u", (uint) retval));
   DBUG_RETURN(retval);
 } /* find_all_keys */
@@ -939,8 +1230,10 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
     (was: Skriver en buffert med nycklar till filen)
 
   @param param             Sort parameters
-  @param sort_keys         Array of pointers to keys to sort
-  @param count             Number of elements in sort_keys array
+  @param fs_info           Holds the array of pointers to keys to sort
+  @param first             Number of the first key to write
+  @param count             Number of keys to write
+  @param sorted            True if the keys have been sorted already
   @param buffpek_pointers  One 'BUFFPEK' struct will be written into this file.
                            The BUFFPEK::{file_pos, count} will indicate where
                            the sorted data was stored.
@@ -953,8 +1246,8 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
 */
 
 static int
-write_keys(Sort_param *param, Filesort_info *fs_info, uint count,
-           IO_CACHE *buffpek_pointers, IO_CACHE *tempfile)
+write_keys(Sort_param *param, Filesort_info *fs_info, uint first, uint count,
+           bool sorted, IO_CACHE *buffpek_pointers, IO_CACHE *tempfile)
 {
   size_t rec_length;
   uchar **end;
@@ -962,10 +1255,10 @@ write_keys(Sort_param *param, Filesort_info *fs_info, uint count,
   THD *thd= current_thd;
   DBUG_ENTER("write_keys");
 
-  rec_length= param->rec_length;
-  uchar **sort_keys= fs_info->get_sort_keys();
+  uchar **sort_keys= fs_info->get_sort_keys() + first;
 
-  fs_info->sort_buffer(param, count);
+  if (!sorted)
+    fs_info->sort_buffer(param, count, first);
 
   /*
     Pass fs_info to open to indicate that filesize is to be checked
@@ -984,6 +1277,7 @@ write_keys(Sort_param *param, Filesort_info *fs_info, uint count,
   buffpek.count=(ha_rows) count;
   for (end=sort_keys+count ; sort_keys != end ; sort_keys++)
   {
+    rec_length= param->get_record_length(*sort_keys);
     if (my_b_write(tempfile, (uchar*) *sort_keys, (uint) rec_length))
       goto err;
     else /* remember the number of temp bytes written into filesort space */
@@ -1047,6 +1341,11 @@ void copy_native_longlong(uchar *to, int to_length,
 void make_sortkey(Sort_param *param, uchar *to, uchar *ref_pos)
 {
   SORT_FIELD *sort_field;
+  uchar *const record= to;
+
+  /* A packed key is made in fixed size format first, then packed */
+  if (param->using_packed_records)
+    to= param->packed_buffer;
 
   for (sort_field= param->local_sortorder ;
        sort_field != param->end ;
@@ -1262,13 +1561,17 @@ void make_sortkey(Sort_param *param, uchar *to, uchar *ref_pos)
       to+= sort_field->length;
   }
 
+  if (param->using_packed_records)
+    to= pack_sort_key(param, record + 4, param->packed_buffer);
+
   if (param->addon_field)
   {
     /* 
       Save field values appended to sorted fields.
       First null bit indicators are appended then field values follow.
-      In this implementation we use fixed layout for field values -
-      the same for all records.
+      The layout of field values is fixed - the same for all records -
+      unless records are packed: then strings take their actual length,
+      and NULL strings no space at all.
     */
     SORT_ADDON_FIELD *addonf= param->addon_field;
     uchar *nulls= to;
@@ -1277,6 +1580,14 @@ void make_sortkey(Sort_param *param, uchar *to, uchar *ref_pos)
     to+= addonf->offset;
     for (Field* field; (field= addonf->field) ; addonf++)
     {
+      if (param->using_packed_records && is_packed_addon(field))
+      {
+        if (addonf->null_bit && field->is_null())
+          nulls[addonf->null_offset]|= addonf->null_bit;
+        else
+          to= field->pack(to, field->ptr);
+        continue;
+      }
       if (addonf->null_bit && field->is_null())
       {
         nulls[addonf->null_offset]|= addonf->null_bit;
@@ -1292,7 +1603,10 @@ void make_sortkey(Sort_param *param, uchar *to, uchar *ref_pos)
   {
     /* Save filepos last */
     memcpy((uchar*) to, ref_pos, (size_t) param->ref_length);
+    to+= param->ref_length;
   }
+  if (param->using_packed_records)
+    int4store(record, (uint32) (to - record));
   return;
 }
 
@@ -1353,7 +1667,10 @@ static bool save_index(Sort_param *param, uint count, Filesort_info *table_sort)
   uchar **sort_keys= table_sort->get_sort_keys();
   for (uchar **end= sort_keys+count ; sort_keys != end ; sort_keys++)
   {
-    memcpy(to, *sort_keys+offset, res_length);
+    if (param->using_packed_records)
+      unpack_sort_result(param, *sort_keys, to);
+    else
+      memcpy(to, *sort_keys+offset, res_length);
     to+= res_length;
   }
   DBUG_RETURN(0);
@@ -1529,12 +1846,264 @@ bool check_if_pq_applicable(Opt_trace_context *trace,
 }
 
 
+/**
+  The work of one merge pass run by several threads, see
+  merge_pass_parallel().
+*/
+
+struct Merge_pass
+{
+  struct Group
+  {
+    BUFFPEK *Fb, *Tb;                   // The runs to merge
+    my_off_t to_pos;                    // Where the merged run is written
+    BUFFPEK result;                     // Describes the merged run
+  };
+
+  IO_CACHE *from_file;
+  File to_file;
+  Group *groups;
+  uint n_groups;
+  std::atomic<uint> next_group;
+  std::atomic<bool> failed;
+  std::atomic<THD::killed_state> *killed;
+};
+
+
+/** A thread taking part in a Merge_pass, and its share of the sort buffer. */
+
+struct Merge_worker
+{
+  Merge_pass *pass;
+  Sort_param param;
+  uchar *sort_buffer;
+  ulonglong bytes_written;
+  int error_no;
+  bool started;
+  pthread_t thread;
+};
+
+
+/**
+  Write the data buffered in a merge worker's output cache.
+
+  The workers of a merge pass write to the same file at different
+  positions, so the data is written with pwrite() at the cache's own
+  position rather than through the file offset the workers share.
+*/
+
+static int flush_merge_cache(IO_CACHE *info)
+{
+  size_t length= (size_t) (info->write_pos - info->write_buffer);
+  if (length &&
+      mysql_file_pwrite(info->file, info->write_buffer, length,
+                        info->pos_in_file, MYF(MY_WME | MY_NABP)))
+    return (info->error= -1);
+  info->pos_in_file+= length;
+  info->write_pos= info->write_buffer;
+  info->write_end= info->write_buffer + info->buffer_length;
+  return 0;
+}
+
+
+/** The write_function of a merge worker's output cache. */
+
+static int write_merge_cache(IO_CACHE *info, const uchar *Buffer,
+                             size_t Count)
+{
+  if (flush_merge_cache(info))
+    return 1;
+  if (Count >= info->buffer_length)
+  {
+    if (mysql_file_pwrite(info->file, Buffer, Count, info->pos_in_file,
+                          MYF(MY_WME | MY_NABP)))
+      return (info->error= -1);
+    info->pos_in_file+= Count;
+    return 0;
+  }
+  memcpy(info->write_pos, Buffer, Count);
+  info->write_pos+= Count;
+  return 0;
+}
+
+
+/** Merge groups of a Merge_pass until none is left. */
+
+static void run_merge_worker(Merge_worker *worker)
+{
+  Merge_pass *pass= worker->pass;
+  IO_CACHE to_file;
+  uint n;
+
+  if (init_io_cache(&to_file, pass->to_file, DISK_BUFFER_SIZE, WRITE_CACHE,
+                    0L, 0, MYF(MY_WME)))
+  {
+    worker->error_no= my_errno;
+    pass->failed= true;
+    return;
+  }
+  to_file.write_function= write_merge_cache;
+
+  while (!pass->failed && (n= pass->next_group++) < pass->n_groups)
+  {
+    Merge_pass::Group *group= &pass->groups[n];
+    to_file.pos_in_file= group->to_pos;
+    if (do_merge_buffers(&worker->param, pass->from_file, &to_file,
+                         worker->sort_buffer, &group->result,
+                         group->Fb, group->Tb, 0, pass->killed,
+                         &worker->bytes_written) ||
+        flush_merge_cache(&to_file))
+    {
+      worker->error_no= my_errno;
+      pass->failed= true;
+    }
+  }
+  end_io_cache(&to_file);
+}
+
+
+static void *merge_worker_thread(void *arg)
+{
+  my_thread_init();
+  run_merge_worker(static_cast<Merge_worker*>(arg));
+  my_thread_end();
+  return NULL;
+}
+
+
+/**
+  Run one pass of merge_many_buff() on several threads.
+
+  The runs are grouped as in the serial pass, and the size of each merged
+  run is known up front, so every group gets its place in to_file before
+  merging starts. The sort buffer is split between the threads, and the
+  session thread merges groups too.
+
+  @param param        Sort parameters
+  @param sort_buffer  Buffer for param->max_keys_per_buffer sort keys
+  @param buffpek      The runs to merge, replaced by the merged runs
+  @param maxbuffer    Number of runs - 1
+  @param from_file    File holding the runs
+  @param to_file      File to write the merged runs to
+  @param threads      Number of threads to use, including this one
+  @param[out] runs    Number of merged runs
+
+  @retval
+    0 OK
+  @retval
+    1 Error
+*/
+
+static int merge_pass_parallel(Sort_param *param, uchar *sort_buffer,
+                               BUFFPEK *buffpek, uint maxbuffer,
+                               IO_CACHE *from_file, IO_CACHE *to_file,
+                               uint threads, uint *runs)
+{
+  THD *thd= current_thd;
+  const uint rec_length= param->rec_length;
+  const uint keys_per_worker= param->max_keys_per_buffer / threads;
+  std::vector<Merge_pass::Group> groups;
+  std::vector<Merge_worker> workers(threads);
+  Merge_pass pass;
+  my_off_t to_pos= 0;
+  ulonglong bytes_written= 0;
+  int error_no= 0;
+  uint i;
+  DBUG_ENTER("merge_pass_parallel");
+
+  /* Group the runs the way the serial pass does */
+  for (i= 0 ; i <= maxbuffer ; )
+  {
+    const uint last= (i <= maxbuffer - MERGEBUFF*3/2) ?
+                     i + MERGEBUFF - 1 : maxbuffer;
+    Merge_pass::Group group;
+    ha_rows count= 0;
+    group.Fb= buffpek + i;
+    group.Tb= buffpek + last;
+    group.to_pos= to_pos;
+    for (BUFFPEK *run= group.Fb; run <= group.Tb; run++)
+      count+= run->count;
+    to_pos+= min(count, param->max_rows) * rec_length;
+    groups.push_back(group);
+    i= last + 1;
+  }
+
+  /* Write through the file descriptor, which open_cached_file() delays */
+  if (to_file->file < 0 && real_open_cached_file(to_file))
+    DBUG_RETURN(1);                             /* purecov: inspected */
+
+  pass.from_file= from_file;
+  pass.to_file= to_file->file;
+  pass.groups= &groups[0];
+  pass.n_groups= groups.size();
+  pass.next_group= 0;
+  pass.failed= false;
+  pass.killed= &thd->killed;
+
+  for (uint w= 0; w < threads; w++)
+  {
+    Merge_worker *worker= &workers[w];
+    worker->pass= &pass;
+    worker->param= *param;
+    worker->param.max_keys_per_buffer= keys_per_worker;
+    worker->sort_buffer=
+      sort_buffer + (size_t) w * keys_per_worker * rec_length;
+    worker->bytes_written= 0;
+    worker->error_no= 0;
+    worker->started= w > 0 &&
+      !mysql_thread_create(key_thread_filesort_worker, &worker->thread,
+                           NULL, merge_worker_thread, worker);
+  }
+  /* Threads which could not be started leave their groups to the others */
+  run_merge_worker(&workers[0]);
+  for (uint w= 0; w < threads; w++)
+  {
+    if (workers[w].started)
+      pthread_join(workers[w].thread, NULL);
+    bytes_written+= workers[w].bytes_written;
+    if (workers[w].error_no)
+      error_no= workers[w].error_no;
+  }
+  /* remember the number of temp bytes written into filesort space */
+  thd->inc_filesort_bytes_written(bytes_written);
+
+  if (pass.failed)
+  {
+    if (!thd->killed && !thd->is_error())
+    {
+      char errbuf[MYSYS_STRERROR_SIZE];
+      my_error(EE_WRITE, MYF(ME_BELL+ME_WAITTANG), my_filename(pass.to_file),
+               error_no, my_strerror(errbuf, sizeof(errbuf), error_no));
+    }
+    DBUG_RETURN(1);
+  }
+
+  for (i= 0; i < pass.n_groups; i++)
+  {
+    thd->inc_status_sort_merge_passes();
+    buffpek[i]= groups[i].result;
+  }
+  status_var_increment(thd->status_var.filesort_parallel_merge_passes);
+  *runs= pass.n_groups;
+
+  /*
+    Move the cache of to_file past the merged runs, which also accounts
+    for them in the filesort disk usage.
+  */
+  if (reinit_io_cache(to_file, WRITE_CACHE, to_pos, 0, 0) ||
+      (to_file->post_write && to_file->post_write(to_file)))
+    DBUG_RETURN(1);
+  DBUG_RETURN(0);
+} /* merge_pass_parallel */
+
+
 /** Merge buffers to make < MERGEBUFF2 buffers. */
 
 int merge_many_buff(Sort_param *param, uchar *sort_buffer,
                     BUFFPEK *buffpek, uint *maxbuffer, IO_CACHE *t_file)
 {
   register uint i;
+  uint threads;
   IO_CACHE t_file2,*from_file,*to_file,*temp;
   BUFFPEK *lastbuff;
   DBUG_ENTER("merge_many_buff");
@@ -1554,15 +2123,35 @@ int merge_many_buff(Sort_param *param, uchar *sort_buffer,
     if (reinit_io_cache(to_file,WRITE_CACHE,0L,0,0))
       goto cleanup;
     lastbuff=buffpek;
-    for (i=0 ; i <= *maxbuffer-MERGEBUFF*3/2 ; i+=MERGEBUFF)
+    /*
+      Every thread of a parallel pass needs room for one key of each of
+      the (up to MERGEBUFF*3/2) runs it merges. Uniques remove duplicates
+      while merging, and packed records vary in length, so the size of
+      their merged runs is not known up front, and they are always merged
+      serially.
+    */
+    threads= min(param->max_threads, (*maxbuffer + 1) / MERGEBUFF);
+    threads= min(threads, param->max_keys_per_buffer / MERGEBUFF2);
+    if (threads > 1 && !param->unique_buff && !param->using_packed_records)
     {
+      uint runs;
+      if (merge_pass_parallel(param, sort_buffer, buffpek, *maxbuffer,
+                              from_file, to_file, threads, &runs))
+        break;
+      lastbuff+= runs;
+    }
+    else
+    {
+      for (i=0 ; i <= *maxbuffer-MERGEBUFF*3/2 ; i+=MERGEBUFF)
+      {
+        if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
+                          buffpek+i,buffpek+i+MERGEBUFF-1,0))
+        goto cleanup;
+      }
       if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
-			buffpek+i,buffpek+i+MERGEBUFF-1,0))
-      goto cleanup;
+                        buffpek+i,buffpek+ *maxbuffer,0))
+        break;					/* purecov: inspected */
     }
-    if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
-		      buffpek+i,buffpek+ *maxbuffer,0))
-      break;					/* purecov: inspected */
     if (flush_io_cache(to_file))
       break;					/* purecov: inspected */
     temp=from_file; from_file=to_file; to_file=temp;
@@ -1610,6 +2199,50 @@ uint read_to_buffer(IO_CACHE *fromfile, BUFFPEK *buffpek,
 } /* read_to_buffer */
 
 
+/**
+  Read packed records to buffer: as many whole records as fit in the
+  buffpek->max_keys * rec_length bytes of the buffer.
+
+  @retval
+    (uint)-1 if something goes wrong
+  @retval
+    Number of bytes read, 0 if there are no more records
+*/
+
+static uint read_packed_to_buffer(IO_CACHE *fromfile, BUFFPEK *buffpek,
+                                  uint rec_length)
+{
+  uint count= 0;
+  size_t length= 0;
+
+  if (buffpek->count)
+  {
+    /* The run may end before the buffer is full, and the file too */
+    size_t bytes_read= mysql_file_pread(fromfile->file, buffpek->base,
+                                        buffpek->max_keys * rec_length,
+                                        buffpek->file_pos, MYF(MY_WME));
+    if (bytes_read == MY_FILE_ERROR)
+      return((uint) -1);			/* purecov: inspected */
+    while (count < buffpek->count && length + 4 <= bytes_read)
+    {
+      const uint record_length= uint4korr(buffpek->base + length);
+      if (length + record_length > bytes_read)
+        break;
+      length+= record_length;
+      count++;
+    }
+    /* Every record fits in the buffer, so at least one has been read */
+    if (!count)
+      return((uint) -1);			/* purecov: inspected */
+    buffpek->key= buffpek->base;
+    buffpek->file_pos+= length;
+    buffpek->count-= count;
+    buffpek->mem_count= count;
+  }
+  return (uint) length;
+} /* read_packed_to_buffer */
+
+
 /**
   Put all room used by freed buffer to use in adjacent buffer.
 
@@ -1643,6 +2276,30 @@ void reuse_freed_buff(QUEUE *queue, BUFFPEK *reuse, uint key_length)
 }
 
 
+/**
+  Write a packed record while merging: as it is, or if flag is set, its
+  part of the sorted result. See do_merge_buffers().
+*/
+
+static int write_merged_record(Sort_param *param, IO_CACHE *to_file,
+                               uchar *record, int flag,
+                               ulonglong *bytes_written)
+{
+  uint length= param->get_record_length(record);
+  if (flag)
+  {
+    unpack_sort_result(param, record, param->packed_buffer);
+    record= param->packed_buffer;
+    length= param->res_length;
+  }
+  if (my_b_write(to_file, record, length))
+    return 1;                                   /* purecov: inspected */
+  /* remember the number of temp bytes written into filesort space */
+  *bytes_written+= length;
+  return 0;
+}
+
+
 /**
   Merge buffers to one buffer.
 
@@ -1654,6 +2311,13 @@ void reuse_freed_buff(QUEUE *queue, BUFFPEK *reuse, uint key_length)
   @param Fb           First element in source BUFFPEKs array
   @param Tb           Last element in source BUFFPEKs array
   @param flag
+  @param killed       Stop merging, with an error, when this is set.
+  @param[in,out] bytes_written  Number of bytes written to to_file is
+                                added here.
+
+  @note
+    Does not use the session THD, so that the passes of
+    merge_many_buff() can run on helper threads.
 
   @retval
     0      OK
@@ -1661,10 +2325,12 @@ void reuse_freed_buff(QUEUE *queue, BUFFPEK *reuse, uint key_length)
     other  error
 */
 
-int merge_buffers(Sort_param *param, IO_CACHE *from_file,
-                  IO_CACHE *to_file, uchar *sort_buffer,
-                  BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
-                  int flag)
+static int do_merge_buffers(Sort_param *param, IO_CACHE *from_file,
+                            IO_CACHE *to_file, uchar *sort_buffer,
+                            BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
+                            int flag,
+                            std::atomic<THD::killed_state> *killed,
+                            ulonglong *bytes_written)
 {
   int error;
   uint rec_length,res_length,offset;
@@ -1677,16 +2343,10 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
   QUEUE queue;
   qsort2_cmp cmp;
   void *first_cmp_arg;
-  std::atomic<THD::killed_state> *killed= &current_thd->killed;
-  std::atomic<THD::killed_state> not_killable;
-  DBUG_ENTER("merge_buffers");
-
-  current_thd->inc_status_sort_merge_passes();
-  if (param->not_killable)
-  {
-   killed= &not_killable;
-    not_killable= THD::NOT_KILLED;
-  }
+  const bool packed= param->using_packed_records;
+  uint (*read_to)(IO_CACHE *, BUFFPEK *, uint)=
+    packed ? read_packed_to_buffer : read_to_buffer;
+  DBUG_ENTER("do_merge_buffers");
 
   error=0;
   rec_length= param->rec_length;
@@ -1706,6 +2366,11 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
     cmp= param->compare;
     first_cmp_arg= (void *) &param->cmp_context;
   }
+  else if (packed)
+  {
+    cmp= cmp_packed_sort_record_ptrs;
+    first_cmp_arg= (void *) param;
+  }
   else
   {
     cmp= get_ptr_compare(sort_length);
@@ -1719,10 +2384,13 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
     buffpek->base= strpos;
     buffpek->max_keys= maxcount;
     strpos+=
-      (uint) (error= (int)read_to_buffer(from_file, buffpek, rec_length));
+      (uint) (error= (int)read_to(from_file, buffpek, rec_length));
     if (error == -1)
       goto err;					/* purecov: inspected */
-    buffpek->max_keys= buffpek->mem_count;	// If less data in buffers than expected
+    if (packed)
+      strpos= buffpek->base + maxcount * rec_length;  // Keep the whole share
+    else
+      buffpek->max_keys= buffpek->mem_count;	// If less data in buffers than expected
     queue_insert(&queue, (uchar*) buffpek);
   }
 
@@ -1744,7 +2412,7 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
     }
     else /* remember the number of temp bytes written into filesort space */
     {
-      current_thd->inc_filesort_bytes_written((ulonglong) rec_length);
+      *bytes_written+= rec_length;
     }
     buffpek->key+= rec_length;
     buffpek->mem_count--;
@@ -1774,7 +2442,15 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
               goto skip_duplicate;
             memcpy(param->unique_buff, (uchar*) buffpek->key, rec_length);
       }
-      if (flag == 0)
+      if (packed)
+      {
+        if (write_merged_record(param, to_file, buffpek->key, flag,
+                                bytes_written))
+        {
+          error=1; goto err;                        /* purecov: inspected */
+        }
+      }
+      else if (flag == 0)
       {
         if (my_b_write(to_file,(uchar*) buffpek->key, rec_length))
         {
@@ -1782,7 +2458,7 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
         }
         else /* remember the number of temp bytes written into filesort space */
         {
-          current_thd->inc_filesort_bytes_written((ulonglong) rec_length);
+          *bytes_written+= rec_length;
         }
       }
       else
@@ -1793,7 +2469,7 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
         }
         else /* remember the number of temp bytes written into filesort space */
         {
-          current_thd->inc_filesort_bytes_written((ulonglong) res_length);
+          *bytes_written+= res_length;
         }
       }
       if (!--max_rows)
@@ -1803,11 +2479,11 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
       }
 
     skip_duplicate:
-      buffpek->key+= rec_length;
+      buffpek->key+= param->get_record_length(buffpek->key);
       if (! --buffpek->mem_count)
       {
-        if (!(error= (int) read_to_buffer(from_file,buffpek,
-                                          rec_length)))
+        if (!(error= (int) read_to(from_file,buffpek,
+                                   rec_length)))
         {
           (void) queue_remove(&queue,0);
           reuse_freed_buff(&queue, buffpek, rec_length);
@@ -1844,7 +2520,19 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
       buffpek->count= 0;                        /* Don't read more */
     }
     max_rows-= buffpek->mem_count;
-    if (flag == 0)
+    if (packed)
+    {
+      strpos= buffpek->key;
+      for (ulong n= buffpek->mem_count; n; n--)
+      {
+        if (write_merged_record(param, to_file, strpos, flag, bytes_written))
+        {
+          error=1; goto err;                        /* purecov: inspected */
+        }
+        strpos+= param->get_record_length(strpos);
+      }
+    }
+    else if (flag == 0)
     {
       if (my_b_write(to_file,(uchar*) buffpek->key,
                      (rec_length*buffpek->mem_count)))
@@ -1853,8 +2541,7 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
       }
       else /* remember the number of temp bytes written into filesort space */
       {
-        current_thd->inc_filesort_bytes_written(
-            (ulonglong) (rec_length*buffpek->mem_count));
+        *bytes_written+= rec_length*buffpek->mem_count;
       }
     }
     else
@@ -1871,12 +2558,12 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
         }
         else /* remember the number of temp bytes written into filesort space */
         {
-          current_thd->inc_filesort_bytes_written((ulonglong) res_length);
+          *bytes_written+= res_length;
         }
       }
     }
   }
-  while ((error=(int) read_to_buffer(from_file,buffpek, rec_length))
+  while ((error=(int) read_to(from_file,buffpek, rec_length))
          != -1 && error != 0);
 
 end:
@@ -1885,7 +2572,37 @@ end:
 err:
   delete_queue(&queue);
   DBUG_RETURN(error);
-} /* merge_buffers */
+} /* do_merge_buffers */
+
+
+/**
+  Merge buffers to one buffer, on the session thread.
+  See do_merge_buffers() for the parameters.
+*/
+
+int merge_buffers(Sort_param *param, IO_CACHE *from_file,
+                  IO_CACHE *to_file, uchar *sort_buffer,
+                  BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
+                  int flag)
+{
+  THD *thd= current_thd;
+  std::atomic<THD::killed_state> *killed= &thd->killed;
+  std::atomic<THD::killed_state> not_killable;
+  ulonglong bytes_written= 0;
+
+  thd->inc_status_sort_merge_passes();
+  if (param->not_killable)
+  {
+    killed= &not_killable;
+    not_killable= THD::NOT_KILLED;
+  }
+  int error= do_merge_buffers(param, from_file, to_file, sort_buffer,
+                              lastbuff, Fb, Tb, flag, killed,
+                              &bytes_written);
+  /* remember the number of temp bytes written into filesort space */
+  thd->inc_filesort_bytes_written(bytes_written);
+  return error;
+}
 
 
 	/* Do a merge to output-file (save only positions) */
@@ -2154,6 +2871,46 @@ unpack_addon_fields(struct st_sort_addon_field *addon_field, uchar *buff)
   }
 }
 
+/**
+  Copy the record reference or the addon fields of a packed record, see
+  make_sortkey(), to the fixed size layout of the sorted result, which
+  is what readers of the result and unpack_addon_fields() expect.
+
+  @param param   Sort parameters
+  @param record  The packed record
+  @param to      Where to write param->res_length bytes
+*/
+
+static void unpack_sort_result(Sort_param *param, const uchar *record,
+                               uchar *to)
+{
+  SORT_ADDON_FIELD *addonf= param->addon_field;
+  if (!addonf)
+  {
+    // The record reference ends the record
+    memcpy(to, record + uint4korr(record) - param->ref_length,
+           param->ref_length);
+    return;
+  }
+
+  const uchar *from= skip_packed_sort_key(param, record + 4);
+  const uchar *nulls= from;
+  memcpy(to, nulls, addonf->offset);
+  from+= addonf->offset;
+  for (Field *field; (field= addonf->field) ; addonf++)
+  {
+    uint length= addonf->length;
+    if (is_packed_addon(field))
+    {
+      if (addonf->null_bit && (nulls[addonf->null_offset] & addonf->null_bit))
+        continue;
+      length= field->packed_col_length(from, field->field_length);
+    }
+    memcpy(to + addonf->offset, from, length);
+    from+= length;
+  }
+}
+
 /*
 ** functions to change a double or float to a sortable string
 ** The following should work for IEEE
@@ -130,6 +130,92 @@ void Filesort_buffer::free_sort_buffer()
   m_idx_array= Idx_array();
   m_record_length= 0;
   m_start_of_data= NULL;
+  m_packed_count= 0;
+  m_end_of_free= NULL;
+}
+
+
+uchar *pack_sort_key(const Sort_param *param, uchar *to, const uchar *key)
+{
+  const SORT_KEY_PART *part= param->key_parts;
+  const SORT_KEY_PART *end= part + param->key_part_count;
+  for (; part != end; part++)
+  {
+    uint length= part->length;
+    if (part->pad)
+    {
+      while (length && key[length - 1] == part->pad[length - 1])
+        length--;
+      int2store(to, length);
+      to+= 2;
+    }
+    memcpy(to, key, length);
+    to+= length;
+    key+= part->length;
+  }
+  return to;
+}
+
+
+const uchar *skip_packed_sort_key(const Sort_param *param, const uchar *key)
+{
+  const SORT_KEY_PART *part= param->key_parts;
+  const SORT_KEY_PART *end= part + param->key_part_count;
+  for (; part != end; part++)
+    key+= part->pad ? 2 + uint2korr(key) : part->length;
+  return key;
+}
+
+
+int cmp_packed_sort_records(const Sort_param *param,
+                            const uchar *a, const uchar *b)
+{
+  const SORT_KEY_PART *part= param->key_parts;
+  const SORT_KEY_PART *end= part + param->key_part_count;
+  int res;
+
+  a+= 4;                                        // Skip the record length
+  b+= 4;
+  for (; part != end; part++)
+  {
+    if (!part->pad)
+    {
+      if ((res= memcmp(a, b, part->length)))
+        return res;
+      a+= part->length;
+      b+= part->length;
+      continue;
+    }
+    /*
+      The stripped bytes are those of the pad, so where one key is longer
+      than the other, compare its extra bytes with the pad.
+    */
+    const uint a_length= uint2korr(a);
+    const uint b_length= uint2korr(b);
+    a+= 2;
+    b+= 2;
+    if ((res= memcmp(a, b, std::min(a_length, b_length))))
+      return res;
+    if (a_length > b_length)
+      res= memcmp(a + b_length, part->pad + b_length, a_length - b_length);
+    else if (a_length < b_length)
+      res= memcmp(part->pad + a_length, b + a_length, b_length - a_length);
+    if (res)
+      return res;
+    a+= a_length;
+    b+= b_length;
+  }
+  // Without addon fields, the record reference is the last part of the key
+  return param->addon_field ? 0 : memcmp(a, b, param->ref_length);
+}
+
+
+int cmp_packed_sort_record_ptrs(const void *param,
+                                const void *a, const void *b)
+{
+  return cmp_packed_sort_records(static_cast<const Sort_param*>(param),
+                                 *static_cast<const uchar* const*>(a),
+                                 *static_cast<const uchar* const*>(b));
 }
 
 
@@ -171,6 +257,20 @@ private:
   size_t m_size;
 };
 
+
+class Packed_compare :
+  public std::binary_function<const uchar*, const uchar*, bool>
+{
+public:
+  Packed_compare(const Sort_param *param) : m_param(param) {}
+  bool operator()(const uchar *s1, const uchar *s2) const
+  {
+    return cmp_packed_sort_records(m_param, s1, s2) < 0;
+  }
+private:
+  const Sort_param *m_param;
+};
+
 template <typename type>
 size_t try_reserve(std::pair<type*, ptrdiff_t> *buf, ptrdiff_t size)
 {
@@ -185,14 +285,25 @@ size_t try_reserve(std::pair<type*, ptrdiff_t> *buf, ptrdiff_t size)
 
 } // namespace
 
-void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
+void Filesort_buffer::sort_buffer(const Sort_param *param, uint count,
+                                  uint first)
 {
   if (count <= 1)
     return;
   if (param->sort_length == 0)
     return;
 
-  uchar **keys= get_sort_keys();
+  uchar **keys= get_sort_keys() + first;
+  if (param->using_packed_records)
+  {
+    // See below for the choice of sort algorithm
+    if (count < 100)
+      my_qsort2(keys, count, sizeof(uchar*), cmp_packed_sort_record_ptrs,
+                param);
+    else
+      std::stable_sort(keys, keys + count, Packed_compare(param));
+    return;
+  }
   std::pair<uchar**, ptrdiff_t> buffer;
   if (radixsort_is_appliccable(count, param->sort_length) &&
       try_reserve(&buffer, count))
@@ -47,6 +47,33 @@ double get_merge_many_buffs_cost_fast(ha_rows num_rows,
                                       uint    elem_size);
 
 
+/**
+  Pack a sort key, see Sort_param::using_packed_records.
+
+  @param param  Sort parameters, with the parts of the key
+  @param to     Where to write the packed key
+  @param key    The key in fixed size format
+
+  @return The end of the packed key.
+*/
+uchar *pack_sort_key(const Sort_param *param, uchar *to, const uchar *key);
+
+/// Returns the end of the packed sort key starting at key.
+const uchar *skip_packed_sort_key(const Sort_param *param, const uchar *key);
+
+/**
+  Compare two packed sort records, as memcmp() would compare the same
+  records in fixed size format. The record reference, if the records have
+  one rather than addon fields, is part of the comparison.
+*/
+int cmp_packed_sort_records(const Sort_param *param,
+                            const uchar *a, const uchar *b);
+
+/// cmp_packed_sort_records() for pointers to records, with qsort2_cmp's type.
+int cmp_packed_sort_record_ptrs(const void *param,
+                                const void *a, const void *b);
+
+
 /**
   A wrapper class around the buffer used by filesort().
   The buffer is a contiguous chunk of memory,
@@ -55,6 +82,9 @@ double get_merge_many_buffs_cost_fast(ha_rows num_rows,
   We wrap the buffer in order to be able to do lazy initialization of the
   pointers: the buffer is often much larger than what we actually need.
 
+  Packed records, which vary in length, are stored differently: see
+  init_packed_records().
+
   The buffer must be kept available for multiple executions of the
   same sort operation, so we have explicit allocate and free functions,
   rather than doing alloc/free in CTOR/DTOR.
@@ -63,11 +93,15 @@ class Filesort_buffer
 {
 public:
   Filesort_buffer() :
-    m_idx_array(), m_record_length(0), m_start_of_data(NULL)
+    m_idx_array(), m_record_length(0), m_start_of_data(NULL),
+    m_packed_count(0), m_end_of_free(NULL)
   {}
 
-  /** Sort me... */
-  void sort_buffer(const Sort_param *param, uint count);
+  /**
+    Sort me... or only the count keys starting at key number first.
+    Disjoint key ranges may be sorted concurrently.
+  */
+  void sort_buffer(const Sort_param *param, uint count, uint first= 0);
 
   /// Initializes a record pointer.
   uchar *get_record_buffer(uint idx)
@@ -83,6 +117,45 @@ public:
       (void) get_record_buffer(ix);
   }
 
+  /**
+    Start filling the buffer with packed records: the record pointers
+    grow from the start of the buffer, and the records from its end, so
+    that the buffer holds more than the allocated number of records when
+    they are shorter than the record length it was allocated with.
+  */
+  void init_packed_records()
+  {
+    m_packed_count= 0;
+    m_end_of_free= m_start_of_data + m_idx_array.size() * m_record_length;
+  }
+
+  /**
+    Returns space for a packed record of at most max_length bytes, which
+    commit_packed_record() then adds to the buffer, or NULL if the buffer
+    is full.
+  */
+  uchar *get_packed_record_buffer(uint max_length)
+  {
+    uchar *pointers_end=
+      reinterpret_cast<uchar*>(m_idx_array.array() + m_packed_count + 1);
+    if (m_end_of_free < pointers_end + max_length)
+      return NULL;
+    return m_end_of_free - max_length;
+  }
+
+  /**
+    Add the first length bytes of the record written to the space returned
+    by get_packed_record_buffer(). They are moved next to the previous
+    record, so that only length bytes of the buffer are used.
+  */
+  void commit_packed_record(uchar *record, uint length)
+  {
+    uchar *to= m_end_of_free - length;
+    memmove(to, record, length);
+    m_idx_array.array()[m_packed_count++]= to;
+    m_end_of_free= to;
+  }
+
   /// Returns total size: pointer array + record buffers.
   size_t sort_buffer_size() const
   {
@@ -109,6 +182,8 @@ public:
     m_idx_array= rhs.m_idx_array;
     m_record_length= rhs.m_record_length;
     m_start_of_data= rhs.m_start_of_data;
+    m_packed_count= rhs.m_packed_count;
+    m_end_of_free= rhs.m_end_of_free;
     return *this;
   }
 
@@ -118,6 +193,8 @@ private:
   Idx_array  m_idx_array;
   uint       m_record_length;
   uchar     *m_start_of_data;
+  uint       m_packed_count;    // Number of packed records in the buffer
+  uchar     *m_end_of_free;     // The last packed record
 };
 
 #endif  // FILESORT_UTILS_INCLUDED
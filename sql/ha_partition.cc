@@ -63,6 +63,16 @@
 #include "sql_admin.h"                       // SQL_ADMIN_MSG_TEXT_SIZE
 
 #include "debug_sync.h"
+#include "mysqld.h"                          // key_thread_partition_scan
+#include "sql_class.h"                       // init_worker_thd
+#include "transaction.h"                     // trans_commit_stmt
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <vector>
 
 using std::min;
 using std::max;
@@ -397,6 +407,8 @@ void ha_partition::init_handler_variables()
   part_share= NULL;
   m_new_partitions_share_refs.empty();
   m_sec_sort_by_rowid= false;
+  m_parallel_scan= NULL;
+  m_parallel_scan_pending= false;
 
 #ifdef DONT_HAVE_TO_BE_INITALIZED
   m_start_key.flag= 0;
@@ -3447,7 +3459,7 @@ int ha_partition::open(const char *name, int mode, uint test_if_locked)
       create_partition_name(name_buff, name, name_buffer_ptr, NORMAL_PART_NAME,
                             FALSE);
       /* ::clone() will also set ha_share from the original. */
-      if (!(m_file[i]= file[i]->clone(name_buff, m_clone_mem_root)))
+      if (!(m_file[i]= file[i]->clone(name_buff, m_clone_mem_root, table)))
       {
         error= HA_ERR_INITIALIZATION;
         file= &m_file[i];
@@ -3577,7 +3589,9 @@ void ha_partition::rebind_psi()
 /**
   Clone the open and locked partitioning handler.
 
-  @param  mem_root  MEM_ROOT to use.
+  @param  name       Name of the table.
+  @param  mem_root   MEM_ROOT to use.
+  @param  table_arg  TABLE to open the clone and its partitions on.
 
   @return Pointer to the successfully created clone or NULL
 
@@ -3590,7 +3604,8 @@ void ha_partition::rebind_psi()
   which will allocate then on the correct MEM_ROOT and also open them.
 */
 
-handler *ha_partition::clone(const char *name, MEM_ROOT *mem_root)
+handler *ha_partition::clone(const char *name, MEM_ROOT *mem_root,
+                             TABLE *table_arg)
 {
   ha_partition *new_handler;
 
@@ -3616,8 +3631,8 @@ handler *ha_partition::clone(const char *name, MEM_ROOT *mem_root)
                                               ALIGN_SIZE(m_ref_length)*2)))
     goto err;
 
-  if (new_handler->ha_open(table, name,
-                           table->db_stat,
+  if (new_handler->ha_open(table_arg, name,
+                           table_arg->db_stat,
                            HA_OPEN_IGNORE_IF_LOCKED | HA_OPEN_NO_PSI_CALL))
     goto err;
 
@@ -3654,6 +3669,7 @@ int ha_partition::close(void)
   DBUG_ENTER("ha_partition::close");
 
   DBUG_ASSERT(table->s == table_share);
+  end_parallel_scan();
   destroy_record_priority_queue();
   free_partition_bitmaps();
   DBUG_ASSERT(m_part_info);
@@ -4772,9 +4788,14 @@ int ha_partition::rnd_init(bool scan)
       is already in use
     */
     rnd_end();
-    late_extra_cache(part_id);
-    if ((error= m_file[part_id]->ha_rnd_init(scan)))
-      goto err;
+    if (parallel_scan_possible())
+      m_parallel_scan_pending= true;
+    else
+    {
+      late_extra_cache(part_id);
+      if ((error= m_file[part_id]->ha_rnd_init(scan)))
+        goto err;
+    }
   }
   else
   {
@@ -4825,7 +4846,11 @@ int ha_partition::rnd_end()
   case 2:                                       // Error
     break;
   case 1:
-    if (NO_CURRENT_PART_ID != m_part_spec.start_part)         // Table scan
+    if (m_parallel_scan)
+      end_parallel_scan();
+    else if (m_parallel_scan_pending)
+      m_parallel_scan_pending= false;
+    else if (NO_CURRENT_PART_ID != m_part_spec.start_part)    // Table scan
     {
       late_extra_no_cache(m_part_spec.start_part);
       m_file[m_part_spec.start_part]->ha_rnd_end();
@@ -4885,6 +4910,24 @@ int ha_partition::rnd_next(uchar *buf)
   }
   
   DBUG_ASSERT(m_scan_value == 1);
+  if (m_parallel_scan_pending)
+  {
+    m_parallel_scan_pending= false;
+    if (!start_parallel_scan(false))
+    {
+      /* Scan the partitions one at a time as rnd_init() would have */
+      late_extra_cache(part_id);
+      if ((result= m_file[part_id]->ha_rnd_init(true)))
+        goto end;
+    }
+  }
+  if (m_parallel_scan)
+  {
+    /* The handler statistics are counted by the workers */
+    if (!(result= handle_parallel_unordered_next(buf)))
+      stats.rows_read++;
+    DBUG_RETURN(result);
+  }
   file= m_file[part_id];
   
   while (TRUE)
@@ -4970,6 +5013,12 @@ void ha_partition::position(const uchar *record)
   DBUG_ASSERT(bitmap_is_set(&(m_part_info->read_partitions), m_last_part));
   DBUG_ENTER("ha_partition::position");
 
+  if (m_parallel_scan)
+  {
+    /* The worker stored the position when it read the row */
+    memcpy(ref, m_parallel_scan->ref(m_last_part), m_ref_length);
+    DBUG_VOID_RETURN;
+  }
   int2store(ref, m_last_part);
   /*
     If m_sec_sort_by_rowid is set, then the ref is already stored in the
@@ -5241,6 +5290,7 @@ int ha_partition::index_init(uint inx, bool sorted)
   DBUG_ENTER("ha_partition::index_init");
 
   DBUG_PRINT("info", ("inx %u sorted %u", inx, sorted));
+  end_parallel_scan();
   last_active_index= active_index= inx;
   m_part_spec.start_part= NO_CURRENT_PART_ID;
   m_start_key.length= 0;
@@ -5306,6 +5356,8 @@ err:
     }
     destroy_record_priority_queue();
   }
+  else
+    m_parallel_scan_pending= parallel_scan_possible();
   DBUG_RETURN(error);
 }
 
@@ -5331,6 +5383,7 @@ int ha_partition::index_end()
   uint i;
   DBUG_ENTER("ha_partition::index_end");
 
+  end_parallel_scan();
   active_index= MAX_KEY;
   m_part_spec.start_part= NO_CURRENT_PART_ID;
   m_sec_sort_by_rowid= false;
@@ -5427,8 +5480,10 @@ int ha_partition::common_index_read(uchar *buf, bool have_start_key)
   int error;
   uint UNINIT_VAR(key_len); /* used if have_start_key==TRUE */
   bool reverse_order= FALSE;
+  const bool parallel= m_parallel_scan_pending;
   DBUG_ENTER("ha_partition::common_index_read");
 
+  end_parallel_scan();
   DBUG_PRINT("info", ("m_ordered %u m_ordered_scan_ong %u",
                       m_ordered, m_ordered_scan_ongoing));
 
@@ -5456,6 +5511,8 @@ int ha_partition::common_index_read(uchar *buf, bool have_start_key)
   }
   DBUG_PRINT("info", ("m_ordered %u m_o_scan_ong %u have_start_key %u",
                       m_ordered, m_ordered_scan_ongoing, have_start_key));
+  if (parallel)
+    (void) start_parallel_scan(true);
   if (!m_ordered_scan_ongoing)
    {
     /*
@@ -5466,7 +5523,10 @@ int ha_partition::common_index_read(uchar *buf, bool have_start_key)
       The unordered index scan will use the partition set created.
     */
     DBUG_PRINT("info", ("doing unordered scan"));
-    error= handle_unordered_scan_next_partition(buf);
+    if (m_parallel_scan)
+      error= handle_parallel_unordered_next(buf);
+    else
+      error= handle_unordered_scan_next_partition(buf);
   }
   else
   {
@@ -5566,12 +5626,20 @@ int ha_partition::index_last(uchar * buf)
 int ha_partition::common_first_last(uchar *buf)
 {
   int error;
+  const bool parallel= m_parallel_scan_pending;
 
+  end_parallel_scan();
   if ((error= partition_scan_set_up(buf, FALSE)))
     return error;
+  if (parallel)
+    (void) start_parallel_scan(true);
   if (!m_ordered_scan_ongoing &&
       m_index_scan_type != partition_index_last)
+  {
+    if (m_parallel_scan)
+      return handle_parallel_unordered_next(buf);
     return handle_unordered_scan_next_partition(buf);
+  }
   return handle_ordered_index_scan(buf, FALSE);
 }
 
@@ -6017,6 +6085,8 @@ int ha_partition::handle_unordered_next(uchar *buf, bool is_next_same)
   int error;
   DBUG_ENTER("ha_partition::handle_unordered_next");
 
+  if (m_parallel_scan)
+    DBUG_RETURN(handle_parallel_unordered_next(buf));
   if (m_part_spec.start_part >= m_tot_parts)
   {
     /* Should never happen! */
@@ -6225,52 +6295,57 @@ int ha_partition::handle_ordered_index_scan(uchar *buf, bool reverse_order)
     int error;
     handler *file= m_file[i];
 
-    switch (m_index_scan_type) {
-    case partition_index_read:
-      error= file->ha_index_read_map(rec_buf_ptr,
-                                     m_start_key.key,
-                                     m_start_key.keypart_map,
-                                     m_start_key.flag);
-      break;
-    case partition_index_first:
-      error= file->ha_index_first(rec_buf_ptr);
-      reverse_order= FALSE;
-      break;
-    case partition_index_last:
-      error= file->ha_index_last(rec_buf_ptr);
-      reverse_order= TRUE;
-      break;
-    case partition_index_read_last:
-      error= file->ha_index_read_last_map(rec_buf_ptr,
-                                          m_start_key.key,
-                                          m_start_key.keypart_map);
-      reverse_order= TRUE;
-      break;
-    case partition_read_range:
+    if (m_parallel_scan)
     {
-      /* 
-        This can only read record to table->record[0], as it was set when
-        the table was being opened. We have to memcpy data ourselves.
-      */
-      error= file->read_range_first(m_start_key.key? &m_start_key: NULL,
-                                    end_range, eq_range, TRUE);
-      memcpy(rec_buf_ptr, table->record[0], m_rec_length);
-      reverse_order= FALSE;
-      break;
+      /* The workers read the partitions as the switch below would */
+      error= parallel_scan_next(i, rec_buf_ptr);
+      reverse_order= m_parallel_scan->is_reverse();
     }
-    default:
-      DBUG_ASSERT(FALSE);
-      DBUG_RETURN(HA_ERR_END_OF_FILE);
+    else
+    {
+      switch (m_index_scan_type) {
+      case partition_index_read:
+        error= file->ha_index_read_map(rec_buf_ptr,
+                                       m_start_key.key,
+                                       m_start_key.keypart_map,
+                                       m_start_key.flag);
+        break;
+      case partition_index_first:
+        error= file->ha_index_first(rec_buf_ptr);
+        reverse_order= FALSE;
+        break;
+      case partition_index_last:
+        error= file->ha_index_last(rec_buf_ptr);
+        reverse_order= TRUE;
+        break;
+      case partition_index_read_last:
+        error= file->ha_index_read_last_map(rec_buf_ptr,
+                                            m_start_key.key,
+                                            m_start_key.keypart_map);
+        reverse_order= TRUE;
+        break;
+      case partition_read_range:
+      {
+        /* 
+          This can only read record to table->record[0], as it was set when
+          the table was being opened. We have to memcpy data ourselves.
+        */
+        error= file->read_range_first(m_start_key.key? &m_start_key: NULL,
+                                      end_range, eq_range, TRUE);
+        memcpy(rec_buf_ptr, table->record[0], m_rec_length);
+        reverse_order= FALSE;
+        break;
+      }
+      default:
+        DBUG_ASSERT(FALSE);
+        DBUG_RETURN(HA_ERR_END_OF_FILE);
+      }
     }
     if (!error)
     {
       found= TRUE;
       if (m_sec_sort_by_rowid)
-      {
-        file->position(rec_buf_ptr);
-        memcpy(part_rec_buf_ptr + PARTITION_BYTES_IN_POS,
-               file->ref, file->ref_length);
-      }
+        store_sort_rowid(i, part_rec_buf_ptr);
       /*
         Initialize queue without order first, simply insert
       */
@@ -6338,6 +6413,32 @@ void ha_partition::return_top_record(uchar *buf)
 }
 
 
+/**
+  Store the ref of the row just read from a partition in its entry of the
+  priority queue, for sorting on rowid.
+
+  @param part_id   Partition the row was read from
+  @param part_buf  Entry of the partition in m_ordered_rec_buffer
+*/
+
+void ha_partition::store_sort_rowid(uint part_id, uchar *part_buf)
+{
+  handler *file= m_file[part_id];
+  if (m_parallel_scan)
+  {
+    /* The worker stored the position when it read the row */
+    memcpy(part_buf + PARTITION_BYTES_IN_POS,
+           m_parallel_scan->ref(part_id) + PARTITION_BYTES_IN_POS,
+           file->ref_length);
+  }
+  else
+  {
+    file->position(part_buf + m_rec_offset);
+    memcpy(part_buf + PARTITION_BYTES_IN_POS, file->ref, file->ref_length);
+  }
+}
+
+
 /**
   Add index_next/prev from partitions without exact match.
 
@@ -6369,18 +6470,16 @@ int ha_partition::handle_ordered_index_scan_key_not_found()
         in index_read_map.
       */
       curr_rec_buf= part_buf + m_rec_offset;
-      error= m_file[i]->ha_index_next(curr_rec_buf);
+      if (m_parallel_scan)
+        error= parallel_scan_next(i, curr_rec_buf);
+      else
+        error= m_file[i]->ha_index_next(curr_rec_buf);
       /* HA_ERR_KEY_NOT_FOUND is not allowed from index_next! */
       DBUG_ASSERT(error != HA_ERR_KEY_NOT_FOUND);
       if (!error)
       {
         if (m_sec_sort_by_rowid)
-        {
-          m_file[i]->position(curr_rec_buf);
-          memcpy(part_buf + PARTITION_BYTES_IN_POS,
-                 m_file[i]->ref,
-                 m_file[i]->ref_length);
-        }
+          store_sort_rowid(i, part_buf);
         queue_insert(&m_queue, part_buf);
       }
       else if (error != HA_ERR_END_OF_FILE && error != HA_ERR_KEY_NOT_FOUND)
@@ -6456,7 +6555,19 @@ int ha_partition::handle_ordered_next(uchar *buf, bool is_next_same)
 
   file= m_file[part_id];
 
-  if (m_index_scan_type == partition_read_range)
+  if (m_parallel_scan)
+  {
+    /*
+      The worker read ahead with index_next(), so the rows past the key
+      end the partition as index_next_same() would have.
+    */
+    error= parallel_scan_next(part_id, rec_buf);
+    if (!error && is_next_same &&
+        m_index_scan_type != partition_read_range &&
+        !parallel_row_has_start_key(rec_buf))
+      error= HA_ERR_END_OF_FILE;
+  }
+  else if (m_index_scan_type == partition_read_range)
   {
     error= file->read_range_next();
     memcpy(rec_buf, table->record[0], m_rec_length);
@@ -6484,11 +6595,7 @@ int ha_partition::handle_ordered_next(uchar *buf, bool is_next_same)
     DBUG_RETURN(error);
   }
   if (m_sec_sort_by_rowid)
-  {
-    file->position(rec_buf);
-    memcpy(rec_buf - m_rec_offset + PARTITION_BYTES_IN_POS,
-           file->ref, file->ref_length);
-  }
+    store_sort_rowid(part_id, rec_buf - m_rec_offset);
   queue_replaced(&m_queue);
   return_top_record(buf);
   DBUG_PRINT("info", ("Record returned from partition %u", m_top_entry));
@@ -6517,7 +6624,11 @@ int ha_partition::handle_ordered_prev(uchar *buf)
   handler *file= m_file[part_id];
   DBUG_ENTER("ha_partition::handle_ordered_prev");
 
-  if ((error= file->ha_index_prev(rec_buf)))
+  if (m_parallel_scan)
+    error= parallel_scan_next(part_id, rec_buf);
+  else
+    error= file->ha_index_prev(rec_buf);
+  if (error)
   {
     if (error == HA_ERR_END_OF_FILE)
     {
@@ -6534,11 +6645,7 @@ int ha_partition::handle_ordered_prev(uchar *buf)
     DBUG_RETURN(error);
   }
   if (m_sec_sort_by_rowid)
-  {
-    file->position(rec_buf);
-    memcpy(rec_buf - m_rec_offset + PARTITION_BYTES_IN_POS,
-           file->ref, file->ref_length);
-  }
+    store_sort_rowid(part_id, rec_buf - m_rec_offset);
   queue_replaced(&m_queue);
   return_top_record(buf);
   DBUG_PRINT("info", ("Record returned from partition %d", m_top_entry));
@@ -7490,7 +7597,9 @@ void ha_partition::prepare_extra_cache(uint cachesize)
 
   m_extra_cache= TRUE;
   m_extra_cache_size= cachesize;
-  if (m_part_spec.start_part != NO_CURRENT_PART_ID)
+  /* A parallel scan sets up the cache of each partition it scans */
+  if (m_part_spec.start_part != NO_CURRENT_PART_ID && !m_parallel_scan &&
+      !m_parallel_scan_pending)
   {
     DBUG_ASSERT(bitmap_is_set(&m_partitions_to_reset,
                               m_part_spec.start_part));
@@ -7631,6 +7740,1029 @@ void ha_partition::late_extra_no_cache(uint partition_id)
 }
 
 
+/****************************************************************************
+                MODULE parallel scan
+****************************************************************************/
+
+/**
+  Copy table with its own record buffers, fields, keys and column bitmaps.
+
+  A worker of a parallel scan opens the clones of the partitions on the
+  copy, so that the storage engines read and compare the rows of the
+  worker without touching the session's buffers and fields.
+*/
+
+static TABLE *copy_table_for_worker(MEM_ROOT *mem_root, TABLE *table)
+{
+  TABLE_SHARE *const share= table->s;
+  const size_t keys_length= share->keys * sizeof(KEY) +
+                            share->key_parts * sizeof(KEY_PART_INFO);
+  const uint bitmap_size= bitmap_buffer_size(share->fields);
+  TABLE *copy= (TABLE*) memdup_root(mem_root, table, sizeof(TABLE));
+  uchar *record= (uchar*) alloc_root(mem_root, share->rec_buff_length * 2);
+  Field **fields= (Field**) alloc_root(mem_root,
+                                       sizeof(Field*) * (share->fields + 1));
+  uchar *bitmaps= (uchar*) alloc_root(mem_root, bitmap_size * 2);
+  KEY *keys= NULL;
+  if (!copy || !record || !fields || !bitmaps ||
+      (share->key_parts &&
+       !(keys= (KEY*) memdup_root(mem_root, table->key_info, keys_length))))
+    return NULL;
+
+  const my_ptrdiff_t diff= record - table->record[0];
+  memcpy(record, share->default_values, share->rec_buff_length);
+  memcpy(record + share->rec_buff_length, share->default_values,
+         share->rec_buff_length);
+  copy->record[0]= record;
+  copy->record[1]= record + share->rec_buff_length;
+  copy->null_flags= table->null_flags + diff;
+  copy->field= fields;
+  for (uint i= 0; i < share->fields; i++)
+  {
+    if (!(fields[i]= table->field[i]->clone(mem_root)))
+      return NULL;
+    fields[i]->move_field_offset(diff);
+    fields[i]->table= fields[i]->orig_table= copy;
+  }
+  fields[share->fields]= NULL;
+  copy->next_number_field= copy->found_next_number_field= NULL;
+
+  if (keys)
+  {
+    const KEY_PART_INFO *parts=
+      reinterpret_cast<KEY_PART_INFO*>(table->key_info + share->keys);
+    KEY_PART_INFO *copy_parts=
+      reinterpret_cast<KEY_PART_INFO*>(keys + share->keys);
+    for (uint i= 0; i < share->keys; i++)
+    {
+      KEY *key= keys + i;
+      key->table= copy;
+      key->key_part= copy_parts + (table->key_info[i].key_part - parts);
+      for (uint j= 0; j < key->actual_key_parts; j++)
+      {
+        KEY_PART_INFO *key_part= key->key_part + j;
+        Field *field= table->key_info[i].key_part[j].field;
+        if (field == table->field[key_part->fieldnr - 1])
+          key_part->field= fields[key_part->fieldnr - 1];
+        else
+        {
+          /* The key part is a prefix of the column */
+          if (!(key_part->field= field->clone(mem_root)))
+            return NULL;
+          key_part->field->move_field_offset(diff);
+          key_part->field->table= key_part->field->orig_table= copy;
+        }
+      }
+    }
+    copy->key_info= keys;
+  }
+
+  bitmap_init(&copy->def_read_set, (my_bitmap_map*) bitmaps, share->fields,
+              FALSE);
+  bitmap_init(&copy->def_write_set, (my_bitmap_map*) (bitmaps + bitmap_size),
+              share->fields, FALSE);
+  bitmap_copy(&copy->def_read_set, table->read_set);
+  bitmap_copy(&copy->def_write_set, table->write_set);
+  copy->read_set= &copy->def_read_set;
+  copy->write_set= &copy->def_write_set;
+
+  /* Memory the storage engines allocate when they open a clone */
+  init_sql_alloc(&copy->mem_root, TABLE_ALLOC_BLOCK_SIZE, 0);
+  copy->in_use= NULL;
+  copy->file= NULL;
+  return copy;
+}
+
+
+/**
+  Reads the partitions of a table or index scan on worker threads.
+
+  Each worker runs in its own THD, set up by init_worker_thd(), and reads
+  whole partitions, taken in turn from the partitions to scan. For each
+  partition it opens a clone of the partition's handler with clone(), on
+  a copy of the TABLE which belongs to the worker, locks it in its own
+  transaction, and scans it the way the session would have. This gives
+  InnoDB and MyRocks consistent reads of their own, and gives MyISAM the
+  state of the session's handler.
+
+  Each row is stored in a block together with its ref in the format of
+  ha_partition::position(), which the worker computes on its clone. Every
+  worker has two blocks, and waits for the session to return one of them
+  when both are full.
+
+  Unordered scans return the rows of the blocks in the order they are
+  filled. Ordered index scans keep the blocks of each partition apart,
+  and the session feeds the rows of each partition to the priority queue
+  of the ordered index scan instead of reading them from m_file. Ordered
+  scans need one worker for each partition, because the merge needs the
+  next row of every partition.
+*/
+
+class Parallel_part_scan
+{
+public:
+  /// How the workers read each partition
+  enum Scan_type
+  {
+    RND_SCAN,                  ///< rnd_next()
+    INDEX_FIRST,               ///< index_first(), then index_next()
+    INDEX_LAST,                ///< index_last(), then index_prev()
+    INDEX_READ,                ///< index_read_map(), then index_next()
+    INDEX_READ_REVERSE,        ///< index_read_map(), then index_prev()
+    INDEX_READ_LAST,           ///< index_read_last_map(), then index_prev()
+    READ_RANGE                 ///< read_range_first(), read_range_next()
+  };
+
+  Parallel_part_scan(THD *thd, TABLE *table, handler **files,
+                     uint ref_length, Scan_type type, bool ordered);
+  ~Parallel_part_scan();
+
+  /**
+    Add a partition to scan.
+
+    @param part  Partition id
+    @param name  Name to open the partition's clone by
+  */
+  bool add_partition(uint part, const char *name);
+
+  /// Let rnd scans use a read cache of cache_size bytes in each partition
+  void set_cache(uint cache_size)
+  {
+    m_extra_cache= true;
+    m_extra_cache_size= cache_size;
+  }
+
+  /**
+    Set the index and keys of an index scan. The keys are copied.
+
+    @return true on out of memory
+  */
+  bool set_index(uint index, bool sorted, const key_range *start_key,
+                 const key_range *end_key, bool eq_range);
+
+  /**
+    Start the workers.
+
+    @return false if the workers could not be started
+  */
+  bool start(uint threads);
+
+  /**
+    Read the next row of an unordered scan into buf.
+
+    @param      buf      Row buffer
+    @param[out] part_id  Partition of the row, or of the failed read
+
+    @return 0, HA_ERR_END_OF_FILE or the error of a worker
+  */
+  int next(uchar *buf, uint *part_id);
+
+  /**
+    Read the next row of partition part of an ordered scan into buf.
+
+    @return 0, HA_ERR_END_OF_FILE, HA_ERR_KEY_NOT_FOUND when the first
+            read of an index_read_map() found no row with the key, or the
+            error of a worker
+  */
+  int next_in_partition(uint part, uchar *buf);
+
+  /// ha_partition::position() of the row last returned from partition part
+  const uchar *ref(uint part) const
+  {
+    DBUG_ASSERT(m_streams[m_stream_of[part]].ref);
+    return m_streams[m_stream_of[part]].ref;
+  }
+
+  bool is_ordered() const { return m_ordered; }
+  bool is_reverse() const
+  {
+    return m_type == INDEX_LAST || m_type == INDEX_READ_REVERSE ||
+           m_type == INDEX_READ_LAST;
+  }
+
+private:
+  struct Block
+  {
+    uchar *entries;
+    uint count;
+    uint worker;                       ///< The worker the block belongs to
+  };
+
+  /// The rows of one partition
+  struct Stream
+  {
+    Stream(uint part_arg, const char *name_arg)
+      : part(part_arg), name(name_arg), key_not_found(false), ended(false),
+        error(HA_ERR_END_OF_FILE), current(NULL), pos(0), ref(NULL),
+        key_not_found_returned(false)
+    {}
+
+    uint part;
+    const char *name;
+    std::deque<Block*> full_blocks;    ///< Of ordered scans only
+    bool key_not_found;                ///< The first read found no key
+    bool ended;                        ///< The worker is done with it
+    int error;                         ///< The last read, once ended
+
+    /* Used by the session only */
+    Block *current;
+    uint pos;
+    const uchar *ref;
+    bool key_not_found_returned;
+  };
+
+  struct Worker
+  {
+    Parallel_part_scan *scan;
+    uint number;
+    TABLE *table;                      ///< Copy the clones are opened on
+    std::vector<Block*> free_blocks;
+    STATUS_VAR status;                 ///< Status of the worker's THD
+  };
+
+  static void *worker_thread(void *arg);
+  int scan_partition(THD *thd, Worker *worker, Block **block, Stream *stream);
+  int read_first(handler *file, uchar *buf);
+  int read_next(handler *file, uchar *buf);
+  bool store_row(Worker *worker, Block **block, Stream *stream,
+                 handler *file);
+  void return_block(Block *block);
+  void fail(int error, uint part);
+
+  THD *const m_thd;
+  TABLE *const m_table;
+  handler **const m_files;
+  const uint m_record_length;
+  const uint m_ref_length;
+  const uint m_entry_length;           ///< Row followed by its ref
+  const Scan_type m_type;
+  const bool m_ordered;
+  bool m_extra_cache;
+  uint m_extra_cache_size;
+  uint m_block_rows;
+  MEM_ROOT m_mem_root;
+
+  /* Index scans */
+  uint m_index;
+  bool m_sorted;
+  key_range m_start_key;
+  key_range m_end_key;
+  bool m_have_start_key;
+  bool m_have_end_key;
+  bool m_eq_range;
+
+  std::vector<Stream> m_streams;
+  std::vector<uint> m_stream_of;       ///< Index in m_streams by partition
+  std::vector<Worker> m_workers;
+  std::vector<pthread_t> m_threads;
+  enum_tx_isolation m_tx_isolation;
+
+  std::mutex m_mutex;
+  std::condition_variable m_filled;    ///< A block was filled or a worker ended
+  std::condition_variable m_emptied;   ///< A block was returned to its worker
+  std::deque<Block*> m_full_blocks;    ///< Of unordered scans
+  std::atomic<uint> m_next_stream;     ///< Index in m_streams of the next scan
+  uint m_running;
+  std::atomic<bool> m_aborted;
+  int m_error;
+  uint m_error_part;
+
+  /* Used by the session only */
+  Block *m_current;
+  uint m_current_pos;
+};
+
+
+Parallel_part_scan::Parallel_part_scan(THD *thd, TABLE *table,
+                                       handler **files, uint ref_length,
+                                       Scan_type type, bool ordered)
+  : m_thd(thd), m_table(table), m_files(files),
+    m_record_length(table->s->reclength), m_ref_length(ref_length),
+    m_entry_length(table->s->reclength + ref_length),
+    m_type(type), m_ordered(ordered), m_extra_cache(false),
+    m_extra_cache_size(0), m_block_rows(0), m_index(MAX_KEY),
+    m_sorted(false), m_have_start_key(false), m_have_end_key(false),
+    m_eq_range(false), m_tx_isolation(thd->tx_isolation), m_next_stream(0),
+    m_running(0), m_aborted(false), m_error(0), m_error_part(0),
+    m_current(NULL), m_current_pos(0)
+{
+  init_sql_alloc(&m_mem_root, 8192, 0);
+}
+
+
+Parallel_part_scan::~Parallel_part_scan()
+{
+  m_aborted= true;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_emptied.notify_all();
+  }
+  for (size_t i= 0; i < m_threads.size(); i++)
+  {
+    pthread_join(m_threads[i], NULL);
+    add_to_status(&m_thd->status_var, &m_workers[i].status);
+  }
+  for (size_t i= 0; i < m_workers.size(); i++)
+  {
+    if (m_workers[i].table)
+      free_root(&m_workers[i].table->mem_root, MYF(0));
+  }
+  free_root(&m_mem_root, MYF(0));
+}
+
+
+bool Parallel_part_scan::add_partition(uint part, const char *name)
+{
+  const char *name_copy= strdup_root(&m_mem_root, name);
+  if (!name_copy)
+    return true;
+  if (m_stream_of.size() <= part)
+    m_stream_of.resize(part + 1);
+  m_stream_of[part]= m_streams.size();
+  m_streams.push_back(Stream(part, name_copy));
+  return false;
+}
+
+
+bool Parallel_part_scan::set_index(uint index, bool sorted,
+                                   const key_range *start_key,
+                                   const key_range *end_key, bool eq_range)
+{
+  m_index= index;
+  m_sorted= sorted;
+  m_eq_range= eq_range;
+  if ((m_have_start_key= start_key && start_key->key))
+  {
+    m_start_key= *start_key;
+    if (!(m_start_key.key= (uchar*) memdup_root(&m_mem_root, start_key->key,
+                                                start_key->length)))
+      return true;
+  }
+  if ((m_have_end_key= end_key && end_key->key))
+  {
+    m_end_key= *end_key;
+    if (!(m_end_key.key= (uchar*) memdup_root(&m_mem_root, end_key->key,
+                                              end_key->length)))
+      return true;
+  }
+  return false;
+}
+
+
+bool Parallel_part_scan::start(uint threads)
+{
+  DBUG_ENTER("Parallel_part_scan::start");
+  DBUG_ASSERT(!m_ordered || threads == m_streams.size());
+
+  /* Blocks of about 64KB, two per worker */
+  m_block_rows= max(1U, (64 * 1024) / m_entry_length);
+  m_workers.resize(threads);
+  for (uint w= 0; w < threads; w++)
+  {
+    Worker *const worker= &m_workers[w];
+    worker->scan= this;
+    worker->number= w;
+    worker->table= NULL;
+    if (!(worker->table= copy_table_for_worker(&m_mem_root, m_table)))
+      DBUG_RETURN(false);
+    for (uint b= 0; b < 2; b++)
+    {
+      Block *block= (Block*) alloc_root(&m_mem_root, sizeof(Block));
+      if (!block ||
+          !(block->entries= (uchar*) alloc_root(&m_mem_root,
+                                                (size_t) m_block_rows *
+                                                m_entry_length)))
+        DBUG_RETURN(false);
+      block->count= 0;
+      block->worker= w;
+      worker->free_blocks.push_back(block);
+    }
+  }
+
+  for (uint w= 0; w < threads; w++)
+  {
+    pthread_t thread;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running++;
+    }
+    if (mysql_thread_create(key_thread_partition_scan, &thread, NULL,
+                            worker_thread, &m_workers[w]))
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running--;
+      break;
+    }
+    m_threads.push_back(thread);
+  }
+  /* The ordered merge needs a worker for every partition */
+  DBUG_RETURN(m_ordered ? m_threads.size() == threads : !m_threads.empty());
+}
+
+
+void *Parallel_part_scan::worker_thread(void *arg)
+{
+  Worker *const worker= static_cast<Worker*>(arg);
+  Parallel_part_scan *const scan= worker->scan;
+  Block *block= NULL;
+  THD *thd;
+
+  my_thread_init();
+  thd= new THD;
+  thd->thread_stack= (char*) &thd;
+  thd->store_globals();
+  init_worker_thd(thd, scan->m_thd);
+  lex_start(thd);
+  thd->lex->sql_command= SQLCOM_SELECT;
+  worker->table->in_use= thd;
+
+  for (;;)
+  {
+    const uint ix= scan->m_next_stream++;
+    int error;
+    if (ix >= scan->m_streams.size() || scan->m_aborted)
+      break;
+    Stream *const stream= &scan->m_streams[ix];
+    if ((error= scan->scan_partition(thd, worker, &block, stream)))
+    {
+      scan->fail(error, stream->part);
+      break;
+    }
+  }
+
+  worker->status= thd->status_var;
+  thd->set_status_var_init();
+  {
+    std::lock_guard<std::mutex> lock(scan->m_mutex);
+    if (block)
+    {
+      if (block->count && !scan->m_aborted)
+        scan->m_full_blocks.push_back(block);
+      else
+      {
+        block->count= 0;
+        worker->free_blocks.push_back(block);
+      }
+    }
+    scan->m_running--;
+    scan->m_filled.notify_one();
+  }
+
+  worker->table->in_use= NULL;
+  thd->release_resources();
+  delete thd;
+  my_thread_end();
+  return NULL;
+}
+
+
+/**
+  Read a partition into blocks, through a clone of its handler which is
+  locked in the worker's own transaction.
+
+  @param         thd     Session of the worker
+  @param         worker  The worker
+  @param[in,out] block   Block being filled, or NULL
+  @param         stream  Partition to read
+
+  @return 0 or the error of the partition's handler
+*/
+
+int Parallel_part_scan::scan_partition(THD *thd, Worker *worker,
+                                       Block **block, Stream *stream)
+{
+  TABLE *const table= worker->table;
+  uchar *const record= table->record[0];
+  handler *file;
+  int error;
+
+  thd->tx_isolation= m_tx_isolation;
+  if (!(file= m_files[stream->part]->clone(stream->name, thd->mem_root,
+                                            table)))
+    return HA_ERR_INITIALIZATION;
+  table->file= file;
+
+  if (!(error= file->ha_external_lock(thd, F_RDLCK)))
+  {
+    if (table->key_read)
+      (void) file->extra(HA_EXTRA_KEYREAD);
+    if (m_type == RND_SCAN)
+    {
+      if (!(error= file->ha_rnd_init(true)) && m_extra_cache)
+        (void) file->extra_opt(HA_EXTRA_CACHE, m_extra_cache_size);
+    }
+    else
+      error= file->ha_index_init(m_index, m_sorted);
+
+    if (!error)
+    {
+      error= read_first(file, record);
+      if (error == HA_ERR_KEY_NOT_FOUND && m_type == INDEX_READ)
+      {
+        /* index_next() goes on from the key, as in the session */
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          stream->key_not_found= true;
+          m_filled.notify_one();
+        }
+        error= read_next(file, record);
+      }
+      for (;;)
+      {
+        if (!error)
+        {
+          if (store_row(worker, block, stream, file))
+            break;                              // Aborted
+        }
+        else if (error != HA_ERR_RECORD_DELETED)
+          break;
+        error= read_next(file, record);
+      }
+
+      if (m_type == RND_SCAN)
+      {
+        if (m_extra_cache)
+          (void) file->extra(HA_EXTRA_NO_CACHE);
+        (void) file->ha_rnd_end();
+      }
+      else
+        (void) file->ha_index_end();
+    }
+    if (error == HA_ERR_END_OF_FILE || error == HA_ERR_KEY_NOT_FOUND)
+    {
+      (void) file->ha_external_lock(thd, F_UNLCK);
+      if (trans_commit_stmt(thd))
+        error= HA_ERR_INTERNAL_ERROR;
+    }
+    else
+    {
+      (void) file->ha_external_lock(thd, F_UNLCK);
+      trans_rollback_stmt(thd);
+    }
+  }
+  file->ha_close();
+  delete file;
+  table->file= NULL;
+
+  if (error && error != HA_ERR_END_OF_FILE && error != HA_ERR_KEY_NOT_FOUND)
+    return error;
+  if (m_ordered)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (*block && (*block)->count)
+    {
+      stream->full_blocks.push_back(*block);
+      *block= NULL;
+    }
+    stream->ended= true;
+    stream->error= error ? error : HA_ERR_END_OF_FILE;
+    m_filled.notify_one();
+  }
+  return 0;
+}
+
+
+int Parallel_part_scan::read_first(handler *file, uchar *buf)
+{
+  switch (m_type) {
+  case RND_SCAN:
+    return file->ha_rnd_next(buf);
+  case INDEX_FIRST:
+    return file->ha_index_first(buf);
+  case INDEX_LAST:
+    return file->ha_index_last(buf);
+  case INDEX_READ:
+  case INDEX_READ_REVERSE:
+    return file->ha_index_read_map(buf, m_start_key.key,
+                                   m_start_key.keypart_map,
+                                   m_start_key.flag);
+  case INDEX_READ_LAST:
+    return file->ha_index_read_last_map(buf, m_start_key.key,
+                                        m_start_key.keypart_map);
+  case READ_RANGE:
+    /* This reads into record[0] of the worker's table, which buf is */
+    return file->read_range_first(m_have_start_key ? &m_start_key : NULL,
+                                  m_have_end_key ? &m_end_key : NULL,
+                                  m_eq_range, m_ordered);
+  }
+  DBUG_ASSERT(FALSE);
+  return HA_ERR_WRONG_COMMAND;
+}
+
+
+int Parallel_part_scan::read_next(handler *file, uchar *buf)
+{
+  switch (m_type) {
+  case RND_SCAN:
+    return file->ha_rnd_next(buf);
+  case INDEX_FIRST:
+  case INDEX_READ:
+    return file->ha_index_next(buf);
+  case INDEX_LAST:
+  case INDEX_READ_REVERSE:
+  case INDEX_READ_LAST:
+    return file->ha_index_prev(buf);
+  case READ_RANGE:
+    return file->read_range_next();
+  }
+  DBUG_ASSERT(FALSE);
+  return HA_ERR_WRONG_COMMAND;
+}
+
+
+/**
+  Store the row in record[0] of the worker's table, and its ref, in the
+  worker's block.
+
+  @return true if the scan was aborted
+*/
+
+bool Parallel_part_scan::store_row(Worker *worker, Block **block,
+                                   Stream *stream, handler *file)
+{
+  if (!*block)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (worker->free_blocks.empty() && !m_aborted)
+      m_emptied.wait(lock);
+    if (m_aborted)
+      return true;
+    *block= worker->free_blocks.back();
+    worker->free_blocks.pop_back();
+  }
+
+  uchar *entry= (*block)->entries + (size_t) (*block)->count * m_entry_length;
+  uchar *ref= entry + m_record_length;
+  memcpy(entry, worker->table->record[0], m_record_length);
+  file->position(worker->table->record[0]);
+  int2store(ref, stream->part);
+  memcpy(ref + PARTITION_BYTES_IN_POS, file->ref, file->ref_length);
+  memset(ref + PARTITION_BYTES_IN_POS + file->ref_length, 0,
+         m_ref_length - PARTITION_BYTES_IN_POS - file->ref_length);
+
+  if (++(*block)->count == m_block_rows)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_ordered)
+      stream->full_blocks.push_back(*block);
+    else
+      m_full_blocks.push_back(*block);
+    m_filled.notify_one();
+    *block= NULL;
+  }
+  return m_aborted;
+}
+
+
+/// Give a block the session has read back to its worker
+void Parallel_part_scan::return_block(Block *block)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  block->count= 0;
+  m_workers[block->worker].free_blocks.push_back(block);
+  m_emptied.notify_all();
+}
+
+
+void Parallel_part_scan::fail(int error, uint part)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_error)
+  {
+    m_error= error;
+    m_error_part= part;
+  }
+  m_aborted= true;
+  m_emptied.notify_all();
+  m_filled.notify_one();
+}
+
+
+int Parallel_part_scan::next(uchar *buf, uint *part_id)
+{
+  DBUG_ASSERT(!m_ordered);
+  if (m_current && m_current_pos == m_current->count)
+  {
+    return_block(m_current);
+    m_current= NULL;
+  }
+  if (!m_current)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_full_blocks.empty() && m_running && !m_error)
+      m_filled.wait(lock);
+    if (m_error)
+    {
+      *part_id= m_error_part;
+      return m_error;
+    }
+    if (m_full_blocks.empty())
+      return HA_ERR_END_OF_FILE;
+    m_current= m_full_blocks.front();
+    m_full_blocks.pop_front();
+    m_current_pos= 0;
+  }
+
+  const uchar *entry= m_current->entries +
+    (size_t) m_current_pos++ * m_entry_length;
+  const uchar *ref= entry + m_record_length;
+  memcpy(buf, entry, m_record_length);
+  *part_id= uint2korr(ref);
+  m_streams[m_stream_of[*part_id]].ref= ref;
+  return 0;
+}
+
+
+int Parallel_part_scan::next_in_partition(uint part, uchar *buf)
+{
+  Stream *const stream= &m_streams[m_stream_of[part]];
+  DBUG_ASSERT(m_ordered);
+
+  if (stream->current && stream->pos == stream->current->count)
+  {
+    return_block(stream->current);
+    stream->current= NULL;
+  }
+  if (!stream->current)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (stream->full_blocks.empty() && !stream->ended && m_running &&
+           !m_error &&
+           (!stream->key_not_found || stream->key_not_found_returned))
+      m_filled.wait(lock);
+    if (m_error)
+      return m_error;
+    if (stream->key_not_found && !stream->key_not_found_returned)
+    {
+      stream->key_not_found_returned= true;
+      return HA_ERR_KEY_NOT_FOUND;
+    }
+    if (stream->full_blocks.empty())
+      return stream->ended ? stream->error : HA_ERR_END_OF_FILE;
+    stream->current= stream->full_blocks.front();
+    stream->full_blocks.pop_front();
+    stream->pos= 0;
+  }
+
+  const uchar *entry= stream->current->entries +
+    (size_t) stream->pos++ * m_entry_length;
+  memcpy(buf, entry, m_record_length);
+  stream->ref= entry + m_record_length;
+  return 0;
+}
+
+
+/**
+  Make the name a clone of the handler of a partition is opened by.
+
+  @param[out] out        Buffer of FN_REFLEN bytes for the name
+  @param      path       Path of the table
+  @param      part_info  Partitioning of the table
+  @param      part_id    Partition, or subpartition, id
+*/
+
+static void create_partition_file_name(char *out, const char *path,
+                                       partition_info *part_info,
+                                       uint part_id)
+{
+  List_iterator<partition_element> part_it(part_info->partitions);
+  partition_element *part_elem;
+
+  if (part_info->is_sub_partitioned())
+  {
+    const uint num_subparts= part_info->num_subparts;
+    partition_element *sub_elem;
+    for (uint i= 0; i <= part_id / num_subparts; i++)
+      part_elem= part_it++;
+    List_iterator<partition_element> sub_it(part_elem->subpartitions);
+    for (uint j= 0; j <= part_id % num_subparts; j++)
+      sub_elem= sub_it++;
+    create_subpartition_name(out, path, part_elem->partition_name,
+                             sub_elem->partition_name, NORMAL_PART_NAME);
+  }
+  else
+  {
+    for (uint i= 0; i <= part_id; i++)
+      part_elem= part_it++;
+    create_partition_name(out, path, part_elem->partition_name,
+                          NORMAL_PART_NAME, true);
+  }
+}
+
+
+/**
+  Check whether the table or index scan being initialized can read the
+  partitions on worker threads.
+*/
+
+bool ha_partition::parallel_scan_possible()
+{
+  THD *thd= ha_thd();
+  handler *file;
+  DBUG_ENTER("ha_partition::parallel_scan_possible");
+
+  if (!thd->variables.partition_scan_max_threads ||
+      get_lock_type() != F_RDLCK || table->reginfo.lock_type != TL_READ ||
+      m_extra_prepare_for_update || table->s->blob_fields ||
+      bitmap_bits_set(&m_part_info->read_partitions) < 2)
+    DBUG_RETURN(false);
+
+  /*
+    The workers read in transactions of their own. They share the
+    session's view of the data through an explicit snapshot. Otherwise
+    each of them reads the latest committed data, which is what a session
+    using READ COMMITTED may see for every statement anyway. The session's
+    table lock keeps tables without transactions from changing.
+  */
+  file= m_file[bitmap_get_first_set(&m_part_info->read_partitions)];
+  if (file->has_transactions())
+  {
+    const bool shared_snapshot= thd->get_explicit_snapshot() != nullptr;
+    if (shared_snapshot ? !file->ht->explicit_snapshot :
+        (thd->tx_isolation > ISO_READ_COMMITTED ||
+         thd->in_active_multi_stmt_transaction()))
+      DBUG_RETURN(false);
+  }
+  DBUG_RETURN(true);
+}
+
+
+/**
+  Start reading the partitions of the table or index scan on worker
+  threads.
+
+  @param index_scan  An index scan is starting, on the partitions set up
+                     by partition_scan_set_up()
+
+  @return false if the partitions are to be read by the session
+*/
+
+bool ha_partition::start_parallel_scan(bool index_scan)
+{
+  THD *thd= ha_thd();
+  const uint max_threads= thd->variables.partition_scan_max_threads;
+  Parallel_part_scan::Scan_type type= Parallel_part_scan::RND_SCAN;
+  Parallel_part_scan *scan;
+  std::vector<uint> parts;
+  uint first_part= 0, last_part= m_tot_parts - 1;
+  bool ordered= false;
+  char name_buff[FN_REFLEN];
+  DBUG_ENTER("ha_partition::start_parallel_scan");
+
+  if (index_scan)
+  {
+    first_part= m_part_spec.start_part;
+    last_part= m_part_spec.end_part;
+    ordered= m_ordered_scan_ongoing ||
+             m_index_scan_type == partition_index_last;
+    switch (m_index_scan_type) {
+    case partition_index_first:
+      type= Parallel_part_scan::INDEX_FIRST;
+      break;
+    case partition_index_last:
+      type= Parallel_part_scan::INDEX_LAST;
+      break;
+    case partition_index_read_last:
+      type= Parallel_part_scan::INDEX_READ_LAST;
+      break;
+    case partition_read_range:
+      type= Parallel_part_scan::READ_RANGE;
+      break;
+    case partition_index_read:
+      switch (m_start_key.flag) {
+      case HA_READ_KEY_EXACT:
+      case HA_READ_KEY_OR_NEXT:
+      case HA_READ_AFTER_KEY:
+        type= Parallel_part_scan::INDEX_READ;
+        break;
+      case HA_READ_PREFIX_LAST:
+      case HA_READ_PREFIX_LAST_OR_PREV:
+      case HA_READ_BEFORE_KEY:
+        type= Parallel_part_scan::INDEX_READ_REVERSE;
+        break;
+      default:
+        DBUG_RETURN(false);
+      }
+      break;
+    default:
+      DBUG_RETURN(false);
+    }
+    /*
+      Unordered index reads return the rows with the key of one partition
+      after the other, so that index_next_same() can stop at the first
+      row without it.
+    */
+    if (!ordered && type != Parallel_part_scan::INDEX_FIRST &&
+        type != Parallel_part_scan::READ_RANGE)
+      DBUG_RETURN(false);
+  }
+
+  for (uint i= bitmap_get_first_set(&m_part_info->read_partitions);
+       i <= last_part;
+       i= bitmap_get_next_set(&m_part_info->read_partitions, i))
+  {
+    if (i >= first_part)
+      parts.push_back(i);
+  }
+  /* The ordered merge needs the next row of every partition at once */
+  if (parts.size() < 2 || (ordered && parts.size() > max_threads))
+    DBUG_RETURN(false);
+
+  if (!(scan= new (std::nothrow)
+        Parallel_part_scan(thd, table, m_file, m_ref_length, type, ordered)))
+    DBUG_RETURN(false);
+  for (size_t i= 0; i < parts.size(); i++)
+  {
+    create_partition_file_name(name_buff, table->s->normalized_path.str,
+                               m_part_info, parts[i]);
+    if (scan->add_partition(parts[i], name_buff))
+      goto err;
+  }
+  if (index_scan)
+  {
+    /* index_first() and index_last() leave m_start_key as it was */
+    const bool have_start_key= type != Parallel_part_scan::INDEX_FIRST &&
+                               type != Parallel_part_scan::INDEX_LAST;
+    if (scan->set_index(active_index, m_ordered,
+                        have_start_key ? &m_start_key : NULL,
+                        type == Parallel_part_scan::READ_RANGE ?
+                        end_range : NULL,
+                        eq_range))
+      goto err;
+  }
+  else if (m_extra_cache)
+    scan->set_cache(m_extra_cache_size);
+  if (!scan->start(min<uint>(parts.size(), max_threads)))
+    goto err;
+
+  m_parallel_scan= scan;
+  status_var_increment(thd->status_var.partition_parallel_scan_count);
+  DBUG_RETURN(true);
+
+err:
+  delete scan;
+  DBUG_RETURN(false);
+}
+
+
+void ha_partition::end_parallel_scan()
+{
+  delete m_parallel_scan;
+  m_parallel_scan= NULL;
+  m_parallel_scan_pending= false;
+}
+
+
+/**
+  Read the next row of partition part_id of an ordered index scan from the
+  workers, as m_file[part_id] would have read it.
+*/
+
+int ha_partition::parallel_scan_next(uint part_id, uchar *buf)
+{
+  int error= m_parallel_scan->next_in_partition(part_id, buf);
+  table->status= error ? STATUS_NOT_FOUND : 0;
+  return error;
+}
+
+
+/**
+  Return the next row of an unordered scan read by the workers.
+*/
+
+int ha_partition::handle_parallel_unordered_next(uchar *buf)
+{
+  uint part_id;
+  int error= m_parallel_scan->next(buf, &part_id);
+  if (error != HA_ERR_END_OF_FILE)
+    m_last_part= part_id;
+  table->status= error ? STATUS_NOT_FOUND : 0;
+  return error;
+}
+
+
+/**
+  Check whether a row the workers read ahead of index_next_same() in
+  rec_buf still has the key of the scan, as index_next_same() of the
+  partition would have checked.
+*/
+
+bool ha_partition::parallel_row_has_start_key(uchar *rec_buf)
+{
+  uchar *save_record_0= table->record[0];
+  KEY *key_info= table->key_info + active_index;
+  bool same;
+
+  table->record[0]= rec_buf;
+  set_key_field_ptr(key_info, rec_buf, save_record_0);
+  same= !key_cmp_if_same(table, m_start_key.key, active_index,
+                         m_start_key.length);
+  set_key_field_ptr(key_info, save_record_0, rec_buf);
+  table->record[0]= save_record_0;
+  return same;
+}
+
+
 /****************************************************************************
                 MODULE optimiser support
 ****************************************************************************/
@@ -29,6 +29,8 @@ enum partition_keywords
 
 #define PARTITION_BYTES_IN_POS 2
 
+class Parallel_part_scan;
+
 
 /** Struct used for partition_name_hash */
 typedef struct st_part_name_def
@@ -265,9 +267,17 @@ private:
   bool m_key_not_found;
   /** Need to sort by ref (rowid) too. */
   bool m_sec_sort_by_rowid;
+  /**
+    Table or index scan reading the partitions on worker threads. It is
+    started by the first read after rnd_init() or index_init() found it
+    possible, so that the workers see the HA_EXTRA_CACHE request that
+    follows rnd_init(), and the partitions left by pruning the index scan.
+  */
+  Parallel_part_scan *m_parallel_scan;
+  bool m_parallel_scan_pending;
 public:
   Partition_share *get_part_share() { return part_share; }
-  handler *clone(const char *name, MEM_ROOT *mem_root);
+  handler *clone(const char *name, MEM_ROOT *mem_root, TABLE *table_arg);
   virtual void set_part_info(partition_info *part_info, bool early)
   {
      m_part_info= part_info;
@@ -676,6 +686,13 @@ private:
   void late_extra_cache(uint partition_id);
   void late_extra_no_cache(uint partition_id);
   void prepare_extra_cache(uint cachesize);
+  bool parallel_scan_possible();
+  bool start_parallel_scan(bool index_scan);
+  void end_parallel_scan();
+  int parallel_scan_next(uint part_id, uchar *buf);
+  int handle_parallel_unordered_next(uchar *buf);
+  bool parallel_row_has_start_key(uchar *rec_buf);
+  void store_sort_rowid(uint part_id, uchar *part_buf);
 public:
 
   /*
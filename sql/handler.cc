@@ -2791,9 +2791,10 @@ void ha_release_concurrency_slot(THD *thd)
 /****************************************************************************
 ** General handler functions
 ****************************************************************************/
-handler *handler::clone(const char *name, MEM_ROOT *mem_root)
+handler *handler::clone(const char *name, MEM_ROOT *mem_root,
+                        TABLE *table_arg)
 {
-  handler *new_handler= get_new_handler(table->s, mem_root, ht);
+  handler *new_handler= get_new_handler(table_arg->s, mem_root, ht);
 
   if (!new_handler)
     return NULL;
@@ -2812,7 +2813,7 @@ handler *handler::clone(const char *name, MEM_ROOT *mem_root)
     TODO: Implement a more efficient way to have more than one index open for
     the same table instance. The ha_open call is not cachable for clone.
   */
-  if (new_handler->ha_open(table, name, table->db_stat,
+  if (new_handler->ha_open(table_arg, name, table_arg->db_stat,
                            HA_OPEN_IGNORE_IF_LOCKED))
     goto err;
 
@@ -2826,10 +2827,15 @@ err:
 
 
 void handler::ha_statistic_increment(ulonglong SSV::*offset) const
+{
+  ha_statistic_add(offset, 1);
+}
+
+void handler::ha_statistic_add(ulonglong SSV::*offset, ulonglong count) const
 {
   if (table && table->in_use)
   {
-    status_var_increment(table->in_use->status_var.*offset);
+    status_var_add(table->in_use->status_var.*offset, count);
     table->in_use->check_limit_rows_examined();
     table->in_use->update_sql_stats_periodic();
     table->in_use->check_yield();
@@ -3149,6 +3155,37 @@ int handler::ha_rnd_next(uchar *buf)
 }
 
 
+/**
+  Read the next rows of a random scan into consecutive row buffers.
+
+  @param[out] buf        Buffer for max_rows rows
+  @param      row_length Distance between the rows in buf, at least
+                         table->s->reclength
+  @param      max_rows   Number of rows to read
+  @param[out] rows_read  Number of rows stored in buf
+
+  @return Status of the last read
+    @retval 0     Success, max_rows rows were read
+    @retval != 0  Error (error code returned); the rows_read rows before
+                  it are valid
+*/
+
+int handler::ha_rnd_next_batch(uchar *buf, size_t row_length, uint max_rows,
+                               uint *rows_read)
+{
+  int result;
+  DBUG_ENTER("handler::ha_rnd_next_batch");
+  DBUG_ASSERT(table_share->tmp_table != NO_TMP_TABLE ||
+              m_lock_type != F_UNLCK);
+  DBUG_ASSERT(inited == RND);
+  DBUG_ASSERT(row_length >= table_share->reclength && max_rows > 0);
+
+  MYSQL_TABLE_IO_WAIT(m_psi, PSI_TABLE_FETCH_ROW, MAX_KEY, 0,
+    { result= rnd_next_batch(buf, row_length, max_rows, rows_read); })
+  DBUG_RETURN(result);
+}
+
+
 /**
   Read row via random scan from position.
 
@@ -3294,6 +3331,28 @@ int handler::ha_index_next(uchar * buf)
 }
 
 
+/**
+  Reads the next rows via index into consecutive row buffers.
+
+  @see ha_rnd_next_batch()
+*/
+
+int handler::ha_index_next_batch(uchar *buf, size_t row_length, uint max_rows,
+                                 uint *rows_read)
+{
+  int result;
+  DBUG_ENTER("handler::ha_index_next_batch");
+  DBUG_ASSERT(table_share->tmp_table != NO_TMP_TABLE ||
+              m_lock_type != F_UNLCK);
+  DBUG_ASSERT(inited == INDEX);
+  DBUG_ASSERT(row_length >= table_share->reclength && max_rows > 0);
+
+  MYSQL_TABLE_IO_WAIT(m_psi, PSI_TABLE_FETCH_ROW, active_index, 0,
+    { result= index_next_batch(buf, row_length, max_rows, rows_read); })
+  DBUG_RETURN(result);
+}
+
+
 /**
   Reads the previous row via index.
 
@@ -5283,6 +5342,41 @@ int handler::index_next_same(uchar *buf, const uchar *key, uint keylen)
 }
 
 
+/*
+  Default batch reads: one rnd_next()/index_next() call per row, directly
+  into the row's buffer.
+*/
+
+int handler::rnd_next_batch(uchar *buf, size_t row_length, uint max_rows,
+                            uint *rows_read)
+{
+  int error= 0;
+  uint n;
+  for (n= 0; n < max_rows; n++)
+  {
+    if ((error= rnd_next(buf + n * row_length)))
+      break;
+  }
+  *rows_read= n;
+  return error;
+}
+
+
+int handler::index_next_batch(uchar *buf, size_t row_length, uint max_rows,
+                              uint *rows_read)
+{
+  int error= 0;
+  uint n;
+  for (n= 0; n < max_rows; n++)
+  {
+    if ((error= index_next(buf + n * row_length)))
+      break;
+  }
+  *rows_read= n;
+  return error;
+}
+
+
 void handler::get_dynamic_partition_info(PARTITION_STATS *stat_info,
                                          uint part_id)
 {
@@ -6594,7 +6688,8 @@ int DsMrr_impl::dsmrr_init(handler *h_arg, RANGE_SEQ_IF *seq_funcs,
     if (check_stack_overrun(thd, 5*STACK_MIN_SIZE, (uchar*) &new_h2))
       DBUG_RETURN(1);
 
-    if (!(new_h2= h->clone(h->table->s->normalized_path.str, thd->mem_root)))
+    if (!(new_h2= h->clone(h->table->s->normalized_path.str, thd->mem_root,
+                           h->table)))
       DBUG_RETURN(1);
     h2= new_h2; /* Ok, now can put it into h2 */
     table->prepare_for_position();
@@ -2232,7 +2232,18 @@ public:
     DBUG_ASSERT(m_lock_type == F_UNLCK);
     DBUG_ASSERT(inited == NONE);
   }
-  virtual handler *clone(const char *name, MEM_ROOT *mem_root);
+  /**
+    Create and open another handler of the same table.
+
+    @param name       Name of the table or partition to open
+    @param mem_root   MEM_ROOT of the new handler and its ref
+    @param table_arg  TABLE to open the new handler on, normally the TABLE
+                      of this handler. A copy with its own record buffers,
+                      fields and keys lets another thread read through the
+                      new handler.
+  */
+  virtual handler *clone(const char *name, MEM_ROOT *mem_root,
+                         TABLE *table_arg);
   /** This is called after create to allow us to set up cached variables */
   void init()
   {
@@ -2250,6 +2261,8 @@ public:
   int ha_rnd_init(bool scan);
   int ha_rnd_end();
   int ha_rnd_next(uchar *buf);
+  int ha_rnd_next_batch(uchar *buf, size_t row_length, uint max_rows,
+                        uint *rows_read);
   int ha_rnd_pos(uchar * buf, uchar *pos);
   int ha_index_read_map(uchar *buf, const uchar *key,
                         key_part_map keypart_map,
@@ -2260,6 +2273,8 @@ public:
                            key_part_map keypart_map,
                            enum ha_rkey_function find_flag);
   int ha_index_next(uchar * buf);
+  int ha_index_next_batch(uchar *buf, size_t row_length, uint max_rows,
+                          uint *rows_read);
   int ha_index_prev(uchar * buf);
   int ha_index_first(uchar * buf);
   int ha_index_last(uchar * buf);
@@ -2556,6 +2571,20 @@ protected:
    { return  HA_ERR_WRONG_COMMAND; }
   /// @returns @see index_read_map().
   virtual int index_next_same(uchar *buf, const uchar *key, uint keylen);
+  /**
+    Read the next rows of an index scan, as by repeated index_next() calls,
+    into buffers row_length bytes apart.
+
+    BLOB values of a row may point to engine buffers that are reused by the
+    following rows of the batch, so batches are only useful for tables whose
+    BLOB columns are not read.
+
+    @param[out] rows_read  Number of rows stored in buf
+    @returns @see index_read_map() for the read that ended the batch, or 0
+             if max_rows rows were read.
+  */
+  virtual int index_next_batch(uchar *buf, size_t row_length, uint max_rows,
+                               uint *rows_read);
   /**
      @brief
      The following functions works like index_read, but it find the last
@@ -2600,6 +2629,9 @@ public:
 protected:
   /// @returns @see index_read_map().
   virtual int rnd_next(uchar *buf)=0;
+  /// Batch version of rnd_next(), @see index_next_batch()
+  virtual int rnd_next_batch(uchar *buf, size_t row_length, uint max_rows,
+                             uint *rows_read);
   /// @returns @see index_read_map().
   virtual int rnd_pos(uchar * buf, uchar *pos)=0;
 public:
@@ -3370,6 +3402,7 @@ public:
 protected:
   /* Service methods for use by storage engines. */
   void ha_statistic_increment(ulonglong SSV::*offset) const;
+  void ha_statistic_add(ulonglong SSV::*offset, ulonglong count) const;
   void **ha_data(THD *) const;
   THD *ha_thd(void) const;
 
@@ -7152,3 +7152,301 @@ Item* Item_func_eq::equality_substitution_transformer(uchar *arg)
   }
   return this;
 }
+
+
+Batch_filter *Batch_filter::create(MEM_ROOT *mem_root, TABLE *table,
+                                   uint max_rows)
+{
+  const size_t row_length= table->s->reclength;
+  uchar *rows= (uchar*) alloc_root(mem_root, row_length * max_rows);
+  uint *selected= (uint*) alloc_root(mem_root, sizeof(uint) * max_rows);
+  if (!rows || !selected)
+    return NULL;
+  return new (mem_root) Batch_filter(mem_root, table, row_length, rows,
+                                     selected, max_rows);
+}
+
+
+Field *Batch_filter::column(Item *item) const
+{
+  Item *real= item->real_item();
+  if (real->type() != Item::FIELD_ITEM)
+    return NULL;
+  Field *field= static_cast<Item_field*>(real)->field;
+  if (field->table != table)
+    return NULL;
+#ifdef WORDS_BIGENDIAN
+  if (!table->s->db_low_byte_first)
+    return NULL;
+#endif
+  switch (field->type())
+  {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+    return field;
+  case MYSQL_TYPE_LONGLONG:
+    /* Unsigned values above LONGLONG_MAX don't fit the ranges */
+    return field->flags & UNSIGNED_FLAG ? NULL : field;
+  default:
+    return NULL;
+  }
+}
+
+
+bool Batch_filter::int_constant(Item *item, longlong *value)
+{
+  if (!item->const_item() || item->is_expensive() ||
+      item->result_type() != INT_RESULT)
+    return false;
+  *value= item->val_int();
+  return !item->null_value && !(item->unsigned_flag && *value < 0);
+}
+
+
+bool Batch_filter::add(Field *field, const Predicate &predicate)
+{
+  static const Column_type signed_types[]= { INT8, INT16, INT24, INT32, INT64 };
+  static const Column_type unsigned_types[]=
+    { UINT8, UINT16, UINT24, UINT32, INT64 };
+  uint size;
+  switch (field->type())
+  {
+  case MYSQL_TYPE_TINY:  size= 0; break;
+  case MYSQL_TYPE_SHORT: size= 1; break;
+  case MYSQL_TYPE_INT24: size= 2; break;
+  case MYSQL_TYPE_LONG:  size= 3; break;
+  default:               size= 4; break;
+  }
+
+  Predicate p= predicate;
+  p.column_type= (field->flags & UNSIGNED_FLAG) ? unsigned_types[size] :
+                                                  signed_types[size];
+  p.offset= field->ptr - table->record[0];
+  p.null_bit= field->null_ptr ? field->null_bit : 0;
+  p.null_offset= field->null_ptr ? field->null_ptr - table->record[0] : 0;
+  return !predicates.push_back(p);
+}
+
+
+bool Batch_filter::add_range(Field *field, longlong low, longlong high,
+                             bool negated)
+{
+  Predicate p;
+  p.negated= negated;
+  p.low= low;
+  p.high= high;
+  p.values= NULL;
+  p.value_count= 0;
+  return add(field, p);
+}
+
+
+bool Batch_filter::add_in_list(Field *field, longlong *values, uint count,
+                               bool negated)
+{
+  std::sort(values, values + count);
+  Predicate p;
+  p.negated= negated;
+  p.low= p.high= 0;
+  p.values= values;
+  p.value_count= count;
+  return add(field, p);
+}
+
+
+namespace {
+
+struct Read_int8
+{ static longlong get(const uchar *p) { return (longlong) (int8) *p; } };
+struct Read_uint8
+{ static longlong get(const uchar *p) { return (longlong) *p; } };
+struct Read_int16
+{ static longlong get(const uchar *p) { return sint2korr(p); } };
+struct Read_uint16
+{ static longlong get(const uchar *p) { return uint2korr(p); } };
+struct Read_int24
+{ static longlong get(const uchar *p) { return sint3korr(p); } };
+struct Read_uint24
+{ static longlong get(const uchar *p) { return uint3korr(p); } };
+struct Read_int32
+{ static longlong get(const uchar *p) { return sint4korr(p); } };
+struct Read_uint32
+{ static longlong get(const uchar *p) { return uint4korr(p); } };
+struct Read_int64
+{ static longlong get(const uchar *p) { return sint8korr(p); } };
+
+}  // namespace
+
+
+/**
+  Keep the selected rows that satisfy one predicate.
+
+  NULL never satisfies a comparison, negated or not. The row numbers are
+  compacted in place, so the selection stays in increasing order.
+*/
+
+template <typename Reader>
+uint Batch_filter::apply(const Predicate &p, uint count)
+{
+  const uchar *const values= rows + p.offset;
+  const uchar *const nulls= rows + p.null_offset;
+  uint kept= 0;
+
+  if (p.values)
+  {
+    for (uint i= 0; i < count; i++)
+    {
+      const uint n= selected[i];
+      if (nulls[n * row_length] & p.null_bit)
+        continue;
+      const longlong v= Reader::get(values + n * row_length);
+      selected[kept]= n;
+      kept+= std::binary_search(p.values, p.values + p.value_count, v) !=
+             p.negated;
+    }
+  }
+  else
+  {
+    for (uint i= 0; i < count; i++)
+    {
+      const uint n= selected[i];
+      if (nulls[n * row_length] & p.null_bit)
+        continue;
+      const longlong v= Reader::get(values + n * row_length);
+      selected[kept]= n;
+      kept+= (v >= p.low && v <= p.high) != p.negated;
+    }
+  }
+  return kept;
+}
+
+
+uint Batch_filter::filter(uint count)
+{
+  DBUG_ASSERT(count <= m_max_rows);
+  for (uint i= 0; i < count; i++)
+    selected[i]= i;
+
+  for (const Predicate *p= predicates.begin(); p != predicates.end() && count;
+       p++)
+  {
+    switch (p->column_type)
+    {
+    case INT8:   count= apply<Read_int8>(*p, count); break;
+    case UINT8:  count= apply<Read_uint8>(*p, count); break;
+    case INT16:  count= apply<Read_int16>(*p, count); break;
+    case UINT16: count= apply<Read_uint16>(*p, count); break;
+    case INT24:  count= apply<Read_int24>(*p, count); break;
+    case UINT24: count= apply<Read_uint24>(*p, count); break;
+    case INT32:  count= apply<Read_int32>(*p, count); break;
+    case UINT32: count= apply<Read_uint32>(*p, count); break;
+    case INT64:  count= apply<Read_int64>(*p, count); break;
+    }
+  }
+  return count;
+}
+
+
+/**
+  Add "column op constant", or "constant op column", as a range of the
+  column, or as the negation of one for <>.
+*/
+
+bool Item_bool_rowready_func2::add_to_batch_filter(Batch_filter *filter)
+{
+  Functype op= functype();
+  Field *field= filter->column(args[0]);
+  longlong value;
+  if (field)
+  {
+    if (!Batch_filter::int_constant(args[1], &value))
+      return false;
+  }
+  else
+  {
+    if (!(field= filter->column(args[1])) ||
+        !Batch_filter::int_constant(args[0], &value))
+      return false;
+    op= rev_functype();
+  }
+
+  longlong low= LONGLONG_MIN, high= LONGLONG_MAX;
+  switch (op)
+  {
+  case EQ_FUNC:
+  case NE_FUNC:
+    low= high= value;
+    break;
+  case LT_FUNC:
+    if (value == LONGLONG_MIN)
+      return filter->add_range(field, 1, 0, false);
+    high= value - 1;
+    break;
+  case LE_FUNC:
+    high= value;
+    break;
+  case GT_FUNC:
+    if (value == LONGLONG_MAX)
+      return filter->add_range(field, 1, 0, false);
+    low= value + 1;
+    break;
+  case GE_FUNC:
+    low= value;
+    break;
+  default:
+    return false;
+  }
+  return filter->add_range(field, low, high, op == NE_FUNC);
+}
+
+
+bool Item_func_between::add_to_batch_filter(Batch_filter *filter)
+{
+  Field *field;
+  longlong low, high;
+  if (cmp_type != INT_RESULT || !(field= filter->column(args[0])) ||
+      !Batch_filter::int_constant(args[1], &low) ||
+      !Batch_filter::int_constant(args[2], &high))
+    return false;
+  return filter->add_range(field, low, high, negated);
+}
+
+
+bool Item_func_in::add_to_batch_filter(Batch_filter *filter)
+{
+  Field *field;
+  if (left_result_type != INT_RESULT || !(field= filter->column(args[0])))
+    return false;
+
+  longlong *values= filter->alloc_values(arg_count - 1);
+  if (!values)
+    return false;
+  for (uint i= 1; i < arg_count; i++)
+  {
+    if (!Batch_filter::int_constant(args[i], &values[i - 1]))
+      return false;
+  }
+  return filter->add_in_list(field, values, arg_count - 1, negated);
+}
+
+
+/**
+  Add the conjuncts that can be evaluated on a block of rows. The others
+  are left to the evaluation of the whole condition on the selected rows.
+*/
+
+bool Item_cond_and::add_to_batch_filter(Batch_filter *filter)
+{
+  bool added= false;
+  List_iterator_fast<Item> li(list);
+  Item *item;
+  while ((item= li++))
+  {
+    if ((item->type() == FUNC_ITEM || item->type() == COND_ITEM) &&
+        static_cast<Item_func*>(item)->add_to_batch_filter(filter))
+      added= true;
+  }
+  return added;
+}
@@ -22,6 +22,7 @@
 #include "thr_malloc.h"                         /* sql_calloc */
 #include "item_func.h"             /* Item_int_func, Item_bool_func */
 #include "my_regex.h"
+#include "mem_root_array.h"
 
 extern Item_result item_cmp_type(Item_result a,Item_result b);
 bool compare_fbson_value(fbson::FbsonValue*, fbson::FbsonValue*);
@@ -426,6 +427,7 @@ public:
   Item *neg_transformer(THD *thd);
   virtual Item *negated_item();
   bool subst_argument_checker(uchar **arg) { return TRUE; }
+  bool add_to_batch_filter(Batch_filter *filter);
 };
 
 /**
@@ -763,6 +765,7 @@ public:
   bool is_bool_func() { return 1; }
   const CHARSET_INFO *compare_collation() { return cmp_collation.collation; }
   uint decimal_precision() const { return 1; }
+  bool add_to_batch_filter(Batch_filter *filter);
 };
 
 
@@ -1443,6 +1446,7 @@ public:
   bool nulls_in_row();
   bool is_bool_func() { return 1; }
   const CHARSET_INFO *compare_collation() { return cmp_collation.collation; }
+  bool add_to_batch_filter(Batch_filter *filter);
 };
 
 class cmp_item_row :public cmp_item
@@ -1912,6 +1916,7 @@ public:
     return item;
   }
   Item *neg_transformer(THD *thd);
+  bool add_to_batch_filter(Batch_filter *filter);
 };
 
 inline bool is_cond_and(Item *item)
@@ -1971,6 +1976,91 @@ longlong get_datetime_value(THD *thd, Item ***item_arg, Item **cache_arg,
 bool get_mysql_time_from_str(THD *thd, String *str, timestamp_type warn_type,
                              const char *warn_name, MYSQL_TIME *l_time);
 
+
+/**
+  Filter that evaluates simple predicates of a WHERE condition on a block of
+  rows of one table at once.
+
+  The rows are copies of table->record[0], stored one after the other. Each
+  predicate compares one fixed-width integer column with constants, either
+  as a range [low, high] (=, <, <=, >, >=, <>, BETWEEN) or as a sorted list
+  of values (IN), and is applied to all the rows still selected in a tight
+  loop over the column values, instead of calling Item::val_int() through
+  the item tree for every row.
+
+  Predicates are added with Item_func::add_to_batch_filter(). A row is
+  selected if it satisfies all of them, so for a conjunction the filter can
+  hold a subset of the conjuncts: the rows it rejects would be rejected by
+  the whole condition, and the others still have to be checked with it.
+*/
+
+class Batch_filter : public Sql_alloc
+{
+public:
+  static Batch_filter *create(MEM_ROOT *mem_root, TABLE *table, uint max_rows);
+
+  /// The column of item if it can be read by the filter, else NULL
+  Field *column(Item *item) const;
+  /// Read an integer constant, false if item isn't one or is NULL
+  static bool int_constant(Item *item, longlong *value);
+
+  bool add_range(Field *field, longlong low, longlong high, bool negated);
+  /// Takes over values, allocated with alloc_values()
+  bool add_in_list(Field *field, longlong *values, uint count, bool negated);
+  longlong *alloc_values(uint count)
+  { return (longlong*) alloc_root(mem_root, sizeof(longlong) * count); }
+
+  bool is_empty() const { return predicates.empty(); }
+  uint max_rows() const { return m_max_rows; }
+  uchar *row(uint n) const { return rows + (size_t) n * row_length; }
+
+  /**
+    Apply the predicates to rows [0, count) of the block.
+
+    @return the number of selected rows, whose numbers are in increasing
+            order in selected_rows()
+  */
+  uint filter(uint count);
+  const uint *selected_rows() const { return selected; }
+
+private:
+  enum Column_type
+  {
+    INT8, UINT8, INT16, UINT16, INT24, UINT24, INT32, UINT32, INT64
+  };
+
+  struct Predicate
+  {
+    Column_type column_type;
+    uint offset;                 ///< Of the column in the row
+    uint null_offset;            ///< Of the NULL byte, if null_bit != 0
+    uchar null_bit;
+    bool negated;
+    longlong low, high;          ///< Range, if values == NULL
+    const longlong *values;      ///< Sorted IN list
+    uint value_count;
+  };
+
+  Batch_filter(MEM_ROOT *mem_root_arg, TABLE *table_arg,
+               size_t row_length_arg, uchar *rows_arg, uint *selected_arg,
+               uint max_rows_arg)
+    : mem_root(mem_root_arg), table(table_arg), row_length(row_length_arg),
+      rows(rows_arg), selected(selected_arg), m_max_rows(max_rows_arg),
+      predicates(mem_root_arg)
+  {}
+
+  bool add(Field *field, const Predicate &predicate);
+  template <typename Reader> uint apply(const Predicate &p, uint count);
+
+  MEM_ROOT *const mem_root;
+  TABLE *const table;
+  const size_t row_length;
+  uchar *const rows;
+  uint *const selected;
+  const uint m_max_rows;
+  Mem_root_array<Predicate, true> predicates;
+};
+
 /*
   These need definitions from this file but the variables are defined
   in mysqld.h. The variables really belong in this component, but for
@@ -32,6 +32,8 @@ using std::isfinite;
 #endif
 #endif
 
+class Batch_filter;
+
 class Item_func :public Item_result_field
 {
 protected:
@@ -145,6 +147,13 @@ public:
   virtual optimize_type select_optimize() const { return OPTIMIZE_NONE; }
   virtual bool have_rev_func() const { return 0; }
   virtual Item *key_item() const { return args[0]; }
+  /**
+    Add this predicate to a filter that evaluates it on a block of rows of
+    one table at once, see Batch_filter.
+
+    @return true if added, false if it can only be evaluated row by row
+  */
+  virtual bool add_to_batch_filter(Batch_filter *filter) { return false; }
   virtual bool const_item() const { return const_item_cache; }
   inline Item **arguments() const
   { DBUG_ASSERT(argument_count() > 0); return args; }
@@ -3554,9 +3554,10 @@ bool subselect_hash_sj_engine::setup(List<Item> *tmp_columns)
      table since it will not be used, and tell the caller we failed to
      initialize the engine.
   */
-  if (tmp_table->s->keys == 0)
+  if (tmp_table->s->keys == 0 || tmp_table->s->uniques)
   {
-    DBUG_ASSERT(tmp_table->s->db_type() == myisam_hton);
+    DBUG_ASSERT(tmp_table->s->db_type() == myisam_hton ||
+                tmp_table->s->uniques);
     DBUG_ASSERT(
       tmp_table->s->uniques ||
       tmp_table->key_info->key_length >= tmp_table->file->max_key_length() ||
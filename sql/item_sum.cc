@@ -835,10 +835,11 @@ bool Aggregator_distinct::setup(THD *thd)
     table->file->extra(HA_EXTRA_NO_ROWS);		// Don't update rows
     table->no_rows=1;
 
-    if (table->s->db_type() == heap_hton)
+    if (table->s->db_type() == heap_hton && !table->s->blob_fields)
     {
       /*
-        No blobs, otherwise it would have been MyISAM: set up a compare
+        No blobs, these would use MyISAM or a MEMORY table with a unique
+        constraint (see tmp_table_memory_blobs): set up a compare
         function and its arguments to use with Unique.
       */
       qsort_cmp2 compare_key;
@@ -894,8 +895,9 @@ bool Aggregator_distinct::setup(THD *thd)
         }
       }
       DBUG_ASSERT(tree == 0);
+      /* Keys compared with memcmp() can go to a hash set */
       tree= new Unique(compare_key, cmp_arg, tree_key_length,
-                       item_sum->ram_limitation(thd));
+                       item_sum->ram_limitation(thd), all_binary);
       /*
         The only time tree_key_length could be 0 is if someone does
         count(distinct) on a char(0) field - stupid thing to do,
@@ -965,7 +967,7 @@ bool Aggregator_distinct::setup(THD *thd)
       are converted to binary representation as well.
     */
     tree= new Unique(simple_raw_key_cmp, &tree_key_length, tree_key_length,
-                     item_sum->ram_limitation(thd));
+                     item_sum->ram_limitation(thd), true);
 
     DBUG_RETURN(tree == 0);
   }
@@ -1055,7 +1057,11 @@ bool Aggregator_distinct::add()
       return tree->unique_add(table->record[0] + table->s->null_bytes);
     }
     if ((error= table->file->ha_write_row(table->record[0])) &&
-        table->file->is_fatal_error(error, HA_CHECK_DUP))
+        table->file->is_fatal_error(error, HA_CHECK_DUP) &&
+        create_myisam_from_heap(table->in_use, table,
+                                tmp_table_param->start_recinfo,
+                                &tmp_table_param->recinfo,
+                                error, TRUE, NULL))
       return TRUE;
     return FALSE;
   }
@@ -61,6 +61,7 @@ slave_ignored_err_throttle(window_size,
 #include <base64.h>
 #include <my_bitmap.h>
 #include "rpl_utility.h"
+#include "rpl_gtid_index.h"
 
 #include "sql_digest.h"
 
@@ -10280,7 +10281,7 @@ Rows_log_event::Rows_log_event(THD *thd_arg, TABLE *tbl_arg, const Table_id& tid
 #ifdef HAVE_REPLICATION
     , m_curr_row(NULL), m_curr_row_end(NULL), m_key(NULL), m_key_info(NULL),
     m_distinct_keys(Key_compare(&m_key_info)), m_distinct_key_spare_buf(NULL),
-    master_had_triggers(0)
+    m_key_batch_left(0), m_key_batch_read(false), master_had_triggers(0)
 #endif
 {
   DBUG_ASSERT(tbl_arg && tbl_arg->s && tid.is_valid());
@@ -10344,7 +10345,7 @@ Rows_log_event::Rows_log_event(const char *buf, uint event_len,
 #if !defined(MYSQL_CLIENT) && defined(HAVE_REPLICATION)
     , m_curr_row(NULL), m_curr_row_end(NULL), m_key(NULL), m_key_info(NULL),
     m_distinct_keys(Key_compare(&m_key_info)), m_distinct_key_spare_buf(NULL),
-    master_had_triggers(0)
+    m_key_batch_left(0), m_key_batch_read(false), master_had_triggers(0)
 #endif
 {
   DBUG_ENTER("Rows_log_event::Rows_log_event(const char*,...)");
@@ -11575,6 +11576,33 @@ Rows_log_event::next_record_scan(bool first_read)
         }
     }
 
+    /*
+      Read the rows of the next keys of a HASH_SCAN in one multi-range
+      read, as do_index_scan_and_update() does for the rows it looks up.
+    */
+    if (first_read && m_rows_lookup_algorithm == ROW_LOOKUP_HASH_SCAN &&
+        opt_slave_rows_lookup_batch_size > 1 &&
+        !(table->file->ha_table_flags() & HA_READ_BEFORE_WRITE_REMOVAL))
+    {
+      if (!m_key_batch_left)
+      {
+        std::vector<uchar *> keys(1, m_key);
+        for (std::set<uchar *, Key_compare>::iterator it= m_itr;
+             it != m_distinct_keys.end() &&
+             keys.size() < opt_slave_rows_lookup_batch_size; ++it)
+          keys.push_back(*it);
+        m_key_batch_left= keys.size();
+        m_key_batch_read= false;
+        /* A single lookup gains nothing from being batched */
+        if (keys.size() > 1 &&
+            (error= read_key_batch(keys, &m_key_batch_read)))
+          DBUG_RETURN(error);
+      }
+      m_key_batch_left--;
+      if (m_key_batch_read)
+        my_atomic_add64((int64*) &slave_rows_batched_lookups, 1);
+    }
+
     if (first_read)
       if ((error= table->file->ha_index_read_map(table->record[0], m_key,
                                                  HA_WHOLE_KEY,
@@ -11613,6 +11641,7 @@ Rows_log_event::open_record_scan()
        */
       m_key= *m_itr;
       m_itr++;
+      m_key_batch_left= 0;
     }
     else {
       /* this is an INDEX_SCAN we need to store the key in m_key */
@@ -11687,6 +11716,291 @@ err:
 }
 
 
+/**
+  Keys of a batch of rows, read as a sequence of single key ranges.
+*/
+struct Row_key_batch
+{
+  std::vector<uchar *>::const_iterator next;
+  std::vector<uchar *>::const_iterator end;
+  uint key_length;
+  key_part_map keypart_map;
+  uint range_flag;
+};
+
+static range_seq_t row_key_batch_init(void *init_param, uint n_ranges,
+                                      uint flags)
+{
+  return (range_seq_t) init_param;
+}
+
+static uint row_key_batch_next(range_seq_t seq, KEY_MULTI_RANGE *range)
+{
+  Row_key_batch *batch= (Row_key_batch *) seq;
+  if (batch->next == batch->end)
+    return 1;
+
+  key_range *start_key= &range->start_key;
+  start_key->key= *batch->next++;
+  start_key->length= batch->key_length;
+  start_key->keypart_map= batch->keypart_map;
+  start_key->flag= HA_READ_KEY_EXACT;
+  range->end_key= *start_key;
+  range->end_key.flag= HA_READ_AFTER_KEY;
+  range->ptr= NULL;
+  range->range_flag= batch->range_flag;
+  return 0;
+}
+
+int Rows_log_event::read_row_batch(Relay_log_info const *rli,
+                                   const uchar **batch_end, bool *batch_read)
+{
+  DBUG_ENTER("Rows_log_event::read_row_batch");
+  DBUG_ASSERT(m_key_index < MAX_KEY);
+  const uchar *saved_m_curr_row= m_curr_row;
+  const uchar *saved_m_curr_row_end= m_curr_row_end;
+  std::set<uchar *, Key_compare> distinct_keys(&m_key_info);
+
+  *batch_read= false;
+
+  /* Collect the keys of the before images of the next rows */
+  while (m_curr_row < m_rows_end &&
+         distinct_keys.size() < opt_slave_rows_lookup_batch_size)
+  {
+    uchar *key;
+    prepare_record(m_table, &m_cols, false);
+    if (unpack_current_row(rli, &m_cols) ||
+        !(key= (uchar*) thd->alloc(m_key_info->key_length)))
+      break;
+    key_copy(key, m_table->record[0], m_key_info, 0);
+
+    if (get_general_type_code() == UPDATE_ROWS_EVENT)
+    {
+      const uchar *bi_start= m_curr_row;
+      m_curr_row= m_curr_row_end;
+      prepare_record(m_table, &m_cols, false);
+      if (unpack_current_row(rli, &m_cols_ai))
+      {
+        m_curr_row= bi_start;
+        break;
+      }
+    }
+    distinct_keys.insert(key);
+    m_curr_row= m_curr_row_end;
+  }
+
+  /* Errors in the rows are left for the rows to report when applied */
+  *batch_end= m_curr_row;
+  m_curr_row= saved_m_curr_row;
+  m_curr_row_end= saved_m_curr_row_end;
+
+  /* A single lookup gains nothing from being batched */
+  if (distinct_keys.size() < 2 || m_table->file->inited)
+    DBUG_RETURN(0);
+
+  std::vector<uchar *> keys(distinct_keys.begin(), distinct_keys.end());
+  DBUG_RETURN(read_key_batch(keys, batch_read));
+}
+
+
+int Rows_log_event::read_key_batch(const std::vector<uchar *> &keys,
+                                   bool *batch_read)
+{
+  DBUG_ENTER("Rows_log_event::read_key_batch");
+  DBUG_ASSERT(m_key_index < MAX_KEY);
+  /* The scan of a HASH_SCAN has the index open already */
+  const bool index_inited= m_table->file->inited;
+  int error= 0;
+
+  *batch_read= false;
+
+  Row_key_batch batch;
+  batch.next= keys.begin();
+  batch.end= keys.end();
+  batch.key_length= m_key_info->key_length;
+  batch.keypart_map=
+    (key_part_map(1) << m_key_info->user_defined_key_parts) - 1;
+  batch.range_flag= EQ_RANGE;
+  if ((m_key_info->flags & (HA_NOSAME | HA_NULL_PART_KEY)) == HA_NOSAME)
+    batch.range_flag|= UNIQUE_RANGE;
+
+  RANGE_SEQ_IF seq_funcs= { row_key_batch_init, row_key_batch_next, 0, 0 };
+  HANDLER_BUFFER buffer;
+  const size_t buffer_size= thd->variables.read_rnd_buff_size;
+  if (!(buffer.buffer= (uchar*) my_malloc(buffer_size, MYF(0))))
+    DBUG_RETURN(0);
+  buffer.buffer_end= buffer.buffer + buffer_size;
+  buffer.end_of_used_area= buffer.buffer;
+
+  if (index_inited ||
+      !(error= m_table->file->ha_index_init(m_key_index, FALSE)))
+  {
+    char *range_info;
+    /*
+      The keys are in index order: engines reading one range at a time
+      walk the index forward, MyRocks looks them up with MultiGet.
+    */
+    if (!(error= m_table->file->multi_range_read_init(&seq_funcs, &batch,
+                                                      keys.size(),
+                                                      HA_MRR_NO_ASSOCIATION |
+                                                      HA_MRR_SORTED,
+                                                      &buffer)))
+    {
+      while (!(error= m_table->file->multi_range_read_next(&range_info)))
+        ;
+    }
+    if (error == HA_ERR_END_OF_FILE || error == HA_ERR_KEY_NOT_FOUND)
+    {
+      error= 0;
+      *batch_read= true;
+    }
+    if (!index_inited)
+      m_table->file->ha_index_end();
+  }
+  my_free(buffer.buffer);
+
+  if (error)
+    m_table->file->print_error(error, MYF(0));
+
+  DBUG_RETURN(error);
+}
+
+
+/**
+  Whether a column of the master is unpacked into a field the way
+  unpack_row() unpacks it when no conversion is needed.
+*/
+static bool prefetch_column_matches(Field *field, const table_def *tabledef,
+                                    uint col)
+{
+  if (tabledef->have_column_names() &&
+      my_strcasecmp(system_charset_info, field->field_name,
+                    tabledef->get_column_name(col)))
+    return false;
+  if (field->real_type() != tabledef->type(col))
+    return false;
+
+  const uint16 metadata= tabledef->field_metadata(col);
+  int order;
+  if (!metadata)
+    return true;
+  /* Field_string::compatible_field_size() needs the relay log info */
+  if (field->real_type() == MYSQL_TYPE_STRING)
+    return field->pack_length_from_metadata(metadata) ==
+           field->row_pack_length();
+  return field->compatible_field_size(metadata, NULL,
+                                      Table_map_log_event::TM_BIT_LEN_EXACT_F,
+                                      &order) && order == 0;
+}
+
+
+/**
+  Walks a row image of a rows event, unpacking its columns into the
+  record of the table if unpack is set.
+
+  @return The end of the image, or NULL if it overruns the event.
+*/
+static const uchar *prefetch_row_image(TABLE *table,
+                                       const table_def *tabledef,
+                                       const MY_BITMAP *cols,
+                                       const uchar *row,
+                                       const uchar *rows_end, bool unpack)
+{
+  const uint null_bytes= (bitmap_bits_set(cols) + 7) / 8;
+  const uchar *pack_ptr= row + null_bytes;
+  uint null_bit= 0;
+
+  if (pack_ptr > rows_end)
+    return NULL;
+  for (uint col= 0; col < cols->n_bits; col++)
+  {
+    if (!bitmap_is_set(cols, col))
+      continue;
+    const bool is_null= row[null_bit / 8] & (1U << (null_bit % 8));
+    Field *const field= table->field[col];
+    null_bit++;
+    if (is_null)
+    {
+      if (unpack && field->maybe_null())
+        field->set_null();
+      continue;
+    }
+
+    const uint32 len= tabledef->calc_field_size(col, (uchar *) pack_ptr);
+    if (pack_ptr + len > rows_end)
+      return NULL;
+    if (unpack)
+    {
+      field->set_notnull();
+      field->unpack(field->ptr, pack_ptr, tabledef->field_metadata(col), TRUE);
+    }
+    pack_ptr+= len;
+  }
+  return pack_ptr;
+}
+
+
+uint Rows_log_event::prefetch_rows(TABLE *table, const table_def *tabledef)
+{
+  DBUG_ENTER("Rows_log_event::prefetch_rows");
+  const bool is_update= get_general_type_code() == UPDATE_ROWS_EVENT;
+  uchar key_buf[MAX_KEY_LENGTH];
+  uint rows= 0;
+
+  if (table->s->fields != m_width || tabledef->size() != m_width)
+    DBUG_RETURN(0);
+  for (uint col= 0; col < m_width; col++)
+  {
+    if (!prefetch_column_matches(table->field[col], tabledef, col))
+      DBUG_RETURN(0);
+  }
+
+  /*
+    Updates and deletes look their rows up by the first unique key, writes
+    check every unique key for duplicates.
+  */
+  for (uint key_nr= 0; key_nr < table->s->keys; key_nr++)
+  {
+    KEY *const key= table->key_info + key_nr;
+    bool usable= (key->flags & HA_NOSAME);
+    for (uint part= 0; usable && part < key->user_defined_key_parts; part++)
+      usable= bitmap_is_set(&m_cols, key->key_part[part].fieldnr - 1);
+    if (!usable)
+      continue;
+
+    int error= table->file->ha_index_init(key_nr, FALSE);
+    for (const uchar *row= m_rows_buf; !error && row < m_rows_end;)
+    {
+      restore_record(table, s->default_values);
+      if (!(row= prefetch_row_image(table, tabledef, &m_cols, row, m_rows_end,
+                                    true)) ||
+          (is_update &&
+           !(row= prefetch_row_image(table, tabledef, &m_cols_ai, row,
+                                     m_rows_end, false))))
+        break;
+
+      bool has_null= false;
+      for (uint part= 0; part < key->user_defined_key_parts; part++)
+        has_null|= key->key_part[part].field->is_null();
+      if (has_null)
+        continue;
+
+      key_copy(key_buf, table->record[0], key, 0);
+      error= table->file->ha_index_read_map(table->record[0], key_buf,
+                                            HA_WHOLE_KEY, HA_READ_KEY_EXACT);
+      if (error == HA_ERR_KEY_NOT_FOUND || error == HA_ERR_END_OF_FILE)
+        error= 0;
+      rows++;
+    }
+    if (table->file->inited)
+      table->file->ha_index_end();
+    if (error || get_general_type_code() != WRITE_ROWS_EVENT)
+      break;
+  }
+  DBUG_RETURN(rows);
+}
+
+
 int Rows_log_event::do_index_scan_and_update(Relay_log_info const *rli,
                                              table_def *tabledef)
 {
@@ -13287,6 +13601,9 @@ int Rows_log_event::do_apply_event(Relay_log_info const *rli)
 
     int (Rows_log_event::*do_apply_row_ptr)
       (Relay_log_info const *, table_def *)= NULL;
+    bool batch_lookups= false;
+    const uchar *batch_end= m_curr_row;
+    bool batch_read= false;
 
     /**
        Skip update rows events that don't have data for this slave's
@@ -13340,9 +13657,25 @@ int Rows_log_event::do_apply_event(Relay_log_info const *rli)
         break;
     }
 
+    /*
+      Index lookups of the rows are preceded by reading the rows of each
+      batch of slave_rows_lookup_batch_size rows in one multi-range read.
+    */
+    batch_lookups=
+      m_rows_lookup_algorithm == ROW_LOOKUP_INDEX_SCAN &&
+      m_key_index < MAX_KEY && opt_slave_rows_lookup_batch_size > 1 &&
+      !(m_table->file->ha_table_flags() & HA_READ_BEFORE_WRITE_REMOVAL);
+
     do {
 
+      if (batch_lookups && m_curr_row >= batch_end &&
+          (error= read_row_batch(rli, &batch_end, &batch_read)))
+        break;
+
+      const bool in_read_batch= batch_read && m_curr_row < batch_end;
       error= (this->*do_apply_row_ptr)(rli, tabledef);
+      if (!error && in_read_batch)
+        my_atomic_add64((int64*) &slave_rows_batched_lookups, 1);
 
       if (handle_idempotent_and_ignored_errors(rli, &error))
         break;
@@ -17183,6 +17516,10 @@ size_t my_strmov_quoted_identifier_helper(int q, char *buffer,
   Finds the position of given gtid by scanning through the given file
   and comparing the given gtid with gtid in each Gtid_log_event.
 
+  If the file has a GTID index, the scan starts at the last transaction
+  of the index logged before the gtid, and only goes back to the start
+  of the file if the gtid is not found after it.
+
   @param log_name File to look in.
   @param gtid     GTID to search for.
   @param sid_map  Sid_map used when parsing Gtid_log_event.
@@ -17201,12 +17538,15 @@ my_off_t find_gtid_pos_in_log(const char* log_name, const Gtid &gtid,
   File file = -1;
   Log_event *ev = NULL;
   my_off_t pos = 0;
+  my_off_t start_pos = BIN_LOG_HEADER_SIZE;
   /*
     Create a Format_description_log_event that is used to read the
     first event of the log.
   */
   Format_description_log_event fd_ev(BINLOG_VERSION), *fd_ev_p= &fd_ev;
 
+  (void) Gtid_index::find_gtid(log_name, gtid, sid_map, &start_pos);
+
 #ifndef MYSQL_CLIENT
   const char *errmsg = NULL;
   if (!fd_ev.is_valid())
@@ -17231,25 +17571,32 @@ my_off_t find_gtid_pos_in_log(const char* log_name, const Gtid &gtid,
   }
 #endif
 
-  my_b_seek(&log, BIN_LOG_HEADER_SIZE);
-  pos = BIN_LOG_HEADER_SIZE;
+  for (;;)
+  {
+    reinit_io_cache(&log, READ_CACHE, start_pos, 0, 0);
+    pos = start_pos;
 #ifndef MYSQL_CLIENT
-  while ((ev = Log_event::read_log_event(&log, 0, fd_ev_p, false, NULL)) !=
-         NULL)
+    while ((ev = Log_event::read_log_event(&log, 0, fd_ev_p, false, NULL)) !=
+           NULL)
 #else
-  while ((ev = Log_event::read_log_event(&log, fd_ev_p, false)) != NULL)
+    while ((ev = Log_event::read_log_event(&log, fd_ev_p, false)) != NULL)
 #endif
-  {
-    if (ev->get_type_code() == GTID_LOG_EVENT)
     {
-      Gtid_log_event *gtid_ev = (Gtid_log_event *) ev;
-      if (gtid_ev->get_sidno(sid_map) == gtid.sidno &&
-            gtid_ev->get_gno() == gtid.gno)
-        break;
+      if (ev->get_type_code() == GTID_LOG_EVENT)
+      {
+        Gtid_log_event *gtid_ev = (Gtid_log_event *) ev;
+        if (gtid_ev->get_sidno(sid_map) == gtid.sidno &&
+              gtid_ev->get_gno() == gtid.gno)
+          break;
+      }
+      DBUG_ASSERT(ev != fd_ev_p);
+      delete ev;
+      pos = my_b_tell(&log);
     }
-    DBUG_ASSERT(ev != fd_ev_p);
-    delete ev;
-    pos = my_b_tell(&log);
+    /* Read the whole file if the index led past the gtid */
+    if (ev != NULL || start_pos == BIN_LOG_HEADER_SIZE)
+      break;
+    start_pos = BIN_LOG_HEADER_SIZE;
   }
 
   /* Event was not found in above while loop.  */
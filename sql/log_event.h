@@ -34,6 +34,7 @@
 #include "table_id.h"
 #include <set>
 #include <deque>
+#include <vector>
 #include <my_murmur3.h>
 
 #ifdef MYSQL_CLIENT
@@ -4394,6 +4395,18 @@ public:
 
 #if defined(MYSQL_SERVER) && defined(HAVE_REPLICATION)
   virtual uint8 get_trg_event_map() = 0;
+
+  /**
+    Looks up the rows of the event in a table by their primary or unique
+    keys, for the storage engine to cache them before the event is
+    applied. Nothing is looked up unless the columns of the table are
+    those of the event, with the same types.
+
+    @param table     The table, opened for reading.
+    @param tabledef  The definition of the table in the table map event.
+    @returns The number of rows looked up.
+  */
+  uint prefetch_rows(TABLE *table, const table_def *tabledef);
 #endif
 
 protected:
@@ -4504,6 +4517,10 @@ private:
     for doing an index scan with HASH_SCAN search algorithm.
   */
   uchar *m_distinct_key_spare_buf;
+  /** Keys of m_distinct_keys left in the batch read by next_record_scan() */
+  uint m_key_batch_left;
+  /** Whether the keys of the current batch have been read */
+  bool m_key_batch_read;
   bool master_had_triggers;
 
   // Unpack the current row into m_table->record[0]
@@ -4702,7 +4719,31 @@ private:
      found it updates it.
    */
   int do_index_scan_and_update(Relay_log_info const *rli, table_def *tabledef);
-  
+
+  /**
+    Reads the rows that the next rows of the event look up with
+    do_index_scan_and_update() in one multi-range read, in key order, so
+    that their lookups find them in the storage engine's cache.
+
+    @param      rli         The reference to the relay log info object.
+    @param[out] batch_end   Set past the last row whose key was collected.
+    @param[out] batch_read  Set if the collected keys have been read.
+    @returns 0 on success. Otherwise, the error code.
+  */
+  int read_row_batch(Relay_log_info const *rli, const uchar **batch_end,
+                     bool *batch_read);
+
+  /**
+    Reads the rows with the given keys of index m_key_index in one
+    multi-range read, so that their lookups find them in the storage
+    engine's cache.
+
+    @param      keys        The keys, in index order.
+    @param[out] batch_read  Set if the keys have been read.
+    @returns 0 on success. Otherwise, the error code.
+  */
+  int read_key_batch(const std::vector<uchar *> &keys, bool *batch_read);
+
   /**
      Implementation of the hash_scan and update algorithm. It collects
      rows positions in a hashtable until the last row is
@@ -65,6 +65,17 @@ std::shared_ptr<Log_event_wrapper> Log_event_wrapper::next()
   return next_ev;
 }
 
+std::shared_ptr<Log_event_wrapper> Log_event_wrapper::peek_next()
+{
+  if (unlikely(is_end_event))
+    return nullptr;
+
+  mysql_mutex_lock(&mutex);
+  auto ret= next_ev;
+  mysql_mutex_unlock(&mutex);
+  return ret;
+}
+
 bool Log_event_wrapper::path_exists(
     const std::shared_ptr<Log_event_wrapper> &ev) const
 {
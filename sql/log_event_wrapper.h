@@ -138,6 +138,8 @@ public:
 
   void put_next(std::shared_ptr<Log_event_wrapper> &ev);
   std::shared_ptr<Log_event_wrapper> next();
+  // next event in the group if the coordinator has scheduled it, no waiting
+  std::shared_ptr<Log_event_wrapper> peek_next();
   bool path_exists(const std::shared_ptr<Log_event_wrapper> &ev) const;
 
   void set_db(const std::string& db)
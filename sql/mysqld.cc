@@ -586,6 +586,10 @@ my_bool rpl_wait_for_semi_sync_ack;
 std::atomic<ulonglong> slave_lag_sla_misses{0};
 ulonglong opt_slave_lag_sla_seconds;
 std::atomic<ulonglong> slave_commit_order_deadlocks{0};
+/* Binlog groups with slave workers' commits, updated under LOCK_log */
+ulonglong slave_commit_groups= 0;
+ulonglong slave_commit_group_trxs= 0;
+ulonglong opt_slave_commit_group_wait_usec;
 my_bool opt_safe_user_create = 0;
 my_bool opt_show_slave_auth_info;
 my_bool opt_log_slave_updates= 0;
@@ -650,6 +654,15 @@ ulonglong relay_sql_bytes= 0;
 /* Time the SQL thread waits for events from the IO thread */
 ulonglong relay_sql_wait_time= 0;
 
+/* Maximum size of the events the IO thread parses for the SQL thread */
+ulonglong opt_relay_log_event_queue_size= 0;
+
+/* Events the SQL thread took from the IO thread rather than the relay log */
+ulonglong relay_log_event_queue_hits= 0;
+
+/* Events the SQL thread read from the hot relay log with the queue enabled */
+ulonglong relay_log_event_queue_misses= 0;
+
 /* Cache hit ratio when using slave_compressed_event_protocol in dump thread.
    It is updated every minute */
 double comp_event_cache_hit_ratio= 0;
@@ -861,10 +874,20 @@ my_bool opt_mts_dynamic_rebalance;
 double opt_mts_imbalance_threshold;
 ulonglong opt_mts_pending_jobs_size_max;
 ulonglong slave_rows_search_algorithms_options;
+ulong opt_slave_rows_lookup_batch_size= 0;
+/* Rows applied after their lookup was batched by the slave */
+ulonglong slave_rows_batched_lookups= 0;
+uint opt_slave_prefetch_threads= 0;
+ulonglong opt_slave_prefetch_window= 0;
+ulonglong opt_slave_prefetch_large_trx_size= 0;
+/* Row events the slave prefetch threads read before or after the SQL thread */
+ulonglong slave_prefetch_useful= 0, slave_prefetch_wasted= 0;
 #ifndef DBUG_OFF
 uint slave_rows_last_search_algorithm_used;
 #endif
 ulonglong binlog_bytes_written = 0;
+ulonglong binlog_tail_cache_hits= 0;
+ulonglong binlog_tail_cache_misses= 0;
 ulonglong relay_log_bytes_written = 0;
 ulong binlog_cache_size=0;
 char *enable_jemalloc_hpp;
@@ -6263,6 +6286,7 @@ static int init_server_components()
 #ifdef HAVE_REPLICATION
   init_slave_list();
   init_compressed_event_cache();
+  mysql_bin_log.get_tail_cache()->resize(opt_binlog_tail_cache_size);
 #endif
 
   /* Setup logs */
@@ -10511,6 +10535,17 @@ static int show_slave_commit_order_deadlocks(THD *thd, SHOW_VAR *var, char *buf)
   return 0;
 }
 
+static int show_slave_commit_group_avg_size(THD *thd, SHOW_VAR *var,
+                                            char *buf)
+{
+  const ulonglong groups= slave_commit_groups;
+  var->type= SHOW_DOUBLE;
+  var->value= buf;
+  *((double *)buf)= groups ?
+    (double) slave_commit_group_trxs / groups : 0.0;
+  return 0;
+}
+
 static int show_slave_received_heartbeats(THD *thd, SHOW_VAR *var, char *buff)
 {
   if (active_mi)
@@ -11197,6 +11232,8 @@ SHOW_VAR status_vars[]= {
   {"Binlog_fsync_count",       (char*) &binlog_fsync_count, SHOW_LONGLONG},
   {"Binlog_stmt_cache_disk_use",(char*) &binlog_stmt_cache_disk_use,  SHOW_LONG},
   {"Binlog_stmt_cache_use",    (char*) &binlog_stmt_cache_use,       SHOW_LONG},
+  {"Binlog_tail_cache_hits",   (char*) &binlog_tail_cache_hits, SHOW_LONGLONG},
+  {"Binlog_tail_cache_misses", (char*) &binlog_tail_cache_misses, SHOW_LONGLONG},
   {"Bytes_received",           (char*) offsetof(STATUS_VAR, bytes_received), SHOW_LONGLONG_STATUS},
   {"Bytes_sent",               (char*) offsetof(STATUS_VAR, bytes_sent), SHOW_LONGLONG_STATUS},
   {"Com",                      (char*) com_status_vars, SHOW_ARRAY},
@@ -11251,6 +11288,8 @@ SHOW_VAR status_vars[]= {
   {"Filesort_disk_usage",      (char*) offsetof(STATUS_VAR, filesort_disk_usage), SHOW_LONGLONG_STATUS},
   {"Filesort_disk_usage_peak", (char*) offsetof(STATUS_VAR, filesort_disk_usage_peak), SHOW_LONGLONG_STATUS},
   {"Filesort_disk_usage_period_peak", (char*) show_filesort_disk_usage_period_peak, SHOW_FUNC},
+  {"Filesort_parallel_merge_passes", (char*) offsetof(STATUS_VAR, filesort_parallel_merge_passes), SHOW_LONGLONG_STATUS},
+  {"Filesort_parallel_runs",   (char*) offsetof(STATUS_VAR, filesort_parallel_runs), SHOW_LONGLONG_STATUS},
   {"Flashcache_enabled",       (char*) &cachedev_enabled,       SHOW_BOOL },
   {"Flush_commands",           (char*) &refresh_version,        SHOW_LONG_NOFLUSH},
   {"git_hash",                 (char*) git_hash, SHOW_CHAR },
@@ -11321,6 +11360,7 @@ SHOW_VAR status_vars[]= {
   {"Opened_tables",            (char*) offsetof(STATUS_VAR, opened_tables), SHOW_LONGLONG_STATUS},
   {"Opened_table_definitions", (char*) offsetof(STATUS_VAR, opened_shares), SHOW_LONGLONG_STATUS},
   {"Parse_seconds",            (char*) offsetof(STATUS_VAR, parse_time), SHOW_TIMER_STATUS},
+  {"Partition_parallel_scans", (char*) offsetof(STATUS_VAR, partition_parallel_scan_count), SHOW_LONGLONG_STATUS},
   {"Pre_exec_seconds",         (char*) offsetof(STATUS_VAR, pre_exec_time), SHOW_TIMER_STATUS},
   {"Prepared_stmt_count",      (char*) &show_prepared_stmt_count, SHOW_FUNC},
 #ifdef HAVE_QUERY_CACHE
@@ -11340,6 +11380,8 @@ SHOW_VAR status_vars[]= {
   {"Read_requests",            (char*) offsetof(STATUS_VAR, read_requests), SHOW_LONG_STATUS},
   {"Read_seconds",             (char*) offsetof(STATUS_VAR, read_time), SHOW_TIMER_STATUS},
   {"Relay_log_bytes_written",  (char*) &relay_log_bytes_written, SHOW_LONGLONG},
+  {"Relay_log_event_queue_hits", (char*) &relay_log_event_queue_hits, SHOW_LONGLONG},
+  {"Relay_log_event_queue_misses", (char*) &relay_log_event_queue_misses, SHOW_LONGLONG},
   {"Relay_log_io_connected",   (char*) &relay_io_connected, SHOW_LONG},
   {"Relay_log_io_events",      (char*) &relay_io_events, SHOW_LONG},
   {"Relay_log_io_bytes",       (char*) &relay_io_bytes, SHOW_LONGLONG},
@@ -11414,6 +11456,7 @@ SHOW_VAR status_vars[]= {
   {"rocksdb_git_date",         (char*) rocksdb_git_date, SHOW_CHAR },
   {"Select_full_join",         (char*) offsetof(STATUS_VAR, select_full_join_count), SHOW_LONGLONG_STATUS},
   {"Select_full_range_join",   (char*) offsetof(STATUS_VAR, select_full_range_join_count), SHOW_LONGLONG_STATUS},
+  {"Select_parallel_union",    (char*) offsetof(STATUS_VAR, select_parallel_union_count), SHOW_LONGLONG_STATUS},
   {"Select_range",             (char*) offsetof(STATUS_VAR, select_range_count), SHOW_LONGLONG_STATUS},
   {"Select_range_check",       (char*) offsetof(STATUS_VAR, select_range_check_count), SHOW_LONGLONG_STATUS},
   {"Select_scan",	       (char*) offsetof(STATUS_VAR, select_scan_count), SHOW_LONGLONG_STATUS},
@@ -11422,8 +11465,14 @@ SHOW_VAR status_vars[]= {
 #endif
   {"Slave_open_temp_tables",   (char*) &slave_open_temp_tables, SHOW_INT},
 #ifdef HAVE_REPLICATION
+  {"Slave_prefetch_useful",    (char*) &slave_prefetch_useful, SHOW_LONGLONG},
+  {"Slave_prefetch_wasted",    (char*) &slave_prefetch_wasted, SHOW_LONGLONG},
   {"Slave_retried_transactions",(char*) &show_slave_retried_trans, SHOW_FUNC},
+  {"Slave_rows_batched_lookups",(char*) &slave_rows_batched_lookups, SHOW_LONGLONG},
   {"Slave_Commit_order_deadlocks",(char*) &show_slave_commit_order_deadlocks, SHOW_FUNC},
+  {"Slave_commit_groups",      (char*) &slave_commit_groups, SHOW_LONGLONG},
+  {"Slave_commit_group_trxs",  (char*) &slave_commit_group_trxs, SHOW_LONGLONG},
+  {"Slave_commit_group_avg_size",(char*) &show_slave_commit_group_avg_size, SHOW_FUNC},
   {"Slave_heartbeat_period",   (char*) &show_heartbeat_period, SHOW_FUNC},
   {"Slave_received_heartbeats",(char*) &show_slave_received_heartbeats, SHOW_FUNC},
   {"Slave_lag_sla_misses",     (char*) &show_slave_lag_sla_misses, SHOW_FUNC},
@@ -11721,9 +11770,11 @@ static int mysql_init_variables(void)
   delayed_insert_errors= thread_created= 0;
   specialflag= 0;
   binlog_bytes_written= 0;
+  binlog_tail_cache_hits= binlog_tail_cache_misses= 0;
   binlog_cache_use=  binlog_cache_disk_use= 0;
   binlog_fsync_count= 0;
   relay_log_bytes_written= 0;
+  relay_log_event_queue_hits= relay_log_event_queue_misses= 0;
   max_used_connections= slow_launch_threads = 0;
   mysqld_user= mysqld_chroot= opt_init_file= opt_bin_logname = 0;
   opt_apply_logname= 0;
@@ -13351,7 +13402,7 @@ PSI_mutex_key
   key_LOCK_slave_net_timeout,
   key_LOCK_server_started, key_LOCK_status,
   key_LOCK_system_variables_hash, key_LOCK_table_share, key_LOCK_thd_data,
-  key_LOCK_thd_db_read_only_hash,
+  key_LOCK_thd_db_read_only_hash, key_LOCK_thd_sql_stats_buffer,
   key_LOCK_db_metadata, key_LOCK_thd_audit_data,
   key_LOCK_user_conn, key_LOCK_uuid_generator, key_LOG_LOCK_log,
   key_master_info_data_lock, key_master_info_run_lock,
@@ -13472,6 +13523,7 @@ static PSI_mutex_info all_server_mutexes[]=
   { &key_LOCK_table_share, "LOCK_table_share", PSI_FLAG_GLOBAL},
   { &key_LOCK_thd_data, "THD::LOCK_thd_data", 0},
   { &key_LOCK_thd_db_read_only_hash, "THD::LOCK_thd_db_read_only_hash", 0},
+  { &key_LOCK_thd_sql_stats_buffer, "THD::LOCK_thd_sql_stats_buffer", 0},
   { &key_LOCK_db_metadata, "THD::LOCK_db_metadata", 0},
   { &key_LOCK_user_conn, "LOCK_user_conn", PSI_FLAG_GLOBAL},
   { &key_LOCK_uuid_generator, "LOCK_uuid_generator", PSI_FLAG_GLOBAL},
@@ -13546,6 +13598,7 @@ PSI_rwlock_key key_rwlock_Binlog_relay_IO_delegate_lock;
 #endif
 
 PSI_rwlock_key key_rwlock_hash_filo;
+PSI_rwlock_key key_rwlock_LOCK_binlog_tail_cache;
 PSI_rwlock_key key_rwlock_LOCK_ac;
 
 static PSI_rwlock_info all_server_rwlocks[]=
@@ -13572,6 +13625,7 @@ static PSI_rwlock_info all_server_rwlocks[]=
   { &key_rwlock_Trans_delegate_lock, "Trans_delegate::lock", PSI_FLAG_GLOBAL},
   { &key_rwlock_Binlog_storage_delegate_lock, "Binlog_storage_delegate::lock", PSI_FLAG_GLOBAL},
   { &key_rwlock_hash_filo, "LOCK_key_hash_filo_rwlock", PSI_FLAG_GLOBAL},
+  { &key_rwlock_LOCK_binlog_tail_cache, "Binlog_tail_cache::m_lock", 0},
   { &key_rwlock_sql_stats_snapshot, "LOCK_sql_stats_snapshot", PSI_FLAG_GLOBAL},
 #if (defined(_WIN32) || defined(HAVE_SMEM)) && !defined(EMBEDDED_LIBRARY)
   { &key_rwlock_LOCK_named_pipe_full_access_group, "LOCK_named_pipe_full_access_group", PSI_FLAG_GLOBAL},
@@ -13669,8 +13723,10 @@ static PSI_cond_info all_server_conds[]=
 };
 
 PSI_thread_key key_thread_bootstrap, key_thread_delayed_insert,
+  key_thread_filesort_worker,
   key_thread_handle_manager, key_thread_handle_slave_stats_daemon, key_thread_main,
-  key_thread_one_connection, key_thread_signal_hand;
+  key_thread_one_connection, key_thread_partition_scan, key_thread_signal_hand,
+  key_thread_union_worker;
 
 #ifdef HAVE_MY_TIMER
 PSI_thread_key key_thread_timer_notifier;
@@ -13700,11 +13756,14 @@ static PSI_thread_info all_server_threads[]=
 
   { &key_thread_bootstrap, "bootstrap", PSI_FLAG_GLOBAL},
   { &key_thread_delayed_insert, "delayed_insert", 0},
+  { &key_thread_filesort_worker, "filesort_worker", 0},
   { &key_thread_handle_manager, "manager", PSI_FLAG_GLOBAL},
   { &key_thread_handle_slave_stats_daemon, "slave_stats_daemon", PSI_FLAG_GLOBAL},
   { &key_thread_main, "main", PSI_FLAG_GLOBAL},
   { &key_thread_one_connection, "one_connection", 0},
-  { &key_thread_signal_hand, "signal_handler", PSI_FLAG_GLOBAL}
+  { &key_thread_partition_scan, "partition_scan", 0},
+  { &key_thread_signal_hand, "signal_handler", PSI_FLAG_GLOBAL},
+  { &key_thread_union_worker, "union_worker", 0}
 };
 
 #ifdef HAVE_MMAP
@@ -339,6 +339,9 @@ extern my_bool rpl_wait_for_semi_sync_ack;
 extern std::atomic<ulonglong> slave_lag_sla_misses;
 extern ulonglong opt_slave_lag_sla_seconds;
 extern std::atomic<ulonglong> slave_commit_order_deadlocks;
+extern ulonglong slave_commit_groups;
+extern ulonglong slave_commit_group_trxs;
+extern ulonglong opt_slave_commit_group_wait_usec;
 extern ulong slave_exec_mode_options;
 extern ulong slave_use_idempotent_for_recovery_options;
 extern ulong slave_run_triggers_for_rbr;
@@ -357,6 +360,12 @@ extern my_bool block_create_myisam;
 extern my_bool block_create_memory;
 extern my_bool lower_case_file_system;
 extern ulonglong slave_rows_search_algorithms_options;
+extern ulong opt_slave_rows_lookup_batch_size;
+extern ulonglong slave_rows_batched_lookups;
+extern uint opt_slave_prefetch_threads;
+extern ulonglong opt_slave_prefetch_window;
+extern ulonglong opt_slave_prefetch_large_trx_size;
+extern ulonglong slave_prefetch_useful, slave_prefetch_wasted;
 #ifndef DBUG_OFF
 extern uint slave_rows_last_search_algorithm_used;
 #endif
@@ -955,6 +964,7 @@ extern const my_thread_id reserved_thread_id;
 extern ulong binlog_cache_use, binlog_cache_disk_use;
 extern ulong binlog_stmt_cache_use, binlog_stmt_cache_disk_use;
 extern ulonglong binlog_bytes_written;
+extern ulonglong binlog_tail_cache_hits, binlog_tail_cache_misses;
 extern ulonglong relay_log_bytes_written;
 extern ulong aborted_threads,aborted_connects;
 extern ulong delayed_insert_timeout;
@@ -1433,7 +1443,7 @@ extern PSI_mutex_key
   key_LOCK_slave_net_timeout,
   key_LOCK_server_started, key_LOCK_status,
   key_LOCK_table_share, key_LOCK_thd_data,
-  key_LOCK_thd_db_read_only_hash,
+  key_LOCK_thd_db_read_only_hash, key_LOCK_thd_sql_stats_buffer,
   key_LOCK_db_metadata, key_LOCK_thd_audit_data,
   key_LOCK_user_conn, key_LOCK_uuid_generator, key_LOG_LOCK_log,
   key_master_info_data_lock, key_master_info_run_lock,
@@ -1497,7 +1507,8 @@ extern PSI_rwlock_key key_rwlock_LOCK_column_statistics, key_rwlock_LOCK_grant,
   key_rwlock_NAME_ID_MAP_LOCK_name_id_map,
   key_rwlock_hash_filo,
   key_rwlock_sql_stats_snapshot,
-  key_rwlock_LOCK_ac;
+  key_rwlock_LOCK_ac,
+  key_rwlock_LOCK_binlog_tail_cache;
 
 #ifdef HAVE_MMAP
 extern PSI_cond_key key_PAGE_cond, key_COND_active, key_COND_pool;
@@ -1533,9 +1544,10 @@ extern PSI_cond_key key_commit_order_manager_cond;
 extern PSI_cond_key key_COND_ac_node;
 
 extern PSI_thread_key key_thread_bootstrap, key_thread_delayed_insert,
-  key_thread_handle_manager, key_thread_handle_slave_stats_daemon,
-  key_thread_kill_server, key_thread_main, key_thread_one_connection,
-  key_thread_signal_hand;
+  key_thread_filesort_worker, key_thread_handle_manager,
+  key_thread_handle_slave_stats_daemon, key_thread_kill_server,
+  key_thread_main, key_thread_one_connection, key_thread_partition_scan,
+  key_thread_signal_hand, key_thread_union_worker;
 
 #ifdef HAVE_MMAP
 extern PSI_file_key key_file_map;
@@ -1689,7 +1689,8 @@ int QUICK_RANGE_SELECT::init_ror_merged_scan(bool reuse_handler)
   }
 
   thd= head->in_use;
-  if (!(file= head->file->clone(head->s->normalized_path.str, thd->mem_root)))
+  if (!(file= head->file->clone(head->s->normalized_path.str, thd->mem_root,
+                                head)))
   {
     /* 
       Manually set the error flag. Note: there seems to be quite a few
@@ -10398,9 +10399,13 @@ int QUICK_INDEX_MERGE_SELECT::read_keys_and_merge()
     DBUG_EXECUTE_IF("only_one_Unique_may_be_created", 
                     DBUG_SET("+d,index_merge_may_not_create_a_Unique"); );
 
+    /*
+      A row always gets the same position() bytes, so the rowids can be
+      deduplicated by a hash set.
+    */
     unique= new Unique(refpos_order_cmp, (void *)file,
                        file->ref_length,
-                       thd->variables.sortbuff_size);
+                       thd->variables.sortbuff_size, true);
   }
   else
   {
@@ -32,6 +32,9 @@
 
 static int rr_quick(READ_RECORD *info);
 int rr_sequential(READ_RECORD *info);
+static int rr_sequential_batch(READ_RECORD *info, uchar *buf,
+                               size_t row_length, uint max_rows,
+                               uint *rows_read);
 static int rr_from_tempfile(READ_RECORD *info);
 static int rr_unpack_from_tempfile(READ_RECORD *info);
 static int rr_unpack_from_buffer(READ_RECORD *info);
@@ -41,6 +44,8 @@ static int init_rr_cache(THD *thd, READ_RECORD *info);
 static int rr_index_first(READ_RECORD *info);
 static int rr_index_last(READ_RECORD *info);
 static int rr_index(READ_RECORD *info);
+static int rr_index_batch(READ_RECORD *info, uchar *buf, size_t row_length,
+                          uint max_rows, uint *rows_read);
 static int rr_index_desc(READ_RECORD *info);
 
 
@@ -284,6 +289,7 @@ bool init_read_record(READ_RECORD *info,THD *thd, TABLE *table,
   {
     DBUG_PRINT("info",("using rr_sequential"));
     info->read_record=rr_sequential;
+    info->read_batch= rr_sequential_batch;
     if ((error= table->file->ha_rnd_init(1)))
       goto err;
     /* We can use record cache if we don't update dynamic length tables */
@@ -395,6 +401,9 @@ static int rr_index_first(READ_RECORD *info)
 {
   int tmp= info->table->file->ha_index_first(info->record);
   info->read_record= rr_index;
+  /* Rows read into other buffers can't be checked by a pushed condition */
+  if (!info->table->file->pushed_idx_cond)
+    info->read_batch= rr_index_batch;
   if (tmp)
     tmp= rr_handle_error(info, tmp);
   return tmp;
@@ -449,6 +458,23 @@ static int rr_index(READ_RECORD *info)
 }
 
 
+/**
+  Reads the next rows of an index scan into buf, row_length bytes apart.
+
+  @see rr_sequential_batch()
+*/
+
+static int rr_index_batch(READ_RECORD *info, uchar *buf, size_t row_length,
+                          uint max_rows, uint *rows_read)
+{
+  int tmp= info->table->file->ha_index_next_batch(buf, row_length, max_rows,
+                                                  rows_read);
+  if (tmp)
+    tmp= rr_handle_error(info, tmp);
+  return tmp;
+}
+
+
 /**
   Reads index sequentially from the last row to the first.
 
@@ -492,6 +518,47 @@ int rr_sequential(READ_RECORD *info)
   return tmp;
 }
 
+/**
+  Read the next rows of a table scan into buf, row_length bytes apart.
+
+  @param info        Scan info
+  @param buf         Buffer for max_rows rows
+  @param row_length  Distance between the rows in buf
+  @param max_rows    Number of rows to read
+  @param rows_read   OUT Number of rows stored in buf
+
+  @retval
+    0   max_rows rows were read
+  @retval
+    -1   End of records, after rows_read rows
+  @retval
+    1   Error
+*/
+
+static int rr_sequential_batch(READ_RECORD *info, uchar *buf,
+                               size_t row_length, uint max_rows,
+                               uint *rows_read)
+{
+  int tmp;
+  uint n= 0;
+  for (;;)
+  {
+    uint read;
+    tmp= info->table->file->ha_rnd_next_batch(buf + n * row_length,
+                                              row_length, max_rows - n,
+                                              &read);
+    n+= read;
+    /* Skip RECORD_DELETED like rr_sequential() */
+    if (!tmp || info->thd->killed || tmp != HA_ERR_RECORD_DELETED)
+      break;
+  }
+  *rows_read= n;
+  if (tmp)
+    tmp= rr_handle_error(info, tmp);
+  return tmp;
+}
+
+
 
 static int rr_from_tempfile(READ_RECORD *info)
 {
@@ -43,6 +43,8 @@ class SQL_SELECT;
 struct READ_RECORD
 {
   typedef int (*Read_func)(READ_RECORD*);
+  typedef int (*Read_batch_func)(READ_RECORD*, uchar *buf, size_t row_length,
+                                 uint max_rows, uint *rows_read);
   typedef void (*Unlock_row_func)(st_join_table *);
   typedef int (*Setup_func)(JOIN_TAB*);
 
@@ -50,6 +52,12 @@ struct READ_RECORD
   TABLE **forms;                                /* head and ref forms */
   Unlock_row_func unlock_row;
   Read_func read_record;
+  /**
+    Read the next rows into buf instead of record[0], or NULL if the access
+    method has no batch read. Returns like read_record, except that rows
+    may have been read before the end of records or an error.
+  */
+  Read_batch_func read_batch;
   THD *thd;
   SQL_SELECT *select;
   uint cache_records;
@@ -0,0 +1,163 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "rpl_binlog_tail_cache.h"
+#include "mysql/psi/mysql_file.h"
+#include "mysqld.h"                             // key_rwlock_...
+#include "log.h"                                // sql_print_warning
+#include "log_event.h"                          // EVENT_LEN_OFFSET
+#include "sql_string.h"
+
+
+Binlog_tail_cache::Binlog_tail_cache()
+  : m_buffer(NULL), m_size(0), m_start(0), m_end(0)
+{
+  m_log_name[0]= 0;
+}
+
+
+void Binlog_tail_cache::init()
+{
+  mysql_rwlock_init(key_rwlock_LOCK_binlog_tail_cache, &m_lock);
+}
+
+
+void Binlog_tail_cache::cleanup()
+{
+  my_free(m_buffer);
+  m_buffer= NULL;
+  m_size= 0;
+  mysql_rwlock_destroy(&m_lock);
+}
+
+
+void Binlog_tail_cache::resize(ulonglong size)
+{
+  mysql_rwlock_wrlock(&m_lock);
+  my_free(m_buffer);
+  m_buffer= NULL;
+  m_size= 0;
+  if (size && !(m_buffer= (uchar*) my_malloc((size_t) size, MYF(0))))
+    sql_print_warning("Could not allocate %llu bytes for the binlog tail "
+                      "cache; dump threads read the binary log from its "
+                      "file.", size);
+  else
+    m_size= (size_t) size;
+  m_log_name[0]= 0;
+  m_start= m_end= 0;
+  mysql_rwlock_unlock(&m_lock);
+}
+
+
+void Binlog_tail_cache::clear()
+{
+  mysql_rwlock_wrlock(&m_lock);
+  m_log_name[0]= 0;
+  m_start= m_end= 0;
+  mysql_rwlock_unlock(&m_lock);
+}
+
+
+/**
+  Read the bytes [from, to) of the file into the buffer, where at most
+  m_size bytes fit.
+*/
+
+bool Binlog_tail_cache::copy_in(File file, my_off_t from, my_off_t to)
+{
+  DBUG_ASSERT(to - from <= m_size);
+  const size_t offset= (size_t) (from % m_size);
+  const size_t length= (size_t) (to - from);
+  const size_t first= min(length, m_size - offset);
+
+  return (mysql_file_pread(file, m_buffer + offset, first, from,
+                           MYF(MY_NABP)) ||
+          (length > first &&
+           mysql_file_pread(file, m_buffer, length - first, from + first,
+                            MYF(MY_NABP))));
+}
+
+
+void Binlog_tail_cache::copy_out(my_off_t pos, size_t length, uchar *to) const
+{
+  const size_t offset= (size_t) (pos % m_size);
+  const size_t first= min(length, m_size - offset);
+
+  memcpy(to, m_buffer + offset, first);
+  memcpy(to + first, m_buffer, length - first);
+}
+
+
+void Binlog_tail_cache::publish(const char *log_name, File file,
+                                my_off_t end_pos)
+{
+  mysql_rwlock_wrlock(&m_lock);
+  if (!m_size)
+    goto end;
+
+  if (strcmp(log_name, m_log_name) || end_pos < m_end)
+  {
+    /*
+      A new log, or one which has been truncated: start caching at its
+      current end, the events before are read from the file.
+    */
+    strmake(m_log_name, log_name, sizeof(m_log_name) - 1);
+    m_start= m_end= end_pos;
+  }
+  else if (end_pos > m_end)
+  {
+    /* Bytes which would be overwritten by later ones are not read */
+    const my_off_t oldest= end_pos > m_size ? end_pos - m_size : 0;
+    if (copy_in(file, max(m_end, oldest), end_pos))
+    {
+      m_log_name[0]= 0;
+      m_start= m_end= 0;
+      goto end;
+    }
+    m_start= max(m_start, oldest);
+    m_end= end_pos;
+  }
+
+end:
+  mysql_rwlock_unlock(&m_lock);
+}
+
+
+bool Binlog_tail_cache::read_event(const char *log_name, my_off_t pos,
+                                   ulong max_len, String *packet,
+                                   my_off_t *next_pos)
+{
+  uchar header[LOG_EVENT_MINIMAL_HEADER_LEN];
+  bool found= false;
+
+  mysql_rwlock_rdlock(&m_lock);
+  if (pos >= m_start && pos + sizeof(header) <= m_end &&
+      !strcmp(log_name, m_log_name))
+  {
+    copy_out(pos, sizeof(header), header);
+    const ulong length= uint4korr(header + EVENT_LEN_OFFSET);
+    const uint32 packet_length= packet->length();
+    if (length >= sizeof(header) && length <= max_len &&
+        pos + length <= m_end && !packet->reserve(length))
+    {
+      copy_out(pos, length, (uchar*) packet->ptr() + packet_length);
+      packet->length(packet_length + length);
+      *next_pos= pos + length;
+      found= true;
+    }
+  }
+  mysql_rwlock_unlock(&m_lock);
+  return found;
+}
@@ -0,0 +1,93 @@
+#ifndef RPL_BINLOG_TAIL_CACHE_INCLUDED
+#define RPL_BINLOG_TAIL_CACHE_INCLUDED
+
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/** @file Shared cache of the end of the binary log being written */
+
+#include "my_global.h"
+#include "my_sys.h"
+#include "mysql/psi/mysql_thread.h"
+
+class String;
+
+/**
+  Ring buffer with the last bytes made visible to dump threads of the
+  binary log being written.
+
+  MYSQL_BIN_LOG publishes every new binlog_end_pos. The bytes up to it are
+  then copied once from the file into the buffer, and dump threads which
+  have caught up with the log send their events from the buffer instead of
+  each reading the file. A dump thread looking for bytes the buffer no
+  longer holds, or for another log, reads the file as before.
+
+  The buffer holds the range [m_start, m_end) of m_log_name, the byte at
+  offset pos being at m_buffer[pos % m_size].
+*/
+class Binlog_tail_cache
+{
+public:
+  Binlog_tail_cache();
+
+  void init();
+  void cleanup();
+
+  /**
+    Change the size of the buffer, dropping its content. A size of 0
+    disables the cache.
+  */
+  void resize(ulonglong size);
+
+  /**
+    Account for the bytes of a binary log made visible to dump threads.
+
+    @param log_name  Binary log being written
+    @param file      Its file, where the bytes have been written
+    @param end_pos   New end of the part of the log dump threads read
+  */
+  void publish(const char *log_name, File file, my_off_t end_pos);
+
+  /// Drop the content of the buffer
+  void clear();
+
+  /**
+    Append the event at an offset of a binary log to a packet.
+
+    @param      log_name  Binary log
+    @param      pos       Offset of the event
+    @param      max_len   Events longer than this are not taken
+    @param      packet    Packet to append the event to
+    @param[out] next_pos  Offset following the event
+
+    @retval true   The event has been appended
+    @retval false  The buffer does not hold the whole event
+  */
+  bool read_event(const char *log_name, my_off_t pos, ulong max_len,
+                  String *packet, my_off_t *next_pos);
+
+private:
+  void copy_out(my_off_t pos, size_t length, uchar *to) const;
+  bool copy_in(File file, my_off_t from, my_off_t to);
+
+  mysql_rwlock_t m_lock;
+  uchar *m_buffer;
+  size_t m_size;
+  char m_log_name[FN_REFLEN];
+  my_off_t m_start;
+  my_off_t m_end;
+};
+
+#endif /* RPL_BINLOG_TAIL_CACHE_INCLUDED */
@@ -1743,6 +1743,137 @@ private:
 #endif
   /// Only Free_intervals_lock is allowed to access free_intervals_mutex.
   friend class Gtid_set::Free_intervals_lock;
+  /// Compact_gtid_set adds its intervals in to_gtid_set().
+  friend class Compact_gtid_set;
+};
+
+
+/**
+  A read-only copy of a Gtid_set, which stores the intervals of all
+  SIDNOs in one array, sorted by SIDNO and then by GNO.
+
+  Gtid_set keeps a linked list of intervals per SIDNO so that groups
+  can be added one by one.  Sets which are only queried, like the
+  GTIDs a slave has when it connects, are faster to search as an array:
+  contains_gtid() is a binary search over the intervals of the SIDNO,
+  and the set operations merge the sorted intervals of both sets,
+  without allocating intervals one by one.
+
+  The set operations assume that both sets use the same Sid_map, as
+  Gtid_set::add_gtid_set() does in its common case.
+*/
+class Compact_gtid_set
+{
+public:
+  Compact_gtid_set() : offsets(1, 0) {}
+  /**
+    Constructs a copy of the given Gtid_set.
+
+    The caller must hold the sid_lock of the Gtid_set, as for
+    iterating over it.
+  */
+  Compact_gtid_set(const Gtid_set *gtid_set) : offsets(1, 0)
+  { assign(gtid_set); }
+
+  /// Replace the contents of this set by those of the given Gtid_set.
+  void assign(const Gtid_set *gtid_set);
+  /**
+    Replace the contents of this set by those of the given Gtid_set,
+    numbering its SIDs as the given Sid_map does, so that this set can
+    be compared with sets copied from Gtid_sets of that Sid_map.  The
+    SIDs the Sid_map does not have are added to it.
+
+    @param gtid_set The Gtid_set to copy.
+    @param sid_map The Sid_map whose SIDNOs this set uses.
+    @return RETURN_STATUS_OK or RETURN_STATUS_REPORTED_ERROR.
+  */
+  enum_return_status assign(const Gtid_set *gtid_set, Sid_map *sid_map);
+  /// Removes all groups from this set.
+  void clear()
+  {
+    intervals.clear();
+    offsets.assign(1, 0);
+  }
+  /// Return true iff this set is empty.
+  bool is_empty() const { return intervals.empty(); }
+  /// Returns the maximal SIDNO this set has intervals for, or less.
+  rpl_sidno get_max_sidno() const { return (rpl_sidno) offsets.size() - 1; }
+  /// Returns the number of intervals of this set.
+  size_t get_n_intervals() const { return intervals.size(); }
+
+  /// Return true iff the given GTID exists in this set.
+  bool contains_gtid(rpl_sidno sidno, rpl_gno gno) const;
+  /// Return true iff the given GTID exists in this set.
+  bool contains_gtid(const Gtid &gtid) const
+  { return contains_gtid(gtid.sidno, gtid.gno); }
+  /// Returns true if this set is a subset of the other set.
+  bool is_subset(const Compact_gtid_set &super) const;
+  /**
+    Returns true if the groups of the given SIDNO of this set are a
+    subset of the groups of super_sidno in the given Gtid_set, as
+    Gtid_set::is_subset_for_sid() does.  A SIDNO of 0 means that the
+    set does not have the SID.
+  */
+  bool is_subset_for_sid(const Gtid_set *super, rpl_sidno super_sidno,
+                         rpl_sidno sidno) const;
+  /// Returns true if this set shares at least one GTID with the other set.
+  bool is_intersection_nonempty(const Compact_gtid_set &other) const;
+  /// Returns true if this set contains the same GTIDs as the other set.
+  bool equals(const Compact_gtid_set &other) const;
+
+  /// Adds all groups of the other set to this set.
+  void add_gtid_set(const Compact_gtid_set &other);
+  /// Removes all groups of the other set from this set.
+  void remove_gtid_set(const Compact_gtid_set &other);
+  /// Removes the groups which are not in the other set from this set.
+  void intersect_gtid_set(const Compact_gtid_set &other);
+
+  /**
+    Adds the groups of this set to the given Gtid_set, which must use
+    the same Sid_map.
+
+    @param gtid_set The Gtid_set to add to.
+    @return RETURN_STATUS_OK or RETURN_STATUS_REPORTED_ERROR.
+  */
+  enum_return_status to_gtid_set(Gtid_set *gtid_set) const;
+
+private:
+  /// An interval of GNOs, as Gtid_set::Interval without the list.
+  struct Interval
+  {
+    /// The first GNO of this interval.
+    rpl_gno start;
+    /// The first GNO after this interval.
+    rpl_gno end;
+  };
+
+  /// The set operations, which merge the intervals of two sets.
+  enum enum_merge { MERGE_UNION, MERGE_DIFFERENCE, MERGE_INTERSECTION };
+  void merge(const Compact_gtid_set &other, enum_merge op);
+  /**
+    Appends an interval to the intervals of the last SIDNO, which start
+    at sidno_start, joining it to the previous one if they touch.
+  */
+  static void append(std::vector<Interval> *ivs, size_t sidno_start,
+                     rpl_gno start, rpl_gno end);
+  /// Returns the number of intervals of the given SIDNO.
+  size_t n_intervals(rpl_sidno sidno) const
+  { return sidno <= get_max_sidno() ? offsets[sidno] - offsets[sidno - 1] : 0; }
+
+  /// Returns the first interval of the given SIDNO.
+  const Interval *begin(rpl_sidno sidno) const
+  { return intervals.data() + offsets[sidno - 1]; }
+  /// Returns the interval after the last one of the given SIDNO.
+  const Interval *end(rpl_sidno sidno) const
+  { return intervals.data() + offsets[sidno]; }
+
+  /// The intervals of all SIDNOs.
+  std::vector<Interval> intervals;
+  /**
+    The intervals of SIDNO N are those from offsets[N - 1] up to
+    offsets[N].
+  */
+  std::vector<size_t> offsets;
 };
 
 
@@ -0,0 +1,316 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "rpl_gtid_index.h"
+#include "my_sys.h"
+#include "unireg.h"                             // BIN_LOG_HEADER_SIZE
+
+#ifndef MYSQL_CLIENT
+#include "log.h"                                // sql_print_error
+#include "log_event.h"                          // Gtid_log_event
+#include "binlog.h"                             // open_binlog_file
+#include <mutex>
+#endif
+
+static const uchar GTID_INDEX_MAGIC[]= { 0xfe, 'g', 'i', 'x' };
+static const uint GTID_INDEX_ENTRY_HEADER_SIZE= 8 + 4;
+
+
+void Gtid_index::make_name(char *buf, const char *log_name)
+{
+  strxnmov(buf, FN_REFLEN - 1, log_name, GTID_INDEX_EXT, NullS);
+}
+
+
+/**
+  Read the index of a binary log up to the last entry whose set of logged
+  GTIDs can be skipped.
+*/
+
+bool Gtid_index::find(const char *log_name, Sid_map *sid_map,
+                      Skip_check can_skip, const void *arg,
+                      my_off_t max_pos, my_off_t *pos)
+{
+  char index_name[FN_REFLEN];
+  uchar *buf= NULL;
+  my_off_t length;
+  File file;
+  bool error= true;
+  DBUG_ENTER("Gtid_index::find");
+
+  *pos= BIN_LOG_HEADER_SIZE;
+  make_name(index_name, log_name);
+  if ((file= my_open(index_name, O_RDONLY | O_BINARY, MYF(0))) < 0)
+    DBUG_RETURN(true);
+
+  length= my_seek(file, 0L, MY_SEEK_END, MYF(0));
+  if (length == MY_FILEPOS_ERROR || length < sizeof(GTID_INDEX_MAGIC) ||
+      my_seek(file, 0L, MY_SEEK_SET, MYF(0)) == MY_FILEPOS_ERROR ||
+      !(buf= (uchar*) my_malloc((size_t) length, MYF(0))) ||
+      my_read(file, buf, (size_t) length, MYF(MY_NABP)) ||
+      memcmp(buf, GTID_INDEX_MAGIC, sizeof(GTID_INDEX_MAGIC)))
+    goto end;
+  error= false;
+
+  {
+    Gtid_set logged(sid_map);
+    const uchar *entry= buf + sizeof(GTID_INDEX_MAGIC);
+    const uchar *const end= buf + length;
+    while ((size_t) (end - entry) >= GTID_INDEX_ENTRY_HEADER_SIZE)
+    {
+      const my_off_t entry_pos= uint8korr(entry);
+      const size_t set_length= uint4korr(entry + 8);
+      const uchar *set= entry + GTID_INDEX_ENTRY_HEADER_SIZE;
+      if ((size_t) (end - set) < set_length || entry_pos > max_pos)
+        break;
+      logged.clear();
+      if (logged.add_gtid_encoding(set, set_length) != RETURN_STATUS_OK ||
+          !can_skip(&logged, arg))
+        break;
+      *pos= entry_pos;
+      entry= set + set_length;
+    }
+  }
+
+end:
+  my_free(buf);
+  my_close(file, MYF(0));
+  DBUG_PRINT("info", ("index of %s: error %d pos %llu", log_name, error,
+                      (ulonglong) *pos));
+  DBUG_RETURN(error);
+}
+
+
+static bool is_subset_of(const Gtid_set *logged, const void *arg)
+{
+  return logged->is_subset(static_cast<const Gtid_set*>(arg));
+}
+
+
+bool Gtid_index::find_start(const char *log_name, const Gtid_set *skip,
+                            my_off_t max_pos, my_off_t *pos)
+{
+  Sid_map sid_map(NULL);
+  return find(log_name, &sid_map, is_subset_of, skip, max_pos, pos);
+}
+
+
+static bool lacks_gtid(const Gtid_set *logged, const void *arg)
+{
+  return !logged->contains_gtid(*static_cast<const Gtid*>(arg));
+}
+
+
+bool Gtid_index::find_gtid(const char *log_name, const Gtid &gtid,
+                           Sid_map *sid_map, my_off_t *pos)
+{
+  return find(log_name, sid_map, lacks_gtid, &gtid, MY_FILEPOS_ERROR, pos);
+}
+
+
+#ifndef MYSQL_CLIENT
+
+Gtid_index::Gtid_index()
+  : m_file(-1), m_interval(0), m_transactions(0), m_sid_map(NULL),
+    m_logged(&m_sid_map)
+{}
+
+
+bool Gtid_index::create(const char *index_name, ulong interval)
+{
+  DBUG_ENTER("Gtid_index::create");
+  DBUG_ASSERT(m_file < 0);
+
+  m_interval= interval;
+  m_transactions= 0;
+  m_logged.clear();
+  m_sid_map.clear();
+  m_sidnos.clear();
+  if ((m_file= my_open(index_name, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY,
+                       MYF(MY_WME))) < 0)
+    DBUG_RETURN(true);
+  if (my_write(m_file, GTID_INDEX_MAGIC, sizeof(GTID_INDEX_MAGIC),
+               MYF(MY_WME | MY_NABP)))
+  {
+    close();
+    DBUG_RETURN(true);
+  }
+  DBUG_RETURN(false);
+}
+
+
+void Gtid_index::open(const char *log_name, ulong interval)
+{
+  char index_name[FN_REFLEN];
+  DBUG_ENTER("Gtid_index::open");
+
+  close();
+  if (!interval)
+    DBUG_VOID_RETURN;
+  make_name(index_name, log_name);
+  if (create(index_name, interval))
+    sql_print_error("Could not create the GTID index %s of binary log %s; "
+                    "the log is read from its beginning when looking for "
+                    "GTIDs.", index_name, log_name);
+  DBUG_VOID_RETURN;
+}
+
+
+void Gtid_index::close()
+{
+  if (m_file >= 0)
+  {
+    my_close(m_file, MYF(0));
+    m_file= -1;
+  }
+}
+
+
+/**
+  Account for a transaction, writing an entry for it first if it is the
+  next one to have an entry.
+
+  @param sidno  SIDNO of the transaction on m_sid_map
+  @param gno    GNO of the transaction
+  @param pos    Offset of its Gtid_log_event
+
+  @retval false  Ok
+  @retval true   Error, the index has been closed
+*/
+
+bool Gtid_index::append(rpl_sidno sidno, rpl_gno gno, my_off_t pos)
+{
+  if (m_transactions++ % m_interval == 0)
+  {
+    const size_t set_length= m_logged.get_encoded_length();
+    m_buffer.resize(GTID_INDEX_ENTRY_HEADER_SIZE + set_length);
+    int8store(&m_buffer[0], pos);
+    int4store(&m_buffer[8], (uint32) set_length);
+    m_logged.encode(&m_buffer[GTID_INDEX_ENTRY_HEADER_SIZE]);
+    if (my_write(m_file, &m_buffer[0], m_buffer.size(),
+                 MYF(MY_WME | MY_NABP)))
+    {
+      close();
+      return true;
+    }
+  }
+  if (m_logged.ensure_sidno(sidno) != RETURN_STATUS_OK ||
+      m_logged._add_gtid(sidno, gno) != RETURN_STATUS_OK)
+  {
+    close();
+    return true;
+  }
+  return false;
+}
+
+
+void Gtid_index::add_transaction(const Gtid &gtid, my_off_t pos)
+{
+  if (m_file < 0)
+    return;
+
+  DBUG_ASSERT(gtid.sidno > 0);
+  if ((size_t) gtid.sidno >= m_sidnos.size())
+    m_sidnos.resize(gtid.sidno + 1, 0);
+  if (!m_sidnos[gtid.sidno])
+  {
+    /* SIDNOs of global_sid_map keep their SID until the log is reset */
+    global_sid_lock->rdlock();
+    const rpl_sid sid= global_sid_map->sidno_to_sid(gtid.sidno);
+    global_sid_lock->unlock();
+    if ((m_sidnos[gtid.sidno]= m_sid_map.add_sid(sid)) <= 0)
+    {
+      close();
+      return;
+    }
+  }
+  if (append(m_sidnos[gtid.sidno], gtid.gno, pos))
+    sql_print_error("Could not write the GTID index of the binary log; "
+                    "the log is read from its beginning when looking for "
+                    "GTIDs.");
+}
+
+
+/// Serializes the builds of missing indexes
+static std::mutex build_mutex;
+
+
+bool Gtid_index::build(const char *log_name, ulong interval)
+{
+  char index_name[FN_REFLEN], tmp_name[FN_REFLEN];
+  const char *errmsg= NULL;
+  Format_description_log_event fd_ev(BINLOG_VERSION);
+  Gtid_index index;
+  IO_CACHE log;
+  File file;
+  Log_event *ev;
+  my_off_t pos;
+  bool error= true;
+  DBUG_ENTER("Gtid_index::build");
+
+  make_name(index_name, log_name);
+  std::lock_guard<std::mutex> lock(build_mutex);
+  if (!my_access(index_name, F_OK))
+    DBUG_RETURN(false);
+  if (!interval || !fd_ev.is_valid())
+    DBUG_RETURN(true);
+
+  strxnmov(tmp_name, FN_REFLEN - 1, index_name, ".tmp", NullS);
+  if ((file= open_binlog_file(&log, log_name, &errmsg)) < 0)
+  {
+    sql_print_error("%s", errmsg);
+    DBUG_RETURN(true);
+  }
+  if (index.create(tmp_name, interval))
+    goto end;
+
+  pos= my_b_tell(&log);
+  while ((ev= Log_event::read_log_event(&log, 0, &fd_ev, false, NULL)) != NULL)
+  {
+    if (ev->get_type_code() == GTID_LOG_EVENT)
+    {
+      Gtid_log_event *gtid_ev= static_cast<Gtid_log_event*>(ev);
+      const rpl_sidno sidno= index.m_sid_map.add_sid(*gtid_ev->get_sid());
+      if (sidno <= 0 || index.append(sidno, gtid_ev->get_gno(), pos))
+      {
+        delete ev;
+        goto end;
+      }
+    }
+    delete ev;
+    pos= my_b_tell(&log);
+  }
+
+  index.close();
+  error= my_rename(tmp_name, index_name, MYF(MY_WME));
+
+end:
+  index.close();
+  if (error)
+    my_delete(tmp_name, MYF(0));
+  end_io_cache(&log);
+  mysql_file_close(file, MYF(MY_WME));
+  DBUG_RETURN(error);
+}
+
+
+void Gtid_index::remove(const char *log_name)
+{
+  char index_name[FN_REFLEN];
+  make_name(index_name, log_name);
+  my_delete(index_name, MYF(0));
+}
+
+#endif /* MYSQL_CLIENT */
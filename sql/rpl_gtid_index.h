@@ -0,0 +1,143 @@
+#ifndef RPL_GTID_INDEX_INCLUDED
+#define RPL_GTID_INDEX_INCLUDED
+
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/** @file Sparse index from the GTIDs of a binary log to offsets in it */
+
+#include "my_global.h"
+#include "rpl_gtid.h"
+#include <vector>
+
+/// Extension of an index file, appended to the name of its binary log
+#define GTID_INDEX_EXT ".gtid_index"
+
+/**
+  Sparse index of the transactions of a binary log, kept in a file named
+  after the log with GTID_INDEX_EXT appended.
+
+  For every binlog_gtid_index_interval-th transaction of the log, the
+  index has an entry with the offset of the transaction's Gtid_log_event
+  and the set of GTIDs logged in the file before it. As these sets only
+  grow, a reader that knows which GTIDs it can skip takes the last entry
+  whose set it can skip as a whole, and starts reading the log at its
+  offset rather than at the beginning of the file.
+
+  The file starts with GTID_INDEX_MAGIC, followed by the entries:
+
+    8 bytes  offset of the Gtid_log_event
+    4 bytes  length of the encoded set
+    n bytes  set of GTIDs logged before, see Gtid_set::encode()
+
+  Entries are appended as transactions are written to the binary log, so
+  readers limit the offsets they take to the part of the log they can
+  read, and an incomplete last entry is ignored. The index of a log which
+  is truncated or appended to after a restart is removed, and the server
+  builds the missing index of a log that is no longer written to the
+  first time it needs it.
+*/
+class Gtid_index
+{
+public:
+  /**
+    Find where to start reading a binary log for the transactions which
+    are not in skip.
+
+    @param      log_name  Binary log
+    @param      skip      GTIDs whose transactions need not be read
+    @param      max_pos   Offsets beyond this are not taken
+    @param[out] pos       Offset to start reading at, or
+                          BIN_LOG_HEADER_SIZE
+
+    @retval false  Ok
+    @retval true   The log has no readable index
+  */
+  static bool find_start(const char *log_name, const Gtid_set *skip,
+                         my_off_t max_pos, my_off_t *pos);
+
+  /**
+    Find where to start looking for the transaction of a GTID in a binary
+    log.
+
+    @param      log_name  Binary log
+    @param      gtid      GTID to look for
+    @param      sid_map   Sid_map of gtid
+    @param[out] pos       Offset to start reading at, or
+                          BIN_LOG_HEADER_SIZE
+
+    @retval false  Ok
+    @retval true   The log has no readable index
+  */
+  static bool find_gtid(const char *log_name, const Gtid &gtid,
+                        Sid_map *sid_map, my_off_t *pos);
+
+#ifndef MYSQL_CLIENT
+  Gtid_index();
+  ~Gtid_index() { close(); }
+
+  /**
+    Start the index of a new binary log, with an entry for every interval
+    transactions. Does nothing if interval is 0.
+  */
+  void open(const char *log_name, ulong interval);
+
+  /**
+    Account for a transaction written to the binary log.
+
+    @param gtid  GTID of the transaction, with a SIDNO of global_sid_map
+    @param pos   Offset of the transaction's Gtid_log_event
+  */
+  void add_transaction(const Gtid &gtid, my_off_t pos);
+
+  void close();
+
+  /**
+    Build the index of a binary log which is no longer written to, unless
+    it already has one.
+
+    @retval false  The log has an index
+    @retval true   Error
+  */
+  static bool build(const char *log_name, ulong interval);
+
+  /// Delete the index of a binary log, if it has one
+  static void remove(const char *log_name);
+#endif
+
+private:
+  typedef bool (*Skip_check)(const Gtid_set *logged, const void *arg);
+
+  static bool find(const char *log_name, Sid_map *sid_map,
+                   Skip_check can_skip, const void *arg,
+                   my_off_t max_pos, my_off_t *pos);
+  static void make_name(char *buf, const char *log_name);
+
+#ifndef MYSQL_CLIENT
+  bool create(const char *index_name, ulong interval);
+  bool append(rpl_sidno sidno, rpl_gno gno, my_off_t pos);
+
+  File m_file;
+  ulong m_interval;
+  ulonglong m_transactions;          ///< Transactions accounted for
+  Sid_map m_sid_map;
+  Gtid_set m_logged;                 ///< GTIDs logged, on m_sid_map
+  /// SIDNOs of m_sid_map by SIDNO of global_sid_map, 0 if not mapped yet
+  std::vector<rpl_sidno> m_sidnos;
+  std::vector<uchar> m_buffer;
+#endif
+};
+
+#endif /* RPL_GTID_INDEX_INCLUDED */
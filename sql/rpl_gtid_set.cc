@@ -1490,3 +1490,309 @@ size_t Gtid_set::get_encoded_length() const
       ret+= 16 + 8 + 2 * 8 * get_n_intervals(sidno);
   return ret;
 }
+
+
+void Compact_gtid_set::assign(const Gtid_set *gtid_set)
+{
+  DBUG_ENTER("Compact_gtid_set::assign");
+  if (gtid_set->sid_lock != NULL)
+    gtid_set->sid_lock->assert_some_lock();
+  rpl_sidno max_sidno= gtid_set->get_max_sidno();
+  clear();
+  offsets.reserve(max_sidno + 1);
+  for (rpl_sidno sidno= 1; sidno <= max_sidno; sidno++)
+  {
+    Gtid_set::Const_interval_iterator ivit(gtid_set, sidno);
+    const Gtid_set::Interval *iv;
+    while ((iv= ivit.get()) != NULL)
+    {
+      Interval interval= { iv->start, iv->end };
+      intervals.push_back(interval);
+      ivit.next();
+    }
+    offsets.push_back(intervals.size());
+  }
+  DBUG_VOID_RETURN;
+}
+
+
+enum_return_status Compact_gtid_set::assign(const Gtid_set *gtid_set,
+                                            Sid_map *sid_map)
+{
+  DBUG_ENTER("Compact_gtid_set::assign(Sid_map *)");
+  const Sid_map *set_sid_map= gtid_set->get_sid_map();
+  if (set_sid_map == sid_map || set_sid_map == NULL || sid_map == NULL)
+  {
+    assign(gtid_set);
+    RETURN_OK;
+  }
+  if (gtid_set->sid_lock != NULL)
+    gtid_set->sid_lock->assert_some_lock();
+
+  // The SIDNO of sid_map of each SIDNO of gtid_set which has intervals.
+  rpl_sidno max_sidno= gtid_set->get_max_sidno();
+  std::vector<rpl_sidno> set_sidnos;
+  for (rpl_sidno sidno= 1; sidno <= max_sidno; sidno++)
+  {
+    Gtid_set::Const_interval_iterator ivit(gtid_set, sidno);
+    if (ivit.get() == NULL)
+      continue;
+    const rpl_sid &sid= set_sid_map->sidno_to_sid(sidno);
+    rpl_sidno map_sidno= sid_map->sid_to_sidno(sid);
+    if (map_sidno == 0 && (map_sidno= sid_map->add_sid(sid)) <= 0)
+      RETURN_REPORTED_ERROR;
+    if ((rpl_sidno) set_sidnos.size() <= map_sidno)
+      set_sidnos.resize(map_sidno + 1, 0);
+    set_sidnos[map_sidno]= sidno;
+  }
+
+  // Copy the intervals in the order of the SIDNOs of sid_map.
+  clear();
+  offsets.reserve(set_sidnos.size() + 1);
+  for (size_t map_sidno= 1; map_sidno < set_sidnos.size(); map_sidno++)
+  {
+    if (set_sidnos[map_sidno] != 0)
+    {
+      Gtid_set::Const_interval_iterator ivit(gtid_set, set_sidnos[map_sidno]);
+      const Gtid_set::Interval *iv;
+      while ((iv= ivit.get()) != NULL)
+      {
+        Interval interval= { iv->start, iv->end };
+        intervals.push_back(interval);
+        ivit.next();
+      }
+    }
+    offsets.push_back(intervals.size());
+  }
+  RETURN_OK;
+}
+
+
+bool Compact_gtid_set::contains_gtid(rpl_sidno sidno, rpl_gno gno) const
+{
+  DBUG_ASSERT(sidno >= 1 && gno >= 1);
+  if (sidno > get_max_sidno())
+    return false;
+  /* The first interval starting after gno, preceded by the only one
+     which may contain it. */
+  const Interval *first= begin(sidno);
+  const Interval *iv=
+    std::upper_bound(first, end(sidno), gno,
+                     [](rpl_gno g, const Interval &i) { return g < i.start; });
+  return iv != first && gno < (iv - 1)->end;
+}
+
+
+bool Compact_gtid_set::is_subset(const Compact_gtid_set &super) const
+{
+  DBUG_ENTER("Compact_gtid_set::is_subset");
+  for (rpl_sidno sidno= 1; sidno <= get_max_sidno(); sidno++)
+  {
+    if (n_intervals(sidno) == 0)
+      continue;
+    if (super.n_intervals(sidno) == 0)
+      DBUG_RETURN(false);
+    const Interval *super_iv= super.begin(sidno);
+    const Interval *super_end= super.end(sidno);
+    for (const Interval *iv= begin(sidno); iv != end(sidno); iv++)
+    {
+      // Skip over the intervals of super which end before iv.
+      while (super_iv != super_end && super_iv->end < iv->end)
+        super_iv++;
+      if (super_iv == super_end || iv->start < super_iv->start)
+        DBUG_RETURN(false);
+    }
+  }
+  DBUG_RETURN(true);
+}
+
+
+bool Compact_gtid_set::is_subset_for_sid(const Gtid_set *super,
+                                         rpl_sidno super_sidno,
+                                         rpl_sidno sidno) const
+{
+  DBUG_ENTER("Compact_gtid_set::is_subset_for_sid");
+  if (super->sid_lock != NULL)
+    super->sid_lock->assert_some_lock();
+  if (sidno == 0 || n_intervals(sidno) == 0)
+    DBUG_RETURN(true);
+  if (super_sidno == 0 || super_sidno > super->get_max_sidno())
+    DBUG_RETURN(false);
+  Gtid_set::Const_interval_iterator super_ivit(super, super_sidno);
+  for (const Interval *iv= begin(sidno); iv != end(sidno); iv++)
+  {
+    // Skip over the intervals of super which end before iv.
+    const Gtid_set::Interval *super_iv;
+    while ((super_iv= super_ivit.get()) != NULL && super_iv->end < iv->end)
+      super_ivit.next();
+    if (super_iv == NULL || iv->start < super_iv->start)
+      DBUG_RETURN(false);
+  }
+  DBUG_RETURN(true);
+}
+
+
+bool
+Compact_gtid_set::is_intersection_nonempty(const Compact_gtid_set &other) const
+{
+  DBUG_ENTER("Compact_gtid_set::is_intersection_nonempty");
+  rpl_sidno max_sidno= min(get_max_sidno(), other.get_max_sidno());
+  for (rpl_sidno sidno= 1; sidno <= max_sidno; sidno++)
+  {
+    const Interval *iv1= begin(sidno), *end1= end(sidno);
+    const Interval *iv2= other.begin(sidno), *end2= other.end(sidno);
+    while (iv1 != end1 && iv2 != end2)
+    {
+      if (iv1->end <= iv2->start)
+        iv1++;
+      else if (iv2->end <= iv1->start)
+        iv2++;
+      else
+        DBUG_RETURN(true);
+    }
+  }
+  DBUG_RETURN(false);
+}
+
+
+bool Compact_gtid_set::equals(const Compact_gtid_set &other) const
+{
+  rpl_sidno max_sidno= max(get_max_sidno(), other.get_max_sidno());
+  for (rpl_sidno sidno= 1; sidno <= max_sidno; sidno++)
+  {
+    size_t n= n_intervals(sidno);
+    if (n != other.n_intervals(sidno))
+      return false;
+    const Interval *iv1= begin(sidno), *iv2= other.begin(sidno);
+    for (size_t i= 0; i < n; i++)
+      if (iv1[i].start != iv2[i].start || iv1[i].end != iv2[i].end)
+        return false;
+  }
+  return true;
+}
+
+
+void Compact_gtid_set::append(std::vector<Interval> *ivs, size_t sidno_start,
+                              rpl_gno start, rpl_gno end)
+{
+  if (start >= end)
+    return;
+  if (ivs->size() > sidno_start && ivs->back().end >= start)
+  {
+    if (ivs->back().end < end)
+      ivs->back().end= end;
+    return;
+  }
+  Interval interval= { start, end };
+  ivs->push_back(interval);
+}
+
+
+void Compact_gtid_set::merge(const Compact_gtid_set &other, enum_merge op)
+{
+  DBUG_ENTER("Compact_gtid_set::merge");
+  rpl_sidno max_sidno= op == MERGE_UNION ?
+    max(get_max_sidno(), other.get_max_sidno()) : get_max_sidno();
+  std::vector<Interval> merged;
+  std::vector<size_t> merged_offsets(1, 0);
+  merged.reserve(op == MERGE_UNION ?
+                 intervals.size() + other.intervals.size() : intervals.size());
+  merged_offsets.reserve(max_sidno + 1);
+
+  for (rpl_sidno sidno= 1; sidno <= max_sidno; sidno++)
+  {
+    const size_t sidno_start= merged.size();
+    const Interval *iv1= n_intervals(sidno) ? begin(sidno) : NULL;
+    const Interval *end1= iv1 ? end(sidno) : NULL;
+    const Interval *iv2= other.n_intervals(sidno) ? other.begin(sidno) : NULL;
+    const Interval *end2= iv2 ? other.end(sidno) : NULL;
+
+    switch (op)
+    {
+    case MERGE_UNION:
+      // Append the intervals of both sets in the order they start.
+      while (iv1 != end1 || iv2 != end2)
+      {
+        const Interval *iv;
+        if (iv2 == end2 || (iv1 != end1 && iv1->start <= iv2->start))
+          iv= iv1++;
+        else
+          iv= iv2++;
+        append(&merged, sidno_start, iv->start, iv->end);
+      }
+      break;
+    case MERGE_DIFFERENCE:
+      // Cut the intervals of other out of each interval of this set.
+      for (; iv1 != end1; iv1++)
+      {
+        rpl_gno start= iv1->start;
+        while (iv2 != end2 && iv2->end <= start)
+          iv2++;
+        for (const Interval *iv= iv2;
+             iv != end2 && iv->start < iv1->end && start < iv1->end; iv++)
+        {
+          append(&merged, sidno_start, start, iv->start);
+          start= max(start, iv->end);
+        }
+        append(&merged, sidno_start, start, iv1->end);
+      }
+      break;
+    case MERGE_INTERSECTION:
+      // Keep the overlap of each pair of intervals.
+      while (iv1 != end1 && iv2 != end2)
+      {
+        append(&merged, sidno_start,
+               max(iv1->start, iv2->start), min(iv1->end, iv2->end));
+        if (iv1->end < iv2->end)
+          iv1++;
+        else
+          iv2++;
+      }
+      break;
+    }
+    merged_offsets.push_back(merged.size());
+  }
+
+  intervals.swap(merged);
+  offsets.swap(merged_offsets);
+  DBUG_VOID_RETURN;
+}
+
+
+void Compact_gtid_set::add_gtid_set(const Compact_gtid_set &other)
+{
+  merge(other, MERGE_UNION);
+}
+
+
+void Compact_gtid_set::remove_gtid_set(const Compact_gtid_set &other)
+{
+  merge(other, MERGE_DIFFERENCE);
+}
+
+
+void Compact_gtid_set::intersect_gtid_set(const Compact_gtid_set &other)
+{
+  merge(other, MERGE_INTERSECTION);
+}
+
+
+enum_return_status Compact_gtid_set::to_gtid_set(Gtid_set *gtid_set) const
+{
+  DBUG_ENTER("Compact_gtid_set::to_gtid_set");
+  rpl_sidno max_sidno= get_max_sidno();
+  while (max_sidno > 0 && n_intervals(max_sidno) == 0)
+    max_sidno--;
+  if (max_sidno == 0)
+    RETURN_OK;
+  PROPAGATE_REPORTED_ERROR(gtid_set->ensure_sidno(max_sidno));
+  Gtid_set::Free_intervals_lock lock(gtid_set);
+  for (rpl_sidno sidno= 1; sidno <= max_sidno; sidno++)
+  {
+    Gtid_set::Interval_iterator ivit(gtid_set, sidno);
+    for (const Interval *iv= begin(sidno); iv != end(sidno); iv++)
+      PROPAGATE_REPORTED_ERROR(gtid_set->add_gno_interval(&ivit, iv->start,
+                                                          iv->end, &lock));
+  }
+  RETURN_OK;
+}
@@ -1980,6 +1980,100 @@ static bool set_dscp(THD *thd) {
   return true;
 }
 
+/**
+  Find where to start sending a binlog to a slave using the GTID protocol,
+  from the binlog's GTID index. The index of a binlog that is no longer
+  written to is built if it is missing.
+
+  @param log_name             Binlog to send
+  @param log                  The binlog, opened for reading
+  @param slave_gtid_executed  GTIDs the slave has
+
+  @return Offset of the first transaction of the index which the slave
+          may not have, or BIN_LOG_HEADER_SIZE
+*/
+static my_off_t gtid_index_start_pos(const char *log_name, IO_CACHE *log,
+                                     const Gtid_set *slave_gtid_executed)
+{
+  my_off_t max_pos, pos;
+
+  if (!opt_binlog_gtid_index_interval || dump_log.is_relay_log())
+    return BIN_LOG_HEADER_SIZE;
+  if (dump_log.is_active(log_name))
+    max_pos= dump_log.get_binlog_end_pos_without_lock();
+  else
+  {
+    (void) Gtid_index::build(log_name, opt_binlog_gtid_index_interval);
+    max_pos= my_b_filelength(log);
+  }
+  (void) Gtid_index::find_start(log_name, slave_gtid_executed, max_pos, &pos);
+  return pos;
+}
+
+
+/**
+  Read the next event of the binary log being sent, from the binlog tail
+  cache if it has the event, else from the file. Counts the events read
+  from the file while the cache is enabled as misses.
+
+  The arguments and return values are those of Log_event::read_log_event().
+*/
+static int read_dump_event(IO_CACHE *log, String *packet, uint8 checksum_alg,
+                           const char *log_file_name,
+                           bool *is_active_binlog= NULL)
+{
+  if (!opt_binlog_tail_cache_size)
+    return Log_event::read_log_event(log, packet, checksum_alg, log_file_name,
+                                     is_active_binlog);
+
+  const uint32 ev_offset= packet->length();
+  my_off_t next_pos;
+  if (mysql_bin_log.get_tail_cache()->read_event(
+        log_file_name, my_b_tell(log),
+        max(current_thd->variables.max_allowed_packet,
+            opt_binlog_rows_event_max_size + MAX_LOG_EVENT_HEADER),
+        packet, &next_pos))
+  {
+    if (opt_master_verify_checksum &&
+        event_checksum_test((uchar*) packet->ptr() + ev_offset,
+                            packet->length() - ev_offset, checksum_alg))
+      return LOG_READ_CHECKSUM_FAILURE;
+    my_b_seek(log, next_pos);
+    if (is_active_binlog)
+      *is_active_binlog= dump_log.is_active(log_file_name);
+    my_atomic_add64((int64*) &binlog_tail_cache_hits, 1);
+    return 0;
+  }
+
+  const int error= Log_event::read_log_event(log, packet, checksum_alg,
+                                             log_file_name, is_active_binlog);
+  if (!error)
+    my_atomic_add64((int64*) &binlog_tail_cache_misses, 1);
+  return error;
+}
+
+/**
+  Returns true if the given GTIDs are all in the GTIDs of the slave.
+
+  The set is copied with the SIDNOs of the slave, which can be compared
+  with the compact copy of the slave's GTIDs.  If the copy fails, the
+  linked lists are compared.
+
+  @param gtid_set             GTIDs of the master
+  @param slave_gtid_executed  GTIDs the slave has
+  @param slave_gtids          compact copy of slave_gtid_executed
+*/
+static bool is_subset_of_slave_gtids(const Gtid_set *gtid_set,
+                                     const Gtid_set *slave_gtid_executed,
+                                     const Compact_gtid_set &slave_gtids)
+{
+  Compact_gtid_set compact;
+  if (compact.assign(gtid_set, slave_gtid_executed->get_sid_map()) !=
+      RETURN_STATUS_OK)
+    return gtid_set->is_subset(slave_gtid_executed);
+  return compact.is_subset(slave_gtids);
+}
+
 void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
                        const Gtid_set* slave_gtid_executed, int flags)
 {
@@ -2005,6 +2099,14 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
   bool has_transmit_started= false;
   bool gtid_event_logged = false;
   Sid_map *sid_map= slave_gtid_executed ? slave_gtid_executed->get_sid_map() : NULL;
+  /*
+    The GTIDs of the slave are searched for every transaction sent, which
+    is a binary search in the compact copy, and compared with the GTIDs of
+    the master when the slave connects.
+  */
+  Compact_gtid_set slave_gtids;
+  if (using_gtid_protocol)
+    slave_gtids.assign(slave_gtid_executed);
   USER_STATS *us= thd_get_user_stats(thd);
   ulonglong cur_timer = my_timer_now();
 
@@ -2191,9 +2293,9 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
       global_sid_lock->wrlock();
       const rpl_sid &server_sid= gtid_state->get_server_sid();
       rpl_sidno subset_sidno= slave_sid_map->sid_to_sidno(server_sid);
-      if (!slave_gtid_executed->is_subset_for_sid(gtid_state->get_logged_gtids(),
-                                                  gtid_state->get_server_sidno(),
-                                                  subset_sidno))
+      if (!slave_gtids.is_subset_for_sid(gtid_state->get_logged_gtids(),
+                                         gtid_state->get_server_sidno(),
+                                         subset_sidno))
       {
         errmsg= ER(ER_SLAVE_HAS_MORE_GTIDS_THAN_MASTER);
         my_errno= ER_MASTER_FATAL_ERROR_READING_BINLOG;
@@ -2230,7 +2332,9 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
       if (!enable_raft_plugin)
       {
         const Gtid_set *lost_gtids= gtid_state->get_lost_gtids();
-        lost_gtids_is_subset= lost_gtids->is_subset(slave_gtid_executed);
+        lost_gtids_is_subset=
+          is_subset_of_slave_gtids(lost_gtids, slave_gtid_executed,
+                                   slave_gtids);
         global_sid_lock->unlock();
       }
       else
@@ -2247,7 +2351,9 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
         Sid_map gtids_lost_sid_map(nullptr);
         Gtid_set gtids_lost(&gtids_lost_sid_map);
         dump_log.get_lost_gtids(&gtids_lost);
-        lost_gtids_is_subset= gtids_lost.is_subset(slave_gtid_executed);
+        lost_gtids_is_subset=
+          is_subset_of_slave_gtids(&gtids_lost, slave_gtid_executed,
+                                   slave_gtids);
       }
 
       if (!lost_gtids_is_subset)
@@ -2298,6 +2404,17 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
   */
   log.extend(thd);
 
+  if (using_gtid_protocol && pos == BIN_LOG_HEADER_SIZE)
+  {
+    /*
+      Start after the transactions of the binlog which the slave has. The
+      Previous_gtids_log_event at the start of the binlog is skipped too.
+    */
+    pos= gtid_index_start_pos(log_file_name, &log, slave_gtid_executed);
+    if (pos > BIN_LOG_HEADER_SIZE)
+      binlog_has_previous_gtids_log_event= true;
+  }
+
   if (pos < BIN_LOG_HEADER_SIZE)
   {
     errmsg= "Client requested master to start replication from position < 4";
@@ -2495,10 +2612,8 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
       GOTO_ERR;
     bool is_active_binlog= false;
     while (!thd->killed &&
-           !(error= Log_event::read_log_event(&log, packet,
-                                              current_checksum_alg,
-                                              log_file_name,
-                                              &is_active_binlog)))
+           !(error= read_dump_event(&log, packet, current_checksum_alg,
+                                    log_file_name, &is_active_binlog)))
     {
       DBUG_EXECUTE_IF("simulate_dump_thread_kill",
                       {
@@ -2584,8 +2699,7 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
         if (using_gtid_protocol && created > 0)
         {
           if (first_gtid.sidno >= 1 && first_gtid.gno >= 1 &&
-              slave_gtid_executed->contains_gtid(first_gtid.sidno,
-                                                 first_gtid.gno))
+              slave_gtids.contains_gtid(first_gtid.sidno, first_gtid.gno))
           {
             /*
               As we are skipping at least the first transaction of the binlog,
@@ -2638,8 +2752,8 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
           Gtid_log_event gtid_ev(packet->ptr() + ev_offset,
                                  packet->length() - checksum_size,
                                  p_fdle);
-          skip_group= slave_gtid_executed->contains_gtid(gtid_ev.get_sidno(sid_map),
-                                                     gtid_ev.get_gno());
+          skip_group= slave_gtids.contains_gtid(gtid_ev.get_sidno(sid_map),
+                                                gtid_ev.get_gno());
           searching_first_gtid= skip_group;
           DBUG_PRINT("info", ("Dumping GTID sidno(%d) gno(%lld) skip group(%d) "
                               "searching gtid(%d).",
@@ -2928,9 +3042,8 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
           has not been updated since last read.
 	*/
 
-        switch (error= Log_event::read_log_event(&log, packet,
-                                                 current_checksum_alg,
-                                                 log_file_name)) {
+        switch (error= read_dump_event(&log, packet, current_checksum_alg,
+                                       log_file_name)) {
 	case 0:
           DBUG_PRINT("info", ("read_log_event returned 0 on line %d",
                               __LINE__));
@@ -3176,8 +3289,8 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
                                      packet->length() - checksum_size,
                                      p_fdle);
               skip_group=
-                slave_gtid_executed->contains_gtid(gtid_ev.get_sidno(sid_map),
-                                               gtid_ev.get_gno());
+                slave_gtids.contains_gtid(gtid_ev.get_sidno(sid_map),
+                                          gtid_ev.get_gno());
               searching_first_gtid= skip_group;
               DBUG_PRINT("info", ("Dumping GTID sidno(%d) gno(%lld) "
                                   "skip group(%d) searching gtid(%d).",
@@ -4009,6 +4122,10 @@ uint find_gtid_position_helper(const char* gtid_string,
         previous_gtid_set_map anymore.
       */
       mysql_bin_log.unlock_index();
+      if (opt_binlog_gtid_index_interval &&
+          !mysql_bin_log.is_active(rit->first.c_str()))
+        (void) Gtid_index::build(rit->first.c_str(),
+                                 opt_binlog_gtid_index_interval);
       gtid_pos = find_gtid_pos_in_log(rit->first.c_str(), gtid, &sid_map);
       if (!gtid_pos)
       {
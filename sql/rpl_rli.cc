@@ -116,7 +116,7 @@ Relay_log_info::Relay_log_info(bool is_slave_recovery
    until_log_pos(0),
    until_sql_gtids(global_sid_map),
    until_sql_gtids_first_event(true),
-   retried_trans(0),
+   retried_trans(0), prefetcher(NULL),
    tables_to_lock(0), tables_to_lock_count(0),
    rows_query_ev(NULL), last_event_start_time(0), deferred_events(NULL),
    curr_group_seen_gtid(false),
@@ -1389,6 +1389,10 @@ int Relay_log_info::purge_relay_logs(THD *thd, bool just_reset,
     cur_log_fd= -1;
   }
 
+  mysql_mutex_lock(relay_log.get_log_lock());
+  event_queue.clear();
+  mysql_mutex_unlock(relay_log.get_log_lock());
+
   if (relay_log.reset_logs(thd))
   {
     *errmsg = "Failed during log reset";
@@ -25,6 +25,7 @@
 #include "log.h"                         /* LOG_INFO */
 #include "binlog.h"                      /* MYSQL_BIN_LOG */
 #include "sql_class.h"                   /* THD */
+#include "rpl_rli_event_queue.h"
 
 #if defined(HAVE_REPLICATION) && !defined(MYSQL_CLIENT)
 #include "log_event_wrapper.h"
@@ -36,6 +37,7 @@
 struct RPL_TABLE_LIST;
 class Master_info;
 class Commit_order_manager;
+class Slave_prefetcher;
 extern uint sql_slave_skip_counter;
 
 
@@ -442,6 +444,21 @@ public:
   char ign_master_log_name_end[FN_REFLEN];
   ulonglong ign_master_log_pos_end;
 
+  /*
+    Events the I/O thread has parsed, for the SQL thread to take rather
+    than reading them from the hot relay log. Protected by
+    relay_log.LOCK_log.
+  */
+  Relay_log_event_queue event_queue;
+
+  /*
+    Reads the relay log ahead of the SQL thread to warm the rows of its
+    row events, and the rows of large transactions ahead of the dependency
+    slave workers, when slave_prefetch_threads is set. Started and stopped
+    by the SQL thread.
+  */
+  Slave_prefetcher *prefetcher;
+
   /* 
     Indentifies where the SQL Thread should create temporary files for the
     LOAD DATA INFILE. This is used for security reasons.
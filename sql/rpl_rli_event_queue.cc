@@ -0,0 +1,116 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "rpl_rli_event_queue.h"
+
+Event_format::Event_format(const Format_description_log_event *fdle,
+                           Log_event_type type)
+  : binlog_version(fdle->binlog_version),
+    common_header_len(fdle->common_header_len),
+    post_header_len((uint) type <= fdle->number_of_event_types ?
+                    fdle->post_header_len[type - 1] : 0),
+    checksum_alg(fdle->checksum_alg)
+{
+  memcpy(server_version_split, fdle->server_version_split,
+         sizeof(server_version_split));
+}
+
+
+bool Event_format::operator==(const Event_format &other) const
+{
+  return (binlog_version == other.binlog_version &&
+          common_header_len == other.common_header_len &&
+          post_header_len == other.post_header_len &&
+          checksum_alg == other.checksum_alg &&
+          !memcmp(server_version_split, other.server_version_split,
+                  sizeof(server_version_split)));
+}
+
+
+/**
+  Events which change how the SQL thread reads the relay log are always
+  read from it.
+*/
+
+bool Relay_log_event_queue::can_queue(Log_event_type type)
+{
+  switch (type)
+  {
+  case FORMAT_DESCRIPTION_EVENT:
+  case START_EVENT_V3:
+  case ROTATE_EVENT:
+  case STOP_EVENT:
+    return false;
+  default:
+    return true;
+  }
+}
+
+
+void Relay_log_event_queue::push(Queued_event *qev)
+{
+  DBUG_ASSERT(qev->ev && qev->end_pos > qev->start_pos);
+  m_entries.push_back(*qev);
+  m_bytes+= (size_t) (qev->end_pos - qev->start_pos);
+  qev->ev= NULL;
+}
+
+
+void Relay_log_event_queue::pop_front()
+{
+  const Queued_event &front= m_entries.front();
+  m_bytes-= (size_t) (front.end_pos - front.start_pos);
+  m_entries.pop_front();
+}
+
+
+Log_event *Relay_log_event_queue::pop(uint32 open_count, my_off_t pos,
+                                      const Format_description_log_event *fdle,
+                                      my_off_t *end_pos)
+{
+  while (!m_entries.empty())
+  {
+    Queued_event &front= m_entries.front();
+    /* Events of a later relay log, or later in this one */
+    if (front.open_count > open_count ||
+        (front.open_count == open_count && front.start_pos > pos))
+      return NULL;
+
+    Log_event *ev= front.ev;
+    const bool at_pos= (front.open_count == open_count &&
+                        front.start_pos == pos);
+    const bool same_format=
+      at_pos && front.format == Event_format(fdle, ev->get_type_code());
+    *end_pos= front.end_pos;
+    pop_front();
+    if (same_format)
+      return ev;
+    /* An earlier event, or one the SQL thread would parse differently */
+    delete ev;
+    if (at_pos)
+      return NULL;
+  }
+  return NULL;
+}
+
+
+void Relay_log_event_queue::clear()
+{
+  while (!m_entries.empty())
+  {
+    delete m_entries.front().ev;
+    pop_front();
+  }
+}
@@ -0,0 +1,127 @@
+#ifndef RPL_RLI_EVENT_QUEUE_INCLUDED
+#define RPL_RLI_EVENT_QUEUE_INCLUDED
+
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file Events parsed by the slave I/O thread, handed to the SQL thread
+  along with the relay log
+*/
+
+#include "my_global.h"
+#include "log_event.h"
+#include <atomic>
+#include <deque>
+
+extern ulonglong opt_relay_log_event_queue_size;
+extern ulonglong relay_log_event_queue_hits, relay_log_event_queue_misses;
+
+/**
+  What the parsing of an event depends on in the Format_description_log_event
+  it is parsed with.
+*/
+struct Event_format
+{
+  uint16 binlog_version;
+  uint8 common_header_len;
+  uint8 post_header_len;
+  uint8 checksum_alg;
+  uchar server_version_split[3];
+
+  Event_format() {}
+  Event_format(const Format_description_log_event *fdle,
+               Log_event_type type);
+  bool operator==(const Event_format &other) const;
+};
+
+
+/**
+  An event written to the relay log together with the Log_event the I/O
+  thread parsed it into.
+*/
+struct Queued_event
+{
+  Log_event *ev;
+  Event_format format;
+  uint32 open_count;                      ///< Of the relay log written to
+  my_off_t start_pos;                     ///< Offset of the event
+  my_off_t end_pos;                       ///< Offset following the event
+};
+
+
+/**
+  Queue of the events the slave I/O thread parsed, so that the SQL thread
+  need not read and parse them from the hot relay log again.
+
+  The I/O thread still writes every event to the relay log, which remains
+  what the SQL thread executes: it only takes the event at the front of
+  the queue if it is the one at its position in the relay log, parsed with
+  the same format it would have used, and otherwise reads the relay log.
+  The I/O thread does not queue events beyond
+  relay_log_event_queue_size bytes, so the SQL thread then reads them from
+  the file.
+
+  Protected by the LOCK_log of the relay log.
+*/
+class Relay_log_event_queue
+{
+public:
+  Relay_log_event_queue() : m_bytes(0) {}
+  ~Relay_log_event_queue() { clear(); }
+
+  /// Whether the I/O thread should parse an event into the queue
+  static bool can_queue(Log_event_type type);
+
+  /**
+    Whether the I/O thread should parse an event of this size. May be
+    called without holding LOCK_log.
+  */
+  bool has_room(ulong event_len) const
+  {
+    return m_bytes.load(std::memory_order_relaxed) + event_len <=
+           opt_relay_log_event_queue_size;
+  }
+
+  /// Queue an event, taking over its Log_event
+  void push(Queued_event *qev);
+
+  /**
+    Take the event at a position of the relay log, dropping the events
+    before it.
+
+    @param      open_count  Open count of the relay log read
+    @param      pos         Offset of the next event to read
+    @param      fdle        Format the reader parses events with
+    @param[out] end_pos     Offset following the event
+
+    @return The event, or NULL if it has not been queued
+  */
+  Log_event *pop(uint32 open_count, my_off_t pos,
+                 const Format_description_log_event *fdle,
+                 my_off_t *end_pos);
+
+  bool empty() const { return m_entries.empty(); }
+  void clear();
+
+private:
+  void pop_front();
+
+  std::deque<Queued_event> m_entries;
+  /// Size of the queued events, written under LOCK_log
+  std::atomic<size_t> m_bytes;
+};
+
+#endif /* RPL_RLI_EVENT_QUEUE_INCLUDED */
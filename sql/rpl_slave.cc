@@ -63,6 +63,7 @@
 #include "debug_sync.h"
 #include "dependency_slave_worker.h"
 #include "rpl_slave_commit_order_manager.h"    // Commit_order_manager
+#include "rpl_slave_prefetch.h"                // Slave_prefetcher
 #include <chrono>
 #include "slave_stats_daemon.h"  // stop_handle_slave_stats_daemon, start_handle_slave_stats_daemon
 #include "raft_listener_queue_if.h" // class MysqlPrimaryInfo
@@ -427,12 +428,14 @@ void unlock_slave_threads(Master_info* mi)
 
 #ifdef HAVE_PSI_INTERFACE
 static PSI_thread_key key_thread_slave_io, key_thread_slave_sql, key_thread_slave_worker;
+PSI_thread_key key_thread_slave_prefetch;
 
 static PSI_thread_info all_slave_threads[]=
 {
   { &key_thread_slave_io, "slave_io", PSI_FLAG_GLOBAL},
   { &key_thread_slave_sql, "slave_sql", PSI_FLAG_GLOBAL},
-  { &key_thread_slave_worker, "slave_worker", PSI_FLAG_GLOBAL}
+  { &key_thread_slave_worker, "slave_worker", PSI_FLAG_GLOBAL},
+  { &key_thread_slave_prefetch, "slave_prefetch", PSI_FLAG_GLOBAL}
 };
 
 static void init_slave_psi_keys(void)
@@ -7247,6 +7250,20 @@ pthread_handler_t handle_slave_sql(void *arg)
     goto err;
   }
   THD_CHECK_SENTRY(thd);
+
+  if (opt_slave_prefetch_threads)
+  {
+    rli->prefetcher= new Slave_prefetcher(rli, opt_slave_prefetch_threads);
+    if (rli->prefetcher->start(rli->get_group_relay_log_name(),
+                               rli->get_group_relay_log_pos()))
+    {
+      sql_print_warning("Slave SQL thread could not create the threads "
+                        "prefetching the rows of the relay log; the slave "
+                        "applies its events without prefetching.");
+      delete rli->prefetcher;
+      rli->prefetcher= NULL;
+    }
+  }
 #ifndef DBUG_OFF
   {
     char llbuf1[22], llbuf2[22];
@@ -7453,6 +7470,9 @@ llstr(rli->get_group_master_log_pos(), llbuff));
  err:
 
   slave_stop_workers(rli, &mts_inited); // stopping worker pool
+  /* After the workers, which may queue rows to look up with it */
+  delete rli->prefetcher;
+  rli->prefetcher= NULL;
   rli->clear_mts_recovery_groups();
 
   /*
@@ -7958,6 +7978,40 @@ int update_rli_and_mi(
   return ret;
 }
 
+/**
+  Parse an event received from the master the way the SQL thread would
+  read it from the relay log, to queue it for the SQL thread.
+
+  @param      mi          Master_info of the I/O thread
+  @param      buf         The event
+  @param      event_len   Its length
+  @param      event_type  Its type
+  @param[out] qev         Gets the event, with ev left NULL on failure
+*/
+
+static void parse_event_for_queue(Master_info *mi, const char *buf,
+                                  ulong event_len, Log_event_type event_type,
+                                  Queued_event *qev)
+{
+  const Format_description_log_event *fdle= mi->get_mi_description_event();
+  const char *errmsg= NULL;
+  char *copy;
+
+  if (!fdle || !(copy= (char*) my_malloc(event_len + 1, MYF(0))))
+    return;
+  memcpy(copy, buf, event_len);
+  copy[event_len]= 0;
+  if (!(qev->ev= Log_event::read_log_event(copy, event_len, &errmsg, fdle,
+                                           opt_slave_sql_verify_checksum)))
+  {
+    /* The SQL thread reads the event from the relay log and reports it */
+    my_free(copy);
+    return;
+  }
+  qev->ev->register_temp_buf(copy);
+  qev->format= Event_format(fdle, event_type);
+}
+
 /*
   queue_event()
 
@@ -8488,9 +8542,20 @@ static int queue_event(Master_info* mi,const char* buf, ulong event_len)
         goto err;
       }
     }
+    /*
+      Parse the event for the SQL thread before writing it, so that it is
+      queued by the time the SQL thread can read it from the relay log.
+    */
+    Queued_event qev;
+    qev.ev= NULL;
+    if (opt_relay_log_event_queue_size && !enable_raft_plugin &&
+        Relay_log_event_queue::can_queue(event_type) &&
+        rli->event_queue.has_room(event_len))
+      parse_event_for_queue(mi, buf, event_len, event_type, &qev);
     /* write the event to the relay log */
     if (!DBUG_EVALUATE_IF("simulate_append_buffer_error", 1, 0) &&
-       likely(rli->relay_log.append_buffer(buf, event_len, mi) == 0))
+       likely(rli->relay_log.append_buffer(buf, event_len, mi,
+                                           qev.ev ? &qev : NULL) == 0))
     {
       mi->set_master_log_pos(mi->get_master_log_pos() + inc_pos);
       DBUG_PRINT("info", ("master_log_pos: %lu", (ulong) mi->get_master_log_pos()));
@@ -8506,6 +8571,7 @@ static int queue_event(Master_info* mi,const char* buf, ulong event_len)
         {
           global_sid_lock->unlock();
           mysql_mutex_unlock(log_lock);
+          delete qev.ev;
           goto err;
         }
         if (!old_retrieved_gtid.empty())
@@ -8514,6 +8580,8 @@ static int queue_event(Master_info* mi,const char* buf, ulong event_len)
       }
       error= ER_SLAVE_RELAY_LOG_WRITE_FAILURE;
     }
+    /* Not queued: the write failed or the queue had no room left */
+    delete qev.ev;
     mysql_mutex_lock(log_lock);
     rli->ign_master_log_name_end[0]= 0; // last event is not ignored
     mysql_mutex_unlock(log_lock);
@@ -8839,6 +8907,34 @@ static IO_CACHE *reopen_relay_log(Relay_log_info *rli, const char **errmsg)
 }
 
 
+/**
+  Take the next event of the hot relay log from the events the I/O thread
+  has parsed, moving the read position of the relay log past it. Called
+  with the LOCK_log of the relay log held.
+
+  @return The event, or NULL if it has to be read from the relay log
+*/
+static Log_event *take_queued_event(Relay_log_info *rli, IO_CACHE *cur_log,
+                                    int *read_length)
+{
+  mysql_mutex_assert_owner(rli->relay_log.get_log_lock());
+  if (rli->event_queue.empty())
+    return NULL;
+
+  const my_off_t pos= my_b_tell(cur_log);
+  my_off_t end_pos;
+  Log_event *ev= rli->event_queue.pop(rli->relay_log.get_open_count(), pos,
+                                      rli->get_rli_description_event(),
+                                      &end_pos);
+  if (ev)
+  {
+    my_b_seek(cur_log, end_pos);
+    *read_length= (int) (end_pos - pos);
+  }
+  return ev;
+}
+
+
 /**
   Reads next event from the relay log.  Should be called from the
   slave SQL thread.
@@ -8961,10 +9057,15 @@ static Log_event* next_event(Relay_log_info* rli)
       But if the relay log is created by new_file(): then the solution is:
       MYSQL_BIN_LOG::open() will write the buffered description event.
     */
-    if ((ev= Log_event::read_log_event(cur_log, 0,
-                                       rli->get_rli_description_event(),
-                                       opt_slave_sql_verify_checksum,
-                                       &read_length)))
+    if (hot_log && (ev= take_queued_event(rli, cur_log, &read_length)))
+      relay_log_event_queue_hits++;
+    else if ((ev= Log_event::read_log_event(cur_log, 0,
+                                            rli->get_rli_description_event(),
+                                            opt_slave_sql_verify_checksum,
+                                            &read_length)) &&
+             hot_log && opt_relay_log_event_queue_size)
+      relay_log_event_queue_misses++;
+    if (ev)
     {
       DBUG_ASSERT(thd==rli->info_thd);
       /*
@@ -8977,6 +9078,9 @@ static Log_event* next_event(Relay_log_info* rli)
 
       rli->set_future_event_relay_log_pos(relay_event_end_log_pos);
       ev->future_event_relay_log_pos= rli->get_future_event_relay_log_pos();
+      if (rli->prefetcher)
+        rli->prefetcher->set_applier_pos(rli->get_event_relay_log_name(),
+                                         relay_event_end_log_pos);
 
       if (hot_log)
         mysql_mutex_unlock(log_lock);
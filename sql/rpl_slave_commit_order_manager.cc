@@ -25,10 +25,12 @@ Commit_order_manager::Commit_order_manager(uint32 worker_numbers)
 {
   m_rollback_trx.store(false);
   mysql_mutex_init(key_commit_order_manager_mutex, &m_queue_mutex, NULL);
+  mysql_cond_init(key_commit_order_manager_cond, &m_group_cond, NULL);
   for (uint32 i= 0; i < worker_numbers; i++)
   {
     mysql_cond_init(key_commit_order_manager_cond, &m_workers[i].cond, NULL);
     m_workers[i].status= OCS_FINISH;
+    m_workers[i].waiting= false;
   }
 }
 
@@ -84,16 +86,19 @@ bool Commit_order_manager::wait_for_its_turn(Slave_worker *worker,
                     &stage_worker_waiting_for_its_turn_to_commit,
                     &old_stage);
 
+    m_workers[worker->id].waiting= true;
     while (queue_front(db) != worker->id)
     {
       if (unlikely(worker->found_order_commit_deadlock()))
       {
+        m_workers[worker->id].waiting= false;
         thd->EXIT_COND(&old_stage);
         DBUG_RETURN(true);
       }
       mysql_cond_wait(cond, &m_queue_mutex);
     }
 
+    m_workers[worker->id].waiting= false;
     m_workers[worker->id].status= OCS_SIGNAL;
 
     thd->EXIT_COND(&old_stage);
@@ -128,6 +133,7 @@ void Commit_order_manager::unregister_trx(Slave_worker *worker)
     queue_pop(db);
     if (!queue_empty(db))
       mysql_cond_signal(&m_workers[queue_front(db)].cond);
+    mysql_cond_broadcast(&m_group_cond);
 
     m_workers[worker->id].status= OCS_FINISH;
 
@@ -154,6 +160,36 @@ void Commit_order_manager::report_rollback(Slave_worker *worker)
   DBUG_VOID_RETURN;
 }
 
+/**
+  The transactions which are ready to commit are those waiting for their
+  turn, and the one at the head of the queue which was signaled and has
+  not unregistered yet. Each of them unregisters when it enrolls in the
+  flush stage, which does not need LOCK_log, so the leader can wait for
+  them while holding it.
+*/
+void Commit_order_manager::wait_for_group(Slave_worker *worker,
+                                          ulonglong max_wait_usec)
+{
+  DBUG_ENTER("Commit_order_manager::wait_for_group");
+  const auto db= worker->get_current_db();
+  struct timespec abstime;
+
+  /* One deadline for the whole group, not one per joining transaction */
+  set_timespec_nsec(abstime, max_wait_usec * 1000);
+  mysql_mutex_lock(&m_queue_mutex);
+  /* At most one transaction per worker can join */
+  for (size_t i= 0; i < m_workers.size() && !queue_empty(db); i++)
+  {
+    const worker_info &next= m_workers[queue_front(db)];
+    if (next.status != OCS_SIGNAL && !next.waiting)
+      break;
+    if (mysql_cond_timedwait(&m_group_cond, &m_queue_mutex, &abstime))
+      break;
+  }
+  mysql_mutex_unlock(&m_queue_mutex);
+  DBUG_VOID_RETURN;
+}
+
 void Commit_order_manager::report_deadlock(Slave_worker *worker)
 {
   DBUG_ENTER("Commit_order_manager::report_deadlock");
@@ -77,6 +77,17 @@ public:
 
   void report_deadlock(Slave_worker *worker);
 
+  /**
+    Wait for the transactions following the one of a binlog group commit
+    leader in commit order to join the group, as long as they are ready to
+    commit, so that they share the leader's flush and sync.
+
+    @param[in] worker        The worker leading the flush stage, which has
+                             unregistered its transaction.
+    @param[in] max_wait_usec How long to wait for in total.
+  */
+  void wait_for_group(Slave_worker *worker, ulonglong max_wait_usec);
+
 private:
   enum order_commit_status
   {
@@ -90,9 +101,13 @@ private:
     uint32 next;
     mysql_cond_t cond;
     enum order_commit_status status;
+    /* The worker waits for its turn, so it is ready to commit */
+    bool waiting;
   };
 
   mysql_mutex_t m_queue_mutex;
+  /* Signaled when a transaction leaves a queue, for wait_for_group() */
+  mysql_cond_t m_group_cond;
   std::atomic<bool> m_rollback_trx;
 
   /* It stores order commit information of all workers. */
@@ -0,0 +1,502 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "rpl_slave_prefetch.h"
+#include "mysql/psi/mysql_file.h"
+#include "mysqld.h"                             // next_query_id
+#include "rpl_rli.h"
+#include "rpl_utility.h"                        // RPL_TABLE_LIST
+#include "sql_base.h"                           // open_n_lock_single_table
+#include "sql_parse.h"                  // mysql_reset_thd_for_next_command
+#include <chrono>
+
+#ifdef HAVE_PSI_INTERFACE
+extern PSI_thread_key key_thread_slave_prefetch;
+#endif
+
+/// Sequence number of a relay log, from the extension of its name
+static ulong relay_log_file_no(const char *log_name)
+{
+  return strtoul(fn_ext(log_name) + 1, NULL, 10);
+}
+
+static bool pos_before(ulong file_no1, my_off_t pos1,
+                       ulong file_no2, my_off_t pos2)
+{
+  return file_no1 < file_no2 || (file_no1 == file_no2 && pos1 < pos2);
+}
+
+
+pthread_handler_t handle_slave_prefetch_reader(void *arg)
+{
+  Slave_prefetcher *prefetcher= (Slave_prefetcher *) arg;
+
+  my_thread_init();
+  prefetcher->run_reader();
+  my_thread_end();
+  pthread_exit(0);
+  return 0;
+}
+
+
+/// Give a prefetch thread a session, called first by the thread
+static void prefetch_thread_init(THD **thd)
+{
+  my_thread_init();
+  *thd= new THD;
+  (*thd)->thread_stack= (char *) thd;
+  (*thd)->store_globals();
+  (*thd)->security_ctx->skip_grants();
+  /* Consistent reads, which take no row locks */
+  (*thd)->variables.tx_isolation= ISO_READ_COMMITTED;
+}
+
+
+static void prefetch_thread_end(THD *thd)
+{
+  thd->release_resources();
+  delete thd;
+  my_thread_end();
+}
+
+
+pthread_handler_t handle_slave_prefetch_worker(void *arg)
+{
+  Slave_prefetcher *prefetcher= (Slave_prefetcher *) arg;
+  THD *thd;
+
+  prefetch_thread_init(&thd);
+  prefetcher->run_worker(thd);
+  prefetch_thread_end(thd);
+  pthread_exit(0);
+  return 0;
+}
+
+
+Prefetch_table::Prefetch_table(Table_map_log_event *table_map)
+  : m_table_list(NULL)
+{
+  m_memory= table_map->setup_table_rli(&m_table_list);
+}
+
+
+Prefetch_table::~Prefetch_table()
+{
+  if (!m_memory)
+    return;
+  m_table_list->m_tabledef.table_def::~table_def();
+  my_free(m_memory);
+}
+
+
+uint Prefetch_table::prefetch(THD *thd, Rows_log_event *rows) const
+{
+  const uint flags= (MYSQL_OPEN_IGNORE_GLOBAL_READ_LOCK |
+                     MYSQL_LOCK_IGNORE_GLOBAL_READ_ONLY |
+                     MYSQL_OPEN_FAIL_ON_MDL_CONFLICT);
+  TABLE_LIST table_list;
+  TABLE *table;
+  uint n_rows= 0;
+
+  if (!m_memory)
+    return 0;
+  /* The table list of the table map event is shared, open a copy */
+  table_list.init_one_table(m_table_list->db, m_table_list->db_length,
+                            m_table_list->table_name,
+                            m_table_list->table_name_length,
+                            m_table_list->alias, TL_READ);
+  table_list.open_type= OT_BASE_ONLY;
+
+  lex_start(thd);
+  mysql_reset_thd_for_next_command(thd);
+  thd->lex->sql_command= SQLCOM_SELECT;
+  thd->set_query_id(next_query_id());
+
+  if ((table= open_n_lock_single_table(thd, &table_list, TL_READ, flags)))
+  {
+    table->use_all_columns();
+    n_rows= rows->prefetch_rows(table, &m_table_list->m_tabledef);
+    ha_commit_trans(thd, FALSE, FALSE, TRUE);
+    ha_commit_trans(thd, TRUE, FALSE, TRUE);
+  }
+  /* Tables which cannot be opened now are not prefetched */
+  thd->clear_error();
+  close_thread_tables(thd);
+  thd->mdl_context.release_transactional_locks();
+  return n_rows;
+}
+
+
+Slave_prefetcher::Slave_prefetcher(Relay_log_info *rli, uint n_workers)
+  : m_rli(rli), m_n_workers(n_workers), m_stop(false),
+    m_applier_file_no(0), m_applier_pos(0), m_reader_waiting(false),
+    m_file(-1), m_file_no(0), m_fdle(NULL)
+{
+  m_applier_log[0]= 0;
+  m_log_name[0]= 0;
+}
+
+
+Slave_prefetcher::~Slave_prefetcher()
+{
+  stop();
+  close_log();
+  delete m_fdle;
+}
+
+
+bool Slave_prefetcher::start(const char *log_name, my_off_t pos)
+{
+  set_applier_pos(log_name, pos);
+
+  /* The reader, then the workers */
+  for (uint i= 0; i <= m_n_workers; i++)
+  {
+    pthread_t thread;
+    if (mysql_thread_create(key_thread_slave_prefetch, &thread, NULL,
+                            i ? handle_slave_prefetch_worker :
+                                handle_slave_prefetch_reader,
+                            this))
+      break;
+    m_threads.push_back(thread);
+  }
+
+  if (m_threads.size() > 1)
+    return false;
+  stop();
+  return true;
+}
+
+
+void Slave_prefetcher::stop()
+{
+  m_stop= true;
+  {
+    std::lock_guard<std::mutex> guard(m_pos_lock);
+    m_pos_cond.notify_all();
+  }
+  {
+    std::lock_guard<std::mutex> guard(m_jobs_lock);
+    m_jobs_cond.notify_all();
+  }
+  for (pthread_t thread : m_threads)
+    pthread_join(thread, NULL);
+  m_threads.clear();
+  m_jobs.clear();
+  m_group_jobs.clear();
+}
+
+
+void Slave_prefetcher::set_applier_pos(const char *log_name, my_off_t pos)
+{
+  std::lock_guard<std::mutex> guard(m_pos_lock);
+  if (strcmp(log_name, m_applier_log))
+  {
+    strmake(m_applier_log, log_name, sizeof(m_applier_log) - 1);
+    m_applier_file_no= relay_log_file_no(log_name);
+  }
+  m_applier_pos= pos;
+  if (m_reader_waiting)
+    m_pos_cond.notify_one();
+}
+
+
+void Slave_prefetcher::queue(const std::shared_ptr<Group_job> &job)
+{
+  std::lock_guard<std::mutex> guard(m_jobs_lock);
+  m_group_jobs.push_back(job);
+  m_jobs_cond.notify_one();
+}
+
+
+bool Slave_prefetcher::claim(Group_job *job)
+{
+  int state= Group_job::PENDING;
+  if (job->state.compare_exchange_strong(state, Group_job::DROPPED))
+    return false;
+
+  std::unique_lock<std::mutex> lock(m_jobs_lock);
+  while (job->state != Group_job::DONE)
+    m_done_cond.wait(lock);
+  return true;
+}
+
+
+/// Whether the SQL thread has read the event at a position
+bool Slave_prefetcher::applier_passed(ulong file_no, my_off_t pos)
+{
+  std::lock_guard<std::mutex> guard(m_pos_lock);
+  return pos_before(file_no, pos, m_applier_file_no, m_applier_pos);
+}
+
+
+/**
+  Wait until the SQL thread reads an event, or for a while: the I/O thread
+  does not signal the events it appends to the relay log.
+*/
+void Slave_prefetcher::wait_for_applier()
+{
+  std::unique_lock<std::mutex> lock(m_pos_lock);
+  if (m_stop)
+    return;
+  m_reader_waiting= true;
+  m_pos_cond.wait_for(lock, std::chrono::milliseconds(10));
+  m_reader_waiting= false;
+}
+
+
+/**
+  Open a relay log at a position, reading the format description events
+  at its start first.
+*/
+bool Slave_prefetcher::open_log(const char *log_name, my_off_t pos)
+{
+  const char *errmsg;
+
+  if ((m_file= open_binlog_file(&m_log, log_name, &errmsg)) < 0)
+    return true;
+  strmake(m_log_name, log_name, sizeof(m_log_name) - 1);
+  m_file_no= relay_log_file_no(log_name);
+
+  delete m_fdle;
+  m_fdle= new Format_description_log_event(3);
+  while (my_b_tell(&m_log) < pos)
+  {
+    Log_event *ev= Log_event::read_log_event(&m_log, NULL, m_fdle, FALSE,
+                                             NULL);
+    if (!ev)
+    {
+      close_log();
+      return true;
+    }
+    const Log_event_type type= ev->get_type_code();
+    if (type == FORMAT_DESCRIPTION_EVENT)
+    {
+      delete m_fdle;
+      m_fdle= (Format_description_log_event *) ev;
+      continue;
+    }
+    delete ev;
+    if (type != ROTATE_EVENT && type != PREVIOUS_GTIDS_LOG_EVENT)
+      break;
+  }
+  my_b_seek(&m_log, pos);
+  return false;
+}
+
+
+void Slave_prefetcher::close_log()
+{
+  if (m_file < 0)
+    return;
+  end_io_cache(&m_log);
+  mysql_file_close(m_file, MYF(MY_WME));
+  m_file= -1;
+}
+
+
+/// Bytes of the relay logs between the SQL thread and the reader
+my_off_t Slave_prefetcher::bytes_ahead(ulong applier_file_no,
+                                       my_off_t applier_pos)
+{
+  my_off_t end= my_b_tell(&m_log);
+
+  m_file_sizes.erase(m_file_sizes.begin(),
+                     m_file_sizes.lower_bound(applier_file_no));
+  for (const auto &file_size : m_file_sizes)
+    end+= file_size.second;
+  return end > applier_pos ? end - applier_pos : 0;
+}
+
+
+/**
+  Read the next event of the relay log.
+
+  @retval 0   An event has been read
+  @retval 1   There is no event to read yet
+  @retval -1  The relay log could not be read
+*/
+int Slave_prefetcher::read_event()
+{
+  MYSQL_BIN_LOG *relay_log= &m_rli->relay_log;
+  const my_off_t pos= my_b_tell(&m_log);
+
+  relay_log->lock_binlog_end_pos();
+  const bool hot= relay_log->is_active(m_log_name);
+  const my_off_t end_pos= relay_log->get_binlog_end_pos();
+  relay_log->unlock_binlog_end_pos();
+
+  /* The events before the end position are complete */
+  if (hot && pos >= end_pos)
+    return 1;
+
+  Log_event *ev= Log_event::read_log_event(&m_log, NULL, m_fdle, FALSE, NULL);
+  if (!ev)
+  {
+    if (hot || m_log.error)
+      return -1;
+
+    /* The end of a relay log the I/O thread has rotated */
+    LOG_INFO linfo;
+    if (relay_log->find_log_pos(&linfo, m_log_name, true) ||
+        relay_log->find_next_log(&linfo, true))
+      return 1;
+    m_file_sizes[m_file_no]= pos;
+    close_log();
+    return open_log(linfo.log_file_name, BIN_LOG_HEADER_SIZE) ? -1 : 0;
+  }
+
+  switch (ev->get_type_code())
+  {
+  case FORMAT_DESCRIPTION_EVENT:
+    delete m_fdle;
+    m_fdle= (Format_description_log_event *) ev;
+    break;
+  case TABLE_MAP_EVENT:
+  {
+    Table_map_log_event *table_map= (Table_map_log_event *) ev;
+    m_table_maps[table_map->get_table_id()].reset(table_map);
+    break;
+  }
+  case WRITE_ROWS_EVENT:
+  case UPDATE_ROWS_EVENT:
+  case DELETE_ROWS_EVENT:
+  case WRITE_ROWS_EVENT_V1:
+  case UPDATE_ROWS_EVENT_V1:
+  case DELETE_ROWS_EVENT_V1:
+    queue_rows((Rows_log_event *) ev, pos);
+    break;
+  default:
+    delete ev;
+  }
+  return 0;
+}
+
+
+void Slave_prefetcher::queue_rows(Rows_log_event *ev, my_off_t start_pos)
+{
+  std::shared_ptr<Rows_log_event> rows(ev);
+  const auto it= m_table_maps.find(ev->get_table_id());
+
+  if (it != m_table_maps.end())
+  {
+    Job job= { it->second, rows, m_file_no, start_pos };
+    std::lock_guard<std::mutex> guard(m_jobs_lock);
+    m_jobs.push_back(job);
+    m_jobs_cond.notify_one();
+  }
+  /* Table ids are only valid within a statement */
+  if (ev->get_flags(Rows_log_event::STMT_END_F))
+    m_table_maps.clear();
+}
+
+
+void Slave_prefetcher::run_reader()
+{
+  char applier_log[FN_REFLEN];
+  ulong applier_file_no;
+  my_off_t applier_pos;
+
+  while (!m_stop)
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_pos_lock);
+      strmov(applier_log, m_applier_log);
+      applier_file_no= m_applier_file_no;
+      applier_pos= m_applier_pos;
+    }
+
+    /* Start over from the SQL thread when it has caught up with us */
+    if (m_file < 0 ||
+        pos_before(m_file_no, my_b_tell(&m_log), applier_file_no,
+                   applier_pos))
+    {
+      close_log();
+      m_table_maps.clear();
+      m_file_sizes.clear();
+      if (open_log(applier_log, applier_pos))
+      {
+        wait_for_applier();
+        continue;
+      }
+    }
+
+    int error= 1;
+    if (bytes_ahead(applier_file_no, applier_pos) < opt_slave_prefetch_window &&
+        !(error= read_event()))
+      continue;
+    if (error < 0)
+      close_log();
+    wait_for_applier();
+  }
+
+  close_log();
+  m_table_maps.clear();
+}
+
+
+void Slave_prefetcher::run_worker(THD *thd)
+{
+  while (true)
+  {
+    Job job;
+    std::shared_ptr<Group_job> group_job;
+    {
+      std::unique_lock<std::mutex> lock(m_jobs_lock);
+      while (m_jobs.empty() && m_group_jobs.empty() && !m_stop)
+        m_jobs_cond.wait(lock);
+      if (m_stop)
+        break;
+      /* A slave worker is about to apply these */
+      if (!m_group_jobs.empty())
+      {
+        group_job= m_group_jobs.front();
+        m_group_jobs.pop_front();
+      }
+      else
+      {
+        job= m_jobs.front();
+        m_jobs.pop_front();
+      }
+    }
+
+    if (group_job)
+    {
+      /* Dropped by the slave worker, which may have freed the event */
+      int state= Group_job::PENDING;
+      if (!group_job->state.compare_exchange_strong(state, Group_job::RUNNING))
+        continue;
+      group_job->table->prefetch(thd, group_job->rows);
+
+      std::lock_guard<std::mutex> guard(m_jobs_lock);
+      group_job->state= Group_job::DONE;
+      m_done_cond.notify_all();
+      continue;
+    }
+
+    /* Too late to be of any use */
+    if (applier_passed(job.file_no, job.start_pos))
+    {
+      my_atomic_add64((int64*) &slave_prefetch_wasted, 1);
+      continue;
+    }
+    if (!Prefetch_table(job.table_map.get()).prefetch(thd, job.rows.get()))
+      continue;
+    if (applier_passed(job.file_no, job.start_pos))
+      my_atomic_add64((int64*) &slave_prefetch_wasted, 1);
+    else
+      my_atomic_add64((int64*) &slave_prefetch_useful, 1);
+  }
+}
@@ -0,0 +1,195 @@
+#ifndef RPL_SLAVE_PREFETCH_INCLUDED
+#define RPL_SLAVE_PREFETCH_INCLUDED
+
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/** @file Looking up rows ahead of the slave threads applying them */
+
+#include "my_global.h"
+#include "my_sys.h"
+#include "log_event.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class Log_event_wrapper;
+class Relay_log_info;
+class THD;
+struct RPL_TABLE_LIST;
+
+extern uint opt_slave_prefetch_threads;
+extern ulonglong opt_slave_prefetch_window;
+extern ulonglong slave_prefetch_useful, slave_prefetch_wasted;
+
+/**
+  The table a table map event refers to, with the definition its columns
+  had on the master. Shared by the threads looking up rows in it.
+*/
+class Prefetch_table
+{
+public:
+  explicit Prefetch_table(Table_map_log_event *table_map);
+  ~Prefetch_table();
+
+  /**
+    Look up the rows of a row event in the table, in the session of the
+    calling thread.
+
+    @return The number of rows looked up
+  */
+  uint prefetch(THD *thd, Rows_log_event *rows) const;
+
+private:
+  RPL_TABLE_LIST *m_table_list;
+  void *m_memory;
+};
+
+/**
+  Threads reading the relay log ahead of the slave SQL thread, which look
+  up the rows that its row events change by their unique keys, so that the
+  SQL thread finds them in the storage engine's cache.
+
+  A reader thread parses the events of the relay log from the position of
+  the SQL thread on, staying at most slave_prefetch_window bytes ahead of
+  it, and queues each row event with its table map. Worker threads open the
+  table of each queued event in their own session and read its rows by
+  their primary or unique keys, in READ COMMITTED consistent reads which
+  take no row locks and do not wait for metadata locks.
+
+  A prefetch is useful if it was done before the SQL thread read the
+  event, and wasted otherwise.
+
+  The worker threads also look up the rows of large transactions ahead of
+  the dependency slave workers applying them, which the coordinator has
+  scheduled further than the reader looks ahead, see
+  Dependency_slave_worker::prefetch_ahead(). The slave worker claims the
+  job of an event before applying it: a job not started yet is dropped,
+  and one in progress is waited for, so that no thread reads an event the
+  slave worker may have freed.
+*/
+class Slave_prefetcher
+{
+public:
+  /// A row event of a transaction of a dependency slave worker
+  struct Group_job
+  {
+    enum enum_state { PENDING, RUNNING, DONE, DROPPED };
+
+    std::shared_ptr<Prefetch_table> table;
+    Rows_log_event *rows;
+    /// The event in the transaction of the slave worker
+    const Log_event_wrapper *ev;
+    std::atomic<int> state;
+
+    Group_job(const std::shared_ptr<Prefetch_table> &table,
+              Rows_log_event *rows, const Log_event_wrapper *ev)
+      : table(table), rows(rows), ev(ev), state(PENDING) {}
+  };
+
+  Slave_prefetcher(Relay_log_info *rli, uint n_workers);
+  ~Slave_prefetcher();
+
+  /**
+    Start the threads, reading from a position of the relay log.
+
+    @retval false  Success
+    @retval true   No thread could be created
+  */
+  bool start(const char *log_name, my_off_t pos);
+
+  /// Stop the threads and wait for them to exit
+  void stop();
+
+  /**
+    Account for the SQL thread having read the relay log up to a position.
+    Called by the SQL thread for every event it reads.
+  */
+  void set_applier_pos(const char *log_name, my_off_t pos);
+
+  /// Queue a job of a dependency slave worker for the worker threads
+  void queue(const std::shared_ptr<Group_job> &job);
+
+  /**
+    Take a job back from the worker threads, waiting for it if it is in
+    progress.
+
+    @retval true   The rows of the job have been looked up
+    @retval false  The job has been dropped
+  */
+  bool claim(Group_job *job);
+
+  /// Body of the reader thread
+  void run_reader();
+  /// Body of a worker thread
+  void run_worker(THD *thd);
+
+private:
+  /// A row event to prefetch, with the table map it refers to
+  struct Job
+  {
+    std::shared_ptr<Table_map_log_event> table_map;
+    std::shared_ptr<Rows_log_event> rows;
+    ulong file_no;
+    my_off_t start_pos;
+  };
+
+  bool applier_passed(ulong file_no, my_off_t pos);
+  void wait_for_applier();
+  bool open_log(const char *log_name, my_off_t pos);
+  void close_log();
+  my_off_t bytes_ahead(ulong applier_file_no, my_off_t applier_pos);
+  int read_event();
+  void queue_rows(Rows_log_event *ev, my_off_t start_pos);
+
+  Relay_log_info *m_rli;
+  uint m_n_workers;
+  std::vector<pthread_t> m_threads;
+  std::atomic<bool> m_stop;
+
+  /* Position of the SQL thread, protected by m_pos_lock */
+  std::mutex m_pos_lock;
+  std::condition_variable m_pos_cond;
+  char m_applier_log[FN_REFLEN];
+  ulong m_applier_file_no;
+  my_off_t m_applier_pos;
+  bool m_reader_waiting;
+
+  /* Row events for the workers, protected by m_jobs_lock */
+  std::mutex m_jobs_lock;
+  std::condition_variable m_jobs_cond;
+  std::deque<Job> m_jobs;
+  std::deque<std::shared_ptr<Group_job>> m_group_jobs;
+  /// Signaled when a job of a dependency slave worker is done
+  std::condition_variable m_done_cond;
+
+  /* State of the reader thread */
+  IO_CACHE m_log;
+  File m_file;
+  char m_log_name[FN_REFLEN];
+  ulong m_file_no;
+  Format_description_log_event *m_fdle;
+  std::unordered_map<ulonglong, std::shared_ptr<Table_map_log_event>>
+    m_table_maps;
+  /// Sizes of the relay logs read since the one the SQL thread reads
+  std::map<ulong, my_off_t> m_file_sizes;
+};
+
+#endif /* RPL_SLAVE_PREFETCH_INCLUDED */
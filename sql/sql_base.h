@@ -385,6 +385,7 @@ void reset_sql_stats_from_diff(THD *thd, SHARED_SQL_STATS *prev_stats,
 bool is_sql_stats_collection_above_limit();
 bool toggle_sql_stats_snapshot(THD *thd);
 void flush_sql_statistics(THD *thd);
+void free_sql_stats_buffer(THD *thd);
 
 /* For active sql */
 extern mysql_mutex_t LOCK_global_active_sql;
@@ -1092,6 +1092,7 @@ THD::THD(bool enable_plugins)
   commit_consensus_error= false;
   last_cpu_info_result = -1;
   cumulative_sql_stats = nullptr;
+  sql_stats_buffer = nullptr;
   cpu_start_timespec = {};
   should_update_stats = false;
 
@@ -1120,6 +1121,8 @@ THD::THD(bool enable_plugins)
   mysql_mutex_init(key_LOCK_thd_data, &LOCK_thd_data, MY_MUTEX_INIT_FAST);
   mysql_mutex_init(key_LOCK_thd_db_read_only_hash, &LOCK_thd_db_read_only_hash,
                    MY_MUTEX_INIT_FAST);
+  mysql_mutex_init(key_LOCK_thd_sql_stats_buffer, &LOCK_thd_sql_stats_buffer,
+                   MY_MUTEX_INIT_FAST);
   mysql_mutex_init(key_LOCK_db_metadata, &LOCK_db_metadata,
                    MY_MUTEX_INIT_FAST);
 
@@ -1644,6 +1647,8 @@ void THD::reset_stmt_stats()
   m_index_dive_count        = 0; /* index dive count */
   m_index_dive_cpu          = 0; /* index dive cpu time in microseconds */
   m_compilation_cpu         = 0; /* compilation cpu time in microseconds */
+  m_plan_cache_hits         = 0; /* join orders reused from plan cache */
+  m_plan_cache_misses       = 0; /* join orders searched and cached */
   stmt_elapsed_utime        = 0; /* statment elapsed time in microseconds */
 
   /* The disk usage of a single statement is the difference between the peak
@@ -1699,6 +1704,7 @@ void THD::cleanup_connection(void)
 
   if (variables.sql_stats_snapshot)
     toggle_sql_stats_snapshot(this);
+  free_sql_stats_buffer(this);
 
   init();
   stmt_map.reset();
@@ -1847,6 +1853,8 @@ void THD::release_resources()
 
   if (variables.sql_stats_snapshot)
     toggle_sql_stats_snapshot(this);
+  /* Merge the buffered SQL stats while the session is still listed */
+  free_sql_stats_buffer(this);
 
   /* Ensure that no one is using THD */
   mysql_mutex_lock(&LOCK_thd_data);
@@ -1932,6 +1940,7 @@ THD::~THD()
   mysql_mutex_unlock(&LOCK_thd_db_read_only_hash);
 
   mysql_mutex_destroy(&LOCK_thd_db_read_only_hash);
+  mysql_mutex_destroy(&LOCK_thd_sql_stats_buffer);
 
   mysql_mutex_destroy(&LOCK_db_metadata);
 
@@ -2046,6 +2055,71 @@ void add_diff_to_status(STATUS_VAR *to_var, STATUS_VAR *from_var,
 }
 
 
+/**
+  Set up the session of a thread which reads data for the statement of
+  another session.
+
+  The worker runs in autocommit mode with the variables, isolation level,
+  current database, privileges and explicit snapshot of parent. It keeps
+  its own plugin variables and the ones which refer to memory of its own
+  session.
+
+  @param thd     Session of the worker thread
+  @param parent  Session executing the statement
+*/
+
+void init_worker_thd(THD *thd, THD *parent)
+{
+  {
+    char *dynamic_variables_ptr= thd->variables.dynamic_variables_ptr;
+    uint dynamic_variables_head= thd->variables.dynamic_variables_head;
+    uint dynamic_variables_size= thd->variables.dynamic_variables_size;
+    LIST *dynamic_variables_allocs= thd->variables.dynamic_variables_allocs;
+    ulong dynamic_variables_version= thd->variables.dynamic_variables_version;
+    plugin_ref table_plugin= thd->variables.table_plugin;
+    plugin_ref temp_table_plugin= thd->variables.temp_table_plugin;
+    plugin_ref multi_tenancy_plugin= thd->variables.multi_tenancy_plugin;
+    Gtid_specification gtid_next= thd->variables.gtid_next;
+    Gtid_set_or_null gtid_next_list= thd->variables.gtid_next_list;
+
+    thd->variables= parent->variables;
+
+    thd->variables.dynamic_variables_ptr= dynamic_variables_ptr;
+    thd->variables.dynamic_variables_head= dynamic_variables_head;
+    thd->variables.dynamic_variables_size= dynamic_variables_size;
+    thd->variables.dynamic_variables_allocs= dynamic_variables_allocs;
+    thd->variables.dynamic_variables_version= dynamic_variables_version;
+    thd->variables.table_plugin= table_plugin;
+    thd->variables.temp_table_plugin= temp_table_plugin;
+    thd->variables.multi_tenancy_plugin= multi_tenancy_plugin;
+    thd->variables.gtid_next= gtid_next;
+    thd->variables.gtid_next_list= gtid_next_list;
+    thd->variables.sql_stats_snapshot= false;
+  }
+  thd->variables.pseudo_thread_id= thd->set_new_thread_id();
+  thd->variables.option_bits&= ~(OPTION_NOT_AUTOCOMMIT | OPTION_BEGIN);
+  thd->variables.option_bits|= OPTION_AUTOCOMMIT;
+  thd->tx_isolation= parent->tx_isolation;
+  thd->set_db(parent->db, parent->db_length);
+
+  /* The parent has checked the privileges for the statement already */
+  thd->security_ctx->set_user(parent->security_ctx->user);
+  thd->security_ctx->set_host(parent->security_ctx->host.ptr(),
+                              parent->security_ctx->host.length());
+  thd->security_ctx->host_or_ip= parent->security_ctx->host_or_ip;
+  strmake(thd->security_ctx->priv_user, parent->security_ctx->priv_user,
+          sizeof(thd->security_ctx->priv_user) - 1);
+  strmake(thd->security_ctx->priv_host, parent->security_ctx->priv_host,
+          sizeof(thd->security_ctx->priv_host) - 1);
+  strmake(thd->security_ctx->proxy_user, parent->security_ctx->proxy_user,
+          sizeof(thd->security_ctx->proxy_user) - 1);
+  thd->security_ctx->master_access= parent->security_ctx->master_access;
+  thd->security_ctx->db_access= parent->security_ctx->db_access;
+
+  thd->set_explicit_snapshot(parent->get_explicit_snapshot());
+}
+
+
 /**
   Awake a thread.
 
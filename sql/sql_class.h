@@ -126,6 +126,7 @@ class PerfCounter;
 }
 
 class Srv_session;
+class Sql_stats_buffer;
 
 struct st_thd_timer;
 
@@ -657,8 +658,11 @@ typedef struct system_variables
   ulonglong tmp_table_size;
   ulonglong tmp_table_conv_concurrency_timeout;
   ulonglong tmp_table_max_file_size;
+  my_bool tmp_table_memory_blobs;
   ulonglong filesort_max_file_size;
+  ulong filesort_max_threads;
   ulonglong long_query_time;
+  my_bool filesort_packed_records;
   my_bool end_markers_in_json;
   my_bool disable_trigger;
   /* A bitmap for switching optimizations on/off */
@@ -671,6 +675,7 @@ typedef struct system_variables
   my_bool   optimizer_low_limit_heuristic;
   my_bool   optimizer_force_index_for_range;
   my_bool   optimizer_full_scan;
+  my_bool   optimizer_plan_cache;
   double    optimizer_group_by_cost_adjust;
   sql_mode_t sql_mode; ///< which non-standard SQL behaviour should be enabled
   my_bool   error_partial_strict;
@@ -706,6 +711,9 @@ typedef struct system_variables
   ulong net_write_timeout_seconds;
   ulong optimizer_prune_level;
   ulong optimizer_search_depth;
+  ulong batch_filter_rows;
+  ulong parallel_union_max_threads;
+  ulong partition_scan_max_threads;
   ulong range_optimizer_max_mem_size;
   ulong range_optimizer_fail_mode;
   ulong preload_buff_size;
@@ -934,6 +942,8 @@ typedef struct system_status_var
   ulonglong table_open_cache_overflows;
   ulonglong select_full_join_count;
   ulonglong select_full_range_join_count;
+  ulonglong select_parallel_union_count;
+  ulonglong partition_parallel_scan_count;
   ulonglong select_range_count;
   ulonglong select_range_check_count;
   ulonglong select_scan_count;
@@ -942,6 +952,8 @@ typedef struct system_status_var
   ulonglong filesort_range_count;
   ulonglong filesort_rows;
   ulonglong filesort_scan_count;
+  ulonglong filesort_parallel_runs;
+  ulonglong filesort_parallel_merge_passes;
   /* Prepared statements and binary protocol */
   ulonglong com_stmt_prepare;
   ulonglong com_stmt_reprepare;
@@ -2576,6 +2588,8 @@ public:
   */
   mysql_mutex_t LOCK_thd_data;
   mysql_mutex_t LOCK_thd_db_read_only_hash;
+  /* Protects sql_stats_buffer, which is merged by other threads too */
+  mysql_mutex_t LOCK_thd_sql_stats_buffer;
   mysql_mutex_t LOCK_db_metadata;
   mysql_mutex_t LOCK_thd_audit_data;
 
@@ -2762,6 +2776,9 @@ public:
     should_update_stats = false;
   }
 
+  /* SQL stats of this session not yet merged into the global stats */
+  Sql_stats_buffer *sql_stats_buffer;
+
 /*end stats tracking*/
 
 public:
@@ -3510,6 +3527,13 @@ private:
   */
   ulonglong m_compilation_cpu;
 
+  /**
+     Number of query blocks whose join order was reused from, or stored
+     in, the plan cache of a prepared statement.
+  */
+  uint m_plan_cache_hits;
+  uint m_plan_cache_misses;
+
   /**
      Total binlog bytes written per stmt.
   */
@@ -3679,6 +3703,18 @@ public:
   void inc_compilation_cpu(ulonglong val)
   { m_compilation_cpu += val; }
 
+  uint get_plan_cache_hits() const
+  { return m_plan_cache_hits; }
+
+  void inc_plan_cache_hits()
+  { m_plan_cache_hits++; }
+
+  uint get_plan_cache_misses() const
+  { return m_plan_cache_misses; }
+
+  void inc_plan_cache_misses()
+  { m_plan_cache_misses++; }
+
   ulonglong get_row_binlog_bytes_written() const
   { return m_binlog_bytes_written; }
 
@@ -6140,6 +6176,7 @@ public:
 class select_union :public select_result_interceptor
 {
   TMP_TABLE_PARAM tmp_table_param;
+  bool write_row();
 public:
   TABLE *table;
 
@@ -6157,6 +6194,13 @@ public:
   { return false; }
 
   bool send_data(List<Item> &items);
+  /**
+    Add a row that is already in the record format of the result table,
+    as produced by a query block executed on a worker thread.
+
+    @see Parallel_union
+  */
+  virtual bool send_record(const uchar *record);
   bool send_eof();
   virtual bool flush();
   void cleanup();
@@ -6219,6 +6263,7 @@ public:
   bool postponed_prepare(List<Item> &types);
   bool send_result_set_metadata(List<Item> &list, uint flags);
   bool send_data(List<Item> &items);
+  bool send_record(const uchar *record);
   bool initialize_tables (JOIN *join= NULL);
   void send_error(uint errcode, const char *err)
   {
@@ -6582,6 +6627,11 @@ public:
    it's dumped to the file. User can request sorted values, or
    just iterate through them. In the last case tree merging is performed in
    memory simultaneously with iteration, so it should be ~2-3x faster.
+
+   When the keys are equal exactly when their bytes are equal, the caller
+   can ask for an open addressing hash set instead of the TREE: the keys are
+   copied to a MEM_ROOT and only sorted when they are dumped to the file or
+   read back.
  */
 
 class Unique :public Sql_alloc
@@ -6595,18 +6645,34 @@ class Unique :public Sql_alloc
   bool flush();
   uint size;
 
+  /* The hash set used instead of the tree when use_hash is set */
+  bool use_hash;
+  bool hash_sorted;               // hash_slots hold the keys sorted instead
+  MEM_ROOT hash_root;             // Copies of the keys
+  uchar **hash_slots;
+  ulong hash_size;                // Number of slots, a power of two
+  ulong hash_elements;
+  bool hash_insert(uchar *key);
+  bool hash_resize(ulong new_size);
+  void hash_sort();
+  void hash_clear();
+
 public:
   ulong elements;
   Unique(qsort_cmp2 comp_func, void *comp_func_fixed_arg,
-	 uint size_arg, ulonglong max_in_memory_size_arg);
+	 uint size_arg, ulonglong max_in_memory_size_arg,
+         bool use_hash_arg= false);
   ~Unique();
-  ulong elements_in_tree() { return tree.elements_in_tree; }
+  ulong elements_in_tree()
+  { return use_hash ? hash_elements : tree.elements_in_tree; }
   inline bool unique_add(void *ptr)
   {
     DBUG_ENTER("unique_add");
-    DBUG_PRINT("info", ("tree %u - %lu", tree.elements_in_tree, max_elements));
-    if (tree.elements_in_tree > max_elements && flush())
+    DBUG_PRINT("info", ("tree %lu - %lu", elements_in_tree(), max_elements));
+    if (elements_in_tree() > max_elements && flush())
       DBUG_RETURN(1);
+    if (use_hash)
+      DBUG_RETURN(hash_insert((uchar*) ptr));
     DBUG_RETURN(!tree_insert(&tree, ptr, 0, tree.custom_arg));
   }
 
@@ -6901,6 +6967,8 @@ void add_to_status(STATUS_VAR *to_var, STATUS_VAR *from_var);
 void add_diff_to_status(STATUS_VAR *to_var, STATUS_VAR *from_var,
                         STATUS_VAR *dec_var);
 
+void init_worker_thd(THD *thd, THD *parent);
+
 /* Inline functions */
 
 inline bool add_item_to_list(THD *thd, Item *item)
@@ -52,6 +52,9 @@ static enum_nested_loop_state
 evaluate_join_record(JOIN *join, JOIN_TAB *join_tab);
 static enum_nested_loop_state
 evaluate_null_complemented_join_record(JOIN *join, JOIN_TAB *join_tab);
+static void setup_batch_filter(JOIN_TAB *join_tab);
+static enum_nested_loop_state
+sub_select_batched(JOIN *join, JOIN_TAB *join_tab);
 static enum_nested_loop_state
 end_send(JOIN *join, JOIN_TAB *join_tab, bool end_of_records);
 static enum_nested_loop_state
@@ -1286,6 +1289,11 @@ sub_select(JOIN *join,JOIN_TAB *join_tab,bool end_of_records)
 
   join->thd->get_stmt_da()->reset_current_row_for_warning();
 
+  if (!join_tab->batch_filter_checked)
+    setup_batch_filter(join_tab);
+  if (join_tab->batch_filter)
+    DBUG_RETURN(sub_select_batched(join, join_tab));
+
   enum_nested_loop_state rc= NESTED_LOOP_OK;
   bool in_first_read= true;
   while (rc == NESTED_LOOP_OK && join->return_tab >= join_tab)
@@ -1325,6 +1333,130 @@ sub_select(JOIN *join,JOIN_TAB *join_tab,bool end_of_records)
 }
 
 
+/**
+  Set up the batch filter of a table, if batch_filter_rows is set and
+  some predicates of the table's condition can be evaluated on blocks of
+  its rows.
+
+  Reading ahead is limited to plain SELECTs that don't lock rows, since a
+  row lock or unlock would apply to the last row read rather than to the
+  one being evaluated. It is also left out for inner tables of outer joins,
+  whose conditions are evaluated in several steps, for tables whose current
+  rowid is needed, and for tables with BLOB columns, whose values live in
+  engine buffers that the next read may overwrite.
+*/
+
+static void setup_batch_filter(JOIN_TAB *join_tab)
+{
+  THD *const thd= join_tab->join->thd;
+  TABLE *const table= join_tab->table;
+  Item *const cond= join_tab->condition();
+  const uint rows= thd->variables.batch_filter_rows;
+
+  join_tab->batch_filter_checked= true;
+  if (rows < 2 || !cond ||
+      (cond->type() != Item::FUNC_ITEM && cond->type() != Item::COND_ITEM) ||
+      thd->lex->sql_command != SQLCOM_SELECT ||
+      join_tab->type != JT_ALL || join_tab->use_quick == QS_DYNAMIC_RANGE ||
+      join_tab->first_inner || join_tab->keep_current_rowid ||
+      table->s->blob_fields ||
+      (table->reginfo.lock_type != TL_READ &&
+       table->reginfo.lock_type != TL_READ_HIGH_PRIORITY))
+    return;
+
+  Batch_filter *filter= Batch_filter::create(thd->mem_root, table, rows);
+  if (filter && static_cast<Item_func*>(cond)->add_to_batch_filter(filter))
+    join_tab->batch_filter= filter;
+}
+
+
+/**
+  Scan a table in blocks of rows for sub_select().
+
+  Each block is filled by the batch read of the table's access method, or
+  else by its single row reads, copying every row out of record[0], and
+  filtered with the table's batch filter. The selected rows are then copied
+  back one at a time and go through evaluate_join_record() as usual, while
+  the rejected ones are only counted as examined.
+*/
+
+static enum_nested_loop_state
+sub_select_batched(JOIN *join, JOIN_TAB *join_tab)
+{
+  READ_RECORD *info= &join_tab->read_record;
+  TABLE *const table= join_tab->table;
+  Batch_filter *const filter= join_tab->batch_filter;
+  const size_t reclength= table->s->reclength;
+  THD *const thd= join->thd;
+  DBUG_ENTER("sub_select_batched");
+
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  bool in_first_read= true;
+  bool eof= false;
+  while (rc == NESTED_LOOP_OK && !eof && join->return_tab >= join_tab)
+  {
+    uint rows= 0;
+    while (rows < filter->max_rows())
+    {
+      int error;
+      uint read= 0;
+      bool batched= false;
+      if (in_first_read)
+      {
+        in_first_read= false;
+        error= (*join_tab->read_first_record)(join_tab);
+      }
+      else if (info->read_batch)
+      {
+        batched= true;
+        error= info->read_batch(info, filter->row(rows), reclength,
+                                filter->max_rows() - rows, &read);
+      }
+      else
+        error= info->read_record(info);
+
+      if (error > 0 || thd->is_error())           // Fatal error
+        DBUG_RETURN(NESTED_LOOP_ERROR);
+      if (thd->killed)                            // Aborted by user
+      {
+        thd->send_kill_message();
+        DBUG_RETURN(NESTED_LOOP_KILLED);
+      }
+      rows+= read;
+      if (error < 0)
+      {
+        eof= true;
+        break;
+      }
+      if (!batched)
+        memcpy(filter->row(rows++), table->record[0], reclength);
+    }
+
+    const uint selected= filter->filter(rows);
+    const uint *next= filter->selected_rows();
+    const uint *const end= next + selected;
+    for (uint n= 0;
+         n < rows && rc == NESTED_LOOP_OK && join->return_tab >= join_tab;
+         n++)
+    {
+      if (next < end && *next == n)
+      {
+        next++;
+        memcpy(table->record[0], filter->row(n), reclength);
+        table->status= 0;
+        rc= evaluate_join_record(join, join_tab);
+      }
+      else
+      {
+        join->examined_rows++;
+        thd->get_stmt_da()->inc_current_row_for_warning();
+      }
+    }
+  }
+  DBUG_RETURN(rc);
+}
+
+
 /**
   @brief Prepare table to be scanned.
 
@@ -3066,6 +3198,45 @@ end:
   DBUG_RETURN(NESTED_LOOP_OK);
 }
 
+/**
+  Apply a group row update that made a MEMORY table full.
+
+  With tmp_table_memory_blobs, growing BLOB values of a group can take the
+  table over its size limit. Convert the table to MyISAM, find the group row
+  there through the key or unique constraint that record[0] duplicates, and
+  update it with record[0], which already holds the new values.
+
+  @return false if the row was updated, true on error (already reported)
+*/
+
+static bool
+update_group_row_after_full(JOIN *join, JOIN_TAB *join_tab, int error)
+{
+  TABLE *const table= join_tab->table;
+  bool is_duplicate;
+  DBUG_ENTER("update_group_row_after_full");
+
+  if (create_myisam_from_heap(join->thd, table,
+                              join_tab->tmp_table_param->start_recinfo,
+                              &join_tab->tmp_table_param->recinfo,
+                              error, TRUE, &is_duplicate))
+    DBUG_RETURN(true);                          // Not a table_is_full error
+  DBUG_ASSERT(is_duplicate);
+  error= table->s->uniques ? HA_ERR_FOUND_DUPP_UNIQUE : HA_ERR_FOUND_DUPP_KEY;
+  if (!is_duplicate ||
+      (int) table->file->get_dup_key(error) < 0 ||
+      (error= table->file->ha_rnd_pos(table->record[1],
+                                      table->file->dup_ref)) ||
+      (error= table->file->ha_update_row(table->record[1],
+                                         table->record[0])))
+  {
+    table->file->print_error(error, MYF(0));
+    DBUG_RETURN(true);
+  }
+  DBUG_RETURN(false);
+}
+
+
 /* ARGSUSED */
 /** Group by searching after group record and updating it if possible. */
 
@@ -3106,8 +3277,20 @@ end_update(JOIN *join, JOIN_TAB *join_tab, bool end_of_records)
     if ((error=table->file->ha_update_row(table->record[1],
                                           table->record[0])))
     {
-      table->file->print_error(error,MYF(0));	/* purecov: inspected */
-      DBUG_RETURN(NESTED_LOOP_ERROR);            /* purecov: inspected */
+      if (error != HA_ERR_RECORD_FILE_FULL)
+      {
+        table->file->print_error(error,MYF(0));	/* purecov: inspected */
+        DBUG_RETURN(NESTED_LOOP_ERROR);          /* purecov: inspected */
+      }
+      if (update_group_row_after_full(join, join_tab, error))
+        DBUG_RETURN(NESTED_LOOP_ERROR);
+      /* Change method to update rows, as after a failed write below */
+      if ((error= table->file->ha_index_init(0, 0)))
+      {
+        table->file->print_error(error, MYF(0));
+        DBUG_RETURN(NESTED_LOOP_ERROR);
+      }
+      ((QEP_tmp_table*)join_tab->op)->set_write_func(end_unique_update);
     }
     DBUG_RETURN(NESTED_LOOP_OK);
   }
@@ -3171,27 +3354,51 @@ end_unique_update(JOIN *join, JOIN_TAB *join_tab, bool end_of_records)
     DBUG_RETURN(NESTED_LOOP_ERROR);           /* purecov: inspected */
 
   if (!(error=table->file->ha_write_row(table->record[0])))
+  {
     join_tab->send_records++;			// New group
-  else
+    DBUG_RETURN(NESTED_LOOP_OK);
+  }
+  if (table->file->is_fatal_error(error, HA_CHECK_DUP))
   {
-    if ((int) table->file->get_dup_key(error) < 0)
-    {
-      table->file->print_error(error,MYF(0));	/* purecov: inspected */
-      DBUG_RETURN(NESTED_LOOP_ERROR);            /* purecov: inspected */
-    }
-    if (table->file->ha_rnd_pos(table->record[1], table->file->dup_ref))
+    /*
+      A MEMORY table with a unique constraint (see tmp_table_memory_blobs)
+      got full. The row may still belong to an existing group.
+    */
+    bool is_duplicate;
+    if (create_myisam_from_heap(join->thd, table,
+                                join_tab->tmp_table_param->start_recinfo,
+                                &join_tab->tmp_table_param->recinfo,
+                                error, TRUE, &is_duplicate))
+      DBUG_RETURN(NESTED_LOOP_ERROR);            // Not a table_is_full error
+    if (!is_duplicate)
     {
-      table->file->print_error(error,MYF(0));	/* purecov: inspected */
-      DBUG_RETURN(NESTED_LOOP_ERROR);            /* purecov: inspected */
+      join_tab->send_records++;                 // New group
+      DBUG_RETURN(NESTED_LOOP_OK);
     }
-    restore_record(table,record[1]);
-    update_tmptable_sum_func(join->sum_funcs,table);
-    if ((error=table->file->ha_update_row(table->record[1],
-                                          table->record[0])))
+    error= HA_ERR_FOUND_DUPP_UNIQUE;
+  }
+  if ((int) table->file->get_dup_key(error) < 0)
+  {
+    table->file->print_error(error,MYF(0));	/* purecov: inspected */
+    DBUG_RETURN(NESTED_LOOP_ERROR);              /* purecov: inspected */
+  }
+  if (table->file->ha_rnd_pos(table->record[1], table->file->dup_ref))
+  {
+    table->file->print_error(error,MYF(0));	/* purecov: inspected */
+    DBUG_RETURN(NESTED_LOOP_ERROR);              /* purecov: inspected */
+  }
+  restore_record(table,record[1]);
+  update_tmptable_sum_func(join->sum_funcs,table);
+  if ((error=table->file->ha_update_row(table->record[1],
+                                        table->record[0])))
+  {
+    if (error != HA_ERR_RECORD_FILE_FULL)
     {
       table->file->print_error(error,MYF(0));	/* purecov: inspected */
       DBUG_RETURN(NESTED_LOOP_ERROR);            /* purecov: inspected */
     }
+    if (update_group_row_after_full(join, join_tab, error))
+      DBUG_RETURN(NESTED_LOOP_ERROR);
   }
   DBUG_RETURN(NESTED_LOOP_OK);
 }
@@ -3482,8 +3689,8 @@ JOIN_TAB::remove_duplicates()
 
   free_io_cache(table);				// Safety
   table->file->info(HA_STATUS_VARIABLE);
-  if (table->s->db_type() == heap_hton ||
-      (!table->s->blob_fields &&
+  if (!table->s->blob_fields &&
+      (table->s->db_type() == heap_hton ||
        ((ALIGN_SIZE(reclength) + HASH_OVERHEAD) * table->file->stats.records <
 	join->thd->variables.sortbuff_size)))
     error=remove_dup_with_hash_index(join->thd, table,
@@ -4322,9 +4529,13 @@ QEP_tmp_table::prepare_tmp_table()
     (void) table->file->extra(HA_EXTRA_WRITE_CACHE);
     empty_record(table);
   }
-  /* If it wasn't already, start index scan for grouping using table index. */
+  /*
+    If it wasn't already, start index scan for grouping using table index.
+    A unique constraint is not used for lookups, see end_unique_update().
+  */
   if (!table->file->inited && table->group &&
-      join_tab->tmp_table_param->sum_func_count && table->s->keys)
+      join_tab->tmp_table_param->sum_func_count && table->s->keys &&
+      !table->s->uniques)
     rc= table->file->ha_index_init(0, 0);
   else
   {
@@ -1848,6 +1848,7 @@ void st_select_lex_unit::init_query()
   describe= 0;
   found_rows_for_union= 0;
   result= NULL;
+  parallel= NULL;
 }
 
 void st_select_lex::init_query()
@@ -1899,6 +1900,8 @@ void st_select_lex::init_query()
   with_sum_func= false;
   removed_select= NULL;
   select_bypass_hint= SELECT_BYPASS_HINT_DEFAULT;
+  select_bypass_plan= NULL;
+  join_order_cache= NULL;
 }
 
 void st_select_lex::init_select()
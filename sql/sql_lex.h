@@ -448,6 +448,17 @@ struct LEX;
 class st_select_lex;
 class st_select_lex_unit;
 
+/*
+  Base class for the plans a storage engine caches on a prepared
+  statement through hton::handle_single_table_select. The engine
+  derives from it, the SQL layer only knows how to destroy it.
+*/
+class Select_bypass_plan
+{
+public:
+  virtual ~Select_bypass_plan() {}
+};
+
 
 class st_select_lex_node {
 protected:
@@ -542,6 +553,8 @@ typedef class st_select_lex_node SELECT_LEX_NODE;
 class THD;
 class select_result;
 class JOIN;
+class Join_order_cache;
+class Parallel_union;
 class select_union;
 
 
@@ -562,7 +575,8 @@ public:
       cleaned(false),
       fake_select_lex(NULL),
       saved_fake_select_lex(NULL),
-      explain_marker(0)
+      explain_marker(0),
+      parallel(NULL)
   {
   }
 
@@ -621,6 +635,12 @@ public:
   */
   int explain_marker;
 
+  /**
+    Set by optimize() when the query blocks are executed on worker threads
+    instead of being optimized and executed by the session.
+  */
+  Parallel_union *parallel;
+
   void init_query();
   st_select_lex_unit* master_unit();
   st_select_lex* outer_select();
@@ -738,6 +758,19 @@ public:
 
   enum select_bypass_hint_type  select_bypass_hint;
 
+  /*
+    Plan cached by the storage engine in hton::handle_single_table_select
+    for prepared statements, so that re-executions don't need to parse the
+    statement again. Owned by this SELECT_LEX and freed together with the
+    prepared statement.
+   */
+  Select_bypass_plan *select_bypass_plan;
+  /*
+    Join order kept for later executions of a prepared statement when
+    optimizer_plan_cache is on. Allocated on the statement's mem_root.
+  */
+  Join_order_cache *join_order_cache;
+
   /* 
     Usualy it is pointer to ftfunc_list_alloc, but in union used to create fake
     select_lex for calling mysql_select under results of union
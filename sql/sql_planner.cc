@@ -1157,6 +1157,28 @@ bool Optimize_table_order::choose_table_order()
                Opt_trace_context::GREEDY_SEARCH);
   if (straight_join)
     optimize_straight_join(join_tables);
+  else if (use_join_order_cache())
+  {
+    Join_order_cache *cache= join->select_lex->join_order_cache;
+    if (cache && cache->is_valid(join))
+    {
+      Opt_trace_object(&thd->opt_trace).add_alnum("join_order_cache", "hit");
+      cache->apply(join);
+      optimize_straight_join(join_tables);
+      thd->inc_plan_cache_hits();
+    }
+    else
+    {
+      if (greedy_search(join_tables))
+        DBUG_RETURN(true);
+      if (!cache)
+        cache= join->select_lex->join_order_cache=
+          Join_order_cache::create(thd->stmt_arena->mem_root, join->tables);
+      if (cache && cache->table_count() == join->tables)
+        cache->store(join);
+      thd->inc_plan_cache_misses();
+    }
+  }
   else
   {
     if (greedy_search(join_tables))
@@ -1175,6 +1197,108 @@ bool Optimize_table_order::choose_table_order()
 }
 
 
+/**
+  Whether the join order of this optimization may be taken from, and stored
+  in, the join order cache of the query block.
+
+  Only complete plans of query blocks of prepared statements, which keep
+  their SELECT_LEX across executions, are cached. Query blocks with
+  semi-join nests are left out, as their plan also depends on the semi-join
+  strategies chosen during the search.
+*/
+
+bool Optimize_table_order::use_join_order_cache() const
+{
+  return thd->variables.optimizer_plan_cache &&
+         thd->stmt_arena->type() == Query_arena::PREPARED_STATEMENT &&
+         !emb_sjm_nest &&
+         join->allow_outer_refs &&
+         join->select_lex->sj_nests.is_empty();
+}
+
+
+/// Power of two class of a row estimate: 0 for no rows, else 1 + log2(rows)
+
+static uchar join_order_row_class(ha_rows rows)
+{
+  uchar row_class= 0;
+  for (; rows; rows>>= 1)
+    row_class++;
+  return row_class;
+}
+
+
+Join_order_cache *Join_order_cache::create(MEM_ROOT *mem_root, uint tables)
+{
+  uint *order= (uint*) alloc_root(mem_root, sizeof(uint) * tables);
+  Table_state *state=
+    (Table_state*) alloc_root(mem_root, sizeof(Table_state) * tables);
+  if (!order || !state)
+    return NULL;
+  return new (mem_root) Join_order_cache(tables, order, state);
+}
+
+
+/**
+  Check that the cached order still applies to a query block.
+
+  The order is rejected if the set of constant tables changed, since that
+  changes the tables to order and their dependencies, if a table was
+  altered, or if the row estimate of a table moved to another power of two,
+  which is where a different order could become cheaper. The dependencies
+  of each table on the tables before it are checked again, so an invalid
+  order is never imposed.
+*/
+
+bool Join_order_cache::is_valid(const JOIN *join) const
+{
+  if (join->tables != tables || join->const_table_map != const_table_map)
+    return false;
+
+  table_map prefix= join->const_table_map;
+  for (uint i= 0; i < tables - join->const_tables; i++)
+  {
+    const JOIN_TAB *const tab= join->join_tab + order[i];
+    const Table_state &ts= state[order[i]];
+    const TABLE *const table= tab->table;
+
+    if (table->s->tmp_table == NO_TMP_TABLE &&
+        table->s->get_table_ref_version() != ts.version)
+      return false;
+    if (join_order_row_class(tab->records) != ts.records_class ||
+        join_order_row_class(tab->found_records) != ts.found_class)
+      return false;
+    if (tab->dependent & join->all_table_map & ~prefix)
+      return false;
+    prefix|= table->map;
+  }
+  return true;
+}
+
+
+void Join_order_cache::apply(JOIN *join) const
+{
+  for (uint i= 0; i < tables - join->const_tables; i++)
+    join->best_ref[join->const_tables + i]= join->join_tab + order[i];
+}
+
+
+void Join_order_cache::store(const JOIN *join)
+{
+  DBUG_ASSERT(join->tables == tables);
+  const_table_map= join->const_table_map;
+  for (uint i= join->const_tables; i < tables; i++)
+  {
+    const JOIN_TAB *const tab= join->best_positions[i].table;
+    const uint idx= tab - join->join_tab;
+    order[i - join->const_tables]= idx;
+    state[idx].version= tab->table->s->get_table_ref_version();
+    state[idx].records_class= join_order_row_class(tab->records);
+    state[idx].found_class= join_order_row_class(tab->found_records);
+  }
+}
+
+
 /**
   Heuristic procedure to automatically guess a reasonable degree of
   exhaustiveness for the greedy search procedure.
@@ -25,6 +25,51 @@
 
 class Opt_trace_object;
 
+/**
+  Join order chosen for a query block of a prepared statement, kept on its
+  SELECT_LEX so that later executions can skip the join order search.
+
+  The order is only reused while the same tables are constant, the tables
+  have not been altered, and each table's estimated row count (from the
+  statistics and from range analysis with the current parameter values)
+  stays within the same power of two as when the order was chosen. The
+  access method of each table is still chosen on every execution.
+
+  Allocated on the mem_root of the prepared statement.
+*/
+class Join_order_cache : public Sql_alloc
+{
+public:
+  static Join_order_cache *create(MEM_ROOT *mem_root, uint tables);
+
+  /// @return true if the cached order can be used for this optimization
+  bool is_valid(const JOIN *join) const;
+  /// Set join->best_ref to the cached order
+  void apply(JOIN *join) const;
+  /// Remember the order of join->best_positions
+  void store(const JOIN *join);
+
+  uint table_count() const { return tables; }
+
+private:
+  struct Table_state
+  {
+    ulonglong version;    ///< TABLE_SHARE::get_table_ref_version()
+    uchar records_class;  ///< log2 class of the table's row estimate
+    uchar found_class;    ///< log2 class of the rows left by range analysis
+  };
+
+  Join_order_cache(uint tables_arg, uint *order_arg, Table_state *state_arg)
+    : tables(tables_arg), const_table_map(0), order(order_arg),
+      state(state_arg)
+  {}
+
+  const uint tables;           ///< Number of JOIN_TABs of the query block
+  table_map const_table_map;   ///< Constant tables when the order was stored
+  uint *const order;           ///< JOIN_TAB indexes of the non-const tables
+  Table_state *const state;    ///< Indexed like JOIN::join_tab
+};
+
 /**
   This class determines the optimal join order for tables within
   a basic query block, ie a query specification clause, possibly extended
@@ -101,6 +146,7 @@ private:
   void backout_nj_state(const table_map remaining_tables,
                         const JOIN_TAB *tab);
   void optimize_straight_join(table_map join_tables);
+  bool use_join_order_cache() const;
   bool greedy_search(table_map remaining_tables);
   bool best_extension_by_limited_search(table_map remaining_tables,
                                         uint idx,
@@ -3291,6 +3291,7 @@ Prepared_statement::~Prepared_statement()
   free_items();
   if (lex)
   {
+    delete lex->select_lex.select_bypass_plan;
     delete lex->result;
     delete (st_lex_local *) lex;
   }
@@ -733,6 +733,14 @@ public:
   int  keep_current_rowid;
   st_cache_field *copy_current_rowid;
 
+  /*
+    Filter applying the simple predicates of the condition to blocks of rows
+    read ahead from a scan of the table, or NULL. Set up by the first
+    sub_select() call, see setup_batch_filter().
+  */
+  Batch_filter *batch_filter;
+  bool batch_filter_checked;
+
   /* NestedOuterJoins: Bitmap of nested joins this table is part of */
   nested_join_map embedding_map;
 
@@ -966,6 +974,8 @@ st_join_table::st_join_table()
 
     keep_current_rowid(0),
     copy_current_rowid(NULL),
+    batch_filter(NULL),
+    batch_filter_checked(false),
     embedding_map(0),
     tmp_table_param(NULL),
     filesort(NULL),
@@ -37,7 +37,6 @@ struct TABLE;
    The structure SORT_ADDON_FIELD describes a fixed layout
    for field values appended to sorted values in records to be sorted
    in the sort buffer.
-   Only fixed layout is supported now.
    Null bit maps for the appended values is placed before the values 
    themselves. Offsets are from the last sorted field, that is from the
    record referefence, which is still last component of sorted records.
@@ -65,6 +64,19 @@ typedef struct st_buffpek {		/* Struktur om sorteringsbuffrarna */
   ulong max_keys;			/* Max keys in buffert */
 } BUFFPEK;
 
+/*
+  Describes one part of a packed sort key, see Sort_param::using_packed_records.
+  A part is the NULL indicator (if any) and the value of one SORT_FIELD.
+  Parts with a pad are stored as a 2-byte length followed by the bytes that
+  remain when the trailing bytes equal to the pad are stripped; other parts
+  are stored at their full length.
+*/
+
+typedef struct st_sort_key_part {
+  uint length;           /* Length of the part when it is not packed */
+  const uchar *pad;      /* Suffix stripped from packed parts, or NULL */
+} SORT_KEY_PART;
+
 struct BUFFPEK_COMPARE_CONTEXT
 {
   qsort_cmp2 key_compare;
@@ -88,6 +100,17 @@ public:
   uchar *unique_buff;
   bool not_killable;
   char* tmp_buffer;
+  uint max_threads;           // Threads the sort may use, 1 (or 0) if serial.
+  /*
+    With packed records, each record starts with its total length (4 bytes),
+    followed by the packed sort key (see SORT_KEY_PART), then the record
+    reference or the addon fields with their strings stored at their actual
+    length. rec_length is then the maximum length of a record.
+  */
+  bool using_packed_records;
+  SORT_KEY_PART *key_parts;   // Parts of packed sort keys
+  uint key_part_count;
+  uchar *packed_buffer;       // Space to convert records to/from packed form
   // The fields below are used only by Unique class.
   qsort2_cmp compare;
   BUFFPEK_COMPARE_CONTEXT cmp_context;
@@ -99,6 +122,10 @@ public:
   void init_for_filesort(uint sortlen, TABLE *table,
                          ulong max_length_for_sort_data,
                          ha_rows maxrows, bool sort_positions);
+
+  /// Length of the sort record starting at rec.
+  uint get_record_length(const uchar *rec) const
+  { return using_packed_records ? uint4korr(rec) : rec_length; }
 };
 
 
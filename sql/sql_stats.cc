@@ -8,6 +8,8 @@
 #include "structs.h"
 #include "tztime.h"                             // struct Time_zone
 #include "rpl_master.h"                         // get_current_replication_lag
+#include "global_threads.h"                     // copy_global_thread_list
+#include "shardedlocks.h"                       // LOCK_thd_remove
 #include <mysql/plugin_rim.h>
 #include <handler.h>
 
@@ -319,6 +321,12 @@ ST_FIELD_INFO sql_stats_fields_info[]=
   {"FILESORT_DISK_USAGE", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG,
       0, MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
 
+  {"PLAN_CACHE_HITS", MY_INT32_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONG,
+      0, MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+
+  {"PLAN_CACHE_MISSES", MY_INT32_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONG,
+      0, MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+
   {0, 0, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE}
 };
 
@@ -355,6 +363,12 @@ ST_FIELD_INFO client_attrs_fields_info[]=
 /* Global sql stats hash maps to track and update metrics in-memory */
 Sql_stats_maps global_sql_stats;
 
+/*
+  Incremented under LOCK_global_sql_stats whenever the entries of
+  global_sql_stats are freed or moved, see Sql_stats_buffer.
+*/
+static ulonglong sql_stats_generation= 0;
+
 /* Snapshot of SQL stats. */
 Sql_stats_maps sql_stats_snapshot;
 extern mysql_rwlock_t LOCK_sql_stats_snapshot;
@@ -1943,6 +1957,8 @@ static bool valid_sql_stats(SQL_STATS *sql_stats)
       sql_stats->shared_stats.compilation_cpu == 0 &&
       sql_stats->shared_stats.tmp_table_disk_usage == 0 &&
       sql_stats->shared_stats.filesort_disk_usage == 0 &&
+      sql_stats->shared_stats.plan_cache_hits == 0 &&
+      sql_stats->shared_stats.plan_cache_misses == 0 &&
       sql_stats->shared_stats.rows_inserted == 0 &&
       sql_stats->shared_stats.rows_updated == 0 &&
       sql_stats->shared_stats.rows_deleted == 0 &&
@@ -2077,6 +2093,8 @@ void reset_sql_stats_from_thd(THD *thd, SHARED_SQL_STATS *stats)
   stats->compilation_cpu = thd->get_compilation_cpu();
   stats->tmp_table_disk_usage = thd->get_stmt_tmp_table_disk_usage_peak();
   stats->filesort_disk_usage = thd->get_stmt_filesort_disk_usage_peak();
+  stats->plan_cache_hits = thd->get_plan_cache_hits();
+  stats->plan_cache_misses = thd->get_plan_cache_misses();
 }
 
 /*
@@ -2125,6 +2143,10 @@ void reset_sql_stats_from_diff(THD *thd, SHARED_SQL_STATS *prev_stats,
   } else {
     stats->filesort_disk_usage = 0;
   }
+  stats->plan_cache_hits =
+    thd->get_plan_cache_hits() - prev_stats->plan_cache_hits;
+  stats->plan_cache_misses =
+    thd->get_plan_cache_misses() - prev_stats->plan_cache_misses;
 }
 
 /*
@@ -2186,6 +2208,233 @@ static void mark_sql_stats_snapshot_for_deletion()
   mysql_rwlock_unlock(&LOCK_sql_stats_snapshot);
 }
 
+static void add_shared_sql_stats(SHARED_SQL_STATS *shared_stats,
+                                 const SHARED_SQL_STATS *stats)
+{
+  shared_stats->rows_sent += stats->rows_sent;
+  shared_stats->tmp_table_bytes_written += stats->tmp_table_bytes_written;
+  shared_stats->filesort_bytes_written += stats->filesort_bytes_written;
+  shared_stats->index_dive_count += stats->index_dive_count;
+  shared_stats->index_dive_cpu += stats->index_dive_cpu;
+  shared_stats->compilation_cpu += stats->compilation_cpu;
+  shared_stats->tmp_table_disk_usage += stats->tmp_table_disk_usage;
+  shared_stats->filesort_disk_usage += stats->filesort_disk_usage;
+  shared_stats->plan_cache_hits += stats->plan_cache_hits;
+  shared_stats->plan_cache_misses += stats->plan_cache_misses;
+
+  // Update CPU stats
+  shared_stats->stmt_cpu_utime += stats->stmt_cpu_utime;
+
+  // Update elapsed time
+  shared_stats->stmt_elapsed_utime += stats->stmt_elapsed_utime;
+
+  // Update Row counts
+  shared_stats->rows_inserted += stats->rows_inserted;
+  shared_stats->rows_updated += stats->rows_updated;
+  shared_stats->rows_deleted += stats->rows_deleted;
+  shared_stats->rows_read += stats->rows_read;
+}
+
+/*
+  add_sql_stats
+    Adds the stats of statement executions to a SQL_STATISTICS entry.
+  Input:
+    sql_stats      out: - entry to update
+    stats          in:  - stats of the executions
+    count          in:  - number of completed executions
+    skipped_count  in:  - number of skipped executions
+*/
+void add_sql_stats(SQL_STATS *sql_stats, const SHARED_SQL_STATS *stats,
+                   ulonglong count, ulonglong skipped_count)
+{
+  add_shared_sql_stats(&sql_stats->shared_stats, stats);
+  sql_stats->count += count;
+  sql_stats->skipped_count += skipped_count;
+}
+
+/*
+  Sql_stats_buffer::add
+    Adds the stats of a statement to the buffer, if the statement has an
+    entry and its query sample is not due to be refreshed.
+    Returns TRUE if the stats were buffered.
+  Input:
+    key                  in: - SQL_STATISTICS cache key of the statement
+    stats                in: - stats of the statement
+    statement_completed  in: - the statement has completed
+    skipped              in: - the statement was skipped
+    time_now             in: - current time, for the query sample
+*/
+bool Sql_stats_buffer::add(const md5_key &key, const SHARED_SQL_STATS *stats,
+                           bool statement_completed, bool skipped,
+                           uint time_now)
+{
+  auto iter= m_entries.find(key);
+  if (iter == m_entries.end())
+    return false;
+
+  Entry &entry= iter->second;
+  if (max_digest_sample_age > 0 &&
+      time_now - entry.query_sample_seen > max_digest_sample_age)
+    return false;
+
+  add_shared_sql_stats(&entry.shared_stats, stats);
+  if (statement_completed) {
+    entry.count++;
+    if (skipped)
+      entry.skipped_count++;
+  }
+
+  m_pending++;
+  return true;
+}
+
+/*
+  Sql_stats_buffer::insert
+    Starts buffering the stats of a statement after they were added to the
+    global entry directly. The caller holds LOCK_global_sql_stats and has
+    merged the buffer.
+  Input:
+    key           in: - SQL_STATISTICS cache key of the statement
+    global_stats  in: - entry of the statement in global_sql_stats
+    generation    in: - current sql_stats_generation
+*/
+void Sql_stats_buffer::insert(const md5_key &key, SQL_STATS *global_stats,
+                              ulonglong generation)
+{
+  DBUG_ASSERT(m_pending == 0);
+  if (generation != m_generation)
+  {
+    m_entries.clear();
+    m_generation = generation;
+  }
+
+  auto iter= m_entries.find(key);
+  if (iter != m_entries.end())
+  {
+    DBUG_ASSERT(iter->second.global_stats == global_stats);
+    iter->second.query_sample_seen = global_stats->query_sample_seen;
+    return;
+  }
+
+  if (m_entries.size() >= MAX_ENTRIES)
+    return;
+
+  Entry entry = {};
+  entry.global_stats = global_stats;
+  entry.query_sample_seen = global_stats->query_sample_seen;
+  m_entries.emplace(key, entry);
+}
+
+/*
+  Sql_stats_buffer::merge
+    Adds the buffered stats to the global entries. The caller holds
+    LOCK_global_sql_stats. If the global maps were replaced since the
+    entries were created, the entries are dropped instead.
+  Input:
+    generation  in: - current sql_stats_generation
+*/
+void Sql_stats_buffer::merge(ulonglong generation)
+{
+  if (generation != m_generation)
+  {
+    m_entries.clear();
+    m_generation = generation;
+    m_pending = 0;
+    return;
+  }
+
+  if (m_pending == 0)
+    return;
+
+  for (auto &iter : m_entries)
+  {
+    Entry &entry= iter.second;
+    add_sql_stats(entry.global_stats, &entry.shared_stats, entry.count,
+                  entry.skipped_count);
+    entry.count = 0;
+    entry.skipped_count = 0;
+    entry.shared_stats.reset();
+  }
+  m_pending = 0;
+}
+
+/*
+  Sql_stats_buffer::clear
+    Drops all entries, without merging them.
+*/
+void Sql_stats_buffer::clear()
+{
+  m_entries.clear();
+  m_pending = 0;
+}
+
+/*
+  merge_sql_stats_buffer
+    Merges the SQL stats buffered by a session into global_sql_stats.
+    The caller holds LOCK_global_sql_stats.
+*/
+static void merge_sql_stats_buffer(THD *thd)
+{
+  mysql_mutex_lock(&thd->LOCK_thd_sql_stats_buffer);
+  if (thd->sql_stats_buffer)
+    thd->sql_stats_buffer->merge(sql_stats_generation);
+  mysql_mutex_unlock(&thd->LOCK_thd_sql_stats_buffer);
+}
+
+/*
+  merge_all_sql_stats_buffers
+    Merges the SQL stats buffered by all sessions into global_sql_stats,
+    so that they are seen by a reader of the global stats.
+    The caller holds LOCK_global_sql_stats.
+  Input:
+    maps_changing  in: - the entries of global_sql_stats are about to be
+                         freed or moved; drop the buffer entries pointing
+                         to them.
+*/
+static void merge_all_sql_stats_buffers(bool maps_changing)
+{
+  std::set<THD*> global_thread_list_copy;
+  mutex_lock_all_shards(SHARDED(&LOCK_thd_remove));
+  copy_global_thread_list(&global_thread_list_copy);
+
+  for (THD *tmp : global_thread_list_copy)
+  {
+    mysql_mutex_lock(&tmp->LOCK_thd_sql_stats_buffer);
+    if (tmp->sql_stats_buffer)
+    {
+      tmp->sql_stats_buffer->merge(sql_stats_generation);
+      if (maps_changing)
+        tmp->sql_stats_buffer->clear();
+    }
+    mysql_mutex_unlock(&tmp->LOCK_thd_sql_stats_buffer);
+  }
+
+  mutex_unlock_all_shards(SHARDED(&LOCK_thd_remove));
+
+  /* Buffers of sessions not in the list drop their entries on next merge */
+  if (maps_changing)
+    sql_stats_generation++;
+}
+
+/*
+  free_sql_stats_buffer
+    Merges the SQL stats buffered by a session that is ending, and frees
+    the buffer.
+*/
+void free_sql_stats_buffer(THD *thd)
+{
+  if (!thd->sql_stats_buffer)
+    return;
+
+  bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
+  mysql_mutex_lock(&thd->LOCK_thd_sql_stats_buffer);
+  thd->sql_stats_buffer->merge(sql_stats_generation);
+  delete thd->sql_stats_buffer;
+  thd->sql_stats_buffer = nullptr;
+  mysql_mutex_unlock(&thd->LOCK_thd_sql_stats_buffer);
+  mt_unlock(lock_acquired, &LOCK_global_sql_stats);
+}
+
 /*
   free_global_sql_stats
     Frees global_sql_stats_map, global_sql_text_map & global_client_attrs_map.
@@ -2208,6 +2457,7 @@ void free_global_sql_stats(bool limits_updated)
     }
   }
 
+  merge_all_sql_stats_buffers(true);
   free_sql_stats_maps(global_sql_stats);
 
   sql_stats_count = 0;
@@ -2411,6 +2661,33 @@ void update_sql_stats_for_statement(THD *thd, SHARED_SQL_STATS *stats,
                                sql_stats_cache_key.data()))
     return;
 
+  const bool skipped = statement_completed &&
+    thd->get_stmt_da()->is_error() &&
+    thd->get_stmt_da()->sql_errno() == ER_DUPLICATE_STATEMENT_EXECUTION;
+  uint time_now = my_time(true);
+
+  /*
+    If the session has seen the statement before, add the stats to its
+    buffer. The buffer is merged into the global stats every
+    Sql_stats_buffer::MERGE_COUNT statements, so that LOCK_global_sql_stats
+    is not taken at the end of every statement.
+  */
+  mysql_mutex_lock(&thd->LOCK_thd_sql_stats_buffer);
+  const bool buffered = thd->sql_stats_buffer &&
+    thd->sql_stats_buffer->add(sql_stats_cache_key, stats,
+                               statement_completed, skipped, time_now);
+  const bool merge = buffered &&
+    thd->sql_stats_buffer->pending() >= Sql_stats_buffer::MERGE_COUNT;
+  mysql_mutex_unlock(&thd->LOCK_thd_sql_stats_buffer);
+  if (buffered) {
+    if (merge) {
+      bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
+      merge_sql_stats_buffer(thd);
+      mt_unlock(lock_acquired, &LOCK_global_sql_stats);
+    }
+    return;
+  }
+
   bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
 
   // Check again inside the lock and release the lock if exiting
@@ -2509,7 +2786,6 @@ void update_sql_stats_for_statement(THD *thd, SHARED_SQL_STATS *stats,
   }
 
   /* Re-sample if last sample is too old */
-	uint time_now = my_time(true);
   if (!get_sample_query && max_digest_sample_age > 0) {
 			uint sample_age = time_now - sql_stats->query_sample_seen;
 			/* Comparison in micro seconds. */
@@ -2524,33 +2800,20 @@ void update_sql_stats_for_statement(THD *thd, SHARED_SQL_STATS *stats,
     sql_stats->query_sample_seen = time_now;
   }
   /* Update stats */
-  sql_stats->shared_stats.rows_sent += stats->rows_sent;
-  sql_stats->shared_stats.tmp_table_bytes_written += stats->tmp_table_bytes_written;
-  sql_stats->shared_stats.filesort_bytes_written += stats->filesort_bytes_written;
-  sql_stats->shared_stats.index_dive_count += stats->index_dive_count;
-  sql_stats->shared_stats.index_dive_cpu += stats->index_dive_cpu;
-  sql_stats->shared_stats.compilation_cpu += stats->compilation_cpu;
-  sql_stats->shared_stats.tmp_table_disk_usage += stats->tmp_table_disk_usage;
-  sql_stats->shared_stats.filesort_disk_usage += stats->filesort_disk_usage;
-
-  // Update CPU stats
-  sql_stats->shared_stats.stmt_cpu_utime += stats->stmt_cpu_utime;
+  add_sql_stats(sql_stats, stats, statement_completed ? 1 : 0,
+                skipped ? 1 : 0);
 
-  // Update elapsed time
-  sql_stats->shared_stats.stmt_elapsed_utime += stats->stmt_elapsed_utime;
-
-  // Update Row counts
-  sql_stats->shared_stats.rows_inserted += stats->rows_inserted;
-  sql_stats->shared_stats.rows_updated += stats->rows_updated;
-  sql_stats->shared_stats.rows_deleted += stats->rows_deleted;
-  sql_stats->shared_stats.rows_read += stats->rows_read;
-
-  if (statement_completed) {
-    sql_stats->count++;
-    if (thd->get_stmt_da()->is_error() &&
-        thd->get_stmt_da()->sql_errno() == ER_DUPLICATE_STATEMENT_EXECUTION)
-      sql_stats->skipped_count++;
+  /* Merge the session's buffer while holding the lock, and buffer the
+     next executions of this statement. */
+  mysql_mutex_lock(&thd->LOCK_thd_sql_stats_buffer);
+  if (!thd->sql_stats_buffer)
+    thd->sql_stats_buffer = new Sql_stats_buffer();
+  if (thd->sql_stats_buffer) {
+    thd->sql_stats_buffer->merge(sql_stats_generation);
+    thd->sql_stats_buffer->insert(sql_stats_cache_key, sql_stats,
+                                  sql_stats_generation);
   }
+  mysql_mutex_unlock(&thd->LOCK_thd_sql_stats_buffer);
 
   mt_unlock(lock_acquired, &LOCK_global_sql_stats);
 }
@@ -2586,6 +2849,8 @@ static void sql_stats_merge(SQL_STATS *base, SQL_STATS *update, SQL_STATS **out,
   storage->shared_stats.compilation_cpu += update->shared_stats.compilation_cpu;
   storage->shared_stats.tmp_table_disk_usage += update->shared_stats.tmp_table_disk_usage;
   storage->shared_stats.filesort_disk_usage += update->shared_stats.filesort_disk_usage;
+  storage->shared_stats.plan_cache_hits += update->shared_stats.plan_cache_hits;
+  storage->shared_stats.plan_cache_misses += update->shared_stats.plan_cache_misses;
   storage->shared_stats.rows_inserted += update->shared_stats.rows_inserted;
   storage->shared_stats.rows_updated += update->shared_stats.rows_updated;
   storage->shared_stats.rows_deleted += update->shared_stats.rows_deleted;
@@ -2708,6 +2973,9 @@ public:
     {
       lock_acquired = mt_lock(&LOCK_global_sql_stats);
 
+      /* Include the stats still buffered by the sessions. */
+      merge_all_sql_stats_buffers(false);
+
       /* From outside snapshot can only be seen if not marked for deletion. */
       if (snapshot_map && !sql_stats_snapshot.drop_maps)
       {
@@ -2970,6 +3238,10 @@ int fill_sql_stats(THD *thd, TABLE_LIST *tables, Item *cond)
       table->field[f++]->store(sql_stats->shared_stats.tmp_table_disk_usage, TRUE);
       /* Filesort disk usage */
       table->field[f++]->store(sql_stats->shared_stats.filesort_disk_usage, TRUE);
+      /* Join orders reused from the plan cache */
+      table->field[f++]->store(sql_stats->shared_stats.plan_cache_hits, TRUE);
+      /* Join orders searched and stored in the plan cache */
+      table->field[f++]->store(sql_stats->shared_stats.plan_cache_misses, TRUE);
 
       if (schema_table_store_record(thd, table))
         result = -1;
@@ -3201,6 +3473,7 @@ bool toggle_sql_stats_snapshot(THD *thd)
         bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
 
         /* Move global stats to snapshot. */
+        merge_all_sql_stats_buffers(true);
         sql_stats_snapshot.move_maps(global_sql_stats);
 
         /* Set new empty stats maps. */
@@ -3233,6 +3506,7 @@ bool toggle_sql_stats_snapshot(THD *thd)
         bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
 
         /* Merge current stats into snapshot. */
+        merge_all_sql_stats_buffers(true);
         sql_stats_map_merge(sql_stats_snapshot.stats, global_sql_stats.stats,
                             dup_count, dup_size);
         sql_stats_map_merge(sql_stats_snapshot.text, global_sql_stats.text,
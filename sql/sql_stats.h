@@ -56,4 +56,51 @@ private:
   Sql_stats_maps &operator=(const Sql_stats_maps &) = delete;
 };
 
+void add_sql_stats(SQL_STATS *sql_stats, const SHARED_SQL_STATS *stats,
+                   ulonglong count, ulonglong skipped_count);
+
+/**
+  @class Sql_stats_buffer
+  Statistics of one session for statements that already have an entry in
+  the global SQL stats. They are added up here without taking
+  LOCK_global_sql_stats, and merged into the global entries in batches
+  while holding it.
+
+  The entries point to SQL_STATS objects of the global maps, so they are
+  tagged with the generation of the maps and dropped once the maps are
+  replaced.
+*/
+class Sql_stats_buffer
+{
+public:
+  /* Number of buffered statements after which the session merges */
+  static const uint MERGE_COUNT= 64;
+  /* Number of distinct statements a session buffers at most */
+  static const uint MAX_ENTRIES= 128;
+
+  Sql_stats_buffer() : m_generation(0), m_pending(0) {}
+
+  bool add(const md5_key &key, const SHARED_SQL_STATS *stats,
+           bool statement_completed, bool skipped, uint time_now);
+  void insert(const md5_key &key, SQL_STATS *global_stats,
+              ulonglong generation);
+  void merge(ulonglong generation);
+  void clear();
+  uint pending() const { return m_pending; }
+
+private:
+  struct Entry
+  {
+    SQL_STATS *global_stats;
+    uint query_sample_seen;
+    ulonglong count;
+    ulonglong skipped_count;
+    SHARED_SQL_STATS shared_stats;
+  };
+
+  Stats_map<Entry> m_entries;
+  ulonglong m_generation;
+  uint m_pending;
+};
+
 #endif /* SQL_STATS_INCLUDED */
@@ -897,7 +897,13 @@ update_hidden:
   /* If result table is small; use a heap */
   /* If result table has document columns then use MyISAM */
   /* future: storage engine selection can be made dynamic? */
-  if (blob_count || using_unique_constraint
+  /*
+    With tmp_table_memory_blobs the heap table also stores BLOB values and
+    keeps a unique constraint as a hash index over the whole values. It is
+    converted to MyISAM by create_myisam_from_heap() when it gets full.
+  */
+  if (((blob_count || using_unique_constraint) &&
+       !thd->variables.tmp_table_memory_blobs)
       || (thd->variables.big_tables && !(select_options & SELECT_SMALL_RESULT))
       || (select_options & TMP_TABLE_FORCE_MYISAM))
   {
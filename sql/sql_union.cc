@@ -30,6 +30,7 @@
 #include "sql_optimizer.h"                      // JOIN
 #include "opt_explain_format.h"
 #include "column_statistics.h"
+#include "sql_union_parallel.h"
 
 bool mysql_union(THD *thd, LEX *lex, select_result *result,
                  SELECT_LEX_UNIT *unit, ulong setup_tables_done_option)
@@ -94,7 +95,6 @@ int select_union::prepare(List<Item> &list, SELECT_LEX_UNIT *u)
 
 bool select_union::send_data(List<Item> &values)
 {
-  int error= 0;
   if (unit->offset_limit_cnt)
   {						// using limit offset,count
     unit->offset_limit_cnt--;
@@ -106,6 +106,22 @@ bool select_union::send_data(List<Item> &values)
   if (thd->is_error())
     return 1;
 
+  return write_row();
+}
+
+
+bool select_union::send_record(const uchar *record)
+{
+  memcpy(table->record[0], record, table->s->reclength);
+  return write_row();
+}
+
+
+/** Write table->record[0] to the result table */
+
+bool select_union::write_row()
+{
+  int error;
   if ((error= table->file->ha_write_row(table->record[0])))
   {
     /* create_myisam_from_heap will generate error if needed */
@@ -263,6 +279,22 @@ bool select_union_direct::send_data(List<Item> &items)
 }
 
 
+bool select_union_direct::send_record(const uchar *record)
+{
+  if (!limit)
+    return false;
+  limit--;
+  if (offset)
+  {
+    offset--;
+    return false;
+  }
+
+  memcpy(table->record[0], record, table->s->reclength);
+  return result->send_data(unit->item_list);
+}
+
+
 bool select_union_direct::initialize_tables (JOIN *join)
 {
   if (done_initialize_tables)
@@ -666,6 +698,15 @@ bool st_select_lex_unit::optimize()
   if (optimized && item && item->assigned() && !uncacheable && !describe)
     DBUG_RETURN(FALSE);
 
+  if (!optimized && !describe && !executed &&
+      thd->variables.parallel_union_max_threads &&
+      (parallel= Parallel_union::create(thd, this)))
+  {
+    /* The query blocks are optimized by the workers executing them */
+    optimized= 1;
+    DBUG_RETURN(FALSE);
+  }
+
   for (SELECT_LEX *sl= first_select(); sl; sl= sl->next_select())
   {
     DBUG_ASSERT(sl->join);
@@ -815,7 +856,27 @@ bool st_select_lex_unit::exec()
     DBUG_RETURN(false);
   executed= true;
 
-  if (uncacheable || !item || !item->assigned())
+  if (parallel)
+  {
+    bool run_serially= false;
+    if (parallel->exec(union_result, &examined_rows, &run_serially))
+    {
+      thd->lex->current_select= lex_select_save;
+      DBUG_RETURN(true);
+    }
+    if (run_serially)
+    {
+      /* The query blocks were left to the workers, optimize them now */
+      parallel= NULL;
+      optimized= 0;
+      if (optimize())
+      {
+        thd->lex->current_select= lex_select_save;
+        DBUG_RETURN(true);
+      }
+    }
+  }
+  if (!parallel && (uncacheable || !item || !item->assigned()))
   {
     if (item)
       item->reset_value_registration();
@@ -993,6 +1054,7 @@ bool st_select_lex_unit::cleanup()
     DBUG_RETURN(FALSE);
   }
   cleaned= true;
+  parallel= NULL;
 
   for (SELECT_LEX *sl= first_select(); sl; sl= sl->next_select())
     error|= sl->cleanup();
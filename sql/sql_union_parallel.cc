@@ -0,0 +1,624 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "sql_priv.h"
+#include "sql_union_parallel.h"
+#include "sql_class.h"
+#include "sql_lex.h"
+#include "sql_base.h"                           // open_normal_and_derived_tables
+#include "sql_parse.h"                          // parse_sql
+#include "sql_select.h"                         // handle_select
+#include "transaction.h"                        // trans_commit_stmt
+#include "mysqld.h"                             // key_thread_union_worker
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+using std::max;
+using std::min;
+
+/** Size of the blocks of rows passed from the workers to the session */
+static const uint union_block_size= 16 * 1024;
+
+
+/** Rows in the record format of the union's result table */
+struct Parallel_union::Block
+{
+  uchar *rows;
+  uint count;
+};
+
+
+/** State shared by the session and the workers of one execution */
+struct Parallel_union::Run
+{
+  Run(Parallel_union *owner_arg, uint record_length_arg, uint block_rows_arg)
+    : owner(owner_arg), next_branch(0), running(0), aborted(false),
+      rows_sent(false), run_serially(false), error(0),
+      record_length(record_length_arg), block_rows(block_rows_arg)
+  {
+    message[0]= '\0';
+  }
+
+  /**
+    Hand a full block over to the session and wait for a free one.
+
+    @return NULL if the execution was aborted
+  */
+  Block *exchange(Block *block);
+  /**
+    Remember the error of a worker and abort the execution. A query block
+    which failed before it was executed makes the session execute the unit
+    instead, unless rows have been sent already.
+  */
+  void fail(THD *worker_thd, bool executing);
+  /** Abort the execution and interrupt the statements of the workers */
+  void abort();
+
+  Parallel_union *const owner;
+  Worker *workers;
+  uint n_workers;
+
+  std::mutex mutex;
+  std::condition_variable filled;       ///< A block is full or a worker ended
+  std::condition_variable emptied;      ///< A block is free or execution ended
+  std::deque<Block*> full_blocks;
+  std::vector<Block*> free_blocks;
+  std::atomic<uint> next_branch;        ///< Next query block to execute
+  uint running;                         ///< Workers which have not ended
+  std::atomic<bool> aborted;
+  bool rows_sent;                       ///< The session has sent a block
+  bool run_serially;                    ///< Aborted for the session to run
+  uint error;                           ///< First error of a worker
+  char message[MYSQL_ERRMSG_SIZE];
+  const uint record_length;
+  const uint block_rows;                ///< Rows per block
+};
+
+
+struct Parallel_union::Worker
+{
+  /**
+    Execute a query block as a SELECT statement.
+
+    @retval false  Ok
+    @retval true   Error, in the diagnostics area of thd unless aborted
+  */
+  bool execute(Branch *branch);
+  /**
+    Add the row in table->record[0] to the current block.
+
+    @retval true  The execution was aborted
+  */
+  bool add_row();
+
+  Run *run;
+  bool executing;                       ///< The query block is prepared
+  THD *thd;                             ///< Set while the thread runs
+  TABLE *table;                         ///< Copy of the result table
+  Block *block;                         ///< Block being filled
+  STATUS_VAR status;                    ///< Status of thd once it has ended
+  bool started;
+  pthread_t thread;
+};
+
+
+/**
+  Result of a query block executed by a worker: stores its rows in the
+  worker's blocks, converted the way select_union::send_data() does.
+*/
+class Parallel_union::Worker_result : public select_result_interceptor
+{
+public:
+  explicit Worker_result(Worker *worker_arg) : worker(worker_arg) {}
+
+  bool send_data(List<Item> &items)
+  {
+    if (unit->offset_limit_cnt)
+    {                                           // using limit offset,count
+      unit->offset_limit_cnt--;
+      return false;
+    }
+    if (worker->run->aborted)
+      return true;
+    fill_record(thd, worker->table->field, items, true, NULL);
+    if (thd->is_error())
+      return true;
+    return worker->add_row();
+  }
+  bool send_eof() { return false; }
+  /* Called once the query block is prepared and optimized */
+  int prepare2()
+  {
+    worker->executing= true;
+    return 0;
+  }
+
+private:
+  Worker *const worker;
+};
+
+
+Parallel_union::Block *Parallel_union::Run::exchange(Block *block)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  full_blocks.push_back(block);
+  filled.notify_one();
+  emptied.wait(lock, [this] { return aborted || !free_blocks.empty(); });
+  if (aborted)
+    return NULL;
+  block= free_blocks.back();
+  free_blocks.pop_back();
+  return block;
+}
+
+
+void Parallel_union::Run::fail(THD *worker_thd, bool executing)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  /* Errors following an abort are caused by it */
+  if (aborted)
+    return;
+  /*
+    A query block printed by the session may not parse or resolve the same
+    way on its own. The error is not the user's, and the session can still
+    execute the unit itself if no rows have been sent.
+  */
+  if (!executing && !rows_sent)
+    run_serially= true;
+  else if (worker_thd->is_error())
+  {
+    error= worker_thd->get_stmt_da()->sql_errno();
+    strmake(message, worker_thd->get_stmt_da()->message(),
+            sizeof(message) - 1);
+  }
+  else
+  {
+    error= ER_UNKNOWN_ERROR;
+    strmake(message, ER(ER_UNKNOWN_ERROR), sizeof(message) - 1);
+  }
+  aborted= true;
+  filled.notify_all();
+  emptied.notify_all();
+}
+
+
+void Parallel_union::Run::abort()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  aborted= true;
+  for (uint w= 0; w < n_workers; w++)
+  {
+    THD *worker_thd= workers[w].thd;
+    if (worker_thd)
+    {
+      mysql_mutex_lock(&worker_thd->LOCK_thd_data);
+      worker_thd->awake(THD::KILL_QUERY);
+      mysql_mutex_unlock(&worker_thd->LOCK_thd_data);
+    }
+  }
+  filled.notify_all();
+  emptied.notify_all();
+}
+
+
+bool Parallel_union::Worker::add_row()
+{
+  memcpy(block->rows + (size_t) block->count * run->record_length,
+         table->record[0], run->record_length);
+  if (++block->count < run->block_rows)
+    return false;
+  return !(block= run->exchange(block));
+}
+
+
+bool Parallel_union::Worker::execute(Branch *branch)
+{
+  LEX *const lex= thd->lex;
+  Parser_state parser_state;
+  Worker_result result(this);
+  bool error;
+
+  executing= false;
+  thd->set_query_and_id(branch->query, branch->query_length, thd->charset(),
+                        next_query_id());
+  if (parser_state.init(thd, branch->query, branch->query_length))
+    return true;
+  lex_start(thd);
+  mysql_reset_thd_for_next_command(thd);
+  /* Functions like NOW() return the time the session's statement started */
+  thd->set_time(&run->owner->thd->start_time);
+
+  error= false;
+  DBUG_EXECUTE_IF("parallel_union_worker_parse_error",
+                  {
+                    my_error(ER_PARSE_ERROR, MYF(0), "", branch->query, 1);
+                    error= true;
+                  });
+  /*
+    The session holds shared metadata locks on the tables already. Requests
+    for exclusive locks which are waiting for them must not make the
+    workers wait in turn.
+  */
+  error= error || parse_sql(thd, &parser_state, NULL) ||
+         open_normal_and_derived_tables(thd, lex->query_tables,
+                                        MYSQL_OPEN_FORCE_SHARED_HIGH_PRIO_MDL |
+                                        MYSQL_OPEN_IGNORE_FLUSH) ||
+         handle_select(thd, &result, 0);
+  error|= thd->is_error();
+  if (!error)
+  {
+    branch->found_rows= thd->limit_found_rows;
+    branch->examined_rows= thd->get_examined_row_count();
+    error= trans_commit_stmt(thd);
+  }
+  else
+    trans_rollback_stmt(thd);
+
+  lex->unit.cleanup();
+  close_thread_tables(thd);
+  thd->mdl_context.release_transactional_locks();
+  thd->end_statement();
+  thd->cleanup_after_query();
+  thd->reset_query();
+  free_root(thd->mem_root, MYF(MY_KEEP_PREALLOC));
+  return error;
+}
+
+
+void *Parallel_union::worker_thread(void *arg)
+{
+  Worker *const worker= static_cast<Worker*>(arg);
+  Run *const run= worker->run;
+  Parallel_union *const owner= run->owner;
+  THD *const parent= owner->thd;
+  THD *thd;
+
+  my_thread_init();
+  thd= new THD;
+  thd->thread_stack= (char*) &thd;
+  thd->store_globals();
+
+  init_worker_thd(thd, parent);
+  worker->table->in_use= thd;
+
+  {
+    std::lock_guard<std::mutex> lock(run->mutex);
+    worker->thd= thd;
+  }
+
+  uint n;
+  while (!run->aborted && (n= run->next_branch++) < owner->n_branches)
+  {
+    if (worker->execute(&owner->branches[n]))
+    {
+      run->fail(thd, worker->executing);
+      break;
+    }
+  }
+
+  worker->status= thd->status_var;
+  thd->set_status_var_init();
+  {
+    std::lock_guard<std::mutex> lock(run->mutex);
+    if (worker->block)
+    {
+      if (worker->block->count && !run->aborted)
+        run->full_blocks.push_back(worker->block);
+      else
+        run->free_blocks.push_back(worker->block);
+      worker->block= NULL;
+    }
+    worker->thd= NULL;
+    run->running--;
+    run->filled.notify_one();
+  }
+
+  thd->release_resources();
+  delete thd;
+  my_thread_end();
+  return NULL;
+}
+
+
+/**
+  Whether the query blocks of unit give the same rows when they are
+  executed as separate statements by other threads.
+*/
+
+bool Parallel_union::is_eligible(THD *thd, SELECT_LEX_UNIT *unit)
+{
+  LEX *const lex= thd->lex;
+
+  if (lex->sql_command != SQLCOM_SELECT || unit != &lex->unit ||
+      !unit->is_union() || unit->union_distinct || lex->describe ||
+      lex->result || lex->proc_analyse || lex->limit_rows_examined ||
+      lex->uses_stored_routines() || thd->sp_runtime_ctx ||
+      thd->in_sub_stmt || !thd->stmt_arena->is_conventional() ||
+      thd->locked_tables_mode ||
+      (unit->first_select()->options & OPTION_FOUND_ROWS))
+    return false;
+
+  /*
+    String literals are printed with backslash escapes, which the workers
+    would parse as literal backslashes.
+  */
+  if (thd->variables.sql_mode & MODE_NO_BACKSLASH_ESCAPES)
+    return false;
+
+  /*
+    Non-deterministic functions, functions with side effects and user
+    variables make the query blocks uncacheable. Subqueries and derived
+    tables are not supported, nor is full-text search, which needs the
+    MATCH functions of the session's query block.
+  */
+  for (SELECT_LEX *sl= unit->first_select(); sl; sl= sl->next_select())
+  {
+    if (sl->uncacheable || sl->first_inner_unit() ||
+        sl->ftfunc_list->elements)
+      return false;
+  }
+
+  /* BLOB values would point to memory of the workers */
+  List_iterator_fast<Item> it(unit->item_list);
+  Item *item;
+  while ((item= it++))
+  {
+    if (item->type() != Item::FIELD_ITEM ||
+        (static_cast<Item_field*>(item)->field->flags & BLOB_FLAG))
+      return false;
+  }
+
+  /*
+    The workers can only share the session's view of the data through an
+    explicit snapshot. Otherwise each of them reads the latest committed
+    data, which is what a session using READ COMMITTED may see for every
+    statement anyway.
+  */
+  const bool shared_snapshot= thd->get_explicit_snapshot() != nullptr;
+  if (!shared_snapshot &&
+      (thd->tx_isolation > ISO_READ_COMMITTED ||
+       thd->in_active_multi_stmt_transaction()))
+    return false;
+
+  for (TABLE_LIST *tl= lex->query_tables; tl; tl= tl->next_global)
+  {
+    TABLE *table= tl->table;
+    if (!table || tl->view || tl->derived || tl->schema_table ||
+        table->s->tmp_table != NO_TMP_TABLE || tl->lock_type != TL_READ ||
+        !table->file->has_transactions() ||
+        (shared_snapshot && !table->file->ht->explicit_snapshot))
+      return false;
+  }
+  return true;
+}
+
+
+Parallel_union *Parallel_union::create(THD *thd, SELECT_LEX_UNIT *unit)
+{
+  Branch *branches;
+  uint n_branches= 0;
+  DBUG_ENTER("Parallel_union::create");
+
+  if (!is_eligible(thd, unit))
+    DBUG_RETURN(NULL);
+
+  for (SELECT_LEX *sl= unit->first_select(); sl; sl= sl->next_select())
+    n_branches++;
+  const uint threads= min<uint>(n_branches,
+                                thd->variables.parallel_union_max_threads);
+  if (threads < 2 ||
+      !(branches= (Branch*) thd->calloc(sizeof(Branch) * n_branches)))
+    DBUG_RETURN(NULL);
+
+  Branch *branch= branches;
+  for (SELECT_LEX *sl= unit->first_select(); sl;
+       sl= sl->next_select(), branch++)
+  {
+    String str;
+    sl->print(thd, &str, QT_ORDINARY);
+    /*
+      Identifiers are printed in the system character set and literals in
+      the connection's, so only 7-bit text is parsed back the same way.
+    */
+    if (!str.is_ascii() ||
+        !(branch->query= thd->strmake(str.ptr(), str.length())))
+      DBUG_RETURN(NULL);
+    branch->select_lex= sl;
+    branch->query_length= str.length();
+    DBUG_PRINT("info", ("query block: %s", branch->query));
+  }
+
+  DBUG_RETURN(new (thd->mem_root) Parallel_union(thd, unit, branches,
+                                                 n_branches, threads));
+}
+
+
+/**
+  Copy the union's result table with its own record buffer and fields, in
+  which a worker can convert its rows.
+*/
+
+static TABLE *clone_result_table(THD *thd, TABLE *table)
+{
+  TABLE_SHARE *const share= table->s;
+  TABLE *copy= (TABLE*) thd->memdup(table, sizeof(TABLE));
+  uchar *record= (uchar*) thd->memdup(share->default_values,
+                                      share->rec_buff_length);
+  Field **fields= (Field**) thd->alloc(sizeof(Field*) * (share->fields + 1));
+  if (!copy || !record || !fields)
+    return NULL;
+
+  const my_ptrdiff_t diff= record - table->record[0];
+  copy->record[0]= record;
+  copy->field= fields;
+  for (uint i= 0; i < share->fields; i++)
+  {
+    if (!(fields[i]= table->field[i]->clone(thd->mem_root)))
+      return NULL;
+    fields[i]->move_field_offset(diff);
+    fields[i]->table= fields[i]->orig_table= copy;
+  }
+  fields[share->fields]= NULL;
+  return copy;
+}
+
+
+bool Parallel_union::exec(select_union *union_result, ha_rows *examined_rows,
+                          bool *run_serially)
+{
+  TABLE *const table= unit->table;
+  const uint record_length= table->s->reclength;
+  Run run(this, record_length, max(1U, union_block_size / record_length));
+  std::vector<Worker> workers(threads);
+  std::vector<Block> blocks(threads * 2);
+  uint started= 0;
+  bool error= false;
+  DBUG_ENTER("Parallel_union::exec");
+
+  run.workers= &workers[0];
+  run.n_workers= threads;
+  for (uint i= 0; i < blocks.size(); i++)
+  {
+    if (!(blocks[i].rows= (uchar*) thd->alloc((size_t) run.block_rows *
+                                              record_length)))
+      DBUG_RETURN(true);
+    run.free_blocks.push_back(&blocks[i]);
+  }
+  for (uint w= 0; w < threads; w++)
+  {
+    workers[w].run= &run;
+    if (!(workers[w].table= clone_result_table(thd, table)))
+      DBUG_RETURN(true);
+  }
+
+  if (union_result->send_result_set_metadata(unit->first_select()->item_list,
+                                             Protocol::SEND_NUM_ROWS |
+                                             Protocol::SEND_EOF))
+    DBUG_RETURN(true);
+
+  for (uint w= 0; w < threads; w++)
+  {
+    Worker *worker= &workers[w];
+    {
+      std::lock_guard<std::mutex> lock(run.mutex);
+      worker->block= run.free_blocks.back();
+      run.free_blocks.pop_back();
+      run.running++;
+    }
+    worker->started=
+      !mysql_thread_create(key_thread_union_worker, &worker->thread, NULL,
+                           worker_thread, worker);
+    if (worker->started)
+      started++;
+    else
+    {
+      std::lock_guard<std::mutex> lock(run.mutex);
+      run.free_blocks.push_back(worker->block);
+      worker->block= NULL;
+      run.running--;
+    }
+  }
+  if (!started)
+  {
+    my_error(ER_CANT_CREATE_THREAD, MYF(0), errno);
+    DBUG_RETURN(true);
+  }
+
+  /* Send the rows of the blocks in the order they are filled */
+  for (;;)
+  {
+    Block *block;
+    {
+      std::unique_lock<std::mutex> lock(run.mutex);
+      while (run.full_blocks.empty() && run.running && !run.aborted &&
+             !thd->killed)
+        run.filled.wait_for(lock, std::chrono::milliseconds(100));
+      if (run.aborted || thd->killed || run.full_blocks.empty())
+        break;
+      block= run.full_blocks.front();
+      run.full_blocks.pop_front();
+      run.rows_sent= true;
+    }
+
+    for (uint i= 0; i < block->count && !error; i++)
+      error= union_result->send_record(block->rows +
+                                       (size_t) i * record_length);
+
+    std::lock_guard<std::mutex> lock(run.mutex);
+    block->count= 0;
+    run.free_blocks.push_back(block);
+    run.emptied.notify_one();
+    if (error)
+      break;
+  }
+  if (error || run.aborted || thd->killed)
+    run.abort();
+
+  for (uint w= 0; w < threads; w++)
+  {
+    if (workers[w].started)
+    {
+      pthread_join(workers[w].thread, NULL);
+      add_to_status(&thd->status_var, &workers[w].status);
+    }
+  }
+
+  if (!error && run.run_serially && !thd->killed)
+  {
+    DBUG_PRINT("info", ("a worker failed, executing the unit serially"));
+    *run_serially= true;
+    DBUG_RETURN(false);
+  }
+
+  if (error || run.aborted || thd->killed)
+  {
+    if (!thd->is_error())
+    {
+      if (thd->killed)
+        thd->send_kill_message();
+      else if (run.error)
+        my_message(run.error, run.message, MYF(0));
+    }
+    DBUG_RETURN(true);
+  }
+
+  for (uint i= 0; i < n_branches; i++)
+  {
+    thd->lex->current_select= branches[i].select_lex;
+    thd->limit_found_rows= branches[i].found_rows;
+    *examined_rows+= branches[i].examined_rows;
+    if (union_result->send_eof())
+      DBUG_RETURN(true);
+  }
+  if (union_result->flush())
+    DBUG_RETURN(true);
+  if (unit->fake_select_lex != NULL)
+  {
+    /* Needed for the number of rows of the union */
+    int info_error= table->file->info(HA_STATUS_VARIABLE);
+    if (info_error)
+    {
+      table->file->print_error(info_error, MYF(0)); /* purecov: inspected */
+      DBUG_RETURN(true); /* purecov: inspected */
+    }
+  }
+  status_var_increment(thd->status_var.select_parallel_union_count);
+  DBUG_RETURN(false);
+}
@@ -0,0 +1,107 @@
+#ifndef SQL_UNION_PARALLEL_INCLUDED
+#define SQL_UNION_PARALLEL_INCLUDED
+
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/** @file Execution of the query blocks of a UNION ALL on worker threads */
+
+#include "my_global.h"
+#include "sql_alloc.h"
+#include "my_base.h"                            // ha_rows
+
+class THD;
+class select_union;
+class st_select_lex;
+class st_select_lex_unit;
+
+/**
+  Executes the query blocks of a top-level UNION ALL concurrently, on up to
+  parallel_union_max_threads worker threads.
+
+  Each worker has its own THD and runs query blocks, printed once the
+  session has resolved them, as separate SELECT statements. The rows are
+  stored in the record format of the union's result table and passed back
+  in blocks, which the session sends to the union's result in the order
+  they arrive.
+
+  Only query blocks whose result does not depend on the thread executing
+  them are run this way, see create(). The workers read the tables through
+  the session's explicit snapshot if it has one; otherwise the session must
+  use READ COMMITTED or a weaker isolation level outside of a transaction,
+  and each worker reads the latest committed data like a separate
+  statement would.
+
+  Allocated on the statement's mem_root.
+*/
+class Parallel_union : public Sql_alloc
+{
+public:
+  /**
+    Check whether the query blocks of unit can be executed on worker
+    threads, and print them for the workers.
+
+    Called after unit has been prepared and its tables have been locked.
+
+    @return NULL if the unit is to be executed by the session.
+  */
+  static Parallel_union *create(THD *thd, st_select_lex_unit *unit);
+
+  /**
+    Execute the query blocks and send their rows to union_result.
+
+    @param union_result        Result of the unit
+    @param[out] examined_rows  Incremented by the rows the workers examined
+    @param[out] run_serially   Set if a worker could not prepare its query
+                               block before any rows were sent; the
+                               session must then execute the unit itself
+
+    @retval false  Ok
+    @retval true   Error, which has been reported
+  */
+  bool exec(select_union *union_result, ha_rows *examined_rows,
+            bool *run_serially);
+
+private:
+  struct Branch
+  {
+    st_select_lex *select_lex;
+    char *query;                ///< The query block as a SELECT statement
+    uint query_length;
+    ha_rows found_rows;         ///< limit_found_rows of the worker
+    ha_rows examined_rows;
+  };
+  struct Block;
+  struct Run;
+  struct Worker;
+  class Worker_result;
+
+  Parallel_union(THD *thd_arg, st_select_lex_unit *unit_arg,
+                 Branch *branches_arg, uint n_branches_arg, uint threads_arg)
+    : thd(thd_arg), unit(unit_arg), branches(branches_arg),
+      n_branches(n_branches_arg), threads(threads_arg)
+  {}
+
+  static bool is_eligible(THD *thd, st_select_lex_unit *unit);
+  static void *worker_thread(void *arg);
+
+  THD *const thd;
+  st_select_lex_unit *const unit;
+  Branch *const branches;       ///< One per query block, in order
+  const uint n_branches;
+  const uint threads;           ///< Number of workers to start
+};
+
+#endif /* SQL_UNION_PARALLEL_INCLUDED */
@@ -538,6 +538,8 @@ typedef struct st_shared_sql_stats {
   ulonglong compilation_cpu; /* plan compilation CPU time in microseconds */
   ulonglong tmp_table_disk_usage; /* peak disk usage by temp tables */
   ulonglong filesort_disk_usage; /* peak disk usage by filesort */
+  uint      plan_cache_hits; /* join orders reused from the plan cache */
+  uint      plan_cache_misses; /* join orders searched and then cached */
 
   void reset_reusable_metrics()
   {
@@ -551,6 +553,8 @@ typedef struct st_shared_sql_stats {
     compilation_cpu = 0;
     tmp_table_disk_usage = 0;
     filesort_disk_usage = 0;
+    plan_cache_hits = 0;
+    plan_cache_misses = 0;
   }
 
   void reset()
@@ -1126,6 +1126,34 @@ static Sys_var_mybool Sys_binlog_order_commits(
        GLOBAL_VAR(opt_binlog_order_commits),
        CMD_LINE(OPT_ARG), DEFAULT(TRUE));
 
+static Sys_var_ulong Sys_binlog_gtid_index_interval(
+       "binlog_gtid_index_interval",
+       "Keep an index of the GTIDs of each binary log in a file next to it, "
+       "with an entry for every this many transactions, and use it to find "
+       "where to start reading a binary log for the GTIDs a slave or FIND "
+       "BINLOG GTID asks for. Takes effect at the next binary log rotation. "
+       "0 disables the index.",
+       GLOBAL_VAR(opt_binlog_gtid_index_interval), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1024*1024L), DEFAULT(0), BLOCK_SIZE(1));
+
+static bool fix_binlog_tail_cache_size(sys_var *self, THD *thd,
+                                       enum_var_type type)
+{
+  mysql_bin_log.get_tail_cache()->resize(opt_binlog_tail_cache_size);
+  return false;
+}
+
+static Sys_var_ulonglong Sys_binlog_tail_cache_size(
+       "binlog_tail_cache_size",
+       "Size in bytes of a buffer with the last bytes of the binary log "
+       "being written. Dump threads of slaves which have caught up send "
+       "events from it instead of reading the binary log file. 0 disables "
+       "the buffer.",
+       GLOBAL_VAR(opt_binlog_tail_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, ULONG_MAX), DEFAULT(0), BLOCK_SIZE(IO_SIZE),
+       NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
+       ON_UPDATE(fix_binlog_tail_cache_size));
+
 #ifdef HAVE_REPLICATION
 static Sys_var_mybool Sys_reset_seconds_behind_master(
        "reset_seconds_behind_master",
@@ -2792,6 +2820,34 @@ static Sys_var_mybool Sys_optimizer_full_scan(
       SESSION_VAR(optimizer_full_scan),
       CMD_LINE(OPT_ARG), DEFAULT(TRUE));
 
+static Sys_var_ulong Sys_batch_filter_rows(
+      "batch_filter_rows",
+      "Number of rows a table scan reads ahead to evaluate the simple "
+      "integer comparisons of its WHERE condition on the whole block at "
+      "once, before the remaining condition is checked row by row. "
+      "0 disables batch evaluation.",
+      SESSION_VAR(batch_filter_rows), CMD_LINE(REQUIRED_ARG),
+      VALID_RANGE(0, 65536), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_parallel_union_max_threads(
+      "parallel_union_max_threads",
+      "The max number of worker threads on which the SELECTs of a "
+      "top-level UNION ALL are executed concurrently, their rows being "
+      "returned in any order. SELECTs using non-deterministic functions, "
+      "subqueries or non-transactional tables are always executed by the "
+      "session thread. 0 disables parallel execution.",
+      SESSION_VAR(parallel_union_max_threads), CMD_LINE(REQUIRED_ARG),
+      VALID_RANGE(0, 64), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_mybool Sys_optimizer_plan_cache(
+      "optimizer_plan_cache",
+      "Keep the join order chosen for each query block of a prepared "
+      "statement and reuse it on later executions, skipping the join order "
+      "search, as long as the tables, their row estimates and the constant "
+      "tables of the query block are unchanged.",
+      SESSION_VAR(optimizer_plan_cache),
+      CMD_LINE(OPT_ARG), DEFAULT(FALSE));
+
 static Sys_var_double Sys_optimizer_group_by_cost_adjust(
     "optimizer_group_by_cost_adjust",
     "Adjust cost of loose index scan group-by plan by this factor.",
@@ -3150,6 +3206,18 @@ static Sys_var_uint Sys_part_scan_max(
        SESSION_VAR(part_scan_max), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(1, UINT_MAX32), DEFAULT(10), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_partition_scan_max_threads(
+       "partition_scan_max_threads",
+       "The max number of worker threads on which the partitions of a "
+       "table are read concurrently during a table or index scan. Scans "
+       "returning rows in index order need a thread for each partition. "
+       "Transactional tables are only read in parallel under READ "
+       "COMMITTED or with an explicit snapshot. Tables with BLOB columns "
+       "and tables that the statement changes are read serially. 0 "
+       "disables parallel scans.",
+       SESSION_VAR(partition_scan_max_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 64), DEFAULT(0), BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_range_alloc_block_size(
        "range_alloc_block_size",
        "Allocation block size for storing ranges during optimization",
@@ -3753,6 +3821,43 @@ static Sys_var_set Slave_rows_search_algorithms(
        slave_rows_search_algorithms_names,
        DEFAULT(SLAVE_ROWS_INDEX_SCAN | SLAVE_ROWS_TABLE_SCAN),  NO_MUTEX_GUARD,
        NOT_IN_BINLOG, ON_CHECK(slave_rows_search_algorithms_check), ON_UPDATE(NULL));
+
+static Sys_var_ulong Sys_slave_rows_lookup_batch_size(
+       "slave_rows_lookup_batch_size",
+       "Maximum number of rows of an update or delete rows event whose "
+       "rows the slave reads in one multi-range read before looking them "
+       "up one at a time with INDEX_SCAN, or with HASH_SCAN over an index. "
+       "Use 0 or 1 to disable",
+       GLOBAL_VAR(opt_slave_rows_lookup_batch_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 65536), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_uint Sys_slave_prefetch_threads(
+       "slave_prefetch_threads",
+       "Number of threads which look up the rows of the row events in the "
+       "relay log before the slave SQL thread applies them, and those of "
+       "large transactions ahead of the dependency slave workers, so that "
+       "they are in the storage engine's cache. Takes effect when the SQL "
+       "thread starts. Use 0 to disable",
+       GLOBAL_VAR(opt_slave_prefetch_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 64), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_ulonglong Sys_slave_prefetch_window(
+       "slave_prefetch_window",
+       "Maximum number of bytes of the relay log the slave prefetch threads "
+       "read ahead of the SQL thread, and of the row events of a large "
+       "transaction they look up ahead of a dependency slave worker",
+       GLOBAL_VAR(opt_slave_prefetch_window), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(IO_SIZE, ULONG_MAX), DEFAULT(16*1024*1024),
+       BLOCK_SIZE(IO_SIZE));
+
+static Sys_var_ulonglong Sys_slave_prefetch_large_trx_size(
+       "slave_prefetch_large_trx_size",
+       "Number of bytes of a transaction a dependency slave worker applies "
+       "before the slave prefetch threads look up the rows of the rest of it "
+       "ahead of the worker. Use 0 to look them up from the start of every "
+       "transaction",
+       GLOBAL_VAR(opt_slave_prefetch_large_trx_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, ULONG_MAX), DEFAULT(16*1024*1024), BLOCK_SIZE(1));
 #endif
 
 bool Sys_var_enum_binlog_checksum::global_update(THD *thd, set_var *var)
@@ -4324,6 +4429,15 @@ static Sys_var_ulonglong Sys_tmp_table_max_file_size(
        VALID_RANGE(0, ULONGLONG_MAX), DEFAULT(0),
        BLOCK_SIZE(1));
 
+static Sys_var_mybool Sys_tmp_table_memory_blobs(
+       "tmp_table_memory_blobs",
+       "Create internal temporary tables with BLOB columns or unique "
+       "constraints in memory too, storing the BLOB values at their actual "
+       "length. Such a table is converted to an on-disk MyISAM table once it "
+       "exceeds tmp_table_size or max_heap_table_size.",
+       SESSION_VAR(tmp_table_memory_blobs), CMD_LINE(OPT_ARG),
+       DEFAULT(FALSE));
+
 static Sys_var_ulonglong Sys_tmp_table_rpl_max_file_size(
        "tmp_table_rpl_max_file_size",
        "The max size of a file to use for a temporary table for replication "
@@ -4340,6 +4454,22 @@ static Sys_var_ulonglong Sys_filesort_max_file_size(
        VALID_RANGE(0, ULONGLONG_MAX), DEFAULT(0),
        BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_filesort_max_threads(
+       "filesort_max_threads",
+       "The max number of threads, including the session thread, a "
+       "filesort may use to sort buffers and run merge passes in "
+       "parallel. 1 means the sort is done on the session thread only.",
+       SESSION_VAR(filesort_max_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, 64), DEFAULT(1), BLOCK_SIZE(1));
+
+static Sys_var_mybool Sys_filesort_packed_records(
+       "filesort_packed_records",
+       "Store the strings of the sort key and of the sorted columns at "
+       "their actual length rather than padded to their maximum length, so "
+       "that more rows fit in the sort buffer and in each merge run.",
+       SESSION_VAR(filesort_packed_records), CMD_LINE(OPT_ARG),
+       DEFAULT(FALSE));
+
 static Sys_var_mybool Sys_timed_mutexes(
        "timed_mutexes",
        "Specify whether to time mutexes. Deprecated, has no effect.",
@@ -5479,6 +5609,13 @@ static Sys_var_ulonglong Sys_relay_log_space_limit(
        READ_ONLY GLOBAL_VAR(relay_log_space_limit), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, ULONG_MAX), DEFAULT(0), BLOCK_SIZE(1));
 
+static Sys_var_ulonglong Sys_relay_log_event_queue_size(
+       "relay_log_event_queue_size", "Maximum size of the events the "
+       "slave I/O thread parses and hands to the SQL thread, which then "
+       "need not read them from the relay log again. Use 0 to disable",
+       GLOBAL_VAR(opt_relay_log_event_queue_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, ULONG_MAX), DEFAULT(0), BLOCK_SIZE(IO_SIZE));
+
 static Sys_var_uint Sys_sync_relaylog_period(
        "sync_relay_log", "Synchronously flush relay log to disk after "
        "every #th event. Use 0 to disable synchronous flushing",
@@ -5654,6 +5791,16 @@ static Sys_var_enum Sys_mts_dependency_order_commits(
        GLOBAL_VAR(opt_mts_dependency_order_commits),
        CMD_LINE(OPT_ARG), commit_order_type_names, DEFAULT(DEP_RPL_ORDER_DB));
 
+static Sys_var_ulonglong Sys_slave_commit_group_wait_usec(
+       "slave_commit_group_wait_usec",
+       "Maximum time (in microsecs), in total, the slave worker leading a "
+       "binlog group commit waits for the workers committing next in order, "
+       "which are ready to commit, to join its group so that they share one "
+       "sync. The leader holds the binlog lock while it waits. Used when "
+       "mts_dependency_order_commits orders the commits. 0 disables the wait",
+       GLOBAL_VAR(opt_slave_commit_group_wait_usec), CMD_LINE(OPT_ARG),
+       VALID_RANGE(0, 1000000), DEFAULT(0), BLOCK_SIZE(1));
+
 static Sys_var_ulonglong Sys_mts_dependency_cond_wait_timeout(
        "mts_dependency_cond_wait_timeout",
        "Timeout for all conditional waits in dependency repl in milliseconds",
@@ -349,8 +349,8 @@ public:
 
   Filesort_info(): record_pointers(0) {};
   /** Sort filesort_buffer */
-  void sort_buffer(Sort_param *param, uint count)
-  { filesort_buffer.sort_buffer(param, count); }
+  void sort_buffer(Sort_param *param, uint count, uint first= 0)
+  { filesort_buffer.sort_buffer(param, count, first); }
 
   /**
      Accessors for Filesort_buffer (which @c).
@@ -370,6 +370,15 @@ public:
   void init_record_pointers()
   { filesort_buffer.init_record_pointers(); }
 
+  void init_packed_records()
+  { filesort_buffer.init_packed_records(); }
+
+  uchar *get_packed_record_buffer(uint max_length)
+  { return filesort_buffer.get_packed_record_buffer(max_length); }
+
+  void commit_packed_record(uchar *record, uint length)
+  { filesort_buffer.commit_packed_record(record, length); }
+
   size_t sort_buffer_size() const
   { return filesort_buffer.sort_buffer_size(); }
 };
@@ -28,6 +28,12 @@
 
   The unique entries will be returned in sort order, to ensure that we do the
   deletes in disk order.
+
+  When the keys can be compared as bytes, an open addressing hash set is
+  used instead of the tree: an insert is one hash and usually one memcmp,
+  and the keys are copied to a MEM_ROOT instead of being malloc'ed one by
+  one. The keys are sorted only when the set is written to disk or read
+  back, so the disk format and the merge are the same as with the tree.
 */
 
 #include "sql_priv.h"
@@ -36,6 +42,11 @@
 #include "queues.h"                             // QUEUE
 #include "my_tree.h"                            // element_count
 #include "sql_class.h"                          // Unique
+#include "my_murmur3.h"                         // murmur3_32
+
+/* Initial number of slots and block size of the MEM_ROOT of the hash set */
+static const ulong UNIQUE_HASH_MIN_SIZE= 256;
+static const size_t UNIQUE_HASH_BLOCK_SIZE= 8192;
 
 int unique_write_to_file(uchar* key, element_count count, Unique *unique)
 {
@@ -55,11 +66,30 @@ int unique_write_to_ptrs(uchar* key, element_count count, Unique *unique)
   return 0;
 }
 
+/*
+  SYNOPSIS
+    Unique::Unique()
+      comp_func             Key comparison function
+      comp_func_fixed_arg   First argument of comp_func
+      size_arg              Size of a key
+      max_in_memory_size_arg  Memory to use before the keys are written to
+                            a temporary file
+      use_hash_arg          Use a hash set instead of a tree. Only valid
+                            when comp_func returns 0 exactly for keys with
+                            equal bytes.
+*/
+
 Unique::Unique(qsort_cmp2 comp_func, void * comp_func_fixed_arg,
-	       uint size_arg, ulonglong max_in_memory_size_arg)
+	       uint size_arg, ulonglong max_in_memory_size_arg,
+               bool use_hash_arg)
   :max_in_memory_size(max_in_memory_size_arg),
    record_pointers(NULL),
    size(size_arg),
+   use_hash(use_hash_arg),
+   hash_sorted(false),
+   hash_slots(NULL),
+   hash_size(0),
+   hash_elements(0),
    elements(0)
 {
   my_b_clear(&file);
@@ -72,6 +102,13 @@ Unique::Unique(qsort_cmp2 comp_func, void * comp_func_fixed_arg,
   */
   max_elements= (ulong) (max_in_memory_size /
                          ALIGN_SIZE(sizeof(TREE_ELEMENT)+size));
+  if (use_hash)
+  {
+    /* A key copy, and up to four slots as the set is at most half full */
+    max_elements= (ulong) (max_in_memory_size /
+                           (ALIGN_SIZE(size) + 4 * sizeof(uchar*)));
+    init_alloc_root(&hash_root, UNIQUE_HASH_BLOCK_SIZE, 0);
+  }
   (void) open_cached_file(&file, mysql_tmpdir,TEMP_PREFIX, DISK_BUFFER_SIZE,
 		   MYF(MY_WME));
 }
@@ -321,6 +358,11 @@ Unique::~Unique()
   close_cached_file(&file);
   delete_tree(&tree);
   delete_dynamic(&file_ptrs);
+  if (use_hash)
+  {
+    free_root(&hash_root, MYF(0));
+    my_free(hash_slots);
+  }
 }
 
 
@@ -328,10 +370,23 @@ Unique::~Unique()
 bool Unique::flush()
 {
   BUFFPEK file_ptr;
-  elements+= tree.elements_in_tree;
-  file_ptr.count=tree.elements_in_tree;
+  elements+= elements_in_tree();
+  file_ptr.count= elements_in_tree();
   file_ptr.file_pos=my_b_tell(&file);
 
+  if (use_hash)
+  {
+    hash_sort();
+    for (ulong i= 0; i < hash_elements; i++)
+    {
+      if (unique_write_to_file(hash_slots[i], 1, this))
+        return 1;
+    }
+    if (insert_dynamic(&file_ptrs, &file_ptr))
+      return 1;
+    hash_clear();
+    return 0;
+  }
   if (tree_walk(&tree, (tree_walk_action) unique_write_to_file,
 		(void*) this, left_root_right) ||
       insert_dynamic(&file_ptrs, &file_ptr))
@@ -349,7 +404,10 @@ bool Unique::flush()
 void
 Unique::reset()
 {
-  reset_tree(&tree);
+  if (use_hash)
+    hash_clear();
+  else
+    reset_tree(&tree);
   /*
     If elements != 0, some trees were stored in the file (see how
     flush() works). Note, that we can not count on my_b_tell(&file) == 0
@@ -383,6 +441,116 @@ static int buffpek_compare(void *arg, uchar *key_ptr1, uchar *key_ptr2)
 C_MODE_END
 
 
+/*
+  Add a key to the hash set, unless it is there already.
+
+  SYNOPSIS
+    Unique::hash_insert()
+      key   Key of size bytes
+
+  RETURN
+    0   ok
+    1   out of memory
+*/
+
+bool Unique::hash_insert(uchar *key)
+{
+  if ((hash_elements + 1) * 2 > hash_size)
+  {
+    if (hash_resize(hash_size ? hash_size * 2 : UNIQUE_HASH_MIN_SIZE))
+      return 1;
+  }
+  else if (hash_sorted && hash_resize(hash_size))
+    return 1;
+
+  const ulong mask= hash_size - 1;
+  for (ulong i= murmur3_32(key, size, 0) & mask; ; i= (i + 1) & mask)
+  {
+    uchar *slot= hash_slots[i];
+    if (slot == NULL)
+    {
+      if (!(slot= (uchar*) alloc_root(&hash_root, size)))
+        return 1;
+      memcpy(slot, key, size);
+      hash_slots[i]= slot;
+      hash_elements++;
+      return 0;
+    }
+    if (!memcmp(slot, key, size))
+      return 0;
+  }
+}
+
+
+/*
+  Move the keys to a new slot array of new_size slots. Also used to
+  rebuild the set after hash_sort().
+*/
+
+bool Unique::hash_resize(ulong new_size)
+{
+  uchar **new_slots;
+  if (!(new_slots= (uchar**) my_malloc(new_size * sizeof(uchar*),
+                                       MYF(MY_ZEROFILL))))
+    return 1;
+  const ulong mask= new_size - 1;
+  for (ulong i= 0; i < hash_size; i++)
+  {
+    uchar *key= hash_slots[i];
+    if (key == NULL)
+      continue;
+    ulong j= murmur3_32(key, size, 0) & mask;
+    while (new_slots[j])
+      j= (j + 1) & mask;
+    new_slots[j]= key;
+  }
+  my_free(hash_slots);
+  hash_slots= new_slots;
+  hash_size= new_size;
+  hash_sorted= false;
+  return 0;
+}
+
+
+/*
+  Move the keys to the first hash_elements slots and sort them with the
+  compare function of the tree. The set is rebuilt by the next insert.
+*/
+
+void Unique::hash_sort()
+{
+  if (hash_sorted)
+    return;
+  ulong n= 0;
+  for (ulong i= 0; i < hash_size; i++)
+  {
+    if (hash_slots[i])
+    {
+      uchar *key= hash_slots[i];
+      hash_slots[i]= NULL;
+      hash_slots[n++]= key;
+    }
+  }
+  DBUG_ASSERT(n == hash_elements);
+  BUFFPEK_COMPARE_CONTEXT compare_context= { tree.compare, tree.custom_arg };
+  my_qsort2(hash_slots, n, sizeof(uchar*), (qsort2_cmp) buffpek_compare,
+            &compare_context);
+  hash_sorted= true;
+}
+
+
+/* Remove all keys from the hash set, keeping its memory */
+
+void Unique::hash_clear()
+{
+  if (hash_slots)
+    memset(hash_slots, 0, hash_size * sizeof(uchar*));
+  free_root(&hash_root, MYF(MY_MARK_BLOCKS_FREE));
+  hash_elements= 0;
+  hash_sorted= false;
+}
+
+
 /*
   DESCRIPTION
 
@@ -554,7 +722,19 @@ bool Unique::walk(tree_walk_action action, void *walk_action_arg)
   uchar *merge_buffer;
 
   if (elements == 0)                       /* the whole tree is in memory */
+  {
+    if (use_hash)
+    {
+      hash_sort();
+      for (ulong i= 0; i < hash_elements; i++)
+      {
+        if (action(hash_slots[i], 1, walk_action_arg))
+          return 1;
+      }
+      return 0;
+    }
     return tree_walk(&tree, action, walk_action_arg, left_root_right);
+  }
 
   /* flush current tree to the file to have some memory for merge buffer */
   if (flush())
@@ -579,17 +759,24 @@ bool Unique::walk(tree_walk_action action, void *walk_action_arg)
 
 bool Unique::get(TABLE *table)
 {
-  table->sort.found_records=elements+tree.elements_in_tree;
+  table->sort.found_records=elements+elements_in_tree();
 
   if (my_b_tell(&file) == 0)
   {
     /* Whole tree is in memory;  Don't use disk if you don't need to */
     DBUG_ASSERT(table->sort.record_pointers == NULL);
     if ((record_pointers=table->sort.record_pointers= (uchar*)
-	 my_malloc(size * tree.elements_in_tree, MYF(0))))
+	 my_malloc(size * elements_in_tree(), MYF(0))))
     {
-      (void) tree_walk(&tree, (tree_walk_action) unique_write_to_ptrs,
-		       this, left_root_right);
+      if (use_hash)
+      {
+        hash_sort();
+        for (ulong i= 0; i < hash_elements; i++)
+          (void) unique_write_to_ptrs(hash_slots[i], 1, this);
+      }
+      else
+        (void) tree_walk(&tree, (tree_walk_action) unique_write_to_ptrs,
+                         this, left_root_right);
       return 0;
     }
   }
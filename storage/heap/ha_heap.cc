@@ -158,10 +158,13 @@ int ha_heap::close(void)
     with '\'-delimited path.
 */
 
-handler *ha_heap::clone(const char *name, MEM_ROOT *mem_root)
+handler *ha_heap::clone(const char *name, MEM_ROOT *mem_root,
+                        TABLE *table_arg)
 {
-  handler *new_handler= get_new_handler(table->s, mem_root, table->s->db_type());
-  if (new_handler && !new_handler->ha_open(table, file->s->name, table->db_stat,
+  handler *new_handler= get_new_handler(table_arg->s, mem_root,
+                                        table_arg->s->db_type());
+  if (new_handler && !new_handler->ha_open(table_arg, file->s->name,
+                                           table_arg->db_stat,
                                            HA_OPEN_IGNORE_IF_LOCKED))
     return new_handler;
   return NULL;  /* purecov: inspected */
@@ -429,6 +432,8 @@ int ha_heap::info(uint flag)
   (void) heap_info(file,&hp_info,flag);
 
   errkey=                     hp_info.errkey;
+  if (flag & HA_STATUS_ERRKEY)
+    *(HEAP_PTR*) dup_ref= hp_info.dupp_key_pos; // Ref is aligned
   stats.records=              hp_info.records;
   stats.deleted=              hp_info.deleted;
   stats.mean_rec_length=      hp_info.reclength;
@@ -677,6 +682,7 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
   ha_rows max_rows;
   HP_KEYDEF *keydef;
   HA_KEYSEG *seg;
+  HP_BLOB_DESC *blob_descs;
   TABLE_SHARE *share= table_arg->s;
   bool found_real_auto_increment= 0;
 
@@ -686,10 +692,23 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
     parts+= table_arg->key_info[key].user_defined_key_parts;
 
   if (!(keydef= (HP_KEYDEF*) my_malloc(keys * sizeof(HP_KEYDEF) +
-				       parts * sizeof(HA_KEYSEG),
+				       parts * sizeof(HA_KEYSEG) +
+				       share->blob_fields *
+				       sizeof(HP_BLOB_DESC),
 				       MYF(MY_WME))))
     return my_errno;
   seg= reinterpret_cast<HA_KEYSEG*>(keydef + keys);
+  blob_descs= reinterpret_cast<HP_BLOB_DESC*>(seg + parts);
+
+  /* Only internal temporary tables are created with BLOB columns */
+  for (uint i= 0; i < share->blob_fields; i++)
+  {
+    Field_blob *field= (Field_blob*) table_arg->field[share->blob_field[i]];
+    DBUG_ASSERT(internal_table && (field->flags & BLOB_FLAG));
+    blob_descs[i].offset= field->offset(table_arg->record[0]);
+    blob_descs[i].packlength= field->pack_length_no_ptr();
+  }
+
   for (key= 0; key < keys; key++)
   {
     KEY *pos= table_arg->key_info+key;
@@ -699,6 +718,14 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
     keydef[key].keysegs=   (uint) pos->user_defined_key_parts;
     keydef[key].flag=      (pos->flags & (HA_NOSAME | HA_NULL_ARE_EQUAL));
     keydef[key].seg=       seg;
+    /*
+      A unique constraint of an internal temporary table (see
+      create_tmp_table()) is kept as a hash index over the whole values.
+      Like MI_UNIQUEDEF it treats NULLs, and values that only differ in
+      trailing spaces, as equal.
+    */
+    if (share->uniques)
+      keydef[key].flag|= HA_NULL_ARE_EQUAL;
 
     switch (pos->algorithm) {
     case HA_KEY_ALG_UNDEF:
@@ -732,6 +759,15 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
       seg->start=   (uint) key_part->offset;
       seg->length=  (uint) key_part->length;
       seg->flag=    key_part->key_part_flag;
+      if (share->uniques)
+        seg->flag|= HA_END_SPACE_ARE_EQUAL;
+      if (field->flags & BLOB_FLAG)
+      {
+        DBUG_ASSERT(share->uniques && pos->algorithm != HA_KEY_ALG_BTREE);
+        seg->flag|= HA_BLOB_PART;
+        seg->length= 0;                         // Whole value
+        seg->bit_start= (uint8) ((Field_blob*) field)->pack_length_no_ptr();
+      }
 
       if (field->flags & (ENUM_FLAG | SET_FLAG))
         seg->charset= &my_charset_bin;
@@ -769,6 +805,13 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
   hp_create_info->auto_key= auto_key;
   hp_create_info->auto_key_type= auto_key_type;
   hp_create_info->max_table_size=current_thd->variables.max_heap_table_size;
+  /*
+    max_rows does not limit the size of the BLOB values, so the byte limit of
+    the table has to include tmp_table_size as well.
+  */
+  if (share->blob_fields)
+    set_if_smaller(hp_create_info->max_table_size,
+                   current_thd->variables.tmp_table_size);
   hp_create_info->with_auto_increment= found_real_auto_increment;
   hp_create_info->internal_table= internal_table;
 
@@ -781,6 +824,8 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
   hp_create_info->keys= share->keys;
   hp_create_info->reclength= share->reclength;
   hp_create_info->keydef= keydef;
+  hp_create_info->blob_descs= blob_descs;
+  hp_create_info->blobs= share->blob_fields;
   return 0;
 }
 
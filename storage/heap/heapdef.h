@@ -32,6 +32,18 @@ C_MODE_START
 #define HP_MIN_RECORDS_IN_BLOCK 16
 #define HP_MAX_RECORDS_IN_BLOCK 8192
 
+/* Header of the allocation holding one stored BLOB value */
+
+typedef struct st_hp_blob_chunk
+{
+  struct st_hp_blob_chunk *prev, *next; /* In HP_SHARE::blob_chunks */
+  size_t length;                        /* Allocated length of the value */
+} HP_BLOB_CHUNK;
+
+/* Bytes a BLOB value of the given length adds to the table size */
+
+#define HP_BLOB_CHUNK_SIZE(length) ALIGN_SIZE(sizeof(HP_BLOB_CHUNK) + (length))
+
 	/* Some extern variables */
 
 extern LIST *heap_open_list,*heap_share_list;
@@ -100,6 +112,14 @@ extern void hp_clear(HP_SHARE *info);
 extern void hp_clear_keys(HP_SHARE *info);
 extern uint hp_rb_pack_key(HP_KEYDEF *keydef, uchar *key, const uchar *old,
                            key_part_map keypart_map);
+extern uint hp_blob_length(uint packlength, const uchar *pos);
+extern const uchar *hp_blob_data(HA_KEYSEG *seg, const uchar *rec,
+                                 uint *length);
+extern size_t hp_blobs_length(HP_SHARE *share, const uchar *record);
+extern int hp_store_blobs(HP_SHARE *share, uchar *pos, const uchar *old);
+extern void hp_free_blobs(HP_SHARE *share, const uchar *record,
+                          const uchar *keep);
+extern void hp_free_all_blobs(HP_SHARE *share);
 
 extern mysql_mutex_t THR_LOCK_heap;
 
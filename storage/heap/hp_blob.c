@@ -0,0 +1,230 @@
+/*
+   Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/*
+  BLOB columns of internal temporary tables.
+
+  The record keeps the server's BLOB format (length followed by a pointer).
+  On write every value is copied to an allocation of its own, so only the
+  bytes actually used are kept in memory, and the stored record points to the
+  copy. The allocations are linked from HP_SHARE::blob_chunks and are freed
+  when their row is updated to other values or deleted, or when the table is
+  cleared.
+*/
+
+#include "heapdef.h"
+
+/* Length of a BLOB value stored with packlength bytes at pos */
+
+uint hp_blob_length(uint packlength, const uchar *pos)
+{
+  switch (packlength) {
+  case 1:
+    return (uint) *pos;
+  case 2:
+    return uint2korr(pos);
+  case 3:
+    return uint3korr(pos);
+  case 4:
+    return uint4korr(pos);
+  default:
+    DBUG_ASSERT(0);
+    return 0;
+  }
+}
+
+
+/*
+  Value of a BLOB key segment in a record
+
+  SYNOPSIS
+    hp_blob_data()
+    seg			Key segment with HA_BLOB_PART, bit_start holds the
+			number of bytes used to store the length
+    rec			Record
+    length	OUT	Length of the value
+
+  RETURN
+    Pointer to the value
+*/
+
+const uchar *hp_blob_data(HA_KEYSEG *seg, const uchar *rec, uint *length)
+{
+  const uchar *pos= rec + seg->start;
+  const uchar *data;
+  *length= hp_blob_length(seg->bit_start, pos);
+  memcpy(&data, pos + seg->bit_start, sizeof(data));
+  return data;
+}
+
+
+/* Number of bytes the BLOB values of a record will add to the table size */
+
+size_t hp_blobs_length(HP_SHARE *share, const uchar *record)
+{
+  HP_BLOB_DESC *blob, *end;
+  size_t length= 0;
+
+  for (blob= share->blob_descs, end= blob + share->blobs; blob < end; blob++)
+  {
+    uint blob_length= hp_blob_length(blob->packlength, record + blob->offset);
+    if (blob_length)
+      length+= HP_BLOB_CHUNK_SIZE(blob_length);
+  }
+  return length;
+}
+
+
+/* Pointer to the value of a BLOB column, 0 if the value is empty */
+
+static uchar *hp_blob_ptr(HP_BLOB_DESC *blob, const uchar *record)
+{
+  const uchar *field= record + blob->offset;
+  uchar *data;
+  if (!hp_blob_length(blob->packlength, field))
+    return 0;
+  memcpy(&data, field + blob->packlength, sizeof(data));
+  return data;
+}
+
+
+static uchar *hp_alloc_blob(HP_SHARE *share, size_t length)
+{
+  HP_BLOB_CHUNK *chunk;
+
+  if (!(chunk= (HP_BLOB_CHUNK*) my_malloc(sizeof(HP_BLOB_CHUNK) + length,
+                                          MYF(0))))
+    return 0;
+  chunk->length= length;
+  chunk->prev= 0;
+  if ((chunk->next= share->blob_chunks))
+    chunk->next->prev= chunk;
+  share->blob_chunks= chunk;
+  share->data_length+= HP_BLOB_CHUNK_SIZE(length);
+  return (uchar*) (chunk + 1);
+}
+
+
+static void hp_free_blob(HP_SHARE *share, uchar *data)
+{
+  HP_BLOB_CHUNK *chunk= ((HP_BLOB_CHUNK*) data) - 1;
+
+  if (chunk->prev)
+    chunk->prev->next= chunk->next;
+  else
+    share->blob_chunks= chunk->next;
+  if (chunk->next)
+    chunk->next->prev= chunk->prev;
+  share->data_length-= HP_BLOB_CHUNK_SIZE(chunk->length);
+  my_free(chunk);
+}
+
+
+/*
+  Copy the BLOB values of a stored record to allocations of the table
+
+  SYNOPSIS
+    hp_store_blobs()
+    share		Table
+    pos			Stored record; its BLOB pointers still refer to the
+			caller's buffers
+    old			Previous version of the record on update, else 0
+
+  NOTES
+    Values that are unchanged since old was read from the table already
+    belong to the row and are not copied again. This keeps the repeated
+    updates of a GROUP BY row cheap. On failure the copies made so far are
+    freed again.
+
+  RETURN
+    0			ok
+    HA_ERR_OUT_OF_MEM	Could not allocate a value
+*/
+
+int hp_store_blobs(HP_SHARE *share, uchar *pos, const uchar *old)
+{
+  HP_BLOB_DESC *blob, *end;
+  DBUG_ENTER("hp_store_blobs");
+
+  for (blob= share->blob_descs, end= blob + share->blobs; blob < end; blob++)
+  {
+    uchar *field= pos + blob->offset;
+    uint length= hp_blob_length(blob->packlength, field);
+    uchar *data, *copy;
+
+    if (!length)
+      continue;
+    memcpy(&data, field + blob->packlength, sizeof(data));
+    if (old && data == hp_blob_ptr(blob, old) &&
+        length <= hp_blob_length(blob->packlength, old + blob->offset))
+      continue;
+    if (!(copy= hp_alloc_blob(share, length)))
+    {
+      /* Free the copies made so far, the caller keeps the old values */
+      HP_BLOB_DESC *done;
+      for (done= share->blob_descs; done < blob; done++)
+      {
+        if ((data= hp_blob_ptr(done, pos)) &&
+            (!old || data != hp_blob_ptr(done, old)))
+          hp_free_blob(share, data);
+      }
+      DBUG_RETURN(my_errno= HA_ERR_OUT_OF_MEM);
+    }
+    memcpy(copy, data, length);
+    memcpy(field + blob->packlength, &copy, sizeof(copy));
+  }
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Free the BLOB values of a row
+
+  SYNOPSIS
+    hp_free_blobs()
+    share		Table
+    record		Row whose values were stored by hp_store_blobs()
+    keep		New version of the row on update, its values are kept
+			even when they are shared with record; else 0
+*/
+
+void hp_free_blobs(HP_SHARE *share, const uchar *record, const uchar *keep)
+{
+  HP_BLOB_DESC *blob, *end;
+
+  for (blob= share->blob_descs, end= blob + share->blobs; blob < end; blob++)
+  {
+    uchar *data= hp_blob_ptr(blob, record);
+    if (data && (!keep || data != hp_blob_ptr(blob, keep)))
+      hp_free_blob(share, data);
+  }
+}
+
+
+/* Free all BLOB values of the table */
+
+void hp_free_all_blobs(HP_SHARE *share)
+{
+  HP_BLOB_CHUNK *chunk, *next;
+
+  for (chunk= share->blob_chunks; chunk; chunk= next)
+  {
+    next= chunk->next;
+    share->data_length-= HP_BLOB_CHUNK_SIZE(chunk->length);
+    my_free(chunk);
+  }
+  share->blob_chunks= 0;
+}
@@ -72,6 +72,17 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
 	  if (keyinfo->algorithm == HA_KEY_ALG_BTREE)
 	    keyinfo->rb_tree.size_of_element++;
 	}
+        if (keyinfo->seg[j].flag & HA_BLOB_PART)
+        {
+          /*
+            Whole BLOB value of a unique constraint, only usable for hash
+            indexes. bit_start is already the number of bytes used to store
+            the length in the record.
+          */
+          DBUG_ASSERT(keyinfo->algorithm == HA_KEY_ALG_HASH);
+          keyinfo->seg[j].type= HA_KEYTYPE_VARTEXT1;
+          continue;
+        }
 	switch (keyinfo->seg[j].type) {
 	case HA_KEYTYPE_SHORT_INT:
 	case HA_KEYTYPE_LONG_INT:
@@ -133,12 +144,17 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
     }
     if (!(share= (HP_SHARE*) my_malloc((uint) sizeof(HP_SHARE)+
 				       keys*sizeof(HP_KEYDEF)+
-				       key_segs*sizeof(HA_KEYSEG),
+				       key_segs*sizeof(HA_KEYSEG)+
+				       create_info->blobs*sizeof(HP_BLOB_DESC),
 				       MYF(MY_ZEROFILL))))
       goto err;
     share->keydef= (HP_KEYDEF*) (share + 1);
     share->key_stat_version= 1;
     keyseg= (HA_KEYSEG*) (share->keydef + keys);
+    share->blob_descs= (HP_BLOB_DESC*) (keyseg + key_segs);
+    share->blobs= create_info->blobs;
+    memcpy(share->blob_descs, create_info->blob_descs,
+           (size_t) (sizeof(HP_BLOB_DESC) * create_info->blobs));
     init_block(&share->block, reclength + 1, min_records, max_records);
 	/* Fix keys */
     memcpy(share->keydef, keydef, (size_t) (sizeof(keydef[0]) * keys));
@@ -320,7 +320,13 @@ ulong hp_rec_hashnr(register HP_KEYDEF *keydef, register const uchar *rec)
 	continue;
       }
     }
-    if (seg->type == HA_KEYTYPE_TEXT)
+    if (seg->flag & HA_BLOB_PART)
+    {
+      uint length;
+      const uchar *data= hp_blob_data(seg, rec, &length);
+      seg->charset->coll->hash_sort(seg->charset, data, length, &nr, &nr2);
+    }
+    else if (seg->type == HA_KEYTYPE_TEXT)
     {
       const CHARSET_INFO *cs= seg->charset;
       uint char_length= seg->length;
@@ -449,7 +455,13 @@ ulong hp_rec_hashnr(register HP_KEYDEF *keydef, register const uchar *rec)
 	continue;
       }
     }
-    if (seg->type == HA_KEYTYPE_TEXT)
+    if (seg->flag & HA_BLOB_PART)
+    {
+      uint length;
+      const uchar *data= hp_blob_data(seg, rec, &length);
+      seg->charset->coll->hash_sort(seg->charset, data, length, &nr, &nr2);
+    }
+    else if (seg->type == HA_KEYTYPE_TEXT)
     {
       uint char_length= seg->length; /* TODO: fix to use my_charpos() */
       seg->charset->coll->hash_sort(seg->charset, pos, char_length,
@@ -514,7 +526,18 @@ int hp_rec_key_cmp(HP_KEYDEF *keydef, const uchar *rec1, const uchar *rec2,
       if (rec1[seg->null_pos] & seg->null_bit)
 	continue;
     }
-    if (seg->type == HA_KEYTYPE_TEXT)
+    if (seg->flag & HA_BLOB_PART)
+    {
+      uint length1, length2;
+      const uchar *data1= hp_blob_data(seg, rec1, &length1);
+      const uchar *data2= hp_blob_data(seg, rec2, &length2);
+      if (seg->charset->coll->strnncollsp(seg->charset,
+                                          data1, length1, data2, length2,
+                                          seg->flag & HA_END_SPACE_ARE_EQUAL ?
+                                          0 : diff_if_only_endspace_difference))
+        return 1;
+    }
+    else if (seg->type == HA_KEYTYPE_TEXT)
     {
       const CHARSET_INFO *cs= seg->charset;
       uint char_length1;
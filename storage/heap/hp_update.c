@@ -31,6 +31,16 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
 
   if (info->opt_flag & READ_CHECK_USED && hp_rectest(info,old))
     DBUG_RETURN(my_errno);				/* Record changed */
+  /* Growing BLOB values count against the size limit, as in heap_write() */
+  if (share->blobs)
+  {
+    size_t new_length= hp_blobs_length(share, heap_new);
+    size_t old_length= hp_blobs_length(share, old);
+    if (new_length > old_length &&
+        share->data_length + share->index_length + new_length - old_length >=
+        share->max_table_size)
+      DBUG_RETURN(my_errno=HA_ERR_RECORD_FILE_FULL);
+  }
   if (--(share->records) < share->blength >> 1) share->blength>>= 1;
   share->changed=1;
 
@@ -48,6 +58,25 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
   }
 
   memcpy(pos,heap_new,(size_t) share->reclength);
+  if (share->blobs && hp_store_blobs(share, pos, old))
+  {
+    /* Go back to the old row, its BLOB values are still stored */
+    int error= my_errno;
+    memcpy(pos, old, (size_t) share->reclength);
+    for (keydef= share->keydef; keydef < end; keydef++)
+    {
+      if (hp_rec_key_cmp(keydef, old, heap_new, 0) &&
+          ((*keydef->delete_key)(info, keydef, heap_new, pos, 0) ||
+           (*keydef->write_key)(info, keydef, old, pos)))
+        break;
+    }
+    if (++(share->records) == share->blength)
+      share->blength+= share->blength;
+    DBUG_RETURN(my_errno= error);
+  }
+  /* The values that were replaced are no longer referenced */
+  if (share->blobs)
+    hp_free_blobs(share, old, pos);
   if (++(share->records) == share->blength) share->blength+= share->blength;
 
 #if !defined(DBUG_OFF) && defined(EXTRA_HEAP_DEBUG)
@@ -42,9 +42,15 @@ int heap_write(HP_INFO *info, const uchar *record)
     DBUG_RETURN(my_errno=EACCES);
   }
 #endif
+  /* The BLOB values count against the size limit as well */
+  if (share->blobs &&
+      share->data_length + share->index_length +
+      hp_blobs_length(share, record) >= share->max_table_size)
+    DBUG_RETURN(my_errno=HA_ERR_RECORD_FILE_FULL);
   if (!(pos=next_free_record_pos(share)))
     DBUG_RETURN(my_errno);
   share->changed=1;
+  info->dupp_key_pos= 0;
 
   for (keydef = share->keydef, end = keydef + share->keys; keydef < end;
        keydef++)
@@ -54,6 +60,12 @@ int heap_write(HP_INFO *info, const uchar *record)
   }
 
   memcpy(pos,record,(size_t) share->reclength);
+  if (share->blobs && hp_store_blobs(share, pos, 0))
+  {
+    for (keydef= share->keydef; keydef < end; keydef++)
+      (void) (*keydef->delete_key)(info, keydef, record, pos, 0);
+    goto err_free;
+  }
   pos[share->reclength]=1;		/* Mark record as not deleted */
   if (++share->records == share->blength)
     share->blength+= share->blength;
@@ -88,6 +100,7 @@ err:
     keydef--;
   } 
 
+err_free:
   share->deleted++;
   *((uchar**) pos)=share->del_link;
   share->del_link=pos;
@@ -374,6 +387,7 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
       {
 	if (! hp_rec_key_cmp(keyinfo, record, pos->ptr_to_rec, 1))
 	{
+          info->dupp_key_pos= pos->ptr_to_rec;
 	  DBUG_RETURN(my_errno=HA_ERR_FOUND_DUPP_KEY);
 	}
       } while ((pos=pos->next_key));
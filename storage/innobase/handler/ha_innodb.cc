@@ -6213,14 +6213,16 @@ handler*
 ha_innobase::clone(
 /*===============*/
 	const char*	name,		/*!< in: table name */
-	MEM_ROOT*	mem_root)	/*!< in: memory context */
+	MEM_ROOT*	mem_root,	/*!< in: memory context */
+	TABLE*		table_arg)	/*!< in: table to open it on */
 {
 	ha_innobase* new_handler;
 
 	DBUG_ENTER("ha_innobase::clone");
 
 	new_handler = static_cast<ha_innobase*>(handler::clone(name,
-							       mem_root));
+							       mem_root,
+							       table_arg));
 	if (new_handler) {
 		DBUG_ASSERT(new_handler->prebuilt != NULL);
 
@@ -9066,18 +9068,42 @@ ha_innobase::general_fetch(
 	innobase_srv_conc_exit_innodb(prebuilt->trx, false);
 
 	stats.rows_requested++;
-	switch (ret) {
-	case DB_SUCCESS:
-		error = 0;
-		table->status = 0;
+
+	DBUG_RETURN(fetch_result(ret, ret == DB_SUCCESS, true));
+}
+
+/***********************************************************************//**
+Counts the rows returned by general_fetch() or general_fetch_batch() and
+converts the status of the last row_search_for_mysql() call.
+@return	0, HA_ERR_END_OF_FILE, or error number */
+UNIV_INTERN
+int
+ha_innobase::fetch_result(
+/*======================*/
+	dberr_t	ret,		/*!< in: status of the last fetch */
+	ulint	n_rows,		/*!< in: number of rows returned */
+	bool	index_scan)	/*!< in: whether the rows count as
+				index scan reads in rows_index_next */
+{
+	int	error;
+
+	if (n_rows > 0) {
 		if (prebuilt->table->is_system_db)
 			srv_stats.n_system_rows_read.add(
-				(size_t) prebuilt->trx->id, 1);
+				(size_t) prebuilt->trx->id, n_rows);
 		else
 			srv_stats.n_rows_read.add(
-				(size_t) prebuilt->trx->id, 1);
-		stats.rows_read++;
-		stats.rows_index_next++;
+				(size_t) prebuilt->trx->id, n_rows);
+		stats.rows_read += n_rows;
+		if (index_scan) {
+			stats.rows_index_next += n_rows;
+		}
+	}
+
+	switch (ret) {
+	case DB_SUCCESS:
+		error = 0;
+		table->status = 0;
 		break;
 	case DB_RECORD_NOT_FOUND:
 		error = HA_ERR_END_OF_FILE;
@@ -9126,7 +9152,61 @@ ha_innobase::general_fetch(
 		break;
 	}
 
-	DBUG_RETURN(error);
+	return(error);
+}
+
+/***********************************************************************//**
+Reads up to max_rows next rows from a cursor, which must have previously
+been positioned, into buffers row_length bytes apart. InnoDB is entered
+once for the whole batch, and since the rows are known to be read
+sequentially the prefetch cache is used from the first row on.
+@return	0 if max_rows rows were read, HA_ERR_END_OF_FILE, or error number */
+UNIV_INTERN
+int
+ha_innobase::general_fetch_batch(
+/*=============================*/
+	uchar*	buf,		/*!< out: buffer for max_rows rows in MySQL
+				format */
+	size_t	row_length,	/*!< in: distance between the rows in buf */
+	uint	max_rows,	/*!< in: number of rows to read */
+	uint*	rows_read,	/*!< out: number of rows stored in buf */
+	bool	index_scan)	/*!< in: false for a table scan */
+{
+	dberr_t	ret = DB_SUCCESS;
+	uint	n;
+
+	DBUG_ENTER("general_fetch_batch");
+
+	ut_a(prebuilt->trx == thd_to_trx(user_thd));
+
+	innobase_srv_conc_enter_innodb(prebuilt->trx, false);
+
+	for (n = 0; n < max_rows; n++) {
+
+		/* Once the fetch direction is known, skip the single
+		row fetches that normally precede prefetching */
+		if (prebuilt->n_rows_fetched > 0
+		    && prebuilt->n_rows_fetched
+		    < MYSQL_FETCH_CACHE_THRESHOLD) {
+			prebuilt->n_rows_fetched =
+				MYSQL_FETCH_CACHE_THRESHOLD;
+		}
+
+		ret = row_search_for_mysql(
+			(byte*) buf + n * row_length, 0, prebuilt, 0,
+			ROW_SEL_NEXT);
+
+		if (ret != DB_SUCCESS) {
+			break;
+		}
+	}
+
+	innobase_srv_conc_exit_innodb(prebuilt->trx, false);
+
+	*rows_read = n;
+	stats.rows_requested += n + (ret != DB_SUCCESS);
+
+	DBUG_RETURN(fetch_result(ret, n, index_scan));
 }
 
 /***********************************************************************//**
@@ -9145,6 +9225,30 @@ ha_innobase::index_next(
 	return(general_fetch(buf, ROW_SEL_NEXT, 0));
 }
 
+/***********************************************************************//**
+Reads the next rows from a cursor, which must have previously been
+positioned using index_read, into buffers row_length bytes apart.
+@return	0 if max_rows rows were read, HA_ERR_END_OF_FILE, or error number */
+UNIV_INTERN
+int
+ha_innobase::index_next_batch(
+/*==========================*/
+	uchar*	buf,		/*!< out: buffer for max_rows rows */
+	size_t	row_length,	/*!< in: distance between the rows in buf */
+	uint	max_rows,	/*!< in: number of rows to read */
+	uint*	rows_read)	/*!< out: number of rows stored in buf */
+{
+	int	error;
+
+	error = general_fetch_batch(buf, row_length, max_rows, rows_read,
+				    true);
+
+	ha_statistic_add(&SSV::ha_read_next_count,
+			 *rows_read + (error != 0));
+
+	return(error);
+}
+
 /*******************************************************************//**
 Reads the next row matching to the key value given as the parameter.
 @return	0, HA_ERR_END_OF_FILE, or error number */
@@ -9307,6 +9411,51 @@ ha_innobase::rnd_next(
 	DBUG_RETURN(error);
 }
 
+/*****************************************************************//**
+Reads the next rows of a table scan into buffers row_length bytes apart.
+@return	0 if max_rows rows were read, HA_ERR_END_OF_FILE, or error number */
+UNIV_INTERN
+int
+ha_innobase::rnd_next_batch(
+/*========================*/
+	uchar*	buf,		/*!< out: buffer for max_rows rows, in
+				MySQL format */
+	size_t	row_length,	/*!< in: distance between the rows in buf */
+	uint	max_rows,	/*!< in: number of rows to read */
+	uint*	rows_read)	/*!< out: number of rows stored in buf */
+{
+	int	error;
+	uint	n;
+
+	DBUG_ENTER("rnd_next_batch");
+
+	*rows_read = 0;
+
+	if (start_of_scan) {
+		/* Position the cursor on the first row */
+		error = rnd_next(buf);
+
+		if (error || max_rows == 1) {
+			*rows_read = !error;
+			DBUG_RETURN(error);
+		}
+
+		*rows_read = 1;
+		buf += row_length;
+		max_rows--;
+	}
+
+	/* rows_index_next only counts index scans, so like rnd_next()
+	the rows of this table scan are only counted in rows_read */
+	error = general_fetch_batch(buf, row_length, max_rows, &n, false);
+
+	ha_statistic_add(&SSV::ha_read_rnd_next_count, n + (error != 0));
+
+	*rows_read += n;
+
+	DBUG_RETURN(error);
+}
+
 /**********************************************************************//**
 Fetches a row from the table based on a row reference.
 @return	0, HA_ERR_KEY_NOT_FOUND, or error code */
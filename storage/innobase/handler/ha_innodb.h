@@ -91,6 +91,10 @@ class ha_innobase: public handler
 	void update_thd();
 	int change_active_index(uint keynr, ulong level);
 	int general_fetch(uchar* buf, uint direction, uint match_mode);
+	int general_fetch_batch(uchar* buf, size_t row_length,
+				uint max_rows, uint* rows_read,
+				bool index_scan);
+	int fetch_result(dberr_t ret, ulint n_rows, bool index_scan);
 	dberr_t innobase_lock_autoinc();
 	ulonglong innobase_peek_autoinc();
 	dberr_t innobase_set_max_autoinc(ulonglong auto_inc);
@@ -126,7 +130,8 @@ class ha_innobase: public handler
 	const key_map* keys_to_use_for_scanning();
 
 	int open(const char *name, int mode, uint test_if_locked);
-	handler* clone(const char *name, MEM_ROOT *mem_root);
+	handler* clone(const char *name, MEM_ROOT *mem_root,
+		       TABLE *table_arg);
 	int close(void);
 	double scan_time();
 	double read_time(uint index, uint ranges, ha_rows rows);
@@ -149,6 +154,8 @@ class ha_innobase: public handler
 			   uint key_len, enum ha_rkey_function find_flag);
 	int index_read_last(uchar * buf, const uchar * key, uint key_len);
 	int index_next(uchar * buf);
+	int index_next_batch(uchar* buf, size_t row_length, uint max_rows,
+			     uint* rows_read);
 	int index_next_same(uchar * buf, const uchar *key, uint keylen);
 	int index_prev(uchar * buf);
 	int index_first(uchar * buf);
@@ -157,6 +164,8 @@ class ha_innobase: public handler
 	int rnd_init(bool scan);
 	int rnd_end();
 	int rnd_next(uchar *buf);
+	int rnd_next_batch(uchar* buf, size_t row_length, uint max_rows,
+			   uint* rows_read);
 	int rnd_pos(uchar * buf, uchar *pos);
 
 	int ft_init();
@@ -652,10 +652,12 @@ ha_myisam::ha_myisam(handlerton *hton, TABLE_SHARE *table_arg)
    detached_disk_usage(false)
 {}
 
-handler *ha_myisam::clone(const char *name, MEM_ROOT *mem_root)
+handler *ha_myisam::clone(const char *name, MEM_ROOT *mem_root,
+                          TABLE *table_arg)
 {
   ha_myisam *new_handler= static_cast <ha_myisam *>(handler::clone(name,
-                                                                   mem_root));
+                                                                   mem_root,
+                                                                   table_arg));
   if (new_handler)
     new_handler->file->state= file->state;
   return new_handler;
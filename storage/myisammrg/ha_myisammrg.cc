@@ -713,11 +713,13 @@ CPP_UNNAMED_NS_END
 
    @return A cloned handler instance.
  */
-handler *ha_myisammrg::clone(const char *name, MEM_ROOT *mem_root)
+handler *ha_myisammrg::clone(const char *name, MEM_ROOT *mem_root,
+                             TABLE *table_arg)
 {
   MYRG_TABLE    *u_table,*newu_table;
   ha_myisammrg *new_handler= 
-    (ha_myisammrg*) get_new_handler(table->s, mem_root, table->s->db_type());
+    (ha_myisammrg*) get_new_handler(table_arg->s, mem_root,
+                                    table_arg->s->db_type());
   if (!new_handler)
     return NULL;
   
@@ -734,7 +736,7 @@ handler *ha_myisammrg::clone(const char *name, MEM_ROOT *mem_root)
     return NULL;
   }
 
-  if (new_handler->ha_open(table, name, table->db_stat,
+  if (new_handler->ha_open(table_arg, name, table_arg->db_stat,
                            HA_OPEN_IGNORE_IF_LOCKED))
   {
     delete new_handler;
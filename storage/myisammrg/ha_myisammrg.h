@@ -107,7 +107,8 @@ public:
   int add_children_list(void);
   int attach_children(void);
   int detach_children(void);
-  virtual handler *clone(const char *name, MEM_ROOT *mem_root);
+  virtual handler *clone(const char *name, MEM_ROOT *mem_root,
+                         TABLE *table_arg);
   int close(void);
   int write_row(uchar * buf);
   int update_row(const uchar * old_data, uchar * new_data);
@@ -698,6 +698,7 @@ static my_bool rocksdb_force_flush_memtable_and_lzero_now_var = 0;
 static my_bool rocksdb_cancel_manual_compactions_var = 0;
 static my_bool rocksdb_enable_ttl = 1;
 static my_bool rocksdb_enable_ttl_read_filtering = 1;
+static my_bool rocksdb_enable_value_offsets = 0;
 static int rocksdb_debug_ttl_rec_ts = 0;
 static int rocksdb_debug_ttl_snapshot_ts = 0;
 static int rocksdb_debug_ttl_read_filter_ts = 0;
@@ -750,7 +751,7 @@ static my_bool rocksdb_select_bypass_allow_filters = TRUE;
 static uint32_t rocksdb_select_bypass_rejected_query_history_size = 0;
 static uint32_t rocksdb_select_bypass_debug_row_delay = 0;
 static unsigned long long  // NOLINT(runtime/int)
-    rocksdb_select_bypass_multiget_min = 0;
+    rocksdb_select_bypass_multiget_min = 1;
 static my_bool rocksdb_skip_locks_if_skip_unique_check = FALSE;
 static my_bool rocksdb_alter_column_default_inplace = FALSE;
 static my_bool rocksdb_alter_table_comment_inplace = FALSE;
@@ -768,6 +769,9 @@ std::atomic<uint64_t> rocksdb_num_get_for_update_calls(0);
 std::atomic<uint64_t> rocksdb_select_bypass_executed(0);
 std::atomic<uint64_t> rocksdb_select_bypass_rejected(0);
 std::atomic<uint64_t> rocksdb_select_bypass_failed(0);
+std::atomic<uint64_t> rocksdb_select_bypass_plan_hits(0);
+std::atomic<uint64_t> rocksdb_select_bypass_plan_misses(0);
+std::atomic<uint64_t> rocksdb_scan_readahead_ramps(0);
 
 static int rocksdb_trace_block_cache_access(
     THD *const thd MY_ATTRIBUTE((__unused__)),
@@ -1101,6 +1105,8 @@ const size_t RDB_DEFAULT_MERGE_COMBINE_READ_SIZE = 1024 * 1024 * 1024;
 const size_t RDB_MIN_MERGE_COMBINE_READ_SIZE = 100;
 const size_t RDB_DEFAULT_MERGE_TMP_FILE_REMOVAL_DELAY = 0;
 const size_t RDB_MIN_MERGE_TMP_FILE_REMOVAL_DELAY = 0;
+const size_t RDB_SCAN_READAHEAD_MIN_SIZE = 64 * 1024;
+const size_t RDB_SCAN_READAHEAD_MAX_SIZE = 1024 * 1024 * 1024;
 const int64 RDB_DEFAULT_BLOCK_CACHE_SIZE = 512 * 1024 * 1024;
 const int64 RDB_MIN_BLOCK_CACHE_SIZE = 1024;
 const int RDB_MAX_CHECKSUMS_PCT = 100;
@@ -1312,7 +1318,9 @@ static MYSQL_THDVAR_ULONGLONG(
 static MYSQL_THDVAR_ULONGLONG(
     write_batch_flush_threshold, PLUGIN_VAR_RQCMDARG,
     "Maximum size of write batch in bytes before flushing. Only valid if "
-    "rocksdb_write_policy is WRITE_UNPREPARED. 0 means no limit.", nullptr,
+    "rocksdb_write_policy is WRITE_UNPREPARED. When set, this is the memory "
+    "ceiling of the transaction's write batch and rocksdb_commit_in_the_middle "
+    "is ignored. 0 means no limit.", nullptr,
     nullptr, /* default */ 0, /* min */ 0, /* max */ SIZE_T_MAX, 1);
 
 static MYSQL_THDVAR_BOOL(
@@ -1919,6 +1927,15 @@ static MYSQL_THDVAR_BOOL(skip_fill_cache, PLUGIN_VAR_RQCMDARG,
                          "Skip filling block cache on read requests", nullptr,
                          nullptr, FALSE);
 
+static MYSQL_THDVAR_ULONGLONG(
+    scan_readahead_max_size, PLUGIN_VAR_RQCMDARG,
+    "Maximum readahead size for range and full scans. Once a scan has read "
+    "64KB sequentially its iterator is re-created with readahead, and the "
+    "readahead size doubles every time the scan goes through a full "
+    "readahead window, up to this size. 0 disables scan readahead.",
+    nullptr, nullptr, /* default */ 0, /* min */ 0,
+    /* max */ RDB_SCAN_READAHEAD_MAX_SIZE, 0);
+
 static MYSQL_THDVAR_BOOL(
     unsafe_for_binlog, PLUGIN_VAR_RQCMDARG,
     "Allowing statement based binary logging which may break consistency",
@@ -1999,6 +2016,14 @@ static MYSQL_SYSVAR_BOOL(
     "transactions as they are dropped during compaction. Use with caution.",
     nullptr, nullptr, TRUE);
 
+static MYSQL_SYSVAR_BOOL(
+    enable_value_offsets, rocksdb_enable_value_offsets, PLUGIN_VAR_RQCMDARG,
+    "Store a field offset directory in the primary key values of newly "
+    "created tables, so that reads which only need a few columns can jump "
+    "to them instead of walking every preceding field. Existing tables keep "
+    "their format until they are rebuilt.",
+    nullptr, nullptr, FALSE);
+
 static MYSQL_SYSVAR_INT(
     debug_ttl_rec_ts, rocksdb_debug_ttl_rec_ts, PLUGIN_VAR_RQCMDARG,
     "For debugging purposes only.  Overrides the TTL of records to "
@@ -2211,6 +2236,16 @@ static MYSQL_SYSVAR_UINT(
     RDB_DEFAULT_TBL_STATS_SAMPLE_PCT, /* everything */ 0,
     /* max */ RDB_TBL_STATS_SAMPLE_PCT_MAX, 0);
 
+static MYSQL_SYSVAR_UINT(
+    table_stats_histogram_buckets, rocksdb_table_stats_histogram_buckets,
+    PLUGIN_VAR_RQCMDARG,
+    "Number of equi-depth histogram buckets to collect per index when SST "
+    "files are written by flushes and compactions. The histograms are used "
+    "to estimate the number of rows in a range and are shown in "
+    "information_schema.rocksdb_index_histogram. 0 disables histograms.",
+    nullptr, nullptr, /* default */ 0, /* min */ 0,
+    /* max */ RDB_TBL_STATS_HISTOGRAM_BUCKETS_MAX, 0);
+
 static MYSQL_SYSVAR_UINT(table_stats_recalc_threshold_pct,
                          rocksdb_table_stats_recalc_threshold_pct,
                          PLUGIN_VAR_RQCMDARG,
@@ -2356,10 +2391,10 @@ static MYSQL_SYSVAR_UINT(
 static MYSQL_SYSVAR_ULONGLONG(
     select_bypass_multiget_min, rocksdb_select_bypass_multiget_min,
     PLUGIN_VAR_RQCMDARG,
-    "Minimum number of items to use RocksDB MultiGet API. Default is "
-    "SIZE_T_MAX meaning it is turned off. Set to 0 to enable always using "
-    "MultiGet",
-    nullptr, nullptr, SIZE_T_MAX, /* min */ 0, /* max */ SIZE_T_MAX, 0);
+    "Point lookups in bypass SELECT use RocksDB MultiGet API when there are "
+    "more keys than this. Default is 1 meaning all IN-list lookups are "
+    "batched. Set to SIZE_T_MAX to turn it off",
+    nullptr, nullptr, 1, /* min */ 0, /* max */ SIZE_T_MAX, 0);
 
 static MYSQL_THDVAR_LONG(mrr_batch_size, PLUGIN_VAR_RQCMDARG,
                          "maximum number of keys to fetch during each MRR",
@@ -2494,6 +2529,7 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(write_ignore_missing_column_families),
 
     MYSQL_SYSVAR(skip_fill_cache),
+    MYSQL_SYSVAR(scan_readahead_max_size),
     MYSQL_SYSVAR(unsafe_for_binlog),
 
     MYSQL_SYSVAR(records_in_range),
@@ -2517,6 +2553,7 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(cancel_manual_compactions),
     MYSQL_SYSVAR(enable_ttl),
     MYSQL_SYSVAR(enable_ttl_read_filtering),
+    MYSQL_SYSVAR(enable_value_offsets),
     MYSQL_SYSVAR(debug_ttl_rec_ts),
     MYSQL_SYSVAR(debug_ttl_snapshot_ts),
     MYSQL_SYSVAR(debug_ttl_read_filter_ts),
@@ -2541,6 +2578,7 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
 
     MYSQL_SYSVAR(validate_tables),
     MYSQL_SYSVAR(table_stats_sampling_pct),
+    MYSQL_SYSVAR(table_stats_histogram_buckets),
     MYSQL_SYSVAR(table_stats_recalc_threshold_pct),
     MYSQL_SYSVAR(table_stats_recalc_threshold_count),
     MYSQL_SYSVAR(table_stats_max_num_rows_scanned),
@@ -2994,6 +3032,18 @@ class Rdb_transaction {
     }
   }
 
+  void start_scan_readahead() {
+    if (m_tbl_io_perf != nullptr) {
+      m_tbl_io_perf->start_scan_readahead(rocksdb_perf_context_level(m_thd));
+    }
+  }
+
+  void end_scan_readahead() {
+    if (m_tbl_io_perf != nullptr) {
+      m_tbl_io_perf->end_scan_readahead();
+    }
+  }
+
   void set_params(int timeout_sec_arg, int max_row_locks_arg) {
     m_timeout_sec = timeout_sec_arg;
     m_max_row_locks = max_row_locks_arg;
@@ -3412,6 +3462,12 @@ class Rdb_transaction {
 
   virtual bool has_modifications() const = 0;
 
+  /*
+    Whether the transaction's WriteBatch is written to the DB as unprepared
+    batches when it grows too large, see Rdb_transaction_impl::m_can_spill
+  */
+  virtual bool can_spill() const { return false; }
+
   virtual rocksdb::WriteBatchBase *get_indexed_write_batch() = 0;
   /*
     Return a WriteBatch that one can write to. The writes will skip any
@@ -3445,7 +3501,7 @@ class Rdb_transaction {
       rocksdb::ColumnFamilyHandle *const column_family, bool skip_bloom_filter,
       bool fill_cache, const rocksdb::Slice &eq_cond_lower_bound,
       const rocksdb::Slice &eq_cond_upper_bound, bool read_current = false,
-      bool create_snapshot = true) {
+      bool create_snapshot = true, size_t readahead_size = 0) {
     // Make sure we are not doing both read_current (which implies we don't
     // want a snapshot) and create_snapshot which makes sure we create
     // a snapshot
@@ -3471,6 +3527,7 @@ class Rdb_transaction {
       options.prefix_same_as_start = true;
     }
     options.fill_cache = fill_cache;
+    options.readahead_size = readahead_size;
     if (read_current) {
       options.snapshot = nullptr;
     }
@@ -3652,6 +3709,33 @@ class Rdb_transaction_impl : public Rdb_transaction {
   rocksdb::Transaction *m_rocksdb_tx = nullptr;
   rocksdb::Transaction *m_rocksdb_reuse_tx = nullptr;
 
+  /*
+    With WRITE_UNPREPARED and rocksdb_write_batch_flush_threshold set, RocksDB
+    writes the transaction's WriteBatch to the DB as an unprepared batch once
+    it grows past the threshold. This bounds the memory used by huge
+    transactions without giving up atomicity, so that commit_in_the_middle
+    isn't needed for them.
+  */
+  bool m_can_spill = false;
+
+  /* Bytes of WriteBatch data written to the DB as unprepared batches */
+  ulonglong m_spilled_bytes = 0;
+
+  size_t get_write_batch_size() const {
+    return m_rocksdb_tx->GetWriteBatch()->GetWriteBatch()->GetDataSize();
+  }
+
+  /*
+    RocksDB flushes the WriteBatch before applying the write that pushes it
+    over the threshold, so the batch shrinking across a write means its
+    previous content has been spilled.
+  */
+  void track_spill(const size_t batch_size_before) {
+    if (get_write_batch_size() < batch_size_before) {
+      m_spilled_bytes += batch_size_before;
+    }
+  }
+
  public:
   void set_lock_timeout(int timeout_sec_arg) override {
     if (m_rocksdb_tx) {
@@ -3752,6 +3836,7 @@ class Rdb_transaction_impl : public Rdb_transaction {
     /* Save the transaction object to be reused */
     release_tx();
 
+    m_spilled_bytes = 0;
     m_write_count = 0;
     m_insert_count = 0;
     m_update_count = 0;
@@ -3770,11 +3855,15 @@ class Rdb_transaction_impl : public Rdb_transaction {
     m_update_count = 0;
     m_delete_count = 0;
     m_row_lock_count = 0;
+    m_spilled_bytes = 0;
     m_auto_incr_map.clear();
     m_ddl_transaction = false;
     if (m_rocksdb_tx) {
       release_snapshot();
-      /* This will also release all of the locks: */
+      /*
+        This will also release all of the locks, and write rollback batches
+        for anything already spilled as unprepared batches:
+      */
       m_rocksdb_tx->Rollback();
 
       /* Save the transaction object to be reused */
@@ -3833,29 +3922,55 @@ class Rdb_transaction_impl : public Rdb_transaction {
                       const rocksdb::Slice &key, const rocksdb::Slice &value,
                       const bool assume_tracked) override {
     ++m_write_count;
-    return m_rocksdb_tx->Put(column_family, key, value, assume_tracked);
+    if (!m_can_spill) {
+      return m_rocksdb_tx->Put(column_family, key, value, assume_tracked);
+    }
+    const size_t batch_size = get_write_batch_size();
+    const rocksdb::Status s =
+        m_rocksdb_tx->Put(column_family, key, value, assume_tracked);
+    track_spill(batch_size);
+    return s;
   }
 
   rocksdb::Status delete_key(rocksdb::ColumnFamilyHandle *const column_family,
                              const rocksdb::Slice &key,
                              const bool assume_tracked) override {
     ++m_write_count;
-    return m_rocksdb_tx->Delete(column_family, key, assume_tracked);
+    if (!m_can_spill) {
+      return m_rocksdb_tx->Delete(column_family, key, assume_tracked);
+    }
+    const size_t batch_size = get_write_batch_size();
+    const rocksdb::Status s =
+        m_rocksdb_tx->Delete(column_family, key, assume_tracked);
+    track_spill(batch_size);
+    return s;
   }
 
   rocksdb::Status single_delete(
       rocksdb::ColumnFamilyHandle *const column_family,
       const rocksdb::Slice &key, const bool assume_tracked) override {
     ++m_write_count;
-    return m_rocksdb_tx->SingleDelete(column_family, key, assume_tracked);
+    if (!m_can_spill) {
+      return m_rocksdb_tx->SingleDelete(column_family, key, assume_tracked);
+    }
+    const size_t batch_size = get_write_batch_size();
+    const rocksdb::Status s =
+        m_rocksdb_tx->SingleDelete(column_family, key, assume_tracked);
+    track_spill(batch_size);
+    return s;
   }
 
   bool has_modifications() const override {
-    return m_rocksdb_tx->GetWriteBatch() &&
-           m_rocksdb_tx->GetWriteBatch()->GetWriteBatch() &&
-           m_rocksdb_tx->GetWriteBatch()->GetWriteBatch()->Count() > 0;
+    return m_spilled_bytes > 0 ||
+           (m_rocksdb_tx->GetWriteBatch() &&
+            m_rocksdb_tx->GetWriteBatch()->GetWriteBatch() &&
+            m_rocksdb_tx->GetWriteBatch()->GetWriteBatch()->Count() > 0);
   }
 
+  bool can_spill() const override { return m_can_spill; }
+
+  ulonglong get_spilled_bytes() const { return m_spilled_bytes; }
+
   rocksdb::WriteBatchBase *get_write_batch() override {
     if (is_two_phase()) {
       return m_rocksdb_tx->GetCommitTimeWriteBatch();
@@ -3950,6 +4065,10 @@ class Rdb_transaction_impl : public Rdb_transaction {
         THDVAR(m_thd, commit_time_batch_for_recovery);
     tx_opts.max_write_batch_size = THDVAR(m_thd, write_batch_max_bytes);
     tx_opts.write_batch_flush_threshold = THDVAR(m_thd, write_batch_flush_threshold);
+    m_can_spill =
+        rocksdb_write_policy == rocksdb::TxnDBWritePolicy::WRITE_UNPREPARED &&
+        tx_opts.write_batch_flush_threshold > 0;
+    m_spilled_bytes = 0;
 
     write_opts.sync = (rocksdb_flush_log_at_trx_commit == FLUSH_LOG_SYNC);
     write_opts.disableWAL = THDVAR(m_thd, write_disable_wal);
@@ -4946,7 +5065,8 @@ class Rdb_trx_info_aggregator : public Rdb_tx_list_walker {
            1,                             /*is_replication */
            1,                             /* skip_trx_api */
            wb_impl->is_tx_read_only(), 0, /* deadlock detection */
-           wb_impl->num_ongoing_bulk_load(), thread_id, "" /* query string */});
+           wb_impl->num_ongoing_bulk_load(), 0, /* spilled_bytes */
+           thread_id, "" /* query string */});
     } else {
       const auto tx_impl = static_cast<const Rdb_transaction_impl *>(tx);
       DBUG_ASSERT(tx_impl);
@@ -4975,7 +5095,8 @@ class Rdb_trx_info_aggregator : public Rdb_tx_list_walker {
                state_it->second, waiting_key, waiting_cf_id, is_replication,
                0, /* skip_trx_api */
                tx_impl->is_tx_read_only(), rdb_trx->IsDeadlockDetect(),
-               tx_impl->num_ongoing_bulk_load(), thread_id, query_str});
+               tx_impl->num_ongoing_bulk_load(), tx_impl->get_spilled_bytes(),
+               thread_id, query_str});
     }
   }
 };
@@ -6698,6 +6819,8 @@ ha_rocksdb::ha_rocksdb(my_core::handlerton *const hton,
       m_scan_it(nullptr),
       m_scan_it_skips_bloom(false),
       m_scan_it_snapshot(nullptr),
+      m_scan_it_readahead_size(0),
+      m_scan_it_read_bytes(0),
       m_scan_it_lower_bound(nullptr),
       m_scan_it_upper_bound(nullptr),
       m_tbl_def(nullptr),
@@ -7915,6 +8038,14 @@ int ha_rocksdb::create_key_def(const TABLE *const table_arg, const uint i,
   });
 
   uint32 index_flags = (ttl_duration > 0 ? Rdb_key_def::TTL_FLAG : 0);
+  if (rocksdb_enable_value_offsets &&
+      index_type != Rdb_key_def::INDEX_TYPE_SECONDARY) {
+    index_flags |= Rdb_key_def::VALUE_OFFSETS_FLAG;
+  }
+  if (Rdb_key_def::has_index_flag(index_flags,
+                                  Rdb_key_def::VALUE_OFFSETS_FLAG)) {
+    kv_version = Rdb_key_def::PRIMARY_FORMAT_VERSION_VALUE_OFFSETS;
+  }
 
   uint32 ttl_rec_offset =
       Rdb_key_def::has_index_flag(index_flags, Rdb_key_def::TTL_FLAG)
@@ -9557,6 +9688,34 @@ int ha_rocksdb::index_next(uchar *const buf) {
   DBUG_RETURN(rc);
 }
 
+/**
+  Read the next rows of an index scan into buffers row_length bytes apart.
+
+  @return
+    HA_EXIT_SUCCESS  max_rows rows were read
+    other            HA_ERR error code of the read that ended the batch
+*/
+int ha_rocksdb::index_next_batch(uchar *const buf, size_t row_length,
+                                 uint max_rows, uint *const rows_read) {
+  DBUG_ENTER_FUNC();
+
+  check_build_decoder();
+
+  const bool moves_forward = !m_key_descr_arr[active_index]->m_is_reverse_cf;
+  int rc = HA_EXIT_SUCCESS;
+  uint n;
+  for (n = 0; n < max_rows; n++) {
+    rc = index_next_with_direction(buf + n * row_length, moves_forward);
+    if (rc) break;
+  }
+  ha_statistic_add(&SSV::ha_read_next_count, n + (rc != 0));
+  *rows_read = n;
+
+  if (rc == HA_ERR_KEY_NOT_FOUND) rc = HA_ERR_END_OF_FILE;
+
+  DBUG_RETURN(rc);
+}
+
 /**
   @return
     HA_EXIT_SUCCESS  OK
@@ -9594,6 +9753,9 @@ int ha_rocksdb::index_next_with_direction(uchar *const buf, bool move_forward) {
         rc = HA_ERR_QUERY_INTERRUPTED;
         break;
       }
+      if (!m_skip_scan_it_next_call) {
+        ramp_scan_readahead(*m_key_descr_arr[active_index], move_forward);
+      }
       if (m_skip_scan_it_next_call) {
         m_skip_scan_it_next_call = false;
       } else {
@@ -9893,8 +10055,17 @@ void ha_rocksdb::set_force_skip_unique_check(bool skip) {
 }
 
 bool ha_rocksdb::commit_in_the_middle() {
-  return THDVAR(table->in_use, bulk_load) ||
-         THDVAR(table->in_use, commit_in_the_middle);
+  if (THDVAR(table->in_use, bulk_load)) {
+    return true;
+  }
+
+  /*
+    No need to break atomicity of transactions whose memory is already
+    bounded by spilling unprepared batches
+  */
+  const Rdb_transaction *const tx = get_tx_from_thd(table->in_use);
+  return THDVAR(table->in_use, commit_in_the_middle) &&
+         (tx == nullptr || !tx->can_spill());
 }
 
 /*
@@ -11024,29 +11195,116 @@ void ha_rocksdb::setup_scan_iterator(const Rdb_key_def &kd,
     In that case, re-use the iterator, but re-position it at the table start.
   */
   if (!m_scan_it) {
-    const bool fill_cache = !THDVAR(ha_thd(), skip_fill_cache);
-    if (commit_in_the_middle()) {
-      DBUG_ASSERT(m_scan_it_snapshot == nullptr);
-      m_scan_it_snapshot = rdb->GetSnapshot();
+    DBUG_ASSERT(m_scan_it_snapshot == nullptr);
+    m_scan_it = new_scan_iterator(kd, tx, skip_bloom, 0);
+    m_scan_it_skips_bloom = skip_bloom;
+    m_scan_it_readahead_size = 0;
+  }
 
-      auto read_opts = rocksdb::ReadOptions();
-      // TODO(mung): set based on WHERE conditions
-      read_opts.total_order_seek = true;
-      read_opts.snapshot = m_scan_it_snapshot;
-      m_scan_it = rdb->NewIterator(read_opts, kd.get_cf());
-    } else {
-      m_scan_it = tx->get_iterator(kd.get_cf(), skip_bloom, fill_cache,
-                                   m_scan_it_lower_bound_slice,
-                                   m_scan_it_upper_bound_slice);
+  // The caller is about to seek, which starts a new sequential run
+  m_scan_it_read_bytes = 0;
+}
+
+rocksdb::Iterator *ha_rocksdb::new_scan_iterator(const Rdb_key_def &kd,
+                                                 Rdb_transaction *const tx,
+                                                 const bool skip_bloom,
+                                                 const size_t readahead_size) {
+  if (commit_in_the_middle()) {
+    if (m_scan_it_snapshot == nullptr) {
+      m_scan_it_snapshot = rdb->GetSnapshot();
     }
-    m_scan_it_skips_bloom = skip_bloom;
+
+    auto read_opts = rocksdb::ReadOptions();
+    // TODO(mung): set based on WHERE conditions
+    read_opts.total_order_seek = true;
+    read_opts.snapshot = m_scan_it_snapshot;
+    read_opts.readahead_size = readahead_size;
+    return rdb->NewIterator(read_opts, kd.get_cf());
   }
+
+  const bool fill_cache = !THDVAR(ha_thd(), skip_fill_cache);
+  return tx->get_iterator(kd.get_cf(), skip_bloom, fill_cache,
+                          m_scan_it_lower_bound_slice,
+                          m_scan_it_upper_bound_slice, false /* read_current */,
+                          true /* create_snapshot */, readahead_size);
+}
+
+/*
+  @brief
+    Ramp up readahead of a scan that keeps reading sequentially.
+
+  @detail
+    Called before m_scan_it is moved to the next entry. Iterator readahead
+    can only be set when the iterator is created, so once the scan has gone
+    through a full readahead window (RDB_SCAN_READAHEAD_MIN_SIZE before the
+    first one), the iterator is re-created with twice the readahead size, up
+    to @@rocksdb_scan_readahead_max_size, and re-positioned on the current
+    key. Point lookups and short scans never get that far, so they keep the
+    plain iterator.
+*/
+void ha_rocksdb::ramp_scan_readahead(const Rdb_key_def &kd,
+                                     const bool move_forward) {
+  const size_t max_size = THDVAR(ha_thd(), scan_readahead_max_size);
+  if (max_size == 0 || m_scan_it_readahead_size >= max_size ||
+      !is_valid_iterator(m_scan_it)) {
+    return;
+  }
+
+  m_scan_it_read_bytes += m_scan_it->key().size() + m_scan_it->value().size();
+  if (m_scan_it_read_bytes <
+      std::max(m_scan_it_readahead_size, RDB_SCAN_READAHEAD_MIN_SIZE)) {
+    return;
+  }
+
+  const size_t readahead_size =
+      std::min(max_size, m_scan_it_readahead_size == 0
+                             ? RDB_SCAN_READAHEAD_MIN_SIZE
+                             : 2 * m_scan_it_readahead_size);
+
+  Rdb_transaction *const tx = get_or_create_tx(table->in_use);
+  const std::string cur_key = m_scan_it->key().ToString();
+
+  // Count SST reads from the re-seek on as readahead reads
+  if (m_scan_it_readahead_size == 0) {
+    tx->start_scan_readahead();
+  }
+
+  delete m_scan_it;
+  m_scan_it = new_scan_iterator(kd, tx, m_scan_it_skips_bloom, readahead_size);
+  if (move_forward) {
+    m_scan_it->Seek(cur_key);
+  } else {
+    m_scan_it->SeekForPrev(cur_key);
+  }
+
+  /*
+    The current key may be gone from the new iterator's view, e.g. when this
+    statement has just deleted it. The seek then already stopped on the entry
+    the caller is about to move to.
+  */
+  if (!is_valid_iterator(m_scan_it) || m_scan_it->key() != cur_key) {
+    m_skip_scan_it_next_call = true;
+  }
+
+  m_scan_it_readahead_size = readahead_size;
+  m_scan_it_read_bytes = 0;
+  rocksdb_scan_readahead_ramps++;
 }
 
 void ha_rocksdb::release_scan_iterator() {
   delete m_scan_it;
   m_scan_it = nullptr;
 
+  if (m_scan_it_readahead_size > 0) {
+    THD *const thd = ha_thd();
+    Rdb_transaction *const tx =
+        thd != nullptr ? get_tx_from_thd(thd) : nullptr;
+    if (tx != nullptr) {
+      tx->end_scan_readahead();
+    }
+    m_scan_it_readahead_size = 0;
+  }
+
   if (m_scan_it_snapshot) {
     rdb->ReleaseSnapshot(m_scan_it_snapshot);
     m_scan_it_snapshot = nullptr;
@@ -11130,6 +11388,46 @@ int ha_rocksdb::rnd_next(uchar *const buf) {
   DBUG_RETURN(rc);
 }
 
+/**
+  Read the next rows of a table scan into buffers row_length bytes apart.
+  Only the first read of a scan may need to retake the snapshot, so the
+  following rows are read straight from the scan iterator.
+
+  @return
+    HA_EXIT_SUCCESS  max_rows rows were read
+    other            HA_ERR error code of the read that ended the batch
+*/
+int ha_rocksdb::rnd_next_batch(uchar *const buf, size_t row_length,
+                               uint max_rows, uint *const rows_read) {
+  DBUG_ENTER_FUNC();
+
+  int rc = HA_EXIT_SUCCESS;
+  uint n = 0;
+
+  if (m_rnd_scan_is_new_snapshot) {
+    rc = rnd_next(buf);
+    if (rc || max_rows == 1) {
+      *rows_read = !rc;
+      DBUG_RETURN(rc);
+    }
+    n = 1;
+  }
+
+  check_build_decoder();
+
+  const uint first = n;
+  for (; n < max_rows; n++) {
+    rc = rnd_next_with_direction(buf + n * row_length, true);
+    if (rc) break;
+  }
+  ha_statistic_add(&SSV::ha_read_rnd_next_count, n - first + (rc != 0));
+  *rows_read = n;
+
+  if (rc == HA_ERR_KEY_NOT_FOUND) rc = HA_ERR_END_OF_FILE;
+
+  DBUG_RETURN(rc);
+}
+
 /*
   See also secondary_index_read().
 */
@@ -11161,6 +11459,9 @@ int ha_rocksdb::rnd_next_with_direction(uchar *const buf, bool move_forward) {
       break;
     }
 
+    if (!m_skip_scan_it_next_call) {
+      ramp_scan_readahead(*m_pk_descr, move_forward);
+    }
     if (m_skip_scan_it_next_call) {
       m_skip_scan_it_next_call = false;
     } else {
@@ -12605,7 +12906,18 @@ void ha_rocksdb::records_in_range_internal(uint inx, key_range *const min_key,
   // Getting statistics, including from Memtables
   uint8_t include_flags = rocksdb::DB::INCLUDE_FILES;
   rdb->GetApproximateSizes(kd.get_cf(), &r, 1, &sz, include_flags);
-  *row_count = rows * ((double)sz / (double)disk_size);
+
+  // Prefer the histogram, which follows skewed keys, over the share of the
+  // index size taken by the range.
+  const auto histogram = ddl_manager.get_histogram(kd);
+  const int64_t histogram_total = histogram ? histogram->total_rows() : 0;
+  int64_t histogram_rows = 0;
+  if (histogram_total > 0 &&
+      histogram->rows_in_range(slice1, slice2, &histogram_rows)) {
+    *row_count = rows * ((double)histogram_rows / (double)histogram_total);
+  } else {
+    *row_count = rows * ((double)sz / (double)disk_size);
+  }
   *total_size = sz;
   uint64_t memTableCount;
   rdb->GetApproximateMemTableStats(kd.get_cf(), r, &memTableCount, &sz);
@@ -14611,6 +14923,14 @@ static SHOW_VAR rocksdb_status_vars[] = {
                        &rocksdb_select_bypass_rejected, SHOW_LONGLONG),
     DEF_STATUS_VAR_PTR("select_bypass_failed", &rocksdb_select_bypass_failed,
                        SHOW_LONGLONG),
+    DEF_STATUS_VAR_PTR("select_bypass_plan_hits",
+                       &rocksdb_select_bypass_plan_hits, SHOW_LONGLONG),
+    DEF_STATUS_VAR_PTR("select_bypass_plan_misses",
+                       &rocksdb_select_bypass_plan_misses, SHOW_LONGLONG),
+    DEF_STATUS_VAR_PTR("scan_readahead_bytes", &rocksdb_scan_readahead_bytes,
+                       SHOW_LONGLONG),
+    DEF_STATUS_VAR_PTR("scan_readahead_ramps", &rocksdb_scan_readahead_ramps,
+                       SHOW_LONGLONG),
     // the variables generated by SHOW_FUNC are sorted only by prefix (first
     // arg in the tuple below), so make sure it is unique to make sorting
     // deterministic as quick sort is not stable
@@ -16810,6 +17130,7 @@ mysql_declare_plugin(rocksdb_se){
     myrocks::rdb_i_s_cfoptions, myrocks::rdb_i_s_compact_stats,
     myrocks::rdb_i_s_global_info, myrocks::rdb_i_s_ddl,
     myrocks::rdb_i_s_sst_props, myrocks::rdb_i_s_index_file_map,
-    myrocks::rdb_i_s_lock_info, myrocks::rdb_i_s_trx_info,
-    myrocks::rdb_i_s_deadlock_info,
+    myrocks::rdb_i_s_index_histogram, myrocks::rdb_i_s_lock_info,
+    myrocks::rdb_i_s_trx_info, myrocks::rdb_i_s_deadlock_info,
+    myrocks::rdb_i_s_bypass_plans,
     myrocks::rdb_i_s_bypass_rejected_query_history mysql_declare_plugin_end;
@@ -152,6 +152,14 @@ class ha_rocksdb : public my_core::handler {
 
   const rocksdb::Snapshot *m_scan_it_snapshot;
 
+  /*
+    Readahead size m_scan_it was created with (0 means none), and how many
+    bytes of keys and values the scan has gone through sequentially since
+    then.
+  */
+  size_t m_scan_it_readahead_size;
+  ulonglong m_scan_it_read_bytes;
+
   /* Buffers used for upper/lower bounds for m_scan_it. */
   uchar *m_scan_it_lower_bound;
   uchar *m_scan_it_upper_bound;
@@ -326,6 +334,11 @@ class ha_rocksdb : public my_core::handler {
   void setup_scan_iterator(const Rdb_key_def &kd, rocksdb::Slice *slice,
                            const bool use_all_keys, const uint eq_cond_len)
       MY_ATTRIBUTE((__nonnull__));
+  rocksdb::Iterator *new_scan_iterator(const Rdb_key_def &kd,
+                                       Rdb_transaction *const tx,
+                                       const bool skip_bloom,
+                                       const size_t readahead_size);
+  void ramp_scan_readahead(const Rdb_key_def &kd, const bool move_forward);
   void release_scan_iterator(void);
 
   rocksdb::Status get_for_update(Rdb_transaction *const tx,
@@ -634,6 +647,9 @@ class ha_rocksdb : public my_core::handler {
 
   int index_next(uchar *const buf) override
       MY_ATTRIBUTE((__warn_unused_result__));
+  int index_next_batch(uchar *const buf, size_t row_length, uint max_rows,
+                       uint *const rows_read) override
+      MY_ATTRIBUTE((__warn_unused_result__));
   int index_next_with_direction(uchar *const buf, bool move_forward)
       MY_ATTRIBUTE((__warn_unused_result__));
   int index_prev(uchar *const buf) override
@@ -916,6 +932,9 @@ class ha_rocksdb : public my_core::handler {
 
   int rnd_next(uchar *const buf) override
       MY_ATTRIBUTE((__warn_unused_result__));
+  int rnd_next_batch(uchar *const buf, size_t row_length, uint max_rows,
+                     uint *const rows_read) override
+      MY_ATTRIBUTE((__warn_unused_result__));
   int rnd_next_with_direction(uchar *const buf, bool move_forward)
       MY_ATTRIBUTE((__warn_unused_result__));
 
@@ -1183,5 +1202,8 @@ bool rdb_tx_started(Rdb_transaction *tx);
 extern std::atomic<uint64_t> rocksdb_select_bypass_executed;
 extern std::atomic<uint64_t> rocksdb_select_bypass_rejected;
 extern std::atomic<uint64_t> rocksdb_select_bypass_failed;
+extern std::atomic<uint64_t> rocksdb_select_bypass_plan_hits;
+extern std::atomic<uint64_t> rocksdb_select_bypass_plan_misses;
+extern std::atomic<uint64_t> rocksdb_scan_readahead_ramps;
 
 }  // namespace myrocks
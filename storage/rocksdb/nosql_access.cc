@@ -54,6 +54,10 @@ static const size_t MAX_SIZE = std::numeric_limits<size_t>::max();
 // for stack allocation
 static const size_t KEY_WRITER_DEFAULT_SIZE = 16;
 
+// Max number of secondary key entries whose primary key lookups are batched
+// into one MultiGet
+static const size_t SK_BATCH_MAX_SIZE = 128;
+
 namespace myrocks {
 
 /* We only support simple equal / comparison functions */
@@ -90,6 +94,82 @@ struct sql_cond {
   sql_cond() = default;
 };
 
+/*
+  Conditional expression as remembered in a cached plan. Field is kept as
+  field_index as TABLE objects are different across executions
+ */
+struct sql_cond_plan {
+  Item_func::Functype op_type;  // the operator, such as >
+  uint field_index;             // index of the field in TABLE::field
+  Item_field *field_item;       // item referring to the field
+  Item_func *cond_item;         // item
+  Item *val_item;               // item containing the value
+
+  sql_cond_plan(Item_func::Functype _op_type, uint _field_index,
+                Item_field *_field_item, Item_func *_cond_item,
+                Item *_val_item)
+      : op_type(_op_type),
+        field_index(_field_index),
+        field_item(_field_item),
+        cond_item(_cond_item),
+        val_item(_val_item) {}
+};
+
+std::list<const BYPASS_PLAN_ITEM *> bypass_plans;
+std::mutex bypass_plan_lock;
+
+/*
+  Result of parsing a SELECT statement, cached on the SELECT_LEX of
+  prepared statements so that subsequent executions only need to bind the
+  fields of the newly opened TABLE and re-check the parameter values.
+  Cached plans are listed in information_schema.ROCKSDB_BYPASS_PLANS
+ */
+class select_plan : public Select_bypass_plan {
+ public:
+  select_plan(const TABLE *table, const st_select_lex *select_lex)
+      : m_table_ref_version(table->s->get_table_ref_version()),
+        m_prep_where(select_lex->prep_where) {}
+
+  ~select_plan() override {
+    if (m_registered) {
+      const std::lock_guard<std::mutex> lock(bypass_plan_lock);
+      bypass_plans.erase(m_registry_pos);
+    }
+  }
+
+  // List the plan once it is cached on the statement
+  void register_plan(const TABLE *table) {
+    m_item.table_schema = table->s->db.str;
+    m_item.table_name = table->s->table_name.str;
+    m_item.index_name = table->key_info[m_index].name;
+
+    const std::lock_guard<std::mutex> lock(bypass_plan_lock);
+    m_registry_pos = bypass_plans.insert(bypass_plans.end(), &m_item);
+    m_registered = true;
+  }
+
+  bool is_valid(const TABLE *table, const st_select_lex *select_lex) const {
+    return m_table_ref_version == table->s->get_table_ref_version() &&
+           m_prep_where == select_lex->prep_where &&
+           m_index < table->s->keys;
+  }
+
+  // Table definition and WHERE the plan is built against
+  const ulonglong m_table_ref_version;
+  const Item *const m_prep_where;
+
+  uint m_index = MAX_KEY;
+  bool m_is_order_desc = false;
+  std::vector<uint> m_field_index_list;
+  std::vector<sql_cond_plan> m_cond_list;
+
+  BYPASS_PLAN_ITEM m_item;
+
+ private:
+  bool m_registered = false;
+  std::list<const BYPASS_PLAN_ITEM *>::iterator m_registry_pos;
+};
+
 /*
   Extract necessary information from SELECT statements
  */
@@ -105,7 +185,13 @@ class select_parser {
     m_error_msg = "UNKNOWN";
   }
 
-  bool INLINE_ATTR parse() {
+  /*
+    Parse the SELECT statement. If plan is given, remember the result of
+    parsing in the plan so that it can be reused by bind() later
+   */
+  bool INLINE_ATTR parse(select_plan *plan = nullptr) {
+    m_plan = plan;
+
     // No locking
     if (m_table_list->lock_type > TL_READ) {
       m_error_msg = "Only SELECT with default READ lock is supported";
@@ -145,9 +231,50 @@ class select_parser {
       return true;
     }
 
+    if (m_plan != nullptr) {
+      m_plan->m_index = m_index;
+      m_plan->m_is_order_desc = m_is_order_desc;
+      m_plan->m_field_index_list.reserve(m_field_list.size());
+      for (const auto field : m_field_list) {
+        m_plan->m_field_index_list.push_back(field->field_index);
+      }
+    }
+
     return false;
   }
 
+  /*
+    Re-create the parse result from a plan cached by a previous execution
+    of the same prepared statement. Only the parts that may change across
+    executions are checked again: the TABLE being used and the values of
+    the parameters
+   */
+  bool INLINE_ATTR bind(const select_plan &plan) {
+    m_index = plan.m_index;
+    m_is_order_desc = plan.m_is_order_desc;
+
+    Item *item;
+    List_iterator_fast<Item> li(m_select_lex->item_list);
+    m_field_list.reserve(plan.m_field_index_list.size());
+    for (const auto field_index : plan.m_field_index_list) {
+      item = li++;
+      DBUG_ASSERT(item != nullptr && item->type() == Item::FIELD_ITEM);
+      Field *field = m_table->field[field_index];
+      static_cast<Item_field *>(item)->set_field(m_thd, field);
+      m_field_list.push_back(field);
+    }
+
+    for (const auto &cond : plan.m_cond_list) {
+      if (check_op_args(cond.cond_item, cond.val_item) ||
+          add_cond(cond.op_type, m_table->field[cond.field_index],
+                   cond.field_item, cond.cond_item, cond.val_item)) {
+        return true;
+      }
+    }
+
+    return parse_limit();
+  }
+
   /*
     Dump out the parsed contents of the SELECT statement
     Typically used in debug only
@@ -275,6 +402,9 @@ class select_parser {
   // Buffer to store my_snprintf-ed error messages
   char m_error_msg_buf[FN_REFLEN];
 
+  // Plan to record the parse result into, if any
+  select_plan *m_plan = nullptr;
+
  private:
   bool parse_index() {
     if (m_table_list->index_hints != nullptr) {
@@ -425,6 +555,34 @@ class select_parser {
             type == Item::VARBIN_ITEM);
   }
 
+  /*
+    Check the operands of the conditional expression. For prepared statements
+    these are parameters and need to be checked in every execution
+   */
+  bool inline check_op_args(Item_func *func, Item *op_arg) {
+    if (func->functype() == Item_func::IN_FUNC) {
+      const auto args = func->arguments();
+      for (uint i = 1; i < func->argument_count(); ++i) {
+        if (!is_supported_op_arg(args[i])) {
+          // Make sure the field has supported type
+          // Where as for values we convert them to the correct type just
+          // like MySQL
+          m_error_msg =
+              "Unsupported WHERE - operand should be "
+              "int/string/real/varbinary";
+          return true;
+        }
+      }
+    } else if (!is_supported_op_arg(op_arg)) {
+      m_error_msg =
+          "Unsupported WHERE - operand should be "
+          "int/string/real/varbinary";
+      return true;
+    }
+
+    return false;
+  }
+
   bool inline parse_cond(Item_func *func) {
     auto type = func->functype();
     if (!is_supported_item_func(type)) {
@@ -439,18 +597,6 @@ class select_parser {
     if (type == Item_func::IN_FUNC) {
       // arg0 is always the field
       field_arg = static_cast<Item_field *>(args[0]);
-      auto in_func = static_cast<Item_func_in *>(func);
-      for (uint i = 1; i < in_func->argument_count(); ++i) {
-        if (!is_supported_op_arg(args[i])) {
-          // Make sure the field has supported type
-          // Where as for values we convert them to the correct type just
-          // like MySQL
-          m_error_msg =
-              "Unsupported WHERE - operand should be "
-              "int/string/real/varbinary";
-          return true;
-        }
-      }
     } else {
       // Extract the field and operand, such as A > 0
       if (args[0]->type() == Item::FIELD_ITEM) {
@@ -463,13 +609,10 @@ class select_parser {
         m_error_msg = "Unsupported WHERE - should only reference field";
         return true;
       }
+    }
 
-      if (!is_supported_op_arg(op_arg)) {
-        m_error_msg =
-            "Unsupported WHERE - operand should be "
-            "int/string/real/varbinary";
-        return true;
-      }
+    if (check_op_args(func, op_arg)) {
+      return true;
     }
 
     // Locate the field
@@ -489,6 +632,20 @@ class select_parser {
       return true;
     }
 
+    if (m_plan != nullptr) {
+      m_plan->m_cond_list.emplace_back(type, found->field_index, field_arg,
+                                       func, op_arg);
+    }
+
+    return add_cond(type, found, field_arg, func, op_arg);
+  }
+
+  /*
+    Add a conditional expression on a resolved field to the list of
+    conditions. Depending on the value this may skip the expression
+   */
+  bool inline add_cond(Item_func::Functype type, Field *found,
+                       Item_field *field_arg, Item_func *func, Item *op_arg) {
     // TAO-specific optimizations to remove redundant time >= 0 and time <=
     // UINT32_MAX. Once TAO removes those unnecessary WHERE we can take
     // these out
@@ -736,6 +893,11 @@ class select_exec {
   int eval_and_send();
   bool run_pk_point_query(txn_wrapper *txn);
   bool run_sk_point_query(txn_wrapper *txn);
+  bool add_to_sk_batch(const rocksdb::Slice &rkey,
+                       const rocksdb::Slice &rvalue);
+  int flush_sk_batch(txn_wrapper *txn);
+  int add_to_sk_batch_and_send(txn_wrapper *txn, const rocksdb::Slice &rkey,
+                               const rocksdb::Slice &rvalue);
   bool pack_index_tuple(uint key_part_no, Rdb_string_writer *writer,
                         const Field *field, Item *item);
   bool pack_cond(uint key_part_no, const sql_cond &cond, bool is_start = true);
@@ -827,6 +989,20 @@ class select_exec {
   // Temporary buffer for storing value
   rocksdb::PinnableSlice m_pk_value;
 
+  // Secondary key entry waiting for its primary key lookup
+  struct sk_entry {
+    std::string key;
+    std::string value;
+    // Position in m_sk_batch_pk_keys, or MAX_SIZE if the entry covers the
+    // lookup
+    size_t pk_pos;
+  };
+
+  // Secondary key entries batched so that their primary key lookups can go
+  // through MultiGet, and the primary keys to look up
+  std::vector<sk_entry> m_sk_batch;
+  std::vector<std::string> m_sk_batch_pk_keys;
+
   // Artificial delays for kill testing
   uint32_t m_debug_row_delay;
 
@@ -1558,11 +1734,16 @@ bool INLINE_ATTR select_exec::run_sk_point_query(txn_wrapper *txn) {
       continue;
     }
 
-    if (unpack_for_sk(txn, rkey_slice, m_scan_it->value())) {
-      return true;
+    int ret;
+    if (m_keyread_only) {
+      if (unpack_for_sk(txn, rkey_slice, m_scan_it->value())) {
+        return true;
+      }
+      ret = eval_and_send();
+    } else {
+      ret = add_to_sk_batch_and_send(txn, rkey_slice, m_scan_it->value());
     }
 
-    int ret = eval_and_send();
     if (ret > 0) {
       return true;
     } else if (ret < 0) {
@@ -1571,7 +1752,7 @@ bool INLINE_ATTR select_exec::run_sk_point_query(txn_wrapper *txn) {
     }
   }
 
-  return false;
+  return flush_sk_batch(txn) > 0;
 }
 
 /*
@@ -1658,6 +1839,123 @@ bool INLINE_ATTR select_exec::unpack_for_sk(txn_wrapper *txn,
   return false;
 }
 
+/*
+  Remember a secondary key entry so that primary key lookups of the
+  entries not covering the query can be done through MultiGet later in
+  flush_sk_batch
+ */
+bool INLINE_ATTR select_exec::add_to_sk_batch(const rocksdb::Slice &rkey,
+                                              const rocksdb::Slice &rvalue) {
+  size_t pk_pos = MAX_SIZE;
+  if (!m_key_def->covers_lookup(&rvalue, &m_lookup_bitmap)) {
+    uint pk_tuple_size = m_key_def->get_primary_key_tuple(
+        m_table, *m_pk_def, &rkey, m_pk_tuple_buf.data());
+    if (pk_tuple_size == RDB_INVALID_KEY_LEN) {
+      m_handler->print_error(HA_ERR_ROCKSDB_CORRUPT_DATA, 0);
+      return true;
+    }
+    pk_pos = m_sk_batch_pk_keys.size();
+    m_sk_batch_pk_keys.emplace_back(
+        reinterpret_cast<const char *>(m_pk_tuple_buf.data()), pk_tuple_size);
+  }
+
+  m_sk_batch.push_back({rkey.ToString(), rvalue.ToString(), pk_pos});
+  return false;
+}
+
+/*
+  Look up the primary keys of all batched secondary key entries, then
+  unpack, evaluate and send them in the original index order.
+  Return value is the same as eval_and_send
+ */
+int INLINE_ATTR select_exec::flush_sk_batch(txn_wrapper *txn) {
+  if (m_sk_batch.empty()) {
+    return 0;
+  }
+
+  const size_t size = m_sk_batch_pk_keys.size();
+  std::vector<rocksdb::Slice> key_slices(m_sk_batch_pk_keys.begin(),
+                                         m_sk_batch_pk_keys.end());
+  std::vector<rocksdb::PinnableSlice> value_slices(size);
+  std::vector<rocksdb::Status> statuses(size);
+  if (size > get_select_bypass_multiget_min()) {
+    // Secondary key order says nothing about primary key order
+    txn->multi_get(m_pk_def->get_cf(), size, false /* sorted_input */,
+                   key_slices.data(), value_slices.data(), statuses.data());
+  } else {
+    for (size_t i = 0; i < size; ++i) {
+      statuses[i] = txn->get(m_pk_def->get_cf(), key_slices[i],
+                             &value_slices[i]);
+    }
+  }
+
+  int ret = 0;
+  for (const auto &entry : m_sk_batch) {
+    if (unlikely(handle_killed())) {
+      ret = 1;
+      break;
+    }
+
+    int rc;
+    if (entry.pk_pos == MAX_SIZE) {
+      // SK covers the entire lookup
+      const rocksdb::Slice rkey(entry.key);
+      const rocksdb::Slice rvalue(entry.value);
+      rc = m_key_def->unpack_record(
+          m_table, m_table->record[0], &rkey, &rvalue,
+          m_converter->get_verify_row_debug_checksums());
+      if (!rc) {
+        ha_rocksdb::inc_covered_sk_lookup();
+      }
+    } else {
+      const rocksdb::Status &s = statuses[entry.pk_pos];
+      if (!s.ok()) {
+        txn->report_error(s);
+        ret = 1;
+        break;
+      }
+      rc = m_converter->decode(m_pk_def, m_table->record[0],
+                               &key_slices[entry.pk_pos],
+                               &value_slices[entry.pk_pos]);
+    }
+
+    if (rc) {
+      m_handler->print_error(rc, 0);
+      ret = 1;
+      break;
+    }
+
+    ret = eval_and_send();
+    if (ret != 0) {
+      break;
+    }
+  }
+
+  m_sk_batch.clear();
+  m_sk_batch_pk_keys.clear();
+  return ret;
+}
+
+/*
+  Batch the secondary key entry and flush the batch once it is full or
+  holds enough rows to satisfy LIMIT.
+  Return value is the same as eval_and_send
+ */
+int INLINE_ATTR select_exec::add_to_sk_batch_and_send(
+    txn_wrapper *txn, const rocksdb::Slice &rkey,
+    const rocksdb::Slice &rvalue) {
+  if (unlikely(add_to_sk_batch(rkey, rvalue))) {
+    return 1;
+  }
+
+  if (m_sk_batch.size() >= SK_BATCH_MAX_SIZE ||
+      m_sk_batch.size() >= m_select_limit - m_row_count) {
+    return flush_sk_batch(txn);
+  }
+
+  return 0;
+}
+
 int INLINE_ATTR select_exec::eval_and_send() {
   m_examined_rows++;
   if (eval_cond()) {
@@ -1840,17 +2138,21 @@ bool INLINE_ATTR select_exec::run_range_query(txn_wrapper *txn) {
       // skipping the first N items in LIMIT, but this is low priority
       // for now
       const rocksdb::Slice rvalue = m_scan_it->value();
+      int ret;
       if (m_index_is_pk) {
         if (unlikely(unpack_for_pk(rkey, rvalue))) {
           return true;
         }
-      } else {
+        ret = eval_and_send();
+      } else if (m_keyread_only) {
         if (unlikely(unpack_for_sk(txn, rkey, rvalue))) {
           return true;
         }
+        ret = eval_and_send();
+      } else {
+        ret = add_to_sk_batch_and_send(txn, rkey, rvalue);
       }
 
-      int ret = eval_and_send();
       if (unlikely(ret > 0)) {
         // failure
         return true;
@@ -1863,7 +2165,7 @@ bool INLINE_ATTR select_exec::run_range_query(txn_wrapper *txn) {
     }  // while (true)
   }    // for m_key_index_tuples
 
-  return false;
+  return flush_sk_batch(txn) > 0;
 }
 
 }  // namespace
@@ -1942,10 +2244,36 @@ bool rocksdb_handle_single_table_select(THD *thd, SELECT_LEX *select_lex) {
     return false;
   }
 
-  // Parse the SELECT statement
   select_parser select_stmt(thd, select_lex);
-  if (select_stmt.parse()) {
-    return handle_unsupported_bypass(thd, select_stmt.get_error_msg());
+  const TABLE *table = select_lex->table_list.first->table;
+  auto plan = static_cast<select_plan *>(select_lex->select_bypass_plan);
+  if (plan != nullptr && plan->is_valid(table, select_lex)) {
+    // Prepared statement executed before - reuse the plan
+    if (select_stmt.bind(*plan)) {
+      return handle_unsupported_bypass(thd, select_stmt.get_error_msg());
+    }
+    plan->m_item.hits++;
+    rocksdb_select_bypass_plan_hits++;
+  } else {
+    delete plan;
+    select_lex->select_bypass_plan = nullptr;
+
+    // Only prepared statements keep their SELECT_LEX across executions
+    std::unique_ptr<select_plan> new_plan;
+    if (thd->stmt_arena->type() == Query_arena::PREPARED_STATEMENT) {
+      new_plan.reset(new select_plan(table, select_lex));
+    }
+
+    // Parse the SELECT statement
+    if (select_stmt.parse(new_plan.get())) {
+      return handle_unsupported_bypass(thd, select_stmt.get_error_msg());
+    }
+
+    if (new_plan) {
+      new_plan->register_plan(table);
+      select_lex->select_bypass_plan = new_plan.release();
+      rocksdb_select_bypass_plan_misses++;
+    }
   }
 
   // Execute SELECT statement
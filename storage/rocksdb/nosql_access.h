@@ -18,6 +18,7 @@
 #include <array>
 #include <atomic>
 #include <deque>
+#include <list>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -40,6 +41,15 @@ struct REJECTED_ITEM {
   std::string error_msg;
 };
 
+struct BYPASS_PLAN_ITEM {
+  // Table and index the plan reads
+  std::string table_schema;
+  std::string table_name;
+  std::string index_name;
+  // Executions that reused the plan
+  std::atomic<uint64_t> hits{0};
+};
+
 namespace myrocks {
 
 bool rocksdb_handle_single_table_select(THD *thd, st_select_lex *select_lex);
@@ -47,4 +57,8 @@ bool rocksdb_handle_single_table_select(THD *thd, st_select_lex *select_lex);
 extern std::deque<REJECTED_ITEM> rejected_bypass_queries;
 extern std::mutex rejected_bypass_query_lock;
 
+// Plans cached on prepared statements, see select_plan
+extern std::list<const BYPASS_PLAN_ITEM *> bypass_plans;
+extern std::mutex bypass_plan_lock;
+
 }  // namespace myrocks
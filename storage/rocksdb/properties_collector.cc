@@ -19,6 +19,7 @@
 
 /* Standard C++ header files */
 #include <algorithm>
+#include <cmath>
 #include <map>
 #include <string>
 #include <vector>
@@ -41,6 +42,7 @@ std::atomic<uint64_t> rocksdb_num_sst_entry_merge(0);
 std::atomic<uint64_t> rocksdb_num_sst_entry_other(0);
 std::atomic<uint64_t> rocksdb_additional_compaction_triggers(0);
 my_bool rocksdb_compaction_sequential_deletes_count_sd = false;
+uint32_t rocksdb_table_stats_histogram_buckets = 0;
 
 Rdb_tbl_prop_coll::Rdb_tbl_prop_coll(Rdb_ddl_manager *const ddl_manager,
                                      const Rdb_compact_params &params,
@@ -60,6 +62,7 @@ Rdb_tbl_prop_coll::Rdb_tbl_prop_coll(Rdb_ddl_manager *const ddl_manager,
       m_file_size(0),
       m_params(params),
       m_cardinality_collector(table_stats_sampling_pct),
+      m_histogram_collector(rocksdb_table_stats_histogram_buckets),
       m_recorded(false) {
   DBUG_ASSERT(ddl_manager != nullptr);
 
@@ -121,6 +124,11 @@ Rdb_index_stats *Rdb_tbl_prop_coll::AccessStats(const rocksdb::Slice &key) {
   if (m_last_stats == nullptr || m_last_stats->m_gl_index_id != gl_index_id) {
     m_keydef = nullptr;
 
+    // the histogram of the previous index is complete
+    if (m_last_stats != nullptr) {
+      m_histogram_collector.SetHistogram(m_last_stats);
+    }
+
     // starting a new table
     // add the new element into m_stats
     m_stats.emplace_back(gl_index_id);
@@ -144,6 +152,7 @@ Rdb_index_stats *Rdb_tbl_prop_coll::AccessStats(const rocksdb::Slice &key) {
       }
     }
     m_cardinality_collector.Reset();
+    m_histogram_collector.Reset();
   }
 
   return m_last_stats;
@@ -189,6 +198,7 @@ void Rdb_tbl_prop_coll::CollectStatsForRow(const rocksdb::Slice &key,
 
   if (m_keydef != nullptr && type == rocksdb::kEntryPut) {
     m_cardinality_collector.ProcessKey(key, m_keydef.get(), stats);
+    m_histogram_collector.ProcessKey(key);
   }
 }
 
@@ -236,6 +246,10 @@ rocksdb::Status Rdb_tbl_prop_coll::Finish(
       rocksdb_num_sst_entry_other += m_total_merges;
     }
 
+    if (m_last_stats != nullptr) {
+      m_histogram_collector.SetHistogram(m_last_stats);
+    }
+
     for (Rdb_index_stats &stat : m_stats) {
       m_cardinality_collector.SetCardinality(&stat);
       m_cardinality_collector.AdjustStats(&stat);
@@ -339,7 +353,9 @@ std::string Rdb_tbl_prop_coll::GetReadableStats(const Rdb_index_stats &it) {
     s.append(std::to_string(num));
     s.append(" ");
   }
-  s.append("]}");
+  s.append("], histogram buckets:");
+  s.append(std::to_string(it.m_histogram ? it.m_histogram->buckets() : 0));
+  s.append("}");
   return s;
 }
 
@@ -366,7 +382,14 @@ void Rdb_tbl_prop_coll::read_stats_from_tbl_props(
 std::string Rdb_index_stats::materialize(
     const std::vector<Rdb_index_stats> &stats) {
   String ret;
-  rdb_netstr_append_uint16(&ret, INDEX_STATS_VERSION_ENTRY_TYPES);
+  // Only use the histogram format when there is a histogram to store, so
+  // that the stats stay readable by older versions otherwise.
+  const bool has_histogram = std::any_of(
+      stats.begin(), stats.end(),
+      [](const Rdb_index_stats &i) { return i.m_histogram != nullptr; });
+  rdb_netstr_append_uint16(&ret, has_histogram
+                                     ? INDEX_STATS_VERSION_HISTOGRAM
+                                     : INDEX_STATS_VERSION_ENTRY_TYPES);
   for (const auto &i : stats) {
     rdb_netstr_append_uint32(&ret, i.m_gl_index_id.cf_id);
     rdb_netstr_append_uint32(&ret, i.m_gl_index_id.index_id);
@@ -382,6 +405,20 @@ std::string Rdb_index_stats::materialize(
     for (const auto &num_keys : i.m_distinct_keys_per_prefix) {
       rdb_netstr_append_uint64(&ret, num_keys);
     }
+    if (has_histogram) {
+      const size_t buckets = i.m_histogram ? i.m_histogram->buckets() : 0;
+      rdb_netstr_append_uint64(&ret, buckets);
+      if (buckets > 0) {
+        for (const auto &bound : i.m_histogram->m_bounds) {
+          DBUG_ASSERT(bound.size() <= Rdb_index_histogram::MAX_BOUND_LENGTH);
+          rdb_netstr_append_uint16(&ret, bound.size());
+          ret.append(bound.data(), bound.size());
+        }
+        for (const auto &rows : i.m_histogram->m_rows) {
+          rdb_netstr_append_uint64(&ret, rows);
+        }
+      }
+    }
   }
 
   return std::string((char *)ret.ptr(), ret.length());
@@ -408,7 +445,7 @@ int Rdb_index_stats::unmaterialize(const std::string &s,
   Rdb_index_stats stats;
   // Make sure version is within supported range.
   if (version < INDEX_STATS_VERSION_INITIAL ||
-      version > INDEX_STATS_VERSION_ENTRY_TYPES) {
+      version > INDEX_STATS_VERSION_HISTOGRAM) {
     // NO_LINT_DEBUG
     sql_print_error(
         "Index stats version %d was outside of supported range. "
@@ -450,6 +487,35 @@ int Rdb_index_stats::unmaterialize(const std::string &s,
     for (std::size_t i = 0; i < stats.m_distinct_keys_per_prefix.size(); i++) {
       stats.m_distinct_keys_per_prefix[i] = rdb_netbuf_read_uint64(&p);
     }
+    stats.m_histogram = nullptr;
+    if (version >= INDEX_STATS_VERSION_HISTOGRAM) {
+      if (p + sizeof(uint64) > p2) {
+        return HA_EXIT_FAILURE;
+      }
+      const uint64 buckets = rdb_netbuf_read_uint64(&p);
+      if (buckets > 0) {
+        const auto histogram = std::make_shared<Rdb_index_histogram>();
+        for (uint64 i = 0; i <= buckets; i++) {
+          if (p + sizeof(uint16) > p2) {
+            return HA_EXIT_FAILURE;
+          }
+          const uint16 len = rdb_netbuf_read_uint16(&p);
+          if (p + len > p2) {
+            return HA_EXIT_FAILURE;
+          }
+          histogram->m_bounds.emplace_back(reinterpret_cast<const char *>(p),
+                                           len);
+          p += len;
+        }
+        if (p + buckets * sizeof(uint64) > p2) {
+          return HA_EXIT_FAILURE;
+        }
+        for (uint64 i = 0; i < buckets; i++) {
+          histogram->m_rows.push_back(rdb_netbuf_read_uint64(&p));
+        }
+        stats.m_histogram = histogram;
+      }
+    }
     ret->push_back(stats);
   }
   return HA_EXIT_SUCCESS;
@@ -495,6 +561,16 @@ void Rdb_index_stats::merge(const Rdb_index_stats &s, const bool increment,
     for (i = 0; i < s.m_distinct_keys_per_prefix.size(); i++) {
       m_distinct_keys_per_prefix[i] += s.m_distinct_keys_per_prefix[i];
     }
+    if (s.m_histogram) {
+      std::vector<std::pair<const Rdb_index_histogram *, double>> sources = {
+          {s.m_histogram.get(), 1.0}};
+      size_t buckets = s.m_histogram->buckets();
+      if (m_histogram) {
+        sources.emplace_back(m_histogram.get(), 1.0);
+        buckets = std::max(buckets, m_histogram->buckets());
+      }
+      m_histogram = Rdb_index_histogram::merge(sources, buckets);
+    }
   } else {
     m_rows -= s.m_rows;
     m_data_size -= s.m_data_size;
@@ -507,6 +583,21 @@ void Rdb_index_stats::merge(const Rdb_index_stats &s, const bool increment,
     for (i = 0; i < s.m_distinct_keys_per_prefix.size(); i++) {
       m_distinct_keys_per_prefix[i] -= s.m_distinct_keys_per_prefix[i];
     }
+    if (m_histogram) {
+      /*
+        The rows of the removed SST can't be told apart in the merged
+        histogram, so keep its shape and only scale it down to the rows that
+        are left. The next full recalculation rebuilds it from the SSTs.
+      */
+      const int64_t total_rows = m_histogram->total_rows();
+      if (m_rows <= 0 || total_rows <= 0) {
+        m_histogram = nullptr;
+      } else if (m_rows < total_rows) {
+        m_histogram = Rdb_index_histogram::merge(
+            {{m_histogram.get(), static_cast<double>(m_rows) / total_rows}},
+            m_histogram->buckets());
+      }
+    }
   }
 }
 
@@ -516,6 +607,170 @@ void Rdb_index_stats::adjust_cardinality(double adjustment_factor) {
   }
 }
 
+const size_t Rdb_index_histogram::MAX_BOUND_LENGTH;
+
+int64_t Rdb_index_histogram::total_rows() const {
+  int64_t total = 0;
+  for (const int64_t rows : m_rows) {
+    total += rows;
+  }
+  return total;
+}
+
+/*
+  Estimates the number of rows with keys in [min_key, max_key), in memcmp
+  order. Buckets that are entirely in the range are counted in full and the
+  ones it only overlaps count for half of their rows.
+
+  Returns false when the range doesn't cover a single bucket: the histogram
+  can't tell where the rows are inside of a bucket, so the caller is better
+  off with a size based estimate.
+*/
+bool Rdb_index_histogram::rows_in_range(const rocksdb::Slice &min_key,
+                                        const rocksdb::Slice &max_key,
+                                        int64_t *rows) const {
+  DBUG_ASSERT(rows != nullptr);
+
+  // Skip to the first bucket whose upper bound isn't below min_key
+  const auto it = std::lower_bound(
+      m_bounds.begin(), m_bounds.end(), min_key,
+      [](const std::string &bound, const rocksdb::Slice &key) {
+        return rocksdb::Slice(bound).compare(key) < 0;
+      });
+  size_t i = it - m_bounds.begin();
+  i = i > 0 ? i - 1 : 0;
+
+  bool covered = false;
+  int64_t full_rows = 0;
+  int64_t partial_rows = 0;
+  for (; i < buckets(); i++) {
+    const rocksdb::Slice lower(m_bounds[i]);
+    const rocksdb::Slice upper(m_bounds[i + 1]);
+    if (lower.compare(max_key) >= 0) {
+      break;
+    }
+    if (upper.compare(min_key) < 0) {
+      continue;
+    }
+    if (lower.compare(min_key) >= 0 && upper.compare(max_key) < 0) {
+      full_rows += m_rows[i];
+      covered = true;
+    } else {
+      partial_rows += m_rows[i];
+    }
+  }
+
+  *rows = full_rows + partial_rows / 2;
+  return covered;
+}
+
+/*
+  Builds a histogram of about max_buckets equi-depth buckets out of the given
+  ones, with the rows of each source scaled by its factor.
+
+  The rows of a source bucket are spread evenly over the pieces it is cut into
+  by the bounds of the other sources, and the pieces are then grouped back
+  into buckets. Single-key buckets are kept apart from their neighbours as
+  long as they are heavy enough to fill a bucket by themselves.
+*/
+std::shared_ptr<const Rdb_index_histogram> Rdb_index_histogram::merge(
+    const std::vector<std::pair<const Rdb_index_histogram *, double>> &sources,
+    const size_t max_buckets) {
+  std::vector<std::string> keys;
+  std::vector<std::string> single_keys;
+  for (const auto &source : sources) {
+    const Rdb_index_histogram &h = *source.first;
+    keys.insert(keys.end(), h.m_bounds.begin(), h.m_bounds.end());
+    for (size_t i = 0; i < h.buckets(); i++) {
+      if (h.m_bounds[i] == h.m_bounds[i + 1]) {
+        single_keys.push_back(h.m_bounds[i]);
+      }
+    }
+  }
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  std::sort(single_keys.begin(), single_keys.end());
+
+  // Piece j goes from bounds[j] to bounds[j + 1]. Single keys are listed
+  // twice, which gives them a piece of their own.
+  std::vector<std::string> bounds;
+  for (const auto &key : keys) {
+    bounds.push_back(key);
+    if (std::binary_search(single_keys.begin(), single_keys.end(), key)) {
+      bounds.push_back(key);
+    }
+  }
+  if (bounds.size() < 2 || max_buckets == 0) {
+    return nullptr;
+  }
+
+  std::vector<double> piece_rows(bounds.size() - 1, 0);
+  for (const auto &source : sources) {
+    const Rdb_index_histogram &h = *source.first;
+    for (size_t i = 0; i < h.buckets(); i++) {
+      const double rows = h.m_rows[i] * source.second;
+      const std::string &lower = h.m_bounds[i];
+      const std::string &upper = h.m_bounds[i + 1];
+      if (lower == upper) {
+        const size_t j =
+            std::lower_bound(bounds.begin(), bounds.end(), lower) -
+            bounds.begin();
+        piece_rows[j] += rows;
+        continue;
+      }
+
+      const size_t first =
+          std::upper_bound(bounds.begin(), bounds.end(), lower) -
+          bounds.begin() - 1;
+      const size_t last =
+          std::lower_bound(bounds.begin(), bounds.end(), upper) -
+          bounds.begin();
+      size_t pieces = 0;
+      for (size_t j = first; j < last; j++) {
+        pieces += (bounds[j] != bounds[j + 1]);
+      }
+      for (size_t j = first; j < last; j++) {
+        if (bounds[j] != bounds[j + 1]) {
+          piece_rows[j] += rows / pieces;
+        }
+      }
+    }
+  }
+
+  double total_rows = 0;
+  for (const double rows : piece_rows) {
+    total_rows += rows;
+  }
+  if (total_rows <= 0) {
+    return nullptr;
+  }
+
+  const double bucket_rows = total_rows / max_buckets;
+  const auto ret = std::make_shared<Rdb_index_histogram>();
+  ret->m_bounds.push_back(bounds[0]);
+  double rows = 0;
+  for (size_t j = 0; j < piece_rows.size(); j++) {
+    if (bounds[j] == bounds[j + 1] && piece_rows[j] >= bucket_rows &&
+        rows > 0) {
+      ret->m_bounds.push_back(bounds[j]);
+      ret->m_rows.push_back(llround(rows));
+      rows = 0;
+    }
+    rows += piece_rows[j];
+    if (rows >= bucket_rows || j + 1 == piece_rows.size()) {
+      if (rows > 0 || ret->m_rows.empty()) {
+        ret->m_bounds.push_back(bounds[j + 1]);
+        ret->m_rows.push_back(llround(rows));
+      } else {
+        ret->m_bounds.back() = bounds[j + 1];
+      }
+      rows = 0;
+    }
+  }
+
+  return ret;
+}
+
 Rdb_tbl_card_coll::Rdb_tbl_card_coll(const uint8_t table_stats_sampling_pct)
     : m_table_stats_sampling_pct(table_stats_sampling_pct),
       m_seed(time(nullptr)) {}
@@ -590,4 +845,76 @@ void Rdb_tbl_card_coll::SetCardinality(Rdb_index_stats *stats) {
   }
 }
 
+Rdb_tbl_hist_coll::Rdb_tbl_hist_coll(const uint32_t max_buckets)
+    : m_max_buckets(max_buckets), m_step(1), m_pending_rows(0) {}
+
+void Rdb_tbl_hist_coll::ProcessKey(const rocksdb::Slice &key) {
+  if (m_max_buckets == 0) {
+    return;
+  }
+
+  m_last_key.assign(key.data(), std::min(key.size(),
+                                         Rdb_index_histogram::MAX_BOUND_LENGTH));
+  if (m_histogram.m_bounds.empty()) {
+    m_histogram.m_bounds.push_back(m_last_key);
+  }
+
+  if (++m_pending_rows >= static_cast<int64_t>(m_step)) {
+    m_histogram.m_bounds.push_back(m_last_key);
+    m_histogram.m_rows.push_back(m_pending_rows);
+    m_pending_rows = 0;
+
+    if (m_histogram.buckets() >= 2 * m_max_buckets) {
+      CompactBuckets();
+    }
+  }
+}
+
+/*
+  Halves the number of buckets by joining them pairwise, and doubles the
+  number of keys going into each of the following ones. This keeps the
+  buckets equi-depth without knowing the number of keys in advance.
+*/
+void Rdb_tbl_hist_coll::CompactBuckets() {
+  DBUG_ASSERT(m_histogram.buckets() % 2 == 0);
+
+  const size_t buckets = m_histogram.buckets() / 2;
+  for (size_t i = 0; i < buckets; i++) {
+    m_histogram.m_bounds[i + 1] = std::move(m_histogram.m_bounds[2 * i + 2]);
+    m_histogram.m_rows[i] =
+        m_histogram.m_rows[2 * i] + m_histogram.m_rows[2 * i + 1];
+  }
+  m_histogram.m_bounds.resize(buckets + 1);
+  m_histogram.m_rows.resize(buckets);
+  m_step *= 2;
+}
+
+void Rdb_tbl_hist_coll::Reset() {
+  m_step = 1;
+  m_pending_rows = 0;
+  m_last_key.clear();
+  m_histogram.m_bounds.clear();
+  m_histogram.m_rows.clear();
+}
+
+void Rdb_tbl_hist_coll::SetHistogram(Rdb_index_stats *stats) {
+  if (m_pending_rows > 0) {
+    m_histogram.m_bounds.push_back(m_last_key);
+    m_histogram.m_rows.push_back(m_pending_rows);
+    m_pending_rows = 0;
+  }
+
+  if (m_histogram.buckets() > 0) {
+    // Reverse column families hand the keys over in descending order
+    if (m_histogram.m_bounds.front() > m_histogram.m_bounds.back()) {
+      std::reverse(m_histogram.m_bounds.begin(), m_histogram.m_bounds.end());
+      std::reverse(m_histogram.m_rows.begin(), m_histogram.m_rows.end());
+    }
+    stats->m_histogram =
+        Rdb_index_histogram::merge({{&m_histogram, 1.0}}, m_max_buckets);
+  }
+
+  Reset();
+}
+
 }  // namespace myrocks
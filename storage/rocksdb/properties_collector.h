@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 /* RocksDB header files */
@@ -40,21 +41,54 @@ extern std::atomic<uint64_t> rocksdb_num_sst_entry_merge;
 extern std::atomic<uint64_t> rocksdb_num_sst_entry_other;
 extern std::atomic<uint64_t> rocksdb_additional_compaction_triggers;
 extern my_bool rocksdb_compaction_sequential_deletes_count_sd;
+extern uint32_t rocksdb_table_stats_histogram_buckets;
 
 struct Rdb_compact_params {
   uint64_t m_deletes, m_window, m_file_size;
 };
 
+/*
+  Equi-depth histogram over the keys of an index.
+
+  m_bounds holds the bucket boundaries in memcmp order, truncated to
+  MAX_BOUND_LENGTH bytes, and m_rows[i] is the number of rows with keys
+  between m_bounds[i] and m_bounds[i + 1]. There is always one more bound than
+  there are buckets. A bucket whose two bounds are equal holds a single key
+  prefix that had too many rows to share a bucket with its neighbours.
+
+  Histograms are immutable once built, so that they can be shared between
+  copies of Rdb_index_stats and read without holding the DDL manager lock.
+*/
+struct Rdb_index_histogram {
+  static const size_t MAX_BOUND_LENGTH = 64;
+
+  std::vector<std::string> m_bounds;
+  std::vector<int64_t> m_rows;
+
+  size_t buckets() const { return m_rows.size(); }
+  int64_t total_rows() const;
+
+  bool rows_in_range(const rocksdb::Slice &min_key,
+                     const rocksdb::Slice &max_key, int64_t *rows) const;
+
+  static std::shared_ptr<const Rdb_index_histogram> merge(
+      const std::vector<std::pair<const Rdb_index_histogram *, double>>
+          &sources,
+      const size_t max_buckets);
+};
+
 struct Rdb_index_stats {
   enum {
     INDEX_STATS_VERSION_INITIAL = 1,
     INDEX_STATS_VERSION_ENTRY_TYPES = 2,
+    INDEX_STATS_VERSION_HISTOGRAM = 3,
   };
   GL_INDEX_ID m_gl_index_id;
   int64_t m_data_size, m_rows, m_actual_disk_size;
   int64_t m_entry_deletes, m_entry_single_deletes;
   int64_t m_entry_merges, m_entry_others;
   std::vector<int64_t> m_distinct_keys_per_prefix;
+  std::shared_ptr<const Rdb_index_histogram> m_histogram;
   std::string m_name;  // name is not persisted
 
   static std::string materialize(const std::vector<Rdb_index_stats> &stats);
@@ -138,6 +172,41 @@ class Rdb_tbl_card_coll {
   unsigned int m_seed;
 };
 
+// The helper class to build an equi-depth histogram of an index
+class Rdb_tbl_hist_coll {
+ public:
+  explicit Rdb_tbl_hist_coll(const uint32_t max_buckets);
+
+ public:
+  /*
+   * Keys must be passed in the order of their column family. Every key is
+   * counted, but only one in m_step becomes a bucket boundary.
+   */
+  void ProcessKey(const rocksdb::Slice &key);
+
+  /*
+   * Resets the state of the collector to start building the histogram of a
+   * next index.
+   */
+  void Reset();
+
+  /*
+   * Closes the last bucket and stores the histogram of the keys processed
+   * since the last Reset() into stats.
+   */
+  void SetHistogram(Rdb_index_stats *stats);
+
+ private:
+  void CompactBuckets();
+
+ private:
+  uint32_t m_max_buckets;
+  uint64_t m_step;
+  int64_t m_pending_rows;
+  std::string m_last_key;
+  Rdb_index_histogram m_histogram;
+};
+
 class Rdb_tbl_prop_coll : public rocksdb::TablePropertiesCollector {
  public:
   Rdb_tbl_prop_coll(Rdb_ddl_manager *const ddl_manager,
@@ -200,6 +269,7 @@ class Rdb_tbl_prop_coll : public rocksdb::TablePropertiesCollector {
   uint64_t m_file_size;
   Rdb_compact_params m_params;
   Rdb_tbl_card_coll m_cardinality_collector;
+  Rdb_tbl_hist_coll m_histogram_collector;
   bool m_recorded;
 };
 
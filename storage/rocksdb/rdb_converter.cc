@@ -225,6 +225,9 @@ Rdb_value_field_iterator<value_field_decoder, dst_type>::
   m_field_iter = fields->begin();
   m_field_end = fields->end();
   m_null_bytes = rdb_converter->get_null_bytes();
+  m_value_offsets = rdb_converter->get_value_offsets();
+  m_value_offsets_width = rdb_converter->get_value_offsets_width();
+  m_value_data = rdb_converter->get_value_data();
 }
 
 // Iterate each requested field and decode one by one
@@ -241,7 +244,21 @@ int Rdb_value_field_iterator<value_field_decoder, dst_type>::next() {
 
     // Skip the bytes we need to skip
     int skip = m_field_iter->m_skip;
-    if (skip && !m_value_slice_reader->read(skip)) {
+    if (m_value_offsets != nullptr) {
+      // Jump straight to the field using the offset directory. Fields are
+      // visited in storage order, so this never moves the reader backwards.
+      const int slot = m_field_iter->m_offset_slot;
+      const char *const field_start =
+          m_value_data + skip +
+          (slot < 0 ? 0
+                    : Rdb_converter::read_value_offset(
+                          m_value_offsets, m_value_offsets_width, slot));
+      const char *const cur = m_value_slice_reader->get_current_ptr();
+      if (field_start < cur ||
+          !m_value_slice_reader->read(field_start - cur)) {
+        return HA_ERR_ROCKSDB_CORRUPT_DATA;
+      }
+    } else if (skip && !m_value_slice_reader->read(skip)) {
       return HA_ERR_ROCKSDB_CORRUPT_DATA;
     }
 
@@ -305,6 +322,9 @@ Rdb_converter::Rdb_converter(const THD *thd, const Rdb_tbl_def *tbl_def,
   m_maybe_unpack_info = false;
   m_row_checksums_checked = 0;
   m_null_bytes = nullptr;
+  m_value_offsets = nullptr;
+  m_value_offsets_width = 0;
+  m_value_data = nullptr;
   setup_field_encoders();
   m_lookup_bitmap = {nullptr, 0, 0, nullptr, nullptr};
 }
@@ -359,6 +379,8 @@ void Rdb_converter::setup_field_decoders(const MY_BITMAP *field_map,
   bitmap_free(&m_lookup_bitmap);
   int last_useful = 0;
   int skip_size = 0;
+  int offset_slot = -1;
+  int next_offset_slot = 0;
 
   for (uint i = 0; i < m_table->s->fields; i++) {
     bool field_requested =
@@ -375,16 +397,36 @@ void Rdb_converter::setup_field_decoders(const MY_BITMAP *field_map,
       continue;
     }
 
+    const bool has_fixed_length =
+        !m_encoder_arr[i].uses_variable_len_encoding() &&
+        !m_encoder_arr[i].maybe_null();
+
+    if (m_has_value_offsets) {
+      // Only the requested fields need a decoder; the offset directory
+      // locates each of them from the nearest preceding directory slot.
+      if (field_requested) {
+        m_decoders_vect.push_back(
+            {&m_encoder_arr[i], true, skip_size, offset_slot});
+        last_useful = m_decoders_vect.size();
+      }
+      if (has_fixed_length) {
+        skip_size += m_encoder_arr[i].m_field_pack_length;
+      } else {
+        offset_slot = next_offset_slot++;
+        skip_size = 0;
+      }
+      continue;
+    }
+
     if (field_requested) {
       // We will need to decode this field
-      m_decoders_vect.push_back({&m_encoder_arr[i], true, skip_size});
+      m_decoders_vect.push_back({&m_encoder_arr[i], true, skip_size, -1});
       last_useful = m_decoders_vect.size();
       skip_size = 0;
     } else {
-      if (m_encoder_arr[i].uses_variable_len_encoding() ||
-          m_encoder_arr[i].maybe_null()) {
+      if (!has_fixed_length) {
         // For variable-length field, we need to read the data and skip it
-        m_decoders_vect.push_back({&m_encoder_arr[i], false, skip_size});
+        m_decoders_vect.push_back({&m_encoder_arr[i], false, skip_size, -1});
         skip_size = 0;
       } else {
         // Fixed-width field can be skipped without looking at it.
@@ -408,6 +450,8 @@ void Rdb_converter::setup_field_decoders(const MY_BITMAP *field_map,
 void Rdb_converter::setup_field_encoders() {
   uint null_bytes_length = 0;
   uchar cur_null_mask = 0x1;
+  m_has_value_offsets = false;
+  m_value_offsets_count = 0;
 
   m_encoder_arr = static_cast<Rdb_field_encoder *>(
       my_malloc(m_table->s->fields * sizeof(Rdb_field_encoder), MYF(0)));
@@ -483,6 +527,11 @@ void Rdb_converter::setup_field_encoders() {
       m_encoder_arr[i].m_null_offset = 0;
       m_encoder_arr[i].m_null_mask = 0;
     }
+
+    if (m_encoder_arr[i].m_storage_type == Rdb_field_encoder::STORE_ALL &&
+        (m_encoder_arr[i].uses_variable_len_encoding() || maybe_null)) {
+      m_value_offsets_count++;
+    }
   }
 
   // Count the last, unfinished NULL-bits byte
@@ -491,6 +540,14 @@ void Rdb_converter::setup_field_encoders() {
   }
 
   m_null_bytes_length_in_record = null_bytes_length;
+
+  // Without nullable or variable length fields every field is at a fixed
+  // position, so there is no directory to write even if the table asks for
+  // one.
+  const auto &pk_def =
+      m_tbl_def->m_key_descr_arr[ha_rocksdb::pk_index(m_table, m_tbl_def)];
+  m_has_value_offsets =
+      pk_def->has_value_offsets() && m_value_offsets_count > 0;
 }
 
 /*
@@ -571,6 +628,17 @@ int Rdb_converter::decode_value_header_for_pk(
                  Rdb_key_def::get_unpack_header_size(unpack_info[0]));
   }
 
+  if (m_has_value_offsets) {
+    uint width;
+    if (reader->read_uint8(&width) ||
+        (width != sizeof(uint16) && width != sizeof(uint32)) ||
+        !(m_value_offsets = reader->read(m_value_offsets_count * width))) {
+      return HA_ERR_ROCKSDB_CORRUPT_DATA;
+    }
+    m_value_offsets_width = width;
+    m_value_data = reader->get_current_ptr();
+  }
+
   return HA_EXIT_SUCCESS;
 }
 
@@ -794,6 +862,12 @@ int Rdb_converter::encode_value_slice(
     m_storage_record.append(reinterpret_cast<char *>(pk_unpack_info->ptr()),
                             pk_unpack_info->get_current_pos());
   }
+
+  // The field offset directory goes here, it is inserted once the field
+  // data has been written and its size is known.
+  const uint32 value_data_pos = m_storage_record.length();
+  m_value_offsets_buf.clear();
+
   for (uint i = 0; i < m_table->s->fields; i++) {
     Rdb_field_encoder &encoder = m_encoder_arr[i];
     /* Don't pack decodable PK key parts */
@@ -812,6 +886,10 @@ int Rdb_converter::encode_value_slice(
       if (field->is_null()) {
         data[encoder.m_null_offset] |= encoder.m_null_mask;
         /* Don't write anything for NULL values */
+        if (m_has_value_offsets) {
+          m_value_offsets_buf.push_back(m_storage_record.length() -
+                                        value_data_pos);
+        }
         continue;
       }
     }
@@ -848,6 +926,18 @@ int Rdb_converter::encode_value_slice(
       const uint len = field->pack_length();
       m_storage_record.append(reinterpret_cast<char *>(field->ptr), len);
     }
+
+    if (m_has_value_offsets &&
+        (encoder.uses_variable_len_encoding() || encoder.maybe_null())) {
+      m_value_offsets_buf.push_back(m_storage_record.length() -
+                                    value_data_pos);
+    }
+  }
+
+  if (m_has_value_offsets) {
+    DBUG_ASSERT(m_value_offsets_buf.size() == m_value_offsets_count);
+    write_value_offsets(&m_storage_record, value_data_pos,
+                        m_value_offsets_buf);
   }
 
   if (store_row_debug_checksums) {
@@ -871,6 +961,39 @@ int Rdb_converter::encode_value_slice(
   return HA_EXIT_SUCCESS;
 }
 
+/**
+  Insert a field offset directory into a value being encoded.
+
+  @param dst      IN/OUT    Value, with all field data written after pos
+  @param pos      IN        Where the field data starts
+  @param offsets  IN        End offset of each directory field, relative to
+                            pos
+
+  The directory is a one byte slot width (2 or 4) followed by the slots in
+  network byte order.
+*/
+void Rdb_converter::write_value_offsets(String *dst, uint32 pos,
+                                        const std::vector<uint32> &offsets) {
+  const uint32 data_len = dst->length() - pos;
+  const uint width = value_offsets_width(data_len);
+  const uint32 dir_len = 1 + offsets.size() * width;
+
+  // Make room for the directory in front of the field data
+  dst->fill(dst->length() + dir_len, 0);
+  uchar *dir = reinterpret_cast<uchar *>(const_cast<char *>(dst->ptr())) + pos;
+  memmove(dir + dir_len, dir, data_len);
+
+  *dir++ = width;
+  for (const uint32 offset : offsets) {
+    if (width == sizeof(uint16)) {
+      rdb_netbuf_store_uint16(dir, offset);
+    } else {
+      rdb_netbuf_store_uint32(dir, offset);
+    }
+    dir += width;
+  }
+}
+
 template class Rdb_value_field_iterator<Rdb_convert_to_record_value_decoder,
                                         uchar *>;
 }  // namespace myrocks
@@ -45,6 +45,12 @@ struct READ_FIELD {
   bool m_decode;
   // Skip this many bytes before reading (or skipping) this field
   int m_skip;
+  /*
+    Only used when values carry a field offset directory: m_skip is counted
+    from the end of the field in this directory slot, or from the start of
+    the field data if it is -1.
+  */
+  int m_offset_slot;
 };
 
 /**
@@ -98,6 +104,11 @@ class Rdb_value_field_iterator {
   Rdb_field_encoder *m_field_dec;
   dst_type m_buf;
   uint m_offset;
+  // Field offset directory of the current value, nullptr if there is none
+  const char *m_value_offsets;
+  uint m_value_offsets_width;
+  // Start of the field data in the current value
+  const char *m_value_data;
 
  public:
   Rdb_value_field_iterator(TABLE *table, Rdb_string_reader *value_slice_reader,
@@ -167,6 +178,7 @@ class Rdb_converter {
     m_key_requested = key_requested;
   }
   bool get_maybe_unpack_info() const { return m_maybe_unpack_info; }
+  bool get_has_value_offsets() const { return m_has_value_offsets; }
 
   char *get_ttl_bytes_buffer() { return m_ttl_bytes; }
 
@@ -180,6 +192,27 @@ class Rdb_converter {
                                  const std::shared_ptr<Rdb_key_def> &pk_def,
                                  rocksdb::Slice *unpack_slice);
 
+  const char *get_value_offsets() const { return m_value_offsets; }
+  uint get_value_offsets_width() const { return m_value_offsets_width; }
+  const char *get_value_data() const { return m_value_data; }
+
+  /*
+    Field offset directory helpers. The directory has one slot for every
+    stored field whose encoded length is not fixed (nullable or variable
+    length fields), holding the offset at which that field ends, counted
+    from the start of the field data.
+  */
+  static uint value_offsets_width(size_t data_len) {
+    return data_len <= 0xFFFF ? sizeof(uint16) : sizeof(uint32);
+  }
+  static uint32 read_value_offset(const char *offsets, uint width, int slot) {
+    const uchar *const p = reinterpret_cast<const uchar *>(offsets);
+    return width == sizeof(uint16) ? rdb_netbuf_to_uint16(p + slot * width)
+                                   : rdb_netbuf_to_uint32(p + slot * width);
+  }
+  static void write_value_offsets(String *dst, uint32 pos,
+                                  const std::vector<uint32> &offsets);
+
  private:
   void setup_field_encoders();
 
@@ -225,6 +258,23 @@ class Rdb_converter {
    TRUE <=> Some fields in the PK may require unpack_info.
   */
   bool m_maybe_unpack_info;
+  /*
+    TRUE <=> Primary key values carry a field offset directory.
+  */
+  bool m_has_value_offsets;
+  /*
+    Number of slots in the field offset directory.
+  */
+  uint m_value_offsets_count;
+  /*
+    Field offset directory, its slot width and the start of the field data
+    of the value being decoded.
+  */
+  const char *m_value_offsets;
+  uint m_value_offsets_width;
+  const char *m_value_data;
+  // field end offsets collected during encode_value_slice
+  std::vector<uint32> m_value_offsets_buf;
   /*
     Pointer to the original TTL timestamp value (8 bytes) during UPDATE.
   */
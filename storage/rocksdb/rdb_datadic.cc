@@ -3665,8 +3665,8 @@ time_t Rdb_tbl_def::get_create_time() {
 
 // Length that each index flag takes inside the record.
 // Each index in the array maps to the enum INDEX_FLAG
-static const std::array<uint, 1> index_flag_lengths = {
-    {ROCKSDB_SIZEOF_TTL_RECORD}};
+static const std::array<uint, 2> index_flag_lengths = {
+    {ROCKSDB_SIZEOF_TTL_RECORD, 0}};
 
 bool Rdb_key_def::has_index_flag(uint32 index_flags, enum INDEX_FLAG flag) {
   return flag & index_flags;
@@ -4409,6 +4409,19 @@ void Rdb_ddl_manager::set_stats(
   mysql_rwlock_unlock(&m_rwlock);
 }
 
+/*
+  Returns the histogram of an index. The stats of a key definition are
+  replaced under m_rwlock, so the pointer to the histogram has to be copied
+  under it as well.
+*/
+std::shared_ptr<const Rdb_index_histogram> Rdb_ddl_manager::get_histogram(
+    const Rdb_key_def &kd) {
+  mysql_rwlock_rdlock(&m_rwlock);
+  auto histogram = kd.m_stats.m_histogram;
+  mysql_rwlock_unlock(&m_rwlock);
+  return histogram;
+}
+
 void Rdb_ddl_manager::adjust_stats(
     const std::vector<Rdb_index_stats> &new_data,
     const std::vector<Rdb_index_stats> &deleted_data) {
@@ -5078,7 +5091,7 @@ bool Rdb_dict_manager::get_index_info(
       case Rdb_key_def::INDEX_TYPE_PRIMARY:
       case Rdb_key_def::INDEX_TYPE_HIDDEN_PRIMARY: {
         error = index_info->m_kv_version >
-                Rdb_key_def::PRIMARY_FORMAT_VERSION_LATEST;
+                Rdb_key_def::PRIMARY_FORMAT_VERSION_VALUE_OFFSETS;
         break;
       }
       case Rdb_key_def::INDEX_TYPE_SECONDARY:
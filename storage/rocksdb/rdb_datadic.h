@@ -472,13 +472,18 @@ class Rdb_key_def {
   };
 
   // bit flags which denote myrocks specific fields stored in the record
-  // currently only used for TTL.
+  // or myrocks specific record layouts.
   enum INDEX_FLAG {
     TTL_FLAG = 1 << 0,
 
+    // Primary key values carry a field offset directory, see
+    // Rdb_converter::encode_value_slice(). Takes no space in the record
+    // prefix.
+    VALUE_OFFSETS_FLAG = 1 << 1,
+
     // MAX_FLAG marks where the actual record starts
     // This flag always needs to be set to the last index flag enum.
-    MAX_FLAG = TTL_FLAG << 1,
+    MAX_FLAG = VALUE_OFFSETS_FLAG << 1,
   };
 
   // Set of flags to ignore when comparing two CF-s and determining if
@@ -562,6 +567,13 @@ class Rdb_key_def {
     //  - This means that when TTL is specified for the table an 8-byte TTL
     //    field is prepended in front of each value.
     PRIMARY_FORMAT_VERSION_TTL = 13,
+    // This change includes support for field offset directories
+    //  - This means that when VALUE_OFFSETS_FLAG is set for the index, the
+    //    end offsets of the nullable and variable length fields are stored
+    //    after the unpack info of each value.
+    //  - Only indexes with VALUE_OFFSETS_FLAG are written with this version,
+    //    so that the others can still be opened by older binaries.
+    PRIMARY_FORMAT_VERSION_VALUE_OFFSETS = 14,
     PRIMARY_FORMAT_VERSION_LATEST = PRIMARY_FORMAT_VERSION_TTL,
 
     SECONDARY_FORMAT_VERSION_INITIAL = 10,
@@ -594,6 +606,12 @@ class Rdb_key_def {
                               std::string *ttl_column, uint *ttl_field_index,
                               bool skip_checks = false);
   inline bool has_ttl() const { return m_ttl_duration > 0; }
+  inline bool has_value_offsets() const {
+    // Secondary keys never carry a directory
+    return index_format_min_check(PRIMARY_FORMAT_VERSION_VALUE_OFFSETS,
+                                  SECONDARY_FORMAT_VERSION_UPDATE3) &&
+           has_index_flag(m_index_flags_bitmap, VALUE_OFFSETS_FLAG);
+  }
 
   uint extract_partial_index_info(const TABLE *const table_arg,
                                   const Rdb_tbl_def *const tbl_def_arg);
@@ -1265,6 +1283,8 @@ class Rdb_ddl_manager {
                     const std::vector<Rdb_index_stats> &deleted_data =
                         std::vector<Rdb_index_stats>());
   void persist_stats(const bool sync = false);
+  std::shared_ptr<const Rdb_index_histogram> get_histogram(
+      const Rdb_key_def &kd);
 
   void set_table_stats(const std::string &tbl_name);
 
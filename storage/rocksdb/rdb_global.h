@@ -55,6 +55,7 @@ struct Rdb_trx_info {
   int read_only;
   int deadlock_detect;
   int num_ongoing_bulk_load;
+  ulonglong spilled_bytes;
   ulong thread_id;
   std::string query_str;
 };
@@ -184,6 +185,9 @@ const char *const RDB_PARTIAL_INDEX_THRESHOLD_QUALIFIER =
 #define RDB_TBL_STATS_SAMPLE_PCT_MIN 1
 #define RDB_TBL_STATS_SAMPLE_PCT_MAX 100
 
+/* Maximum number of histogram buckets collected per index */
+#define RDB_TBL_STATS_HISTOGRAM_BUCKETS_MAX 1024
+
 #define RDB_TBL_STATS_RECALC_THRESHOLD_PCT_MAX 100
 
 /* Minimum time interval between stats recalc for a given table */
@@ -943,6 +943,40 @@ static int rdb_i_s_bypass_rejected_query_history_fill_table(
   DBUG_RETURN(ret);
 }
 
+/*
+  Support for INFORMATION_SCHEMA.ROCKSDB_BYPASS_PLANS dynamic table
+ */
+static int rdb_i_s_bypass_plans_fill_table(
+    my_core::THD *thd, my_core::TABLE_LIST *tables,
+    my_core::Item *cond MY_ATTRIBUTE((__unused__))) {
+  DBUG_ASSERT(thd != nullptr);
+  DBUG_ASSERT(tables != nullptr);
+
+  DBUG_ENTER_FUNC();
+
+  int ret = 0;
+  const std::lock_guard<std::mutex> lock(myrocks::bypass_plan_lock);
+  for (const BYPASS_PLAN_ITEM *entry : myrocks::bypass_plans) {
+    Field **field = tables->table->field;
+    DBUG_ASSERT(field != nullptr);
+
+    field[0]->store(entry->table_schema.c_str(), entry->table_schema.size(),
+                    system_charset_info);
+    field[1]->store(entry->table_name.c_str(), entry->table_name.size(),
+                    system_charset_info);
+    field[2]->store(entry->index_name.c_str(), entry->index_name.size(),
+                    system_charset_info);
+    field[3]->store(entry->hits.load(), true);
+
+    ret = static_cast<int>(
+        my_core::schema_table_store_record(thd, tables->table));
+    if (ret != 0) {
+      break;
+    }
+  }
+  DBUG_RETURN(ret);
+}
+
 static ST_FIELD_INFO rdb_i_s_compact_stats_fields_info[] = {
     ROCKSDB_FIELD_INFO("CF_NAME", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
     ROCKSDB_FIELD_INFO("LEVEL", FN_REFLEN + 1, MYSQL_TYPE_STRING, 0),
@@ -950,6 +984,13 @@ static ST_FIELD_INFO rdb_i_s_compact_stats_fields_info[] = {
     ROCKSDB_FIELD_INFO("VALUE", sizeof(double), MYSQL_TYPE_DOUBLE, 0),
     ROCKSDB_FIELD_INFO_END};
 
+static ST_FIELD_INFO rdb_i_s_bypass_plans_fields_info[] = {
+    ROCKSDB_FIELD_INFO("TABLE_SCHEMA", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("TABLE_NAME", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("INDEX_NAME", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("HITS", sizeof(uint64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO_END};
+
 static ST_FIELD_INFO rdb_i_s_bypass_rejected_query_history_fields_info[] = {
     ROCKSDB_FIELD_INFO("CREATE_TIME", 0, MYSQL_TYPE_TIMESTAMP, 0),
     ROCKSDB_FIELD_INFO("QUERY", 100, MYSQL_TYPE_STRING, 0),
@@ -1152,6 +1193,20 @@ static int rdb_i_s_compact_stats_init(void *p) {
   DBUG_RETURN(0);
 }
 
+static int rdb_i_s_bypass_plans_init(void *p) {
+  my_core::ST_SCHEMA_TABLE *schema;
+
+  DBUG_ENTER_FUNC();
+  DBUG_ASSERT(p != nullptr);
+
+  schema = reinterpret_cast<my_core::ST_SCHEMA_TABLE *>(p);
+
+  schema->fields_info = rdb_i_s_bypass_plans_fields_info;
+  schema->fill_table = rdb_i_s_bypass_plans_fill_table;
+
+  DBUG_RETURN(0);
+}
+
 static int rdb_i_s_bypass_rejected_query_history_init(void *p) {
   my_core::ST_SCHEMA_TABLE *schema;
 
@@ -1520,6 +1575,171 @@ static int rdb_i_s_index_file_map_init(void *const p) {
   DBUG_RETURN(0);
 }
 
+namespace  // anonymous namespace = not visible outside this source file
+{
+struct Rdb_index_histogram_scanner : public Rdb_tables_scanner {
+  my_core::THD *m_thd;
+  my_core::TABLE *m_table;
+
+  int add_table(Rdb_tbl_def *tdef) override;
+};
+}  // anonymous namespace
+
+/*
+  Support for INFORMATION_SCHEMA.ROCKSDB_INDEX_HISTOGRAM dynamic table
+ */
+namespace RDB_INDEX_HISTOGRAM_FIELD {
+enum {
+  TABLE_SCHEMA = 0,
+  TABLE_NAME,
+  PARTITION_NAME,
+  INDEX_NAME,
+  COLUMN_FAMILY,
+  INDEX_NUMBER,
+  BUCKET,
+  LOWER_BOUND,
+  UPPER_BOUND,
+  NUM_ROWS
+};
+}  // namespace RDB_INDEX_HISTOGRAM_FIELD
+
+static ST_FIELD_INFO rdb_i_s_index_histogram_fields_info[] = {
+    /* The bounds are the hex dumps of the index keys without the index
+     * number, truncated to the length kept by the histogram */
+    ROCKSDB_FIELD_INFO("TABLE_SCHEMA", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("TABLE_NAME", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("PARTITION_NAME", NAME_LEN + 1, MYSQL_TYPE_STRING,
+                       MY_I_S_MAYBE_NULL),
+    ROCKSDB_FIELD_INFO("INDEX_NAME", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("COLUMN_FAMILY", sizeof(uint32_t), MYSQL_TYPE_LONG, 0),
+    ROCKSDB_FIELD_INFO("INDEX_NUMBER", sizeof(uint32_t), MYSQL_TYPE_LONG, 0),
+    ROCKSDB_FIELD_INFO("BUCKET", sizeof(uint32_t), MYSQL_TYPE_LONG, 0),
+    ROCKSDB_FIELD_INFO("LOWER_BOUND",
+                       Rdb_index_histogram::MAX_BOUND_LENGTH * 2 + 1,
+                       MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("UPPER_BOUND",
+                       Rdb_index_histogram::MAX_BOUND_LENGTH * 2 + 1,
+                       MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("NUM_ROWS", sizeof(int64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO_END};
+
+static void rdb_i_s_store_histogram_bound(Field *const field,
+                                          const std::string &bound) {
+  const std::size_t skip =
+      std::min(bound.size(), (std::size_t)Rdb_key_def::INDEX_NUMBER_SIZE);
+  const std::string hex =
+      rdb_hexdump(bound.data() + skip, bound.size() - skip);
+  field->store(hex.data(), hex.size(), system_charset_info);
+}
+
+int Rdb_index_histogram_scanner::add_table(Rdb_tbl_def *tdef) {
+  DBUG_ASSERT(tdef != nullptr);
+
+  int ret = 0;
+
+  DBUG_ASSERT(m_table != nullptr);
+  Field **field = m_table->field;
+  DBUG_ASSERT(field != nullptr);
+
+  const std::string &dbname = tdef->base_dbname();
+  field[RDB_INDEX_HISTOGRAM_FIELD::TABLE_SCHEMA]->store(
+      dbname.c_str(), dbname.size(), system_charset_info);
+
+  const std::string &tablename = tdef->base_tablename();
+  field[RDB_INDEX_HISTOGRAM_FIELD::TABLE_NAME]->store(
+      tablename.c_str(), tablename.size(), system_charset_info);
+
+  const std::string &partname = tdef->base_partition();
+  if (partname.length() == 0) {
+    field[RDB_INDEX_HISTOGRAM_FIELD::PARTITION_NAME]->set_null();
+  } else {
+    field[RDB_INDEX_HISTOGRAM_FIELD::PARTITION_NAME]->set_notnull();
+    field[RDB_INDEX_HISTOGRAM_FIELD::PARTITION_NAME]->store(
+        partname.c_str(), partname.size(), system_charset_info);
+  }
+
+  for (uint i = 0; i < tdef->m_key_count; i++) {
+    const Rdb_key_def &kd = *tdef->m_key_descr_arr[i];
+
+    // The DDL manager lock is held while scanning, so the stats are stable
+    const auto &histogram = kd.m_stats.m_histogram;
+    if (!histogram) {
+      continue;
+    }
+
+    field[RDB_INDEX_HISTOGRAM_FIELD::INDEX_NAME]->store(
+        kd.m_name.c_str(), kd.m_name.size(), system_charset_info);
+
+    GL_INDEX_ID gl_index_id = kd.get_gl_index_id();
+    field[RDB_INDEX_HISTOGRAM_FIELD::COLUMN_FAMILY]->store(gl_index_id.cf_id,
+                                                           true);
+    field[RDB_INDEX_HISTOGRAM_FIELD::INDEX_NUMBER]->store(gl_index_id.index_id,
+                                                          true);
+
+    for (size_t bucket = 0; bucket < histogram->buckets(); bucket++) {
+      field[RDB_INDEX_HISTOGRAM_FIELD::BUCKET]->store(bucket, true);
+      rdb_i_s_store_histogram_bound(
+          field[RDB_INDEX_HISTOGRAM_FIELD::LOWER_BOUND],
+          histogram->m_bounds[bucket]);
+      rdb_i_s_store_histogram_bound(
+          field[RDB_INDEX_HISTOGRAM_FIELD::UPPER_BOUND],
+          histogram->m_bounds[bucket + 1]);
+      field[RDB_INDEX_HISTOGRAM_FIELD::NUM_ROWS]->store(
+          histogram->m_rows[bucket], false);
+
+      ret = my_core::schema_table_store_record(m_thd, m_table);
+      if (ret) return ret;
+    }
+  }
+  return HA_EXIT_SUCCESS;
+}
+
+/* Fill the information_schema.rocksdb_index_histogram virtual table */
+static int rdb_i_s_index_histogram_fill_table(
+    my_core::THD *const thd, my_core::TABLE_LIST *const tables,
+    my_core::Item *const cond MY_ATTRIBUTE((__unused__))) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(thd != nullptr);
+  DBUG_ASSERT(tables != nullptr);
+  DBUG_ASSERT(tables->table != nullptr);
+
+  int ret = 0;
+  rocksdb::DB *const rdb = rdb_get_rocksdb_db();
+
+  if (!rdb) {
+    DBUG_RETURN(ret);
+  }
+
+  Rdb_index_histogram_scanner histogram_arg;
+
+  histogram_arg.m_thd = thd;
+  histogram_arg.m_table = tables->table;
+
+  Rdb_ddl_manager *ddl_manager = rdb_get_ddl_manager();
+  DBUG_ASSERT(ddl_manager != nullptr);
+
+  ret = ddl_manager->scan_for_tables(&histogram_arg);
+
+  DBUG_RETURN(ret);
+}
+
+/* Initialize the information_schema.rocksdb_index_histogram virtual table */
+static int rdb_i_s_index_histogram_init(void *const p) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(p != nullptr);
+
+  my_core::ST_SCHEMA_TABLE *schema;
+
+  schema = (my_core::ST_SCHEMA_TABLE *)p;
+
+  schema->fields_info = rdb_i_s_index_histogram_fields_info;
+  schema->fill_table = rdb_i_s_index_histogram_fill_table;
+
+  DBUG_RETURN(0);
+}
+
 /*
   Support for INFORMATION_SCHEMA.ROCKSDB_LOCKS dynamic table
  */
@@ -1622,7 +1842,8 @@ enum {
   HAS_DEADLOCK_DETECTION,
   NUM_ONGOING_BULKLOAD,
   THREAD_ID,
-  QUERY
+  QUERY,
+  SPILLED_BYTES
 };
 }  // namespace RDB_TRX_FIELD
 
@@ -1647,6 +1868,8 @@ static ST_FIELD_INFO rdb_i_s_trx_info_fields_info[] = {
                        MYSQL_TYPE_LONG, 0),
     ROCKSDB_FIELD_INFO("THREAD_ID", sizeof(ulong), MYSQL_TYPE_LONG, 0),
     ROCKSDB_FIELD_INFO("QUERY", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("SPILLED_BYTES", sizeof(ulonglong), MYSQL_TYPE_LONGLONG,
+                       0),
     ROCKSDB_FIELD_INFO_END};
 
 /* Fill the information_schema.rocksdb_trx virtual table */
@@ -1704,6 +1927,8 @@ static int rdb_i_s_trx_info_fill_table(
     tables->table->field[RDB_TRX_FIELD::THREAD_ID]->store(info.thread_id, true);
     tables->table->field[RDB_TRX_FIELD::QUERY]->store(
         info.query_str.c_str(), info.query_str.length(), system_charset_info);
+    tables->table->field[RDB_TRX_FIELD::SPILLED_BYTES]->store(
+        info.spilled_bytes, true);
 
     /* Tell MySQL about this row in the virtual table */
     ret = static_cast<int>(
@@ -2017,6 +2242,22 @@ struct st_mysql_plugin rdb_i_s_index_file_map = {
     0,       /* flags */
 };
 
+struct st_mysql_plugin rdb_i_s_index_histogram = {
+    MYSQL_INFORMATION_SCHEMA_PLUGIN,
+    &rdb_i_s_info,
+    "ROCKSDB_INDEX_HISTOGRAM",
+    "Facebook",
+    "RocksDB index histograms",
+    PLUGIN_LICENSE_GPL,
+    rdb_i_s_index_histogram_init,
+    rdb_i_s_deinit,
+    0x0001,  /* version number (0.1) */
+    nullptr, /* status variables */
+    nullptr, /* system variables */
+    nullptr, /* config options */
+    0,       /* flags */
+};
+
 struct st_mysql_plugin rdb_i_s_lock_info = {
     MYSQL_INFORMATION_SCHEMA_PLUGIN,
     &rdb_i_s_info,
@@ -2065,6 +2306,22 @@ struct st_mysql_plugin rdb_i_s_deadlock_info = {
     0,       /* flags */
 };
 
+struct st_mysql_plugin rdb_i_s_bypass_plans = {
+    MYSQL_INFORMATION_SCHEMA_PLUGIN,
+    &rdb_i_s_info,
+    "ROCKSDB_BYPASS_PLANS",
+    "Facebook",
+    "RocksDB bypass SELECT plans cached on prepared statements",
+    PLUGIN_LICENSE_GPL,
+    rdb_i_s_bypass_plans_init,
+    rdb_i_s_deinit,
+    0x0001,  /* version number (0.1) */
+    nullptr, /* status variables */
+    nullptr, /* system variables */
+    nullptr, /* config options */
+    0,       /* flags */
+};
+
 struct st_mysql_plugin rdb_i_s_bypass_rejected_query_history = {
     MYSQL_INFORMATION_SCHEMA_PLUGIN,
     &rdb_i_s_info,
@@ -31,8 +31,10 @@ extern struct st_mysql_plugin rdb_i_s_global_info;
 extern struct st_mysql_plugin rdb_i_s_ddl;
 extern struct st_mysql_plugin rdb_i_s_sst_props;
 extern struct st_mysql_plugin rdb_i_s_index_file_map;
+extern struct st_mysql_plugin rdb_i_s_index_histogram;
 extern struct st_mysql_plugin rdb_i_s_lock_info;
 extern struct st_mysql_plugin rdb_i_s_trx_info;
 extern struct st_mysql_plugin rdb_i_s_deadlock_info;
+extern struct st_mysql_plugin rdb_i_s_bypass_plans;
 extern struct st_mysql_plugin rdb_i_s_bypass_rejected_query_history;
 }  // namespace myrocks
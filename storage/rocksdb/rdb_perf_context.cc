@@ -178,6 +178,8 @@ static void harvest_diffs(Rdb_atomic_perf_counters *const counters) {
 
 static Rdb_atomic_perf_counters rdb_global_perf_counters;
 
+std::atomic<uint64_t> rocksdb_scan_readahead_bytes(0);
+
 void rdb_get_global_perf_counters(Rdb_perf_counters *const counters) {
   counters->load(rdb_global_perf_counters);
 }
@@ -215,6 +217,33 @@ void Rdb_io_perf::update_bytes_written(const uint32_t perf_context_level,
   }
 }
 
+/*
+  Called when a scan iterator is re-created with readahead. Only the SST
+  block bytes read from then on, until the last such iterator is released or
+  the statement ends, are added to rocksdb_scan_readahead_bytes.
+*/
+void Rdb_io_perf::start_scan_readahead(const uint32_t perf_context_level) {
+  const rocksdb::PerfLevel perf_level =
+      static_cast<rocksdb::PerfLevel>(perf_context_level);
+  if (perf_level != rocksdb::kDisable && m_scan_readahead_iterators++ == 0) {
+    m_scan_readahead_start_bytes =
+        rocksdb::get_perf_context()->block_read_byte;
+  }
+}
+
+void Rdb_io_perf::end_scan_readahead() {
+  if (m_scan_readahead_iterators > 0 && --m_scan_readahead_iterators == 0) {
+    record_scan_readahead_bytes();
+  }
+}
+
+void Rdb_io_perf::record_scan_readahead_bytes() {
+  const uint64_t bytes = rocksdb::get_perf_context()->block_read_byte;
+  if (bytes > m_scan_readahead_start_bytes) {
+    rocksdb_scan_readahead_bytes += bytes - m_scan_readahead_start_bytes;
+  }
+}
+
 void Rdb_io_perf::end_and_record(const uint32_t perf_context_level) {
   const rocksdb::PerfLevel perf_level =
       static_cast<rocksdb::PerfLevel>(perf_context_level);
@@ -228,6 +257,11 @@ void Rdb_io_perf::end_and_record(const uint32_t perf_context_level) {
   }
   harvest_diffs(&rdb_global_perf_counters);
 
+  if (m_scan_readahead_iterators > 0) {
+    record_scan_readahead_bytes();
+    m_scan_readahead_iterators = 0;
+  }
+
   if (m_shared_io_perf_read &&
       (rocksdb::get_perf_context()->block_read_byte != 0 ||
        rocksdb::get_perf_context()->block_read_count != 0 ||
@@ -115,6 +115,12 @@ class Rdb_perf_counters {
 
 extern std::string rdb_pc_stat_types[PC_MAX_IDX];
 
+/*
+  Bytes read from SST blocks while a scan iterator created with readahead was
+  open.
+*/
+extern std::atomic<uint64_t> rocksdb_scan_readahead_bytes;
+
 /*
   Perf timers for data reads
  */
@@ -127,6 +133,12 @@ class Rdb_io_perf {
 
   uint64_t io_write_bytes;
   uint64_t io_write_requests;
+  // Scan iterators with readahead that are open, and the perf context
+  // block_read_byte when the first of them was opened
+  uint m_scan_readahead_iterators;
+  uint64_t m_scan_readahead_start_bytes;
+
+  void record_scan_readahead_bytes();
 
  public:
   Rdb_io_perf(const Rdb_io_perf &) = delete;
@@ -148,11 +160,15 @@ class Rdb_io_perf {
 
     io_write_bytes = 0;
     io_write_requests = 0;
+    m_scan_readahead_iterators = 0;
+    m_scan_readahead_start_bytes = 0;
   }
 
   bool start(const uint32_t perf_context_level);
   void update_bytes_written(const uint32_t perf_context_level,
                             ulonglong bytes_written);
+  void start_scan_readahead(const uint32_t perf_context_level);
+  void end_scan_readahead();
   void end_and_record(const uint32_t perf_context_level);
 
   explicit Rdb_io_perf()
@@ -160,7 +176,9 @@ class Rdb_io_perf {
         m_shared_io_perf_read(nullptr),
         m_stats(nullptr),
         io_write_bytes(0),
-        io_write_requests(0) {}
+        io_write_requests(0),
+        m_scan_readahead_iterators(0),
+        m_scan_readahead_start_bytes(0) {}
 };
 
 }  // namespace myrocks
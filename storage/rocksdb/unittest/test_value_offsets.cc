@@ -0,0 +1,444 @@
+/*
+   Copyright (c) 2020, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA */
+
+/*
+  Encode rows through Rdb_converter with and without a field offset
+  directory, and check that decoding any subset of the columns gives back the
+  original values either way. Then time decoding 2 of N columns for a growing
+  number of columns, with and without the directory.
+*/
+
+/* C++ standard header files */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* MySQL header files */
+#include "./field.h"
+#include "./sql_class.h"
+#include "./table.h"
+
+/* MyRocks header files */
+#include "../ha_rocksdb.h"
+#include "../rdb_converter.h"
+#include "../rdb_datadic.h"
+
+namespace {
+
+const uint VARCHAR_LENGTH = 32;
+
+/*
+  A table with these columns, in order:
+    c0 INT NOT NULL, c1..cN VARCHAR(32) NULL, cN+1 INT NOT NULL,
+    cN+2 VARCHAR(32) NOT NULL
+  so that fixed length fields follow variable length ones, and both nullable
+  and non-nullable variable length fields get a directory slot.
+*/
+class Test_table {
+ public:
+  explicit Test_table(uint nullable_columns)
+      : m_nullable_columns(nullable_columns),
+        m_columns(nullable_columns + 3),
+        m_null_bytes((nullable_columns + 7) / 8),
+        m_fields(m_columns + 1),
+        m_record(m_null_bytes + m_columns * (VARCHAR_LENGTH + 1)),
+        m_default_values(m_record.size()) {
+    m_share.fields = m_columns;
+    m_share.varchar_fields = 0;
+    m_share.primary_key = MAX_INDEXES;
+    m_share.db_low_byte_first = true;
+
+    for (uint i = 0; i < m_columns; i++) {
+      m_column_names.push_back("c" + std::to_string(i));
+    }
+    uint offset = m_null_bytes;
+    for (uint i = 0; i < m_columns; i++) {
+      uchar *const null_ptr =
+          is_nullable(i) ? m_record.data() + (i - 1) / 8 : nullptr;
+      const uchar null_bit = is_nullable(i) ? 1 << ((i - 1) % 8) : 0;
+      if (is_varchar(i)) {
+        m_fields[i] = new Field_varstring(
+            m_record.data() + offset, VARCHAR_LENGTH, 1, null_ptr, null_bit,
+            Field::NONE, m_column_names[i].c_str(), &m_share, &my_charset_bin);
+      } else {
+        m_fields[i] = new Field_long(m_record.data() + offset, 11, nullptr, 0,
+                                     Field::NONE, m_column_names[i].c_str(),
+                                     false, false);
+      }
+      m_fields[i]->init(&m_table);
+      m_fields[i]->field_index = i;
+      offset += m_fields[i]->pack_length();
+    }
+    m_fields[m_columns] = nullptr;
+    m_reclength = offset;
+
+    m_share.default_values = m_default_values.data();
+    m_share.reclength = m_reclength;
+
+    m_table.s = &m_share;
+    m_table.field = m_fields.data();
+    m_table.record[0] = m_record.data();
+    m_table.alias = "t1";
+  }
+
+  ~Test_table() {
+    for (uint i = 0; i < m_columns; i++) {
+      delete m_fields[i];
+    }
+  }
+
+  TABLE *table() { return &m_table; }
+  uchar *record() { return m_record.data(); }
+  uint reclength() const { return m_reclength; }
+  uint columns() const { return m_columns; }
+  const char *column_name(uint i) const { return m_column_names[i].c_str(); }
+
+  bool is_varchar(uint i) const {
+    return i != 0 && i != m_nullable_columns + 1;
+  }
+  bool is_nullable(uint i) const {
+    return i >= 1 && i <= m_nullable_columns;
+  }
+
+  /*
+    Fill the record with a row. Every third nullable column is NULL, shifted
+    by seed, and the VARCHAR lengths vary with seed including empty and full
+    length values.
+  */
+  void fill(uint seed) {
+    std::fill(m_record.begin(), m_record.end(), 0);
+    for (uint i = 0; i < m_columns; i++) {
+      Field *const field = m_fields[i];
+      if (is_nullable(i) && (i + seed) % 3 == 0) {
+        *field->null_ptr |= field->null_bit;
+        continue;
+      }
+      if (is_varchar(i)) {
+        const uint len = (i * 7 + seed * 5) % (VARCHAR_LENGTH + 1);
+        field->ptr[0] = static_cast<uchar>(len);
+        for (uint j = 0; j < len; j++) {
+          field->ptr[1 + j] = static_cast<uchar>('a' + (i + j + seed) % 26);
+        }
+      } else {
+        int4store(field->ptr, i * 1000 + seed);
+      }
+    }
+  }
+
+  /*
+    Compare the value of one column in two records, looking only at the
+    bytes that carry its value.
+  */
+  bool same_value(uint i, const uchar *a, const uchar *b) const {
+    const Field *const field = m_fields[i];
+    if (is_nullable(i)) {
+      const uint null_offset = field->null_ptr - m_record.data();
+      const bool a_null = (a[null_offset] & field->null_bit) != 0;
+      const bool b_null = (b[null_offset] & field->null_bit) != 0;
+      if (a_null != b_null) {
+        return false;
+      }
+      if (a_null) {
+        return true;
+      }
+    }
+    const uint offset = field->ptr - m_record.data();
+    const uint len = is_varchar(i) ? 1 + a[offset] : field->pack_length();
+    return memcmp(a + offset, b + offset, len) == 0;
+  }
+
+ private:
+  const uint m_nullable_columns;
+  const uint m_columns;
+  const uint m_null_bytes;
+  TABLE m_table;
+  TABLE_SHARE m_share;
+  std::vector<std::string> m_column_names;
+  std::vector<Field *> m_fields;
+  std::vector<uchar> m_record;
+  std::vector<uchar> m_default_values;
+  uint m_reclength;
+};
+/*
+  A table definition with only a hidden primary key, in the given format
+  version and with or without the offset directory flag.
+*/
+class Test_tbl_def {
+ public:
+  Test_tbl_def(uint16_t kv_format_version, bool value_offsets)
+      : m_tbl_def("test.t1") {
+    uint32 index_flags = 0;
+    if (value_offsets) {
+      index_flags |= myrocks::Rdb_key_def::VALUE_OFFSETS_FLAG;
+    }
+    m_key_def = std::make_shared<myrocks::Rdb_key_def>(
+        1, 0, nullptr, myrocks::Rdb_key_def::INDEX_INFO_VERSION_LATEST,
+        myrocks::Rdb_key_def::INDEX_TYPE_HIDDEN_PRIMARY, kv_format_version,
+        false, false, "HIDDEN_PK_ID", myrocks::Rdb_index_stats(),
+        index_flags);
+    m_tbl_def.m_key_count = 1;
+    m_tbl_def.m_key_descr_arr = new std::shared_ptr<myrocks::Rdb_key_def>[1];
+    m_tbl_def.m_key_descr_arr[0] = m_key_def;
+  }
+
+  ~Test_tbl_def() {
+    // The key definition was never registered with the DDL manager
+    m_tbl_def.m_key_descr_arr[0] = nullptr;
+  }
+
+  const myrocks::Rdb_tbl_def *tbl_def() const { return &m_tbl_def; }
+  const std::shared_ptr<myrocks::Rdb_key_def> &key_def() const {
+    return m_key_def;
+  }
+
+ private:
+  myrocks::Rdb_tbl_def m_tbl_def;
+  std::shared_ptr<myrocks::Rdb_key_def> m_key_def;
+};
+
+/*
+  Encode the current record of the table with the converter into value.
+*/
+bool encode(const Test_tbl_def &def, myrocks::Rdb_converter *converter,
+            std::string *value) {
+  char ttl_bytes[ROCKSDB_SIZEOF_TTL_RECORD] = {0};
+  bool ttl_bytes_updated = false;
+  rocksdb::Slice value_slice;
+  if (converter->encode_value_slice(def.key_def(), rocksdb::Slice(), nullptr,
+                                    false, false, ttl_bytes,
+                                    &ttl_bytes_updated,
+                                    &value_slice) != HA_EXIT_SUCCESS) {
+    return false;
+  }
+  // The converter reuses its buffer for the next row, so take a copy.
+  value->assign(value_slice.data(), value_slice.size());
+  return true;
+}
+
+/*
+  Encode the current record of the table with the converter, then decode the
+  columns in read_set into decoded.
+*/
+bool encode_and_decode(Test_table *table, const Test_tbl_def &def,
+                       myrocks::Rdb_converter *converter,
+                       const MY_BITMAP *read_set, uchar *decoded) {
+  std::string value;
+  if (!encode(def, converter, &value)) {
+    return false;
+  }
+  const rocksdb::Slice stored_value(value);
+
+  converter->setup_field_decoders(read_set, MAX_INDEXES, false);
+  memset(decoded, 0xff, table->reclength());
+  const rocksdb::Slice key_slice;
+  return converter->decode(def.key_def(), decoded, &key_slice,
+                           &stored_value) == HA_EXIT_SUCCESS;
+}
+
+bool check_read_set(Test_table *table, const Test_tbl_def &plain,
+                    const Test_tbl_def &offsets,
+                    myrocks::Rdb_converter *plain_converter,
+                    myrocks::Rdb_converter *offsets_converter,
+                    const MY_BITMAP *read_set, uint seed) {
+  std::vector<uchar> plain_record(table->reclength());
+  std::vector<uchar> offsets_record(table->reclength());
+  if (!encode_and_decode(table, plain, plain_converter, read_set,
+                         plain_record.data()) ||
+      !encode_and_decode(table, offsets, offsets_converter, read_set,
+                         offsets_record.data())) {
+    fprintf(stderr, "seed=%u: failed to decode the row\n", seed);
+    return false;
+  }
+
+  if (offsets_converter->get_value_offsets() == nullptr ||
+      plain_converter->get_value_offsets() != nullptr) {
+    fprintf(stderr, "seed=%u: offset directory was not used as expected\n",
+            seed);
+    return false;
+  }
+
+  for (uint i = 0; i < table->columns(); i++) {
+    if (!bitmap_is_set(read_set, i)) {
+      continue;
+    }
+    if (!table->same_value(i, table->record(), plain_record.data()) ||
+        !table->same_value(i, table->record(), offsets_record.data())) {
+      fprintf(stderr, "seed=%u: column %s decoded wrong\n", seed,
+              table->column_name(i));
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_round_trip(THD *thd) {
+  Test_table table(8);
+  const uint columns = table.columns();
+
+  // Only the format version for directories honors the flag
+  const Test_tbl_def old_format(
+      myrocks::Rdb_key_def::PRIMARY_FORMAT_VERSION_TTL, true);
+  const Test_tbl_def plain(myrocks::Rdb_key_def::PRIMARY_FORMAT_VERSION_LATEST,
+                           false);
+  const Test_tbl_def offsets(
+      myrocks::Rdb_key_def::PRIMARY_FORMAT_VERSION_VALUE_OFFSETS, true);
+
+  myrocks::Rdb_converter old_converter(thd, old_format.tbl_def(),
+                                       table.table());
+  myrocks::Rdb_converter plain_converter(thd, plain.tbl_def(), table.table());
+  myrocks::Rdb_converter offsets_converter(thd, offsets.tbl_def(),
+                                           table.table());
+  if (old_converter.get_has_value_offsets() ||
+      plain_converter.get_has_value_offsets() ||
+      !offsets_converter.get_has_value_offsets()) {
+    fprintf(stderr, "value offsets enabled for the wrong format version\n");
+    return false;
+  }
+
+  MY_BITMAP read_set;
+  if (bitmap_init(&read_set, nullptr, columns, false)) {
+    return false;
+  }
+
+  bool ok = true;
+  for (uint seed = 0; seed < 6 && ok; seed++) {
+    table.fill(seed);
+
+    // Every single column, every pair of columns, and all columns
+    for (uint i = 0; i < columns && ok; i++) {
+      for (uint j = i; j <= columns && ok; j++) {
+        bitmap_clear_all(&read_set);
+        if (j == columns) {
+          if (i != 0) {
+            continue;
+          }
+          bitmap_set_all(&read_set);
+        } else {
+          bitmap_set_bit(&read_set, i);
+          bitmap_set_bit(&read_set, j);
+        }
+        ok = check_read_set(&table, plain, offsets, &plain_converter,
+                            &offsets_converter, &read_set, seed);
+      }
+    }
+  }
+
+  bitmap_free(&read_set);
+  return ok;
+}
+
+/*
+  Decode the last nullable and the last column of a row num_iterations
+  times, and return the time it took in microseconds, or -1 if the columns
+  were decoded wrong.
+*/
+long long time_decode(Test_table *table, const Test_tbl_def &def,
+                      myrocks::Rdb_converter *converter,
+                      const MY_BITMAP *read_set, int num_iterations) {
+  std::string value;
+  if (!encode(def, converter, &value)) {
+    return -1;
+  }
+  const rocksdb::Slice stored_value(value);
+  const rocksdb::Slice key_slice;
+  std::vector<uchar> decoded(table->reclength());
+  converter->setup_field_decoders(read_set, MAX_INDEXES, false);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_iterations; i++) {
+    if (converter->decode(def.key_def(), decoded.data(), &key_slice,
+                          &stored_value) != HA_EXIT_SUCCESS) {
+      return -1;
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  for (uint i = 0; i < table->columns(); i++) {
+    if (bitmap_is_set(read_set, i) &&
+        !table->same_value(i, table->record(), decoded.data())) {
+      return -1;
+    }
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+      .count();
+}
+
+/*
+  Time decoding 2 of N columns with and without the offset directory, for a
+  growing number of columns. Without the directory the decoder walks all
+  the fields stored before the ones it reads.
+*/
+bool bench_decode(THD *thd) {
+  // Increase value for benchmarking!
+  const int num_iterations = 1000;
+
+  for (uint nullable_columns = 8; nullable_columns <= 512;
+       nullable_columns *= 4) {
+    Test_table table(nullable_columns);
+    const uint columns = table.columns();
+    const Test_tbl_def plain(
+        myrocks::Rdb_key_def::PRIMARY_FORMAT_VERSION_LATEST, false);
+    const Test_tbl_def offsets(
+        myrocks::Rdb_key_def::PRIMARY_FORMAT_VERSION_VALUE_OFFSETS, true);
+    myrocks::Rdb_converter plain_converter(thd, plain.tbl_def(),
+                                           table.table());
+    myrocks::Rdb_converter offsets_converter(thd, offsets.tbl_def(),
+                                             table.table());
+
+    MY_BITMAP read_set;
+    if (bitmap_init(&read_set, nullptr, columns, false)) {
+      return false;
+    }
+    bitmap_set_bit(&read_set, nullable_columns);
+    bitmap_set_bit(&read_set, columns - 1);
+    table.fill(0);
+
+    const long long plain_us = time_decode(&table, plain, &plain_converter,
+                                           &read_set, num_iterations);
+    const long long offsets_us = time_decode(
+        &table, offsets, &offsets_converter, &read_set, num_iterations);
+    bitmap_free(&read_set);
+    if (plain_us < 0 || offsets_us < 0) {
+      fprintf(stderr, "columns=%u: columns decoded wrong\n", columns);
+      return false;
+    }
+    printf("columns=%u decodes=%d plain=%lldus offsets=%lldus\n", columns,
+           num_iterations, plain_us, offsets_us);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  MY_INIT(argv[0]);
+  system_charset_info = &my_charset_utf8_general_ci;
+
+  // A session without plugins, the converter only keeps a pointer to it
+  THD *const thd = new THD(false);
+
+  int ret = 0;
+  if (!check_round_trip(thd) || !bench_decode(thd)) {
+    ret = 1;
+  }
+
+  delete thd;
+  my_end(0);
+  return ret;
+}
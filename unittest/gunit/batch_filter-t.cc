@@ -0,0 +1,211 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "test_utils.h"
+#include "fake_table.h"
+
+#include "item_cmpfunc.h"
+#include "sql_class.h"
+
+namespace batch_filter_unittest {
+
+using my_testing::Server_initializer;
+
+/*
+  Rows of a table (a INT NOT NULL, b INT NULL): one NULL byte, then a and b.
+*/
+const uint row_length= 9;
+const uint block_rows= 64;
+
+class BatchFilterTest : public ::testing::Test
+{
+protected:
+  BatchFilterTest()
+    : field_a(record + 1, 11, NULL, 0, Field::NONE, "a", false, false),
+      field_b(record + 5, 11, record, 1, Field::NONE, "b", false, false),
+      table(&field_a, &field_b)
+  {}
+
+  virtual void SetUp()
+  {
+    initializer.SetUp();
+    table.in_use= thd();
+    table.record[0]= record;
+    table.get_share()->reclength= row_length;
+    // The fake table has no read_set
+    thd()->mark_used_columns= MARK_COLUMNS_NONE;
+    memset(record, 0, sizeof(record));
+  }
+
+  virtual void TearDown() { initializer.TearDown(); }
+
+  THD *thd() { return initializer.thd(); }
+
+  /* a > 100 AND b BETWEEN 10 AND 500 AND a NOT IN (150, 250, 350) */
+  Item *make_condition()
+  {
+    List<Item> in_list;
+    in_list.push_back(new Item_field(&field_a));
+    in_list.push_back(new Item_int(150));
+    in_list.push_back(new Item_int(250));
+    in_list.push_back(new Item_int(350));
+    Item_func_in *in= new Item_func_in(in_list);
+    in->negated= true;
+
+    List<Item> conjuncts;
+    conjuncts.push_back(new Item_func_gt(new Item_field(&field_a),
+                                         new Item_int(100)));
+    conjuncts.push_back(new Item_func_between(new Item_field(&field_b),
+                                              new Item_int(10),
+                                              new Item_int(500)));
+    conjuncts.push_back(in);
+    Item *cond= new Item_cond_and(conjuncts);
+    EXPECT_FALSE(cond->fix_fields(thd(), &cond));
+    return cond;
+  }
+
+  void set_row(uint ix)
+  {
+    field_a.store((longlong) (ix * 7) % 1000, false);
+    if (ix % 11 == 0)
+      field_b.set_null();
+    else
+    {
+      field_b.set_notnull();
+      field_b.store((longlong) (ix * 13) % 600, false);
+    }
+  }
+
+  uchar record[row_length];
+  Field_long field_a;
+  Field_long field_b;
+  Fake_TABLE table;
+  Server_initializer initializer;
+};
+
+
+TEST_F(BatchFilterTest, SelectsSameRowsAsCondition)
+{
+  Item *cond= make_condition();
+  Batch_filter *filter= Batch_filter::create(thd()->mem_root, &table,
+                                             block_rows);
+  ASSERT_TRUE(filter != NULL);
+  ASSERT_TRUE(static_cast<Item_func*>(cond)->add_to_batch_filter(filter));
+
+  for (uint block= 0; block < 16; block++)
+  {
+    std::vector<uint> expected;
+    for (uint n= 0; n < block_rows; n++)
+    {
+      set_row(block * block_rows + n);
+      if (cond->val_int())
+        expected.push_back(n);
+      memcpy(filter->row(n), record, row_length);
+    }
+    const uint selected= filter->filter(block_rows);
+    std::vector<uint> actual(filter->selected_rows(),
+                             filter->selected_rows() + selected);
+    EXPECT_EQ(expected, actual);
+  }
+}
+
+
+TEST_F(BatchFilterTest, UnsupportedConditionIsNotAdded)
+{
+  // a > b compares two columns
+  Item *cond= new Item_func_gt(new Item_field(&field_a),
+                               new Item_field(&field_b));
+  EXPECT_FALSE(cond->fix_fields(thd(), &cond));
+  Batch_filter *filter= Batch_filter::create(thd()->mem_root, &table,
+                                             block_rows);
+  ASSERT_TRUE(filter != NULL);
+  EXPECT_FALSE(static_cast<Item_func*>(cond)->add_to_batch_filter(filter));
+  EXPECT_TRUE(filter->is_empty());
+}
+
+
+/*
+  Evaluating the condition row by row and in blocks are timed by separate
+  tests, so that their times can be compared.
+*/
+class BatchFilterTimeTest : public BatchFilterTest
+{
+protected:
+  // Increase value for benchmarking!
+  static const uint count= 1024 * 1024;
+
+  virtual void SetUp()
+  {
+    BatchFilterTest::SetUp();
+    cond= make_condition();
+    rows.resize(block_rows * row_length);
+    block_matches= 0;
+    for (uint n= 0; n < block_rows; n++)
+    {
+      set_row(n);
+      memcpy(&rows[n * row_length], record, row_length);
+      if (cond->val_int())
+        block_matches++;
+    }
+  }
+
+  /// Number of rows the condition selects from count rows
+  ulonglong expected_matches() const
+  {
+    return static_cast<ulonglong>(count / block_rows) * block_matches;
+  }
+
+  Item *cond;
+  std::vector<uchar> rows;
+  uint block_matches;
+};
+
+
+TEST_F(BatchFilterTimeTest, FilterPerRow)
+{
+  ulonglong matches= 0;
+  for (uint ix= 0; ix < count; ix++)
+  {
+    memcpy(record, &rows[(ix % block_rows) * row_length], row_length);
+    if (cond->val_int())
+      matches++;
+  }
+  EXPECT_EQ(expected_matches(), matches);
+}
+
+
+TEST_F(BatchFilterTimeTest, FilterBatched)
+{
+  Batch_filter *filter= Batch_filter::create(thd()->mem_root, &table,
+                                             block_rows);
+  ASSERT_TRUE(filter != NULL);
+  ASSERT_TRUE(static_cast<Item_func*>(cond)->add_to_batch_filter(filter));
+
+  ulonglong matches= 0;
+  for (uint ix= 0; ix < count; ix+= block_rows)
+  {
+    for (uint n= 0; n < block_rows; n++)
+      memcpy(filter->row(n), &rows[n * row_length], row_length);
+    matches+= filter->filter(block_rows);
+  }
+  EXPECT_EQ(expected_matches(), matches);
+}
+
+}
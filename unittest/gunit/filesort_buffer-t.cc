@@ -16,9 +16,12 @@
 // First include (the generated) my_config.h, to get correct platform defines.
 #include "my_config.h"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "filesort_utils.h"
+#include "sql_sort.h"
 #include "table.h"
 
 namespace filesort_buffer_unittest {
@@ -86,4 +89,195 @@ TEST_F(FileSortBufferTest, AssignmentOperator)
 }
 
 
+/*
+  Sorting packed records, see Sort_param::using_packed_records, of a key
+  like that of a nullable VARCHAR(255) utf8mb4_general_ci column: a NULL
+  indicator, then two bytes per character padded with the weight of space
+  to 255 characters. The values are up to 32 characters long, as short
+  strings in wide columns usually are.
+*/
+class PackedRecordsTest : public ::testing::Test
+{
+protected:
+  static const uint key_length= 1 + 255 * 2;
+  static const uint num_keys= 50 * 1000;
+  // Increase value for benchmarking!
+  static const size_t buffer_size= 2 * 1024 * 1024;
+  // Sort a full buffer this many times. Increase value for benchmarking!
+  static const int num_iterations= 1;
+
+  virtual void SetUp()
+  {
+    pad.push_back(1);
+    for (uint ix= 0; ix < 255; ++ix)
+    {
+      pad.push_back(0);
+      pad.push_back(' ');
+    }
+    part.length= key_length;
+    part.pad= &pad[0];
+
+    fixed_param.sort_length= key_length;
+    fixed_param.rec_length= key_length;
+
+    packed_param= fixed_param;
+    packed_param.using_packed_records= true;
+    packed_param.key_parts= &part;
+    packed_param.key_part_count= 1;
+    packed_param.rec_length= 4 + 2 + key_length;
+
+    const char digits[]= "0123456789ABCDEF";
+    keys.resize(num_keys * key_length);
+    for (uint ix= 0; ix < num_keys; ++ix)
+    {
+      uchar *key= &keys[ix * key_length];
+      uint seed= ix * 2654435761U;
+      if (ix % 97 == 0)
+      {
+        memset(key, 0, key_length);             // NULL
+        continue;
+      }
+      memcpy(key, &pad[0], key_length);
+      for (uint len= 1 + seed % 32, jx= 0; jx < len; ++jx)
+      {
+        key[2 + 2 * jx]= digits[(seed >> (jx % 28)) & 0xf];
+        seed= seed * 1103515245U + 12345U;
+      }
+    }
+  }
+
+  virtual void TearDown()
+  {
+    fixed_info.free_sort_buffer();
+    packed_info.free_sort_buffer();
+  }
+
+  const uchar *key(uint ix) const { return &keys[ix * key_length]; }
+
+  /// Fill fixed_info with up to count keys, returns how many fit.
+  uint fill_fixed(uint count)
+  {
+    const uint max_keys= buffer_size / (key_length + sizeof(uchar*));
+    fixed_info.alloc_sort_buffer(max_keys, key_length);
+    uint ix;
+    for (ix= 0; ix < count && ix < max_keys; ++ix)
+      memcpy(fixed_info.get_record_buffer(ix), key(ix), key_length);
+    return ix;
+  }
+
+  /// Fill packed_info with up to count keys, returns how many fit.
+  uint fill_packed(uint count)
+  {
+    const uint max_keys=
+      buffer_size / (packed_param.rec_length + sizeof(uchar*));
+    packed_info.alloc_sort_buffer(max_keys, packed_param.rec_length);
+    packed_info.init_packed_records();
+    uint ix;
+    for (ix= 0; ix < count; ++ix)
+    {
+      uchar *record=
+        packed_info.get_packed_record_buffer(packed_param.rec_length);
+      if (!record)
+        break;
+      uchar *end= pack_sort_key(&packed_param, record + 4, key(ix));
+      int4store(record, static_cast<uint32>(end - record));
+      packed_info.commit_packed_record(record, end - record);
+    }
+    return ix;
+  }
+
+  /// The fixed size key of a packed record.
+  std::vector<uchar> unpack(const uchar *record) const
+  {
+    const uint length= uint2korr(record + 4);
+    std::vector<uchar> key(pad.begin(), pad.end());
+    std::copy(record + 6, record + 6 + length, key.begin());
+    return key;
+  }
+
+  std::vector<uchar> pad;
+  SORT_KEY_PART part;
+  Sort_param fixed_param;
+  Sort_param packed_param;
+  std::vector<uchar> keys;
+  Filesort_info fixed_info;
+  Filesort_info packed_info;
+};
+
+
+TEST_F(PackedRecordsTest, SortsLikeFixedRecords)
+{
+  const uint count= fill_fixed(num_keys);
+  EXPECT_EQ(count, fill_packed(count));
+  for (uint ix= 0; ix < count; ++ix)
+  {
+    const std::vector<uchar> unpacked= unpack(packed_info.get_sort_keys()[ix]);
+    EXPECT_EQ(0, memcmp(key(ix), &unpacked[0], key_length));
+  }
+
+  fixed_info.sort_buffer(&fixed_param, count);
+  packed_info.sort_buffer(&packed_param, count);
+  for (uint ix= 0; ix < count; ++ix)
+  {
+    const std::vector<uchar> unpacked= unpack(packed_info.get_sort_keys()[ix]);
+    EXPECT_EQ(0, memcmp(fixed_info.get_sort_keys()[ix], &unpacked[0],
+                        key_length));
+  }
+
+  // The sorted records are in order by cmp_packed_sort_records() too
+  for (uint ix= 0; ix + 1 < count; ++ix)
+  {
+    const uchar *a= packed_info.get_sort_keys()[ix];
+    const uchar *b= packed_info.get_sort_keys()[ix + 1];
+    EXPECT_GE(0, cmp_packed_sort_records(&packed_param, a, b));
+    EXPECT_LE(0, cmp_packed_sort_records(&packed_param, b, a));
+  }
+}
+
+
+TEST_F(PackedRecordsTest, MoreRowsPerBuffer)
+{
+  const uint fixed_rows= fill_fixed(num_keys);
+  const uint packed_rows= fill_packed(num_keys);
+  EXPECT_LT(fixed_rows, packed_rows);
+}
+
+
+/*
+  Sort a full buffer of fixed size records, compare the time it takes with
+  SortPackedRecords.
+*/
+TEST_F(PackedRecordsTest, SortFixedRecords)
+{
+  uint count= 0;
+  for (int iter= 0; iter < num_iterations; ++iter)
+  {
+    count= fill_fixed(num_keys);
+    fixed_info.sort_buffer(&fixed_param, count);
+  }
+  for (uint ix= 0; ix + 1 < count; ++ix)
+    EXPECT_GE(0, memcmp(fixed_info.get_sort_keys()[ix],
+                        fixed_info.get_sort_keys()[ix + 1], key_length));
+}
+
+
+/*
+  Sort a full buffer of packed records, which holds more rows than the one
+  of SortFixedRecords.
+*/
+TEST_F(PackedRecordsTest, SortPackedRecords)
+{
+  uint count= 0;
+  for (int iter= 0; iter < num_iterations; ++iter)
+  {
+    count= fill_packed(num_keys);
+    packed_info.sort_buffer(&packed_param, count);
+  }
+  for (uint ix= 0; ix + 1 < count; ++ix)
+    EXPECT_GE(0, cmp_packed_sort_records(&packed_param,
+                                         packed_info.get_sort_keys()[ix],
+                                         packed_info.get_sort_keys()[ix + 1]));
+}
+
+
 }  // namespace
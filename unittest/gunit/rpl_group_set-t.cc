@@ -16,17 +16,29 @@
 
 #include <gtest/gtest.h>
 #include <string.h>
-
+#include <vector>
+
+/*
+  The GroupTest cases were written for the Group_cache, Group_log_state
+  and Owned_groups classes of an early GTID design, and do not build
+  against the current Gtid_set and Sid_map.  They are only compiled with
+  OLD_GROUP_TESTS defined.  The Compact_gtid_set cases at the end of the
+  file are always built.
+*/
+#ifdef OLD_GROUP_TESTS
 #define FRIEND_OF_GTID_SET class GroupTest_Group_containers_Test
 #define FRIEND_OF_GROUP_CACHE class GroupTest_Group_containers_Test
 #define FRIEND_OF_GROUP_LOG_STATE class GroupTest_Group_containers_Test
 #define NON_DISABLED_UNITTEST_GTID
+#endif
 
 #include "sql_class.h"
 #include "my_pthread.h"
 #include "binlog.h"
 #include "rpl_gtid.h"
 
+namespace rpl_group_set_unittest {
+
 #define N_SIDS 16
 
 #define ASSERT_OK(X) ASSERT_EQ(RETURN_STATUS_OK, X)
@@ -34,6 +46,7 @@
 #define EXPECT_NOK(X) EXPECT_NE(RETURN_STATUS_OK, X)
 
 
+#ifdef OLD_GROUP_TESTS
 class GroupTest : public ::testing::Test
 {
 public:
@@ -952,3 +965,221 @@ TEST_F(GroupTest, Group_containers)
 
   mysql_bin_log.sid_lock.assert_no_lock();
 }
+#endif // OLD_GROUP_TESTS
+
+
+/**
+  Builds a Gtid_set with n_sids SIDs, where SIDNO N has n_intervals
+  intervals of random length with random gaps between them.
+*/
+static void make_gtid_set(Sid_map *sm, Gtid_set *set, int n_sids,
+                          int n_intervals)
+{
+  for (int i= 1; i <= n_sids; i++)
+  {
+    rpl_sid sid;
+    sid.clear();
+    int4store(sid.bytes, i);
+    rpl_sidno sidno= sm->add_sid(sid);
+    ASSERT_LE(1, sidno);
+    ASSERT_OK(set->ensure_sidno(sidno));
+    rpl_gno gno= 1 + rand() % 5;
+    for (int j= 0; j < n_intervals; j++)
+    {
+      rpl_gno end= gno + 1 + rand() % 10;
+      for (; gno < end; gno++)
+        ASSERT_OK(set->_add_gtid(sidno, gno));
+      gno+= 1 + rand() % 10;
+    }
+  }
+}
+
+
+TEST(CompactGtidSetTest, Compare_with_gtid_set)
+{
+  Sid_map sm(NULL);
+  Gtid_set a(&sm), b(&sm);
+  make_gtid_set(&sm, &a, N_SIDS, 50);
+  make_gtid_set(&sm, &b, N_SIDS / 2, 50);
+
+  Compact_gtid_set ca(&a), cb(&b);
+  EXPECT_FALSE(ca.is_empty());
+
+  // Lookups agree with the linked lists.
+  for (rpl_sidno sidno= 1; sidno <= N_SIDS + 1; sidno++)
+    for (rpl_gno gno= 1; gno < 1000; gno++)
+      EXPECT_EQ(a.contains_gtid(sidno, gno), ca.contains_gtid(sidno, gno))
+        << "sidno=" << sidno << " gno=" << gno;
+
+  // Converting back gives the same set.
+  Gtid_set a2(&sm);
+  ASSERT_OK(ca.to_gtid_set(&a2));
+  EXPECT_TRUE(a.is_subset(&a2));
+  EXPECT_TRUE(a2.is_subset(&a));
+
+  // The set operations agree with those of Gtid_set.
+  Gtid_set sum(&sm), diff(&sm), meet(&sm);
+  ASSERT_OK(sum.add_gtid_set(&a));
+  ASSERT_OK(sum.add_gtid_set(&b));
+  ASSERT_OK(diff.add_gtid_set(&a));
+  ASSERT_OK(diff.remove_gtid_set(&b));
+  ASSERT_OK(meet.add_gtid_set(&a));
+  ASSERT_OK(meet.remove_gtid_set(&diff));
+
+  Compact_gtid_set csum(ca), cdiff(ca), cmeet(ca);
+  csum.add_gtid_set(cb);
+  cdiff.remove_gtid_set(cb);
+  cmeet.intersect_gtid_set(cb);
+  EXPECT_TRUE(csum.equals(Compact_gtid_set(&sum)));
+  EXPECT_TRUE(cdiff.equals(Compact_gtid_set(&diff)));
+  EXPECT_TRUE(cmeet.equals(Compact_gtid_set(&meet)));
+
+  EXPECT_EQ(b.is_subset(&a), cb.is_subset(ca));
+  EXPECT_TRUE(cmeet.is_subset(ca));
+  EXPECT_TRUE(cmeet.is_subset(cb));
+  EXPECT_TRUE(ca.is_subset(csum));
+  EXPECT_EQ(a.is_intersection_nonempty(&b), ca.is_intersection_nonempty(cb));
+  EXPECT_FALSE(cdiff.is_intersection_nonempty(cb));
+
+  Compact_gtid_set empty;
+  EXPECT_TRUE(empty.is_subset(ca));
+  EXPECT_FALSE(ca.is_subset(empty));
+  EXPECT_FALSE(empty.contains_gtid(1, 1));
+}
+
+
+TEST(CompactGtidSetTest, Other_sid_map)
+{
+  Sid_map sm(NULL), other_sm(NULL);
+  // other_sm numbers half of the SIDs of sm, in reverse order.
+  for (int i= N_SIDS / 2; i >= 1; i--)
+  {
+    rpl_sid sid;
+    sid.clear();
+    int4store(sid.bytes, i);
+    ASSERT_LE(1, other_sm.add_sid(sid));
+  }
+  Gtid_set a(&sm), b(&other_sm), c(&sm);
+  make_gtid_set(&sm, &a, N_SIDS, 50);
+  make_gtid_set(&other_sm, &b, N_SIDS / 2, 50);
+  ASSERT_OK(c.add_gtid_set(&b));
+
+  // The SIDs other_sm lacks are added to it.
+  Compact_gtid_set ca, cb(&b), cc;
+  ASSERT_OK(ca.assign(&a, &other_sm));
+  EXPECT_EQ(N_SIDS, other_sm.get_max_sidno());
+  ASSERT_OK(cc.assign(&c, &other_sm));
+  EXPECT_TRUE(cc.equals(cb));
+
+  Gtid_set copy(&other_sm);
+  ASSERT_OK(ca.to_gtid_set(&copy));
+  EXPECT_TRUE(copy.equals(&a));
+  EXPECT_EQ(b.is_subset(&a), cb.is_subset(ca));
+  EXPECT_EQ(a.is_subset(&b), ca.is_subset(cb));
+
+  for (rpl_sidno sidno= 1; sidno <= N_SIDS / 2; sidno++)
+  {
+    rpl_sidno other_sidno= other_sm.sid_to_sidno(sm.sidno_to_sid(sidno));
+    EXPECT_EQ(b.is_subset_for_sid(&a, sidno, other_sidno),
+              cb.is_subset_for_sid(&a, sidno, other_sidno))
+      << "sidno=" << sidno;
+    EXPECT_TRUE(cb.is_subset_for_sid(&c, sidno, other_sidno))
+      << "sidno=" << sidno;
+  }
+  EXPECT_TRUE(cb.is_subset_for_sid(&a, 1, 0));
+  EXPECT_FALSE(cb.is_subset_for_sid(&a, 0, 1));
+}
+
+
+/*
+  Compares the lookups of a slave's GTIDs in the linked lists of
+  Gtid_set and in Compact_gtid_set, for a server with many SIDs from
+  past failovers, each with fragmented intervals.  Each operation is
+  timed by its own test.
+*/
+class CompactGtidSetBenchmark : public ::testing::Test
+{
+protected:
+  // Increase these for benchmarking!
+  static const int num_sids= 100;
+  static const int num_intervals= 100;
+  static const int num_lookups= 100 * 1000;
+  static const int num_set_operations= 100;
+
+  CompactGtidSetBenchmark() : sm(NULL), set(&sm), super(&sm) {}
+
+  virtual void SetUp()
+  {
+    make_gtid_set(&sm, &set, num_sids, num_intervals);
+    // The GTIDs of a master which the slave connects to.
+    make_gtid_set(&sm, &super, num_sids, num_intervals);
+    ASSERT_OK(super.add_gtid_set(&set));
+    compact.assign(&set);
+    compact_super.assign(&super);
+
+    for (int i= 0; i < num_lookups; i++)
+      lookups.push_back(std::make_pair(1 + rand() % num_sids,
+                                       1 + rand() % (num_intervals * 20)));
+  }
+
+  Sid_map sm;
+  Gtid_set set;
+  Gtid_set super;
+  Compact_gtid_set compact;
+  Compact_gtid_set compact_super;
+  std::vector<std::pair<rpl_sidno, rpl_gno> > lookups;
+};
+
+
+TEST_F(CompactGtidSetBenchmark, Copy)
+{
+  for (int i= 0; i < num_set_operations; i++)
+  {
+    Compact_gtid_set copy(&set);
+    ASSERT_EQ(compact.get_n_intervals(), copy.get_n_intervals());
+  }
+}
+
+
+TEST_F(CompactGtidSetBenchmark, LookupInGtidSet)
+{
+  int found= 0;
+  for (int i= 0; i < num_lookups; i++)
+    found+= set.contains_gtid(lookups[i].first, lookups[i].second);
+  EXPECT_LT(0, found);
+}
+
+
+TEST_F(CompactGtidSetBenchmark, LookupInCompactGtidSet)
+{
+  int found= 0;
+  for (int i= 0; i < num_lookups; i++)
+    found+= compact.contains_gtid(lookups[i].first, lookups[i].second);
+  EXPECT_LT(0, found);
+}
+
+
+TEST_F(CompactGtidSetBenchmark, IsSubsetOfGtidSet)
+{
+  for (int i= 0; i < num_set_operations; i++)
+    ASSERT_TRUE(set.is_subset(&super));
+}
+
+
+TEST_F(CompactGtidSetBenchmark, IsSubsetOfCompactGtidSet)
+{
+  for (int i= 0; i < num_set_operations; i++)
+    ASSERT_TRUE(compact.is_subset(compact_super));
+}
+
+
+TEST_F(CompactGtidSetBenchmark, CompactAgreesWithGtidSet)
+{
+  for (int i= 0; i < num_lookups; i++)
+    ASSERT_EQ(set.contains_gtid(lookups[i].first, lookups[i].second),
+              compact.contains_gtid(lookups[i].first, lookups[i].second));
+  EXPECT_EQ(set.is_subset(&super), compact.is_subset(compact_super));
+  EXPECT_EQ(super.is_subset(&set), compact_super.is_subset(compact));
+}
+
+}  // namespace rpl_group_set_unittest
@@ -0,0 +1,298 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "thread_utils.h"
+
+#include "sql_class.h"
+#include "sql_stats.h"
+
+namespace sql_stats_unittest {
+
+using thread::Thread;
+
+const uint num_keys= 16;
+
+md5_key make_key(uint ix)
+{
+  md5_key key{};
+  key[0]= static_cast<unsigned char>(ix);
+  return key;
+}
+
+SHARED_SQL_STATS make_stats()
+{
+  SHARED_SQL_STATS stats;
+  stats.reset();
+  stats.rows_read= 2;
+  stats.rows_sent= 1;
+  stats.stmt_cpu_utime= 10;
+  return stats;
+}
+
+class SqlStatsBufferTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    saved_sample_age= max_digest_sample_age;
+    max_digest_sample_age= 0;
+    global.reset();
+  }
+
+  virtual void TearDown()
+  {
+    max_digest_sample_age= saved_sample_age;
+  }
+
+  longlong saved_sample_age;
+  SQL_STATS global;
+  Sql_stats_buffer buffer;
+};
+
+
+TEST_F(SqlStatsBufferTest, MergesIntoGlobalEntry)
+{
+  const SHARED_SQL_STATS stats= make_stats();
+
+  // Statements are only buffered once they have a global entry
+  EXPECT_FALSE(buffer.add(make_key(1), &stats, true, false, 0));
+  buffer.insert(make_key(1), &global, 1);
+
+  for (uint ix= 0; ix < 10; ++ix)
+    EXPECT_TRUE(buffer.add(make_key(1), &stats, true, ix == 0, 0));
+  EXPECT_TRUE(buffer.add(make_key(1), &stats, false, false, 0));
+  EXPECT_EQ(11U, buffer.pending());
+  EXPECT_EQ(0U, global.count);
+
+  buffer.merge(1);
+  EXPECT_EQ(0U, buffer.pending());
+  EXPECT_EQ(10U, global.count);
+  EXPECT_EQ(1U, global.skipped_count);
+  EXPECT_EQ(22U, global.shared_stats.rows_read);
+  EXPECT_EQ(11U, global.shared_stats.rows_sent);
+  EXPECT_EQ(110U, global.shared_stats.stmt_cpu_utime);
+
+  // Merging again adds nothing
+  buffer.merge(1);
+  EXPECT_EQ(10U, global.count);
+}
+
+
+TEST_F(SqlStatsBufferTest, DropsEntriesOfOldGeneration)
+{
+  const SHARED_SQL_STATS stats= make_stats();
+  buffer.insert(make_key(1), &global, 1);
+  EXPECT_TRUE(buffer.add(make_key(1), &stats, true, false, 0));
+
+  // The global maps were replaced: the entry and its stats are dropped
+  buffer.merge(2);
+  EXPECT_EQ(0U, global.count);
+  EXPECT_FALSE(buffer.add(make_key(1), &stats, true, false, 0));
+}
+
+
+TEST_F(SqlStatsBufferTest, RefreshesQuerySample)
+{
+  const SHARED_SQL_STATS stats= make_stats();
+  max_digest_sample_age= 10;
+  global.query_sample_seen= 100;
+  buffer.insert(make_key(1), &global, 1);
+
+  EXPECT_TRUE(buffer.add(make_key(1), &stats, true, false, 110));
+  // The sample is too old, the statement must take the global path
+  EXPECT_FALSE(buffer.add(make_key(1), &stats, true, false, 111));
+
+  buffer.merge(1);
+  global.query_sample_seen= 111;
+  buffer.insert(make_key(1), &global, 1);
+  EXPECT_TRUE(buffer.add(make_key(1), &stats, true, false, 111));
+}
+
+
+/*
+  Each thread executes the same statements, adding their stats either to
+  the global entries under one mutex, as every statement used to, or to its
+  own buffer, merged every MERGE_COUNT statements.
+*/
+class Stats_thread : public Thread
+{
+public:
+  enum Mode { DISABLED, GLOBAL_LOCK, BUFFERED };
+
+  Stats_thread(Mode mode, uint statements, mysql_mutex_t *global_lock,
+               std::vector<SQL_STATS> *global)
+    : m_mode(mode), m_statements(statements), m_global_lock(global_lock),
+      m_global(global)
+  {
+    mysql_mutex_init(0, &m_buffer_lock, MY_MUTEX_INIT_FAST);
+  }
+
+  ~Stats_thread()
+  {
+    mysql_mutex_destroy(&m_buffer_lock);
+  }
+
+protected:
+  virtual void run()
+  {
+    const SHARED_SQL_STATS stats= make_stats();
+    for (uint ix= 0; ix < m_statements; ++ix)
+    {
+      const uint key= ix % num_keys;
+      switch (m_mode) {
+      case DISABLED:
+        break;
+      case GLOBAL_LOCK:
+        mysql_mutex_lock(m_global_lock);
+        add_sql_stats(&(*m_global)[key], &stats, 1, 0);
+        mysql_mutex_unlock(m_global_lock);
+        break;
+      case BUFFERED:
+      {
+        mysql_mutex_lock(&m_buffer_lock);
+        const bool buffered=
+          m_buffer.add(make_key(key), &stats, true, false, 0);
+        const bool merge= m_buffer.pending() >= Sql_stats_buffer::MERGE_COUNT;
+        mysql_mutex_unlock(&m_buffer_lock);
+        if (!buffered || merge)
+        {
+          mysql_mutex_lock(m_global_lock);
+          mysql_mutex_lock(&m_buffer_lock);
+          m_buffer.merge(1);
+          if (!buffered)
+          {
+            add_sql_stats(&(*m_global)[key], &stats, 1, 0);
+            m_buffer.insert(make_key(key), &(*m_global)[key], 1);
+          }
+          mysql_mutex_unlock(&m_buffer_lock);
+          mysql_mutex_unlock(m_global_lock);
+        }
+        break;
+      }
+      }
+    }
+    mysql_mutex_lock(m_global_lock);
+    m_buffer.merge(1);
+    mysql_mutex_unlock(m_global_lock);
+  }
+
+private:
+  Mode m_mode;
+  uint m_statements;
+  mysql_mutex_t *m_global_lock;
+  mysql_mutex_t m_buffer_lock;
+  std::vector<SQL_STATS> *m_global;
+  Sql_stats_buffer m_buffer;
+};
+
+
+class SqlStatsThreadsTest : public SqlStatsBufferTest
+{
+protected:
+  static const uint num_threads= 8;
+  // Statements per thread. Increase value for benchmarking!
+  static const uint statements= 20000;
+
+  virtual void SetUp()
+  {
+    SqlStatsBufferTest::SetUp();
+    mysql_mutex_init(0, &global_lock, MY_MUTEX_INIT_FAST);
+  }
+
+  virtual void TearDown()
+  {
+    mysql_mutex_destroy(&global_lock);
+    SqlStatsBufferTest::TearDown();
+  }
+
+  /// Run the statements in all threads, returns the global entries.
+  std::vector<SQL_STATS> run_statements(Stats_thread::Mode mode)
+  {
+    std::vector<SQL_STATS> global(num_keys);
+    for (uint key= 0; key < num_keys; ++key)
+      global[key].reset();
+
+    std::vector<Stats_thread*> threads;
+    for (uint ix= 0; ix < num_threads; ++ix)
+      threads.push_back(new Stats_thread(mode, statements, &global_lock,
+                                         &global));
+    for (uint ix= 0; ix < num_threads; ++ix)
+      threads[ix]->start();
+    for (uint ix= 0; ix < num_threads; ++ix)
+    {
+      threads[ix]->join();
+      delete threads[ix];
+    }
+    return global;
+  }
+
+  static ulonglong total_count(const std::vector<SQL_STATS> &global)
+  {
+    ulonglong count= 0;
+    for (uint key= 0; key < num_keys; ++key)
+      count+= global[key].count;
+    return count;
+  }
+
+  mysql_mutex_t global_lock;
+};
+
+
+/*
+  The three ways of running the statements are timed by separate tests, so
+  that their times can be compared.
+*/
+TEST_F(SqlStatsThreadsTest, StatementsWithoutStats)
+{
+  EXPECT_EQ(0U, total_count(run_statements(Stats_thread::DISABLED)));
+}
+
+
+TEST_F(SqlStatsThreadsTest, StatementsUnderGlobalLock)
+{
+  EXPECT_EQ(num_threads * statements,
+            total_count(run_statements(Stats_thread::GLOBAL_LOCK)));
+}
+
+
+TEST_F(SqlStatsThreadsTest, StatementsBuffered)
+{
+  EXPECT_EQ(num_threads * statements,
+            total_count(run_statements(Stats_thread::BUFFERED)));
+}
+
+
+TEST_F(SqlStatsThreadsTest, BufferedAgreesWithGlobalLock)
+{
+  const std::vector<SQL_STATS> locked=
+    run_statements(Stats_thread::GLOBAL_LOCK);
+  const std::vector<SQL_STATS> buffered=
+    run_statements(Stats_thread::BUFFERED);
+  for (uint key= 0; key < num_keys; ++key)
+  {
+    EXPECT_EQ(locked[key].count, buffered[key].count);
+    EXPECT_EQ(locked[key].shared_stats.rows_read,
+              buffered[key].shared_stats.rows_read);
+    EXPECT_EQ(locked[key].shared_stats.stmt_cpu_utime,
+              buffered[key].shared_stats.stmt_cpu_utime);
+  }
+}
+
+}  // namespace
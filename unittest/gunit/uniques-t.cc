@@ -0,0 +1,165 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "sql_class.h"
+
+namespace uniques_unittest {
+
+const uint key_size= 8;
+
+extern "C" int uniques_key_cmp(const void *arg, const void *a, const void *b)
+{
+  return memcmp(a, b, key_size);
+}
+
+extern "C" int uniques_collect(void *key, element_count count, void *arg)
+{
+  std::vector<std::string> *keys= static_cast<std::vector<std::string>*>(arg);
+  keys->push_back(std::string(static_cast<char*>(key), key_size));
+  return 0;
+}
+
+/*
+  Pseudo random 8 byte keys where every value appears about 'repeat' times.
+  std::string orders them like memcmp().
+*/
+class UniqueTest : public ::testing::Test
+{
+protected:
+  // Number of keys of the timed tests. Increase value for benchmarking!
+  static const uint bench_keys= 100000;
+
+  void make_keys(uint count, uint repeat)
+  {
+    keys.resize(count * key_size);
+    expected.clear();
+    ulonglong value= 1;
+    for (uint ix= 0; ix < count; ++ix)
+    {
+      value= value * 6364136223846793005ULL + 1442695040888963407ULL;
+      uchar *key= &keys[ix * key_size];
+      int8store(key, (value >> 16) % (count / repeat + 1));
+      expected.insert(std::string(reinterpret_cast<char*>(key), key_size));
+    }
+  }
+
+  bool add_all(Unique *unique)
+  {
+    for (size_t pos= 0; pos < keys.size(); pos+= key_size)
+    {
+      if (unique->unique_add(&keys[pos]))
+        return true;
+    }
+    return false;
+  }
+
+  std::vector<std::string> walk(Unique *unique)
+  {
+    std::vector<std::string> result;
+    EXPECT_FALSE(unique->walk(uniques_collect, &result));
+    return result;
+  }
+
+  std::vector<uchar> keys;
+  std::set<std::string> expected;
+};
+
+
+TEST_F(UniqueTest, HashInMemory)
+{
+  make_keys(10000, 4);
+  Unique tree(uniques_key_cmp, NULL, key_size, 16 * 1024 * 1024);
+  Unique hash(uniques_key_cmp, NULL, key_size, 16 * 1024 * 1024, true);
+  EXPECT_FALSE(add_all(&tree));
+  EXPECT_FALSE(add_all(&hash));
+  EXPECT_EQ(0U, hash.elements);
+  EXPECT_EQ(expected.size(), hash.elements_in_tree());
+
+  // Walked in the same order as the tree
+  const std::vector<std::string> tree_keys= walk(&tree);
+  const std::vector<std::string> hash_keys= walk(&hash);
+  EXPECT_TRUE(std::vector<std::string>(expected.begin(), expected.end()) ==
+              hash_keys);
+  EXPECT_TRUE(tree_keys == hash_keys);
+
+  // The set is rebuilt after walk(), and reset() empties it
+  EXPECT_FALSE(add_all(&hash));
+  EXPECT_EQ(expected.size(), hash.elements_in_tree());
+  hash.reset();
+  EXPECT_EQ(0U, hash.elements_in_tree());
+  make_keys(1000, 2);
+  EXPECT_FALSE(add_all(&hash));
+  EXPECT_TRUE(std::vector<std::string>(expected.begin(), expected.end()) ==
+              walk(&hash));
+}
+
+
+TEST_F(UniqueTest, HashSpillsToDisk)
+{
+  make_keys(20000, 2);
+  Unique hash(uniques_key_cmp, NULL, key_size, 16 * 1024, true);
+  EXPECT_FALSE(add_all(&hash));
+  // Written to the file in several sorted runs, merged by walk()
+  EXPECT_LT(0U, hash.elements);
+  EXPECT_TRUE(std::vector<std::string>(expected.begin(), expected.end()) ==
+              walk(&hash));
+}
+
+
+TEST_F(UniqueTest, TreeAndHashAgree)
+{
+  make_keys(bench_keys, 4);
+
+  Unique tree(uniques_key_cmp, NULL, key_size, 64 * 1024 * 1024);
+  Unique hash(uniques_key_cmp, NULL, key_size, 64 * 1024 * 1024, true);
+  EXPECT_FALSE(add_all(&tree));
+  EXPECT_FALSE(add_all(&hash));
+
+  EXPECT_EQ(0U, tree.elements);
+  EXPECT_EQ(0U, hash.elements);
+  EXPECT_EQ(tree.elements_in_tree(), hash.elements_in_tree());
+  EXPECT_TRUE(walk(&tree) == walk(&hash));
+}
+
+
+/*
+  Deduplicate keys with the tree, compare the time it takes with
+  DeduplicateWithHash.
+*/
+TEST_F(UniqueTest, DeduplicateWithTree)
+{
+  make_keys(bench_keys, 4);
+  Unique tree(uniques_key_cmp, NULL, key_size, 64 * 1024 * 1024);
+  EXPECT_FALSE(add_all(&tree));
+  EXPECT_EQ(expected.size(), walk(&tree).size());
+}
+
+
+TEST_F(UniqueTest, DeduplicateWithHash)
+{
+  make_keys(bench_keys, 4);
+  Unique hash(uniques_key_cmp, NULL, key_size, 64 * 1024 * 1024, true);
+  EXPECT_FALSE(add_all(&hash));
+  EXPECT_EQ(expected.size(), walk(&hash).size());
+}
+
+}  // namespace